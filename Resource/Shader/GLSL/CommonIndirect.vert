@@ -0,0 +1,33 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+
+layout (location = 0) in vec3 position_VS_in;
+layout (location = 1) in vec3 normal_VS_in;
+layout (location = 2) in vec2 texcoord_VS_in;
+
+out vec2 texcoord_VS_out;
+flat out float diffuse_layer_VS_out;
+
+layout (std140, binding = 0) uniform UBO0 {
+	mat4 view;
+	mat4 proj;
+	vec3 camPos;
+};
+
+// per-draw data of a multi-draw, indexed by gl_DrawIDARB
+struct DrawData {
+	mat4 model;
+	vec4 params;
+	// texture array layers of the material, see MaterialCBDS
+	vec4 layers[3];
+};
+
+layout (std430, binding = 0) readonly buffer DrawDataBuffer {
+	DrawData draws[];
+};
+
+void main() {
+	gl_Position = proj * view * draws[gl_DrawIDARB].model * vec4(position_VS_in, 1.0);
+	texcoord_VS_out = texcoord_VS_in;
+	diffuse_layer_VS_out = draws[gl_DrawIDARB].layers[0].x;
+}
@@ -0,0 +1,13 @@
+#version 420 core
+
+// diffuse textures packed by Material::Pack
+layout (binding = 0) uniform sampler2DArray diffuse_array;
+
+in vec2 texcoord_VS_out;
+flat in float diffuse_layer_VS_out;
+
+out vec4 color_FS_out;
+
+void main() {
+	color_FS_out = texture(diffuse_array, vec3(texcoord_VS_out, diffuse_layer_VS_out));
+}
@@ -0,0 +1,217 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "Bounds.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define NN_FRUSTUM_SSE
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+/** BoundingBox >>> */
+
+BoundingBox::BoundingBox() : min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+{}
+
+BoundingBox::BoundingBox(const NNVec3& min, const NNVec3& max) : min(min), max(max)
+{}
+
+BoundingBox BoundingBox::FromPoints(const void* points, const NNUInt point_num, const NNUInt stride)
+{
+	BoundingBox result;
+	const NNByte* data = (const NNByte*)points;
+	for (NNUInt i = 0; i < point_num; ++i, data += stride)
+	{
+		const NNFloat* position = (const NNFloat*)data;
+		result.Merge(NNVec3(position[0], position[1], position[2]));
+	}
+	return result;
+}
+
+NNFloat BoundingBox::GetRadius() const
+{
+	if (IsEmpty())
+	{
+		return 0.0f;
+	}
+	const NNVec3 extent = GetExtent();
+	return sqrtf(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+}
+
+NNFloat BoundingBox::GetArea() const
+{
+	if (IsEmpty())
+	{
+		return 0.0f;
+	}
+	const NNVec3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void BoundingBox::Merge(const NNVec3& point)
+{
+	min = NNVec3(std::min(min.x, point.x), std::min(min.y, point.y), std::min(min.z, point.z));
+	max = NNVec3(std::max(max.x, point.x), std::max(max.y, point.y), std::max(max.z, point.z));
+}
+
+void BoundingBox::Merge(const BoundingBox& rhs)
+{
+	min = NNVec3(std::min(min.x, rhs.min.x), std::min(min.y, rhs.min.y), std::min(min.z, rhs.min.z));
+	max = NNVec3(std::max(max.x, rhs.max.x), std::max(max.y, rhs.max.y), std::max(max.z, rhs.max.z));
+}
+
+bool BoundingBox::Contains(const BoundingBox& rhs) const
+{
+	return min.x <= rhs.min.x && min.y <= rhs.min.y && min.z <= rhs.min.z &&
+		max.x >= rhs.max.x && max.y >= rhs.max.y && max.z >= rhs.max.z;
+}
+
+BoundingBox BoundingBox::Transform(const NNMat4& mat) const
+{
+	if (IsEmpty())
+	{
+		return *this;
+	}
+	// 中心按仿射变换, 半长按矩阵元素的绝对值变换
+	const NNVec3 center = GetCenter();
+	const NNVec3 extent = GetExtent();
+	NNVec3 new_center, new_extent;
+	for (NNUInt row = 0; row < 3; ++row)
+	{
+		new_center[row] = mat[0][row] * center.x + mat[1][row] * center.y + mat[2][row] * center.z + mat[3][row];
+		new_extent[row] = fabsf(mat[0][row]) * extent.x + fabsf(mat[1][row]) * extent.y + fabsf(mat[2][row]) * extent.z;
+	}
+	return BoundingBox(new_center - new_extent, new_center + new_extent);
+}
+
+BoundingBox BoundingBox::Expand(const NNFloat margin) const
+{
+	return BoundingBox(min - NNVec3(margin), max + NNVec3(margin));
+}
+
+/** Frustum >>> */
+
+Frustum::Frustum()
+{
+	for (NNUInt i = 0; i < 8; ++i)
+	{
+		m_x[i] = m_y[i] = m_z[i] = 0.0f;
+		m_w[i] = 1.0f;
+	}
+	for (NNUInt i = 0; i < 6; ++i)
+	{
+		m_planes[i] = NNVec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+Frustum Frustum::FromMatrix(const NNMat4& view_proj)
+{
+	// Gribb-Hartmann: 行 3 加减行 0, 1, 2
+	Frustum result;
+	NNVec4 rows[4];
+	for (NNUInt row = 0; row < 4; ++row)
+	{
+		rows[row] = NNVec4(view_proj[0][row], view_proj[1][row], view_proj[2][row], view_proj[3][row]);
+	}
+	result.m_planes[0] = rows[3] + rows[0];
+	result.m_planes[1] = rows[3] - rows[0];
+	result.m_planes[2] = rows[3] + rows[1];
+	result.m_planes[3] = rows[3] - rows[1];
+	result.m_planes[4] = rows[3] + rows[2];
+	result.m_planes[5] = rows[3] - rows[2];
+	for (NNUInt i = 0; i < 6; ++i)
+	{
+		NNVec4& plane = result.m_planes[i];
+		const NNFloat length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (length > 0.0f)
+		{
+			plane = plane / length;
+		}
+		result.m_x[i] = plane.x;
+		result.m_y[i] = plane.y;
+		result.m_z[i] = plane.z;
+		result.m_w[i] = plane.w;
+	}
+	return result;
+}
+
+Frustum::Result Frustum::Test(const BoundingBox& box) const
+{
+	if (box.IsEmpty())
+	{
+		return OUTSIDE;
+	}
+	const NNVec3 center = box.GetCenter();
+	const NNVec3 extent = box.GetExtent();
+#if defined NN_FRUSTUM_SSE
+	const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	const __m128 ex = _mm_set1_ps(extent.x), ey = _mm_set1_ps(extent.y), ez = _mm_set1_ps(extent.z);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+	const __m128 zero = _mm_setzero_ps();
+	int outside = 0, intersect = 0;
+	for (NNUInt i = 0; i < 8; i += 4)
+	{
+		const __m128 nx = _mm_load_ps(m_x + i), ny = _mm_load_ps(m_y + i), nz = _mm_load_ps(m_z + i);
+		// 中心到平面的距离, 以及包围盒在法线方向上的投影半径
+		const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), _mm_load_ps(m_w + i)));
+		const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, abs_mask), ex), _mm_mul_ps(_mm_and_ps(ny, abs_mask), ey)),
+			_mm_mul_ps(_mm_and_ps(nz, abs_mask), ez));
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+		intersect |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), zero));
+	}
+	return outside != 0 ? OUTSIDE : (intersect != 0 ? INTERSECT : INSIDE);
+#else
+	Result result = INSIDE;
+	for (NNUInt i = 0; i < 6; ++i)
+	{
+		const NNFloat dist = m_x[i] * center.x + m_y[i] * center.y + m_z[i] * center.z + m_w[i];
+		const NNFloat radius = fabsf(m_x[i]) * extent.x + fabsf(m_y[i]) * extent.y + fabsf(m_z[i]) * extent.z;
+		if (dist + radius < 0.0f)
+		{
+			return OUTSIDE;
+		}
+		if (dist - radius < 0.0f)
+		{
+			result = INTERSECT;
+		}
+	}
+	return result;
+#endif
+}
+
+Frustum::Result Frustum::Test(const NNVec3& center, const NNFloat radius) const
+{
+#if defined NN_FRUSTUM_SSE
+	const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	const __m128 r = _mm_set1_ps(radius);
+	const __m128 zero = _mm_setzero_ps();
+	int outside = 0, intersect = 0;
+	for (NNUInt i = 0; i < 8; i += 4)
+	{
+		const __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(m_x + i), cx), _mm_mul_ps(_mm_load_ps(m_y + i), cy)),
+			_mm_add_ps(_mm_mul_ps(_mm_load_ps(m_z + i), cz), _mm_load_ps(m_w + i)));
+		outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, r), zero));
+		intersect |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, r), zero));
+	}
+	return outside != 0 ? OUTSIDE : (intersect != 0 ? INTERSECT : INSIDE);
+#else
+	Result result = INSIDE;
+	for (NNUInt i = 0; i < 6; ++i)
+	{
+		const NNFloat dist = m_x[i] * center.x + m_y[i] * center.y + m_z[i] * center.z + m_w[i];
+		if (dist + radius < 0.0f)
+		{
+			return OUTSIDE;
+		}
+		if (dist - radius < 0.0f)
+		{
+			result = INTERSECT;
+		}
+	}
+	return result;
+#endif
+}
@@ -0,0 +1,71 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "Types.h"
+
+//
+//    BoundingBox: Axis aligned bounding box, empty when min > max
+//
+
+struct BoundingBox
+{
+	NNVec3 min;
+	NNVec3 max;
+
+	BoundingBox();
+	BoundingBox(const NNVec3& min, const NNVec3& max);
+	// 按步长读取顶点位置 (前三个浮点数)
+	static BoundingBox FromPoints(const void* points, const NNUInt point_num, const NNUInt stride);
+	//
+	inline bool IsEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+	inline NNVec3 GetCenter() const { return (min + max) * 0.5f; }
+	inline NNVec3 GetExtent() const { return (max - min) * 0.5f; }
+	// 包围球半径
+	NNFloat GetRadius() const;
+	// 表面积, 用于层次包围盒的插入代价
+	NNFloat GetArea() const;
+	//
+	void Merge(const NNVec3& point);
+	void Merge(const BoundingBox& rhs);
+	bool Contains(const BoundingBox& rhs) const;
+	// 变换后的包围盒 (变换八个角点的包围盒)
+	BoundingBox Transform(const NNMat4& mat) const;
+	// 各方向扩大 margin
+	BoundingBox Expand(const NNFloat margin) const;
+};
+
+//
+//    Frustum: Six inward-facing planes extracted from a view-projection matrix
+//
+
+class Frustum
+{
+public:
+	enum Result
+	{
+		OUTSIDE = 0,
+		INTERSECT,
+		INSIDE,
+	};
+
+public:
+	Frustum();
+	// 平面法线指向视锥内部, 深度范围为 OpenGL 的 [-1, 1]
+	static Frustum FromMatrix(const NNMat4& view_proj);
+	// 同时测试六个平面, 支持 SSE 时每次四个
+	Result Test(const BoundingBox& box) const;
+	Result Test(const NNVec3& center, const NNFloat radius) const;
+	//
+	inline const NNVec4& GetPlane(const NNUInt i) const { return m_planes[i]; }
+
+private:
+	NNVec4 m_planes[6];
+	// 按分量连续存放的平面, 补齐到 8 个, 多出的两个永远通过
+	alignas(16) NNFloat m_x[8];
+	alignas(16) NNFloat m_y[8];
+	alignas(16) NNFloat m_z[8];
+	alignas(16) NNFloat m_w[8];
+};
+
+#endif // BOUNDS_H
@@ -73,6 +73,11 @@ void Camera::SetOrtho() {
 
 }
 
+Frustum Camera::GetFrustum() {
+	m_view_mat = NNCreateLookAt(m_position, m_position + m_front, m_up);
+	return Frustum::FromMatrix(m_proj_mat * m_view_mat);
+}
+
 void Camera::Use() {
 	// 更新View矩阵
 	m_view_mat = NNCreateLookAt(m_position, m_position + m_front, m_up);
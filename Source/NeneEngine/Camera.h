@@ -6,6 +6,7 @@
 
 #include "Utils.h"
 #include "NeneCB.h"
+#include "Bounds.h"
 
 //
 //    Camera: Mange View Point Class
@@ -42,6 +43,8 @@ public:
 	inline NNMat4& GetProjMat() { return m_proj_mat; }
 	inline NNMat4& GetInversedViewMat() { m_inv_view_mat = NNMat4Inverse(m_view_mat); return m_inv_view_mat; }
 	inline NNMat4& GetInversedProjMat() { m_inv_proj_mat = NNMat4Inverse(m_proj_mat); return m_inv_proj_mat; }
+	// 当前位置和朝向的视锥平面
+	Frustum GetFrustum();
 private:
 	//
 	NNMat4 m_view_mat;
@@ -0,0 +1,72 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <algorithm>
+#include "CommandStream.h"
+
+using namespace std;
+
+CommandStream::CommandStream() : m_capacity(0), m_size(0), m_command_num(0)
+{}
+
+CommandStream::~CommandStream()
+{}
+
+shared_ptr<CommandStream> CommandStream::Create(const size_t capacity)
+{
+	CommandStream* result = new CommandStream();
+	result->m_capacity = max((capacity + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, ALIGNMENT);
+	result->m_buffer.reset(new NNByte[result->m_capacity]);
+	return shared_ptr<CommandStream>(result);
+}
+
+NNByte* CommandStream::Allocate(void (*replay)(NNByte* command), const size_t size)
+{
+	//
+	const size_t aligned = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	if (m_size + aligned > m_capacity)
+	{
+		// 命令都可以按字节拷贝, 直接搬到新的缓冲
+		const size_t capacity = max(m_capacity * 2, m_size + aligned);
+		NNByte* buffer = new NNByte[capacity];
+		memcpy(buffer, m_buffer.get(), m_size);
+		m_buffer.reset(buffer);
+		m_capacity = capacity;
+	}
+	NNByte* command = m_buffer.get() + m_size;
+	Header* header = (Header*)command;
+	header->replay = replay;
+	header->size = aligned;
+	m_size += aligned;
+	m_command_num += 1;
+	return command;
+}
+
+void CommandStream::RecordCall(function<void()>&& call)
+{
+	m_calls.push_back(move(call));
+	Record(&CommandStream::Call, this, (NNUInt)m_calls.size() - 1);
+}
+
+void CommandStream::Call(const NNUInt index)
+{
+	m_calls[index]();
+}
+
+void CommandStream::Execute()
+{
+	for (size_t offset = 0; offset < m_size;)
+	{
+		NNByte* command = m_buffer.get() + offset;
+		const Header* header = (const Header*)command;
+		offset += header->size;
+		header->replay(command);
+	}
+	Clear();
+}
+
+void CommandStream::Clear()
+{
+	m_size = 0;
+	m_command_num = 0;
+	m_calls.clear();
+}
@@ -0,0 +1,124 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef COMMAND_STREAM_H
+#define COMMAND_STREAM_H
+
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <new>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "Types.h"
+
+//
+//    CommandStream: A compact linear buffer of recorded calls, replayed in order on the render thread
+//
+
+class CommandStream
+{
+public:
+	static std::shared_ptr<CommandStream> Create(const size_t capacity = 256 * 1024);
+	~CommandStream();
+	// 录制一次调用: 函数 (或成员函数和对象指针) 与参数按值保存; 参数必须可以按字节拷贝, 不能引用会被销毁的对象
+	template<typename F, typename... Args>
+	void Record(F function, Args... args);
+	// 录制一次带数据的调用, 数据在录制时拷贝, 回放时以 (args..., 数据地址, 大小) 调用
+	template<typename F, typename... Args>
+	void RecordData(F function, const void* data, const size_t size, Args... args);
+	// 不常用的操作 (释放资源, 需要拷贝容器的绘制) 保存为函数对象
+	void RecordCall(std::function<void()>&& call);
+	// 按录制顺序执行后清空
+	void Execute();
+	void Clear();
+	//
+	inline NNUInt GetCommandNum() const { return m_command_num; }
+	inline size_t GetBytes() const { return m_size; }
+
+private:
+	// 每条命令以回放函数和总长度开头, 按 16 字节对齐
+	struct Header
+	{
+		void (*replay)(NNByte* command);
+		size_t size;
+	};
+	static constexpr size_t ALIGNMENT = 16;
+	template<typename F, typename... Args>
+	struct Command
+	{
+		Header header;
+		F function;
+		std::tuple<Args...> args;
+		static void Replay(NNByte* command);
+	};
+	template<typename F, typename... Args>
+	struct DataCommand
+	{
+		Header header;
+		F function;
+		std::tuple<Args...> args;
+		size_t data_size;
+		static void Replay(NNByte* command);
+	};
+	// 分配对齐后的命令空间, 写入回放函数和长度
+	NNByte* Allocate(void (*replay)(NNByte* command), const size_t size);
+	// 回放 RecordCall 保存的函数对象
+	void Call(const NNUInt index);
+
+private:
+	std::unique_ptr<NNByte[]> m_buffer;
+	size_t m_capacity;
+	size_t m_size;
+	NNUInt m_command_num;
+	std::vector<std::function<void()>> m_calls;
+
+private:
+	CommandStream();
+	CommandStream(const CommandStream& rhs) = delete;
+	CommandStream& operator=(const CommandStream& rhs) = delete;
+};
+
+template<typename F, typename... Args>
+void CommandStream::Command<F, Args...>::Replay(NNByte* command)
+{
+	Command& self = *(Command*)command;
+	std::apply([&self](const Args&... args) { std::invoke(self.function, args...); }, self.args);
+}
+
+template<typename F, typename... Args>
+void CommandStream::DataCommand<F, Args...>::Replay(NNByte* command)
+{
+	DataCommand& self = *(DataCommand*)command;
+	const void* data = command + (sizeof(DataCommand) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	std::apply([&self, data](const Args&... args) { std::invoke(self.function, args..., data, self.data_size); }, self.args);
+}
+
+template<typename F, typename... Args>
+void CommandStream::Record(F function, Args... args)
+{
+	typedef Command<F, Args...> Type;
+	static_assert((std::is_trivially_copyable<Args>::value && ...), "Recorded arguments must be trivially copyable.");
+	Type* command = (Type*)Allocate(&Type::Replay, sizeof(Type));
+	new (&command->function) F(function);
+	new (&command->args) std::tuple<Args...>(args...);
+}
+
+template<typename F, typename... Args>
+void CommandStream::RecordData(F function, const void* data, const size_t size, Args... args)
+{
+	typedef DataCommand<F, Args...> Type;
+	static_assert((std::is_trivially_copyable<Args>::value && ...), "Recorded arguments must be trivially copyable.");
+	const size_t head = (sizeof(Type) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	NNByte* memory = Allocate(&Type::Replay, head + size);
+	Type* command = (Type*)memory;
+	new (&command->function) F(function);
+	new (&command->args) std::tuple<Args...>(args...);
+	command->data_size = size;
+	if (size > 0)
+	{
+		memcpy(memory + head, data, size);
+	}
+}
+
+#endif // COMMAND_STREAM_H
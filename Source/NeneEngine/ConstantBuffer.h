@@ -3,9 +3,10 @@
 #define CONSTANT_BUFFER_H
 
 #include "Utils.h"
+#include "UniformPool.h"
 
 //
-//  ConstantBuffer: Manage Uniform Buffer Object in GL or Constant Buffer in D3D
+//  ConstantBuffer: Manage a typed view of UniformPool in GL or Constant Buffer in D3D
 //
 
 template<typename T, std::size_t N=1>
@@ -29,7 +30,7 @@ private:
 	ConstantBuffer& operator=(const ConstantBuffer& rhs);
 	// 缓冲指针
 #if defined NENE_GL
-	GLuint m_UBO;
+	UniformPool::Block m_block;
 #elif defined NENE_DX
 	ID3D11Buffer* mpBuffer;
 #endif
@@ -3,11 +3,12 @@
 #define CONSTANT_BUFFER_POOL_H
 
 #include "Utils.h"
+#include "UniformPool.h"
 #include <vector>
 #include <type_traits>
 
 //
-//  ConstantBufferPool:
+//  ConstantBufferPool: Variables appended at runtime with std140 layout, stored in a block of UniformPool
 //
 
 class ConstantBufferPool {
@@ -22,8 +23,8 @@ public:
 	inline size_t size(const NNUInt& idx) { return mSizes[idx]; }
 	// 写入数据
 	void writeRaw(const NNUInt& idx, const void* data);
-	// 增加数据
-	size_t appendRaw(const NNUInt& size, const void* data = nullptr);
+	// 增加数据, 按 std140 的基准对齐 (alignment 为 0 时由大小推断: 4, 8, 16)
+	size_t appendRaw(const NNUInt& size, const void* data = nullptr, const NNUInt& alignment = 0);
 	// 更新数据
 	void Update(const NNUInt& slot);
 
@@ -53,26 +54,20 @@ public:
 	size_t inline append(const T& data) { return appendRaw(sizeof(T), &data); }
 
 private:
-	// 重新分配
-	void reallocate(const size_t& newCapacity);
+	// 重新分配, 旧数据拷贝到新的块
+	void reallocate(const NNUInt& newCapacity);
 	// 禁止拷贝
 	ConstantBufferPool(const ConstantBufferPool& rhs);
 	ConstantBufferPool& operator=(const ConstantBufferPool& rhs);
 private:
-	// 内存数据
-	NNByte* mBuffer;
-	// 实际申请的容量
-	size_t mCapacity;
+	// 池中的块, 容量即块大小
+	UniformPool::Block mBlock;
+	// 已使用的大小
+	NNUInt mUsed;
 	// 每一段数据大小
 	std::vector<NNUInt> mSizes;
 	// 每一段数据偏移
 	std::vector<NNUInt> mOffsets;
-	// 缓冲指针
-#if defined NENE_GL
-	GLuint mUBO;
-#elif defined NENE_DX
-	ID3D11Buffer* mpBuffer;
-#endif
 };
 
 
@@ -1,6 +1,7 @@
 ﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 #ifdef NENE_GL
 
+#include <cstring>
 #include "Debug.h"
 #include "Utils.h"
 #include "ConstantBufferPool.h"
@@ -10,41 +11,46 @@ using namespace std;
 ConstantBufferPool::ConstantBufferPool() 
 {
 	//
-	mUBO = 0;
-	mCapacity = 0;
-	mBuffer = nullptr;
+	mUsed = 0;
+	mBlock = { 0, 0, 0 };
 	//
 	reallocate(16);
 }
 
 ConstantBufferPool::~ConstantBufferPool() 
 {
-	if (mUBO != 0)
-	{
-		glDeleteBuffers(1, &mUBO);
-		mUBO = 0;
-	}
+	UniformPool::Instance().Free(mBlock);
 }
 
-size_t ConstantBufferPool::appendRaw(const NNUInt& size, const void* data)
+size_t ConstantBufferPool::appendRaw(const NNUInt& size, const void* data, const NNUInt& alignment)
 {
-	// 计算已经使用的大小
-	NNUInt used = 0;
-	if (!mOffsets.empty())
+	// std140: 标量 4, vec2 8, vec3 / vec4 16
+	NNUInt align = alignment;
+	if (align == 0)
 	{
-		used = mOffsets.back() + mSizes.back();
+		align = size <= 4 ? 4 : (size <= 8 ? 8 : 16);
 	}
+	NNUInt offset = (mUsed + align - 1) / align * align;
 	// 如果不够用 重新申请内存
-	if (used + size > mCapacity)
+	if (offset + size > mBlock.size)
 	{
-		reallocate(mCapacity * 2);
+		NNUInt capacity = mBlock.size;
+		while (offset + size > capacity)
+		{
+			capacity *= 2;
+		}
+		reallocate(capacity);
 	}
 	// 存储新的数据的大小和偏移
 	size_t idx = mSizes.size();
 	mSizes.push_back(size);
-	mOffsets.push_back(used);
+	mOffsets.push_back(offset);
+	mUsed = offset + size;
 	// 写入新的数据
-	memcpy(mBuffer + used, data, size);
+	if (data != nullptr)
+	{
+		UniformPool::Instance().Write(mBlock, data, offset, size);
+	}
 	//
 	return idx;
 }
@@ -54,56 +60,29 @@ void ConstantBufferPool::writeRaw(const NNUInt& idx, const void* data)
 	if (idx >= mOffsets.size())
 	{
 		dLog("Invalid offset.");
+		return;
 	}
-	NNUInt size = mSizes[idx];
-	NNUInt offset = mOffsets[idx];
-	memcpy(mBuffer + offset, data, size);
+	UniformPool::Instance().Write(mBlock, data, mOffsets[idx], mSizes[idx]);
 }
 
 void ConstantBufferPool::Update(const NNUInt& slot)
 {
-	//
-	static size_t total = 0;
-	if (mOffsets.empty())
-	{
-		total = 0;
-	}
-	else
-	{
-		total = mOffsets.back() + mSizes.back();
-	}
-	// 更新数据
-	glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
-		GLvoid *pData = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-		memcpy(pData, mBuffer, total);
-		glUnmapBuffer(GL_UNIFORM_BUFFER);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
-	// 绑定到某个 Slot 中
-	glBindBufferBase(GL_UNIFORM_BUFFER, slot, mUBO);
+	// 只上传写入过的区间; 绑定大小按 vec4 补齐
+	NNUInt size = max((mUsed + 15) / 16 * 16, 16u);
+	UniformPool::Instance().Bind(mBlock, slot, min(size, mBlock.size));
 }
 
-void ConstantBufferPool::reallocate(const size_t& newCapacity)
+void ConstantBufferPool::reallocate(const NNUInt& newCapacity)
 {
 	//
-	NNByte* newBuffer = new NNByte[newCapacity];
-	memset(newBuffer, 0xffff, newCapacity);
-	if (mBuffer != nullptr)
-	{
-		memcpy(newBuffer, mBuffer, mCapacity);
-		delete mBuffer;
-	}
-	mBuffer = newBuffer;
-	mCapacity = newCapacity;
-	//
-	if (mUBO != 0)
+	UniformPool& pool = UniformPool::Instance();
+	UniformPool::Block block = pool.Allocate(newCapacity);
+	if (mBlock.IsValid())
 	{
-		glDeleteBuffers(1, &mUBO);
+		pool.Write(block, pool.Data(mBlock), 0, mUsed);
+		pool.Free(mBlock);
 	}
-	//
-	glGenBuffers(1, &mUBO);
-	glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
-		glBufferData(GL_UNIFORM_BUFFER, mCapacity, mBuffer, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	mBlock = block;
 }
 
-#endif // NENE_GL
\ No newline at end of file
+#endif // NENE_GL
@@ -7,32 +7,22 @@
 
 template<typename T, std::size_t N>
 ConstantBuffer<T, N>::ConstantBuffer() {
-	m_UBO = 0;
-	// 申请UBO显存
-	glGenBuffers(1, &m_UBO);
-	// 写入数据
-	glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(T) * N, &m_datas, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// 从共享的 Arena 中分配, 多个小常量缓冲共用一个 UBO
+	m_block = UniformPool::Instance().Allocate(sizeof(m_datas));
 }
 
 template<typename T, std::size_t N>
 ConstantBuffer<T, N>::~ConstantBuffer() {
-	if (m_UBO != 0) {
-		glDeleteBuffers(1, &m_UBO);
-	}
+	UniformPool::Instance().Free(m_block);
 }
 
 template<typename T, std::size_t N>
 void ConstantBuffer<T, N>::Update(const NNUInt& slot) {
-	// 更新数据
-	glBindBuffer(GL_UNIFORM_BUFFER, m_UBO);
-		GLvoid *p_data = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-		memcpy(p_data, &m_datas, sizeof(m_datas) * N);
-		glUnmapBuffer(GL_UNIFORM_BUFFER);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// 更新数据: 只记录脏区间, 绑定时和同一 Arena 的其他写入一起上传
+	UniformPool& pool = UniformPool::Instance();
+	pool.Write(m_block, m_datas, 0, sizeof(m_datas));
 	// 绑定到某个 Slot 中
-	glBindBufferBase(GL_UNIFORM_BUFFER, slot, m_UBO);
+	pool.Bind(m_block, slot);
 }
 
 #endif // CONSTANT_BUFFER_GL_INL
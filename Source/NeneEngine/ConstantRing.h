@@ -0,0 +1,60 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef CONSTANT_RING_H
+#define CONSTANT_RING_H
+
+#include <array>
+
+#include "Types.h"
+
+//
+//    ConstantRing: A singleton persistently mapped ring sub-allocating per-draw constants, fenced per frame
+//
+
+class ConstantRing
+{
+public:
+	// 获取单例
+	static ConstantRing& Instance();
+	// 拷贝到当前帧的区域并绑定到 slot, 不需要 map / unmap
+	void Bind(const NNUInt slot, const void* data, const size_t size);
+	template<typename T>
+	inline void Bind(const NNUInt slot, const T& data) { Bind(slot, &data, sizeof(T)); }
+	// 帧结束时调用: 围栏保护本帧的数据, 切换到下一帧的区域, 由 Utils::SwapBuffers 调用
+	void EndFrame();
+	// 释放图形资源, 由 Utils::Terminate 调用
+	void Release();
+	// 每帧区域的初始大小, 不够时翻倍
+	void SetFrameCapacity(const size_t bytes);
+	//
+	inline size_t GetFrameBytes() const { return m_offset; }
+	inline NNUInt GetFrameAllocations() const { return m_allocations; }
+	inline bool IsPersistent() const { return m_mapped != nullptr; }
+
+public:
+	~ConstantRing();
+
+private:
+	void Allocate(const size_t frame_capacity);
+
+private:
+	static const NNUInt FRAME_NUM = 3;
+	size_t m_frame_capacity;
+	// 当前帧的区域和写入位置
+	NNUInt m_frame;
+	size_t m_offset;
+	NNUInt m_allocations;
+	// 持久映射的地址, 不支持 glBufferStorage 时为空, 改用 glBufferSubData
+	NNByte* m_mapped;
+#if defined NENE_GL
+	GLuint m_buffer;
+	GLint m_alignment;
+	std::array<GLsync, FRAME_NUM> m_fences;
+#endif
+
+private:
+	ConstantRing();
+	ConstantRing(const ConstantRing& rhs) = delete;
+	ConstantRing& operator=(const ConstantRing& rhs) = delete;
+};
+
+#endif // CONSTANT_RING_H
@@ -0,0 +1,157 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <cstring>
+#include <algorithm>
+#include "Debug.h"
+#include "ConstantRing.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+// 默认每帧 1MB, 256 字节对齐时可以容纳 4096 次绘制
+static const size_t DEFAULT_FRAME_CAPACITY = 1 << 20;
+// 等待围栏的超时 (纳秒)
+static const GLuint64 RING_FENCE_TIMEOUT = 1000000000;
+
+// 渲染线程运行时在执行到这次绘制时才写入, 录制时数据先拷贝到命令流
+static void WriteConstants(const GLuint buffer, NNByte* mapped, const size_t offset, const void* data, const size_t size)
+{
+	RenderStats::Add(NN_COUNTER_UNIFORM_BYTES, size);
+	if (mapped != nullptr)
+	{
+		memcpy(mapped + offset, data, size);
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+}
+
+ConstantRing::ConstantRing() :
+	m_frame_capacity(DEFAULT_FRAME_CAPACITY), m_frame(0), m_offset(0), m_allocations(0), m_mapped(nullptr), m_buffer(0), m_alignment(256), m_fences()
+{}
+
+ConstantRing::~ConstantRing()
+{
+	// 单例析构时上下文已经销毁, 图形资源由 Release 释放
+}
+
+ConstantRing& ConstantRing::Instance()
+{
+	static ConstantRing instance;
+	return instance;
+}
+
+void ConstantRing::SetFrameCapacity(const size_t bytes)
+{
+	m_frame_capacity = bytes;
+	if (m_buffer != 0)
+	{
+		Allocate(bytes);
+	}
+}
+
+void ConstantRing::Allocate(const size_t frame_capacity)
+{
+	// 旧缓冲上还没执行的绘制由驱动保证数据有效
+	NN_RENDER_THREAD_FORWARD(Allocate(frame_capacity));
+	Release();
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+	m_alignment = max(m_alignment, 1);
+	m_frame_capacity = (frame_capacity + m_alignment - 1) / m_alignment * m_alignment;
+	//
+	const size_t total = m_frame_capacity * FRAME_NUM;
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	if (GLEW_ARB_buffer_storage)
+	{
+		// 持久 + 一致映射: 写入后不需要刷新, 由围栏保证 GPU 读完之前不会覆盖
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, total, nullptr, flags);
+		m_mapped = (NNByte*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, total, flags);
+	}
+	else
+	{
+		glBufferData(GL_UNIFORM_BUFFER, total, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	if (m_mapped == nullptr)
+	{
+		dLog("[Info] Persistent mapping is not available, constant ring falls back to glBufferSubData.");
+	}
+}
+
+void ConstantRing::Bind(const NNUInt slot, const void* data, const size_t size)
+{
+	//
+	if (m_buffer == 0)
+	{
+		Allocate(m_frame_capacity);
+	}
+	const size_t aligned = (size + m_alignment - 1) / m_alignment * m_alignment;
+	if (m_offset + aligned > m_frame_capacity)
+	{
+		dLog("[Info] Constant ring is full (%zd draws), grows to %zd bytes per frame.", (size_t)m_allocations, m_frame_capacity * 2);
+		Allocate(max(m_frame_capacity * 2, aligned));
+	}
+	// 写入当前帧的区域
+	const size_t offset = m_frame * m_frame_capacity + m_offset;
+	RenderThread::RecordData(&WriteConstants, data, size, m_buffer, m_mapped, offset);
+	RenderContext::instance().bindUniformBuffer(slot, m_buffer, offset, size);
+	//
+	m_offset += aligned;
+	m_allocations += 1;
+}
+
+void ConstantRing::EndFrame()
+{
+	//
+	if (m_buffer == 0)
+	{
+		return;
+	}
+	const NNUInt last = m_frame;
+	m_frame = (m_frame + 1) % FRAME_NUM;
+	m_offset = 0;
+	m_allocations = 0;
+	// 围栏只在执行图形调用的线程上创建和等待
+	RenderThread::Record([](ConstantRing* ring, const NNUInt last_frame, const NNUInt next_frame) {
+		GLsync& next = ring->m_fences[next_frame];
+		ring->m_fences[last_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		// 等待 GPU 读完 FRAME_NUM 帧之前写入这块区域的数据
+		if (next != nullptr)
+		{
+			glClientWaitSync(next, GL_SYNC_FLUSH_COMMANDS_BIT, RING_FENCE_TIMEOUT);
+			glDeleteSync(next);
+			next = nullptr;
+		}
+	}, this, last, m_frame);
+}
+
+void ConstantRing::Release()
+{
+	NN_RENDER_THREAD_FORWARD(Release());
+	for (GLsync& fence : m_fences)
+	{
+		if (fence != nullptr) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	// 删除缓冲时映射自动解除
+	if (m_buffer != 0)
+	{
+		RenderContext::instance().forgetBuffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_mapped = nullptr;
+	m_frame = 0;
+	m_offset = 0;
+	m_allocations = 0;
+}
+
+#endif // NENE_GL
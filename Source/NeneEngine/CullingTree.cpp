@@ -0,0 +1,430 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <algorithm>
+#include "Camera.h"
+#include "Drawable.h"
+#include "CullingTree.h"
+
+using namespace std;
+
+static BoundingBox Union(const BoundingBox& a, const BoundingBox& b)
+{
+	BoundingBox result = a;
+	result.Merge(b);
+	return result;
+}
+
+CullingTree::CullingTree(const NNFloat margin) : m_margin(margin), m_root(NULL_NODE), m_free_list(NULL_NODE), m_stats({ 0, 0, 0, 0, 0 })
+{}
+
+CullingTree::~CullingTree()
+{}
+
+shared_ptr<CullingTree> CullingTree::Create(const NNFloat margin)
+{
+	return shared_ptr<CullingTree>(new CullingTree(margin));
+}
+
+NNInt CullingTree::AllocateNode()
+{
+	NNInt node = m_free_list;
+	if (node != NULL_NODE)
+	{
+		m_free_list = m_nodes[node].parent;
+	}
+	else
+	{
+		node = (NNInt)m_nodes.size();
+		m_nodes.emplace_back();
+	}
+	Node& result = m_nodes[node];
+	result.bounds = BoundingBox();
+	result.parent = result.child1 = result.child2 = NULL_NODE;
+	result.height = 0;
+	result.object = 0;
+	return node;
+}
+
+void CullingTree::FreeNode(const NNInt node)
+{
+	m_nodes[node].parent = m_free_list;
+	m_nodes[node].height = -1;
+	m_free_list = node;
+}
+
+void CullingTree::InsertLeaf(const NNInt leaf)
+{
+	if (m_root == NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = NULL_NODE;
+		return;
+	}
+	// 按表面积代价向下找兄弟节点
+	const BoundingBox bounds = m_nodes[leaf].bounds;
+	NNInt index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		const Node& node = m_nodes[index];
+		const NNFloat area = node.bounds.GetArea();
+		const NNFloat combined_area = Union(node.bounds, bounds).GetArea();
+		// 在这里新建父节点的代价, 以及继续向下时祖先增加的代价
+		const NNFloat cost = 2.0f * combined_area;
+		const NNFloat inheritance = 2.0f * (combined_area - area);
+		NNFloat child_costs[2];
+		const NNInt children[2] = { node.child1, node.child2 };
+		for (NNUInt i = 0; i < 2; ++i)
+		{
+			const Node& child = m_nodes[children[i]];
+			const NNFloat merged_area = Union(child.bounds, bounds).GetArea();
+			child_costs[i] = (child.IsLeaf() ? merged_area : merged_area - child.bounds.GetArea()) + inheritance;
+		}
+		if (cost < child_costs[0] && cost < child_costs[1])
+		{
+			break;
+		}
+		index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+	}
+	// 新的父节点替换兄弟节点的位置
+	const NNInt sibling = index;
+	const NNInt old_parent = m_nodes[sibling].parent;
+	const NNInt new_parent = AllocateNode();
+	m_nodes[new_parent].parent = old_parent;
+	m_nodes[new_parent].bounds = Union(bounds, m_nodes[sibling].bounds);
+	m_nodes[new_parent].height = m_nodes[sibling].height + 1;
+	m_nodes[new_parent].child1 = sibling;
+	m_nodes[new_parent].child2 = leaf;
+	m_nodes[sibling].parent = new_parent;
+	m_nodes[leaf].parent = new_parent;
+	if (old_parent != NULL_NODE)
+	{
+		if (m_nodes[old_parent].child1 == sibling)
+		{
+			m_nodes[old_parent].child1 = new_parent;
+		}
+		else
+		{
+			m_nodes[old_parent].child2 = new_parent;
+		}
+	}
+	else
+	{
+		m_root = new_parent;
+	}
+	FixUpwards(m_nodes[leaf].parent);
+}
+
+void CullingTree::RemoveLeaf(const NNInt leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NULL_NODE;
+		return;
+	}
+	// 兄弟节点替换父节点
+	const NNInt parent = m_nodes[leaf].parent;
+	const NNInt grand_parent = m_nodes[parent].parent;
+	const NNInt sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+	if (grand_parent != NULL_NODE)
+	{
+		if (m_nodes[grand_parent].child1 == parent)
+		{
+			m_nodes[grand_parent].child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grand_parent].child2 = sibling;
+		}
+		m_nodes[sibling].parent = grand_parent;
+		FreeNode(parent);
+		FixUpwards(grand_parent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void CullingTree::FixUpwards(NNInt node)
+{
+	while (node != NULL_NODE)
+	{
+		node = Balance(node);
+		Node& current = m_nodes[node];
+		const Node& child1 = m_nodes[current.child1];
+		const Node& child2 = m_nodes[current.child2];
+		current.height = 1 + max(child1.height, child2.height);
+		current.bounds = Union(child1.bounds, child2.bounds);
+		node = current.parent;
+	}
+}
+
+NNInt CullingTree::Balance(const NNInt a)
+{
+	Node& A = m_nodes[a];
+	if (A.IsLeaf() || A.height < 2)
+	{
+		return a;
+	}
+	const NNInt b = A.child1, c = A.child2;
+	Node& B = m_nodes[b];
+	Node& C = m_nodes[c];
+	const NNInt balance = C.height - B.height;
+	// C 提升为子树的根
+	if (balance > 1)
+	{
+		const NNInt f = C.child1, g = C.child2;
+		Node& F = m_nodes[f];
+		Node& G = m_nodes[g];
+		C.child1 = a;
+		C.parent = A.parent;
+		A.parent = c;
+		if (C.parent != NULL_NODE)
+		{
+			if (m_nodes[C.parent].child1 == a)
+			{
+				m_nodes[C.parent].child1 = c;
+			}
+			else
+			{
+				m_nodes[C.parent].child2 = c;
+			}
+		}
+		else
+		{
+			m_root = c;
+		}
+		// 较高的孙节点留在 C 下
+		if (F.height > G.height)
+		{
+			C.child2 = f;
+			A.child2 = g;
+			G.parent = a;
+			A.bounds = Union(B.bounds, G.bounds);
+			C.bounds = Union(A.bounds, F.bounds);
+			A.height = 1 + max(B.height, G.height);
+			C.height = 1 + max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = g;
+			A.child2 = f;
+			F.parent = a;
+			A.bounds = Union(B.bounds, F.bounds);
+			C.bounds = Union(A.bounds, G.bounds);
+			A.height = 1 + max(B.height, F.height);
+			C.height = 1 + max(A.height, G.height);
+		}
+		return c;
+	}
+	// B 提升为子树的根
+	if (balance < -1)
+	{
+		const NNInt d = B.child1, e = B.child2;
+		Node& D = m_nodes[d];
+		Node& E = m_nodes[e];
+		B.child1 = a;
+		B.parent = A.parent;
+		A.parent = b;
+		if (B.parent != NULL_NODE)
+		{
+			if (m_nodes[B.parent].child1 == a)
+			{
+				m_nodes[B.parent].child1 = b;
+			}
+			else
+			{
+				m_nodes[B.parent].child2 = b;
+			}
+		}
+		else
+		{
+			m_root = b;
+		}
+		if (D.height > E.height)
+		{
+			B.child2 = d;
+			A.child1 = e;
+			E.parent = a;
+			A.bounds = Union(C.bounds, E.bounds);
+			B.bounds = Union(A.bounds, D.bounds);
+			A.height = 1 + max(C.height, E.height);
+			B.height = 1 + max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = e;
+			A.child1 = d;
+			D.parent = a;
+			A.bounds = Union(C.bounds, D.bounds);
+			B.bounds = Union(A.bounds, E.bounds);
+			A.height = 1 + max(C.height, D.height);
+			B.height = 1 + max(A.height, E.height);
+		}
+		return b;
+	}
+	return a;
+}
+
+void CullingTree::Add(const shared_ptr<Drawable>& drawable)
+{
+	if (drawable == nullptr || m_indices.count(drawable.get()) != 0)
+	{
+		return;
+	}
+	const NNUInt object = (NNUInt)m_objects.size();
+	m_objects.push_back({ drawable, NULL_NODE, drawable->GetBoundsVersion() });
+	m_indices[drawable.get()] = object;
+	UpdateObject(object);
+}
+
+void CullingTree::Remove(const shared_ptr<Drawable>& drawable)
+{
+	auto it = m_indices.find(drawable.get());
+	if (it == m_indices.end())
+	{
+		return;
+	}
+	const NNUInt object = it->second;
+	m_indices.erase(it);
+	if (m_objects[object].leaf != NULL_NODE)
+	{
+		RemoveLeaf(m_objects[object].leaf);
+		FreeNode(m_objects[object].leaf);
+	}
+	// 最后一个物体移到空位
+	const NNUInt last = (NNUInt)m_objects.size() - 1;
+	if (object != last)
+	{
+		m_objects[object] = move(m_objects[last]);
+		m_indices[m_objects[object].drawable.get()] = object;
+		if (m_objects[object].leaf != NULL_NODE)
+		{
+			m_nodes[m_objects[object].leaf].object = object;
+		}
+	}
+	m_objects.pop_back();
+}
+
+void CullingTree::Clear()
+{
+	m_nodes.clear();
+	m_objects.clear();
+	m_indices.clear();
+	m_root = NULL_NODE;
+	m_free_list = NULL_NODE;
+}
+
+void CullingTree::UpdateObject(const NNUInt object)
+{
+	Object& target = m_objects[object];
+	const BoundingBox bounds = target.drawable->GetWorldBounds();
+	target.version = target.drawable->GetBoundsVersion();
+	if (bounds.IsEmpty())
+	{
+		if (target.leaf != NULL_NODE)
+		{
+			RemoveLeaf(target.leaf);
+			FreeNode(target.leaf);
+			target.leaf = NULL_NODE;
+			++m_stats.reinserts;
+		}
+		return;
+	}
+	if (target.leaf != NULL_NODE)
+	{
+		// 仍在扩大的包围盒内, 并且没有缩小太多
+		const BoundingBox& fat = m_nodes[target.leaf].bounds;
+		if (fat.Contains(bounds) && bounds.Expand(4.0f * m_margin).Contains(fat))
+		{
+			return;
+		}
+		RemoveLeaf(target.leaf);
+	}
+	else
+	{
+		target.leaf = AllocateNode();
+		m_nodes[target.leaf].object = object;
+	}
+	m_nodes[target.leaf].bounds = bounds.Expand(m_margin);
+	InsertLeaf(target.leaf);
+	++m_stats.reinserts;
+}
+
+void CullingTree::Refit()
+{
+	m_stats.reinserts = 0;
+	for (NNUInt i = 0; i < m_objects.size(); ++i)
+	{
+		if (m_objects[i].version != m_objects[i].drawable->GetBoundsVersion())
+		{
+			UpdateObject(i);
+		}
+	}
+}
+
+void CullingTree::CollectLeaves(const NNInt node, vector<Drawable*>& visible)
+{
+	const Node& current = m_nodes[node];
+	if (current.IsLeaf())
+	{
+		visible.push_back(m_objects[current.object].drawable.get());
+		return;
+	}
+	CollectLeaves(current.child1, visible);
+	CollectLeaves(current.child2, visible);
+}
+
+void CullingTree::Cull(const Frustum& frustum, vector<Drawable*>& visible)
+{
+	visible.clear();
+	m_stats.objects = (NNUInt)m_objects.size();
+	m_stats.node_tests = 0;
+	// 没有包围盒的物体总是可见
+	for (const Object& object : m_objects)
+	{
+		if (object.leaf == NULL_NODE)
+		{
+			visible.push_back(object.drawable.get());
+		}
+	}
+	if (m_root != NULL_NODE)
+	{
+		vector<NNInt> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+		while (!stack.empty())
+		{
+			const NNInt node = stack.back();
+			stack.pop_back();
+			++m_stats.node_tests;
+			const Node& current = m_nodes[node];
+			const Frustum::Result result = frustum.Test(current.bounds);
+			if (result == Frustum::OUTSIDE)
+			{
+				continue;
+			}
+			if (result == Frustum::INSIDE || current.IsLeaf())
+			{
+				CollectLeaves(node, visible);
+				continue;
+			}
+			stack.push_back(current.child1);
+			stack.push_back(current.child2);
+		}
+	}
+	m_stats.visible = (NNUInt)visible.size();
+	m_stats.culled = m_stats.objects - m_stats.visible;
+}
+
+void CullingTree::Cull(const shared_ptr<Camera>& camera, vector<Drawable*>& visible)
+{
+	Cull(camera->GetFrustum(), visible);
+}
+
+NNUInt CullingTree::GetHeight() const
+{
+	return m_root != NULL_NODE ? (NNUInt)m_nodes[m_root].height : 0;
+}
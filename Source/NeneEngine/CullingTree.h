@@ -0,0 +1,100 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef CULLING_TREE_H
+#define CULLING_TREE_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "Types.h"
+#include "Bounds.h"
+
+class Camera;
+class Drawable;
+
+//
+//    CullingTree: Dynamic AABB tree over drawables, refitted incrementally and queried against a frustum
+//
+
+class CullingTree
+{
+public:
+	// 上一次 Refit / Cull 的统计
+	struct Stats
+	{
+		NNUInt objects;
+		NNUInt visible;
+		NNUInt culled;
+		NNUInt node_tests;
+		NNUInt reinserts;
+	};
+	static const NNInt NULL_NODE = -1;
+
+public:
+	// 叶子保存扩大 margin 后的包围盒, 物体在其中移动时不需要改动树
+	static std::shared_ptr<CullingTree> Create(const NNFloat margin = 0.1f);
+	~CullingTree();
+	// 没有包围盒的物体不参与剔除, 总是可见
+	void Add(const std::shared_ptr<Drawable>& drawable);
+	void Remove(const std::shared_ptr<Drawable>& drawable);
+	void Clear();
+	// 只更新变换或包围盒改变过的物体, 移出扩大包围盒时才重新插入
+	void Refit();
+	// 可见物体写入 visible (会先清空); 完全在视锥内的子树不再逐个测试
+	void Cull(const Frustum& frustum, std::vector<Drawable*>& visible);
+	void Cull(const std::shared_ptr<Camera>& camera, std::vector<Drawable*>& visible);
+	//
+	inline NNUInt GetObjectNum() const { return (NNUInt)m_objects.size(); }
+	NNUInt GetHeight() const;
+	inline const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Node
+	{
+		BoundingBox bounds;
+		// 空闲节点中为下一个空闲节点
+		NNInt parent;
+		NNInt child1, child2;
+		// 叶子为 0, 空闲节点为 -1
+		NNInt height;
+		// 叶子对应的物体
+		NNUInt object;
+		inline bool IsLeaf() const { return child1 == NULL_NODE; }
+	};
+	struct Object
+	{
+		std::shared_ptr<Drawable> drawable;
+		NNInt leaf;
+		NNUInt version;
+	};
+
+private:
+	NNInt AllocateNode();
+	void FreeNode(const NNInt node);
+	void InsertLeaf(const NNInt leaf);
+	void RemoveLeaf(const NNInt leaf);
+	// 高度差大于 1 时旋转, 返回子树新的根
+	NNInt Balance(const NNInt node);
+	// 从 node 向上更新包围盒和高度
+	void FixUpwards(NNInt node);
+	// 按物体当前的世界包围盒更新叶子
+	void UpdateObject(const NNUInt object);
+	// 子树中所有叶子加入 visible
+	void CollectLeaves(const NNInt node, std::vector<Drawable*>& visible);
+
+private:
+	NNFloat m_margin;
+	std::vector<Node> m_nodes;
+	NNInt m_root;
+	NNInt m_free_list;
+	std::vector<Object> m_objects;
+	std::unordered_map<const Drawable*, NNUInt> m_indices;
+	Stats m_stats;
+
+private:
+	CullingTree(const NNFloat margin);
+	CullingTree(const CullingTree& rhs) = delete;
+	CullingTree& operator=(const CullingTree& rhs) = delete;
+};
+
+#endif // CULLING_TREE_H
@@ -1,5 +1,6 @@
 ﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 
+#include <cstring>
 #include "Debug.h"
 #include "Utils.h"
 
@@ -32,26 +33,26 @@ void _dCheckFileExist(const char* fileName) {
 
 
 #if defined NENE_GL
-void _dCheckGLError(const char* file, const int& line) {
+bool _dCheckGLCalls = false;
 
-	//
-	static char filepath[128];
-	static int linenum;
-	static GLenum errcode;
-	static GLuint finite;
-	static char* filename;
-	finite = 16;
+void _dCheckGLError(const char* file, const int& line) {
+	// 报告的是上一个调用的位置, __FILE__ 是字面量, 只记录指针
+	static thread_local const char* lastfile = nullptr;
+	static thread_local int lastline = 0;
+	GLenum errcode;
+	GLuint finite = 16;
 	//
 	while (errcode = glGetError(), errcode != GL_NO_ERROR && finite--) {
-		filename = strrchr(filepath, '\\');
-		if (filename != nullptr) {
-			++filename;
+		const char* filename = lastfile != nullptr ? lastfile : "unknown";
+		const char* separator = strrchr(filename, '\\');
+		if (separator == nullptr) {
+			separator = strrchr(filename, '/');
 		}
-		ddLog("File: \"%s\", line %d, error %d.\n\n\n", filename, linenum, errcode);
+		dLog("[Error] GL error 0x%04x after call at \"%s\", line %d.", errcode, separator != nullptr ? separator + 1 : filename, lastline);
 	}
 	//
-	strcpy(filepath, file);
-	linenum = line;
+	lastfile = file;
+	lastline = line;
 }
 
 void GLAPIENTRY _dMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
@@ -5,6 +5,7 @@
 #include <cstdio>
 #include <string>
 #include "assert.h"
+#include "Logger.h"
 
 //
 #ifndef IN
@@ -14,8 +15,33 @@
 	#define OUT
 #endif
 
-// 调试级别
-#define NNDEBUG 1
+// 调试级别, 可以在工程设置中覆盖
+#ifndef NNDEBUG
+	#define NNDEBUG 1
+#endif
+
+// GL 验证: 为 1 时 DebugLayer 默认开启, 并且可以在同步模式下逐个调用检查 glGetError; 发布构建默认为 0
+#ifndef NN_GL_VALIDATION
+	#if defined _DEBUG || (!defined _MSC_VER && !defined NDEBUG)
+		#define NN_GL_VALIDATION 1
+	#else
+		#define NN_GL_VALIDATION 0
+	#endif
+#endif
+
+// 编译期的最低日志级别, 低于它的 nnLog 不生成代码; 运行时用 Logger::SetLevel 按分类调整
+#ifndef NN_LOG_MIN_LEVEL
+	#if NNDEBUG >= 2
+		#define NN_LOG_MIN_LEVEL NN_LOG_TRACE
+	#elif NNDEBUG >= 1
+		#define NN_LOG_MIN_LEVEL NN_LOG_DEBUG
+	#else
+		#define NN_LOG_MIN_LEVEL NN_LOG_OFF
+	#endif
+#endif
+
+// 异步日志: 调用线程只拷贝参数, 格式化和输出在 Logger 的后台线程完成; fmt 必须是字符串字面量
+#define nnLog(level, category, fmt, ...) do { if ((level) >= NN_LOG_MIN_LEVEL && Logger::IsEnabled((level), (category))) Logger::Instance().Write((level), (category), fmt, ##__VA_ARGS__); } while (0)
 
 // 连接字符串
 #define CONNECTION(text1, text2) text1##text2
@@ -30,8 +56,8 @@
 	#define dCallOnce(func)
 #else
 	#define checkFileExist(filePath) _dCheckFileExist(filePath)
-	#define dLog(fmt, ...) printf(fmt, ##__VA_ARGS__), printf("\n")
-	#define dLogIf(expr, fmt, ...) if(expr) printf(fmt, ##__VA_ARGS__)
+	#define dLog(fmt, ...) nnLog(NN_LOG_INFO, NN_LOG_GENERAL, fmt, ##__VA_ARGS__)
+	#define dLogIf(expr, fmt, ...) do { if (expr) nnLog(NN_LOG_INFO, NN_LOG_GENERAL, fmt, ##__VA_ARGS__); } while (0)
 	#define dCall(func) func
 	#define dCallOnce(func) static bool CONNECT(__static_call_flag, __LINE__) = (func, true)
 #endif
@@ -40,7 +66,7 @@
 #if NNDEBUG < 2
 	#define ddLog(fmt, ...)
 #else
-	#define ddLog(fmt, ...) printf(fmt, ##__VA_ARGS__)
+	#define ddLog(fmt, ...) nnLog(NN_LOG_TRACE, NN_LOG_GENERAL, fmt, ##__VA_ARGS__)
 #endif
 
 // 检查文件存在
@@ -50,15 +76,20 @@ void _dCheckFileExist(const char* filepath);
 #if defined NENE_GL
 	//
 	#define GLEW_STATIC
-	#ifdef GLEW_GET_FUN
-		#undef GLEW_GET_FUN
+	#if NN_GL_VALIDATION > 0
+		// 只有 DebugLayer 在同步模式时才检查, 其他时候只多一次分支
+		#ifdef GLEW_GET_FUN
+			#undef GLEW_GET_FUN
+		#endif
+		#define GLEW_GET_FUN(x) ((_dCheckGLCalls ? _dCheckGLError(__FILE__, __LINE__) : (void)0), x)
 	#endif
-	#define GLEW_GET_FUN(x) (_dCheckGLError(__FILE__, __LINE__), x)
 	//	
 	#include <GL/glew.h>
 #endif
 
 #if defined NENE_GL
+// 由 DebugLayer::SetMode 设置
+extern bool _dCheckGLCalls;
 //
 void _dCheckGLError(const char* file, const int& line);
 
@@ -0,0 +1,57 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef DEBUG_LAYER_H
+#define DEBUG_LAYER_H
+
+#include <string>
+
+#include "Debug.h"
+#include "Types.h"
+
+//
+//    DebugLayer: Static class switching KHR_debug validation at runtime, with object labels and debug groups
+//
+
+class DebugLayer
+{
+public:
+	enum class Mode
+	{
+		// 不检查, 标签和调试组也不发给驱动
+		OFF = 0,
+		// 驱动异步回调报告错误
+		ASYNCHRONOUS = 1,
+		// 回调在出错的调用里同步执行, 可以在回调中断点看到调用位置; 调试构建还会在每个 GL 调用前检查 glGetError
+		SYNCHRONOUS = 2,
+	};
+
+public:
+	// 创建上下文后由 Utils::Init 调用, 进入默认模式 (NN_GL_VALIDATION 为 0 时是 OFF)
+	static void Init();
+	// 驱动是否支持 KHR_debug
+	static bool IsAvailable();
+	//
+	static void SetMode(const Mode mode);
+	static Mode GetMode();
+	// 给对象命名, 出现在驱动的报告和 RenderDoc 等工具里
+	static void SetLabel(const GLenum identifier, const GLuint name, const std::string& label);
+	// 调试组可以嵌套, 必须成对调用
+	static void PushGroup(const NNChar* name);
+	static void PopGroup();
+	// 收到的错误数 (不含性能提示等)
+	static NNUInt GetErrorNum();
+
+public:
+	// 作用域内的调试组
+	class Group
+	{
+	public:
+		Group(const NNChar* name) { PushGroup(name); }
+		~Group() { PopGroup(); }
+		Group(const Group& rhs) = delete;
+		Group& operator=(const Group& rhs) = delete;
+	};
+};
+
+#define NN_DEBUG_GROUP(name) DebugLayer::Group CONNECT(__debug_group, __LINE__)(name)
+
+#endif // DEBUG_LAYER_H
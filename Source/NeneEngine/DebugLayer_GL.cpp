@@ -0,0 +1,144 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include "DebugLayer.h"
+#include "RenderThread.h"
+
+using namespace std;
+
+static const DebugLayer::Mode DEFAULT_MODE = NN_GL_VALIDATION > 0 ? DebugLayer::Mode::ASYNCHRONOUS : DebugLayer::Mode::OFF;
+
+static DebugLayer::Mode s_mode = DEFAULT_MODE;
+static bool s_available = false;
+// 异步模式下回调可能在驱动的线程上执行
+static atomic<NNUInt> s_error_num(0);
+// 每个调试组是否发给了驱动, 切换模式后 PopGroup 仍然和 PushGroup 配对
+static vector<bool> s_groups;
+
+static void GLAPIENTRY DebugLayerCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+	// 调试组的进出也会产生消息
+	if (type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP)
+	{
+		return;
+	}
+	if (type == GL_DEBUG_TYPE_ERROR)
+	{
+		s_error_num += 1;
+	}
+	_dMessageCallback(source, type, id, severity, length, message, userParam);
+}
+
+static void ApplyMode(const NNUInt mode, const bool available)
+{
+	//
+	_dCheckGLCalls = NN_GL_VALIDATION > 0 && mode == (NNUInt)DebugLayer::Mode::SYNCHRONOUS;
+	if (!available)
+	{
+		return;
+	}
+	if (mode == (NNUInt)DebugLayer::Mode::OFF)
+	{
+		glDisable(GL_DEBUG_OUTPUT);
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		return;
+	}
+	glEnable(GL_DEBUG_OUTPUT);
+	if (mode == (NNUInt)DebugLayer::Mode::SYNCHRONOUS)
+	{
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	}
+	else
+	{
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	}
+}
+
+void DebugLayer::Init()
+{
+	//
+	s_available = GLEW_KHR_debug || GLEW_VERSION_4_3;
+	s_error_num = 0;
+	s_groups.clear();
+	if (!s_available)
+	{
+		dLog("[Info] KHR_debug is not available, GL validation only works with glGetError in synchronous mode.");
+	}
+	else
+	{
+		RenderThread::Record([]() {
+			glDebugMessageCallback(DebugLayerCallback, nullptr);
+			// 通知级别的消息太多, 默认不报告
+			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+		});
+	}
+	SetMode(s_mode);
+}
+
+bool DebugLayer::IsAvailable()
+{
+	return s_available;
+}
+
+void DebugLayer::SetMode(const Mode mode)
+{
+	s_mode = mode;
+	RenderThread::Record(&ApplyMode, (NNUInt)mode, s_available);
+}
+
+DebugLayer::Mode DebugLayer::GetMode()
+{
+	return s_mode;
+}
+
+void DebugLayer::SetLabel(const GLenum identifier, const GLuint name, const string& label)
+{
+	//
+	if (s_mode == Mode::OFF || !s_available || name == 0)
+	{
+		return;
+	}
+	RenderThread::RecordData([](const GLenum object_type, const GLuint object, const void* data, const size_t size) {
+		glObjectLabel(object_type, object, (GLsizei)size, (const GLchar*)data);
+	}, label.data(), label.size(), identifier, name);
+}
+
+void DebugLayer::PushGroup(const NNChar* name)
+{
+	//
+	const bool enabled = s_mode != Mode::OFF && s_available;
+	s_groups.push_back(enabled);
+	if (!enabled)
+	{
+		return;
+	}
+	RenderThread::RecordData([](const void* data, const size_t size) {
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, (GLsizei)size, (const GLchar*)data);
+	}, name, strlen(name));
+}
+
+void DebugLayer::PopGroup()
+{
+	//
+	if (s_groups.empty())
+	{
+		dLog("[Error] DebugLayer::PopGroup without a matching PushGroup.");
+		return;
+	}
+	const bool enabled = s_groups.back();
+	s_groups.pop_back();
+	if (enabled)
+	{
+		RenderThread::Record([]() { glPopDebugGroup(); });
+	}
+}
+
+NNUInt DebugLayer::GetErrorNum()
+{
+	return s_error_num;
+}
+
+#endif // NENE_GL
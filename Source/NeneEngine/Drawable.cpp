@@ -2,68 +2,66 @@
 #include "Drawable.h"
 
 Drawable::Drawable() {
-	mModelMat = NNMat4Identity;
-	mTranslation = NNVec3(0.0f, 0.0f, 0.0f);
-	mTranslationMat = NNMat4Identity;
+	mTransform = TransformSystem::Instance().Create();
 	mRotation = NNVec3(0.0f, 0.0f, 0.0f);
-	mRotationMat = NNMat4Identity;
-	mScale = NNVec3(0.0f, 0.0f, 0.0f);
-	mScaleMat = NNMat4Identity;
+	mBoundsVersion = 0;
 }
 
 Drawable::~Drawable() {
-	;
+	TransformSystem::Instance().Destroy(mTransform);
 }
 
 void Drawable::MoveTo(const NNVec3& position) {
-	mTranslation = position;
-	mTranslationMat = NNCreateTranslation(mTranslation);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	TransformSystem::Instance().SetPosition(mTransform, position);
 }
 
 void Drawable::ScaleTo(const NNVec3& scale) {
-	mScale = scale;
-	mScaleMat = NNCreateScale(mScale);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	TransformSystem::Instance().SetScale(mTransform, scale);
 }
 
 void Drawable::ScaleTo(const NNFloat& scale) {
-	mScale = NNVec3(scale);
-	mScaleMat = NNCreateScale(mScale);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	TransformSystem::Instance().SetScale(mTransform, NNVec3(scale));
 }
 
 void Drawable::RotateX(const NNFloat& radians) {
 	mRotation.x = radians;
-	mRotationMat = NNMat4Identity;
-	mRotationMat = NNCreateRotationX(mRotationMat, mRotation.x);
-	mRotationMat = NNCreateRotationY(mRotationMat, mRotation.y);
-	mRotationMat = NNCreateRotationZ(mRotationMat, mRotation.z);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	UpdateRotation();
 }
 
 void Drawable::RotateY(const NNFloat& radians) {
 	mRotation.y = radians;
-	mRotationMat = NNMat4Identity;
-	mRotationMat = NNCreateRotationX(mRotationMat, mRotation.x);
-	mRotationMat = NNCreateRotationY(mRotationMat, mRotation.y);
-	mRotationMat = NNCreateRotationZ(mRotationMat, mRotation.z);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	UpdateRotation();
 }
 
 void Drawable::RotateZ(const NNFloat& radians) {
 	mRotation.z = radians;
-	mRotationMat = NNMat4Identity;
-	mRotationMat = NNCreateRotationX(mRotationMat, mRotation.x);
-	mRotationMat = NNCreateRotationY(mRotationMat, mRotation.y);
-	mRotationMat = NNCreateRotationZ(mRotationMat, mRotation.z);
-	mModelMat = mTranslationMat * mRotationMat * mScaleMat;
+	UpdateRotation();
 }
 
-const NNMat4& Drawable::GetModelMat() {
-	return mModelMat;
+void Drawable::UpdateRotation() {
+	// 与 X * Y * Z 的旋转矩阵相同
+	NNQuat rotation = NNQuatAngleAxis(mRotation.x, NNVec3(1.0f, 0.0f, 0.0f));
+	rotation = rotation * NNQuatAngleAxis(mRotation.y, NNVec3(0.0f, 1.0f, 0.0f));
+	rotation = rotation * NNQuatAngleAxis(mRotation.z, NNVec3(0.0f, 0.0f, 1.0f));
+	TransformSystem::Instance().SetRotation(mTransform, rotation);
+}
+
+NNMat4 Drawable::GetModelMat() {
+	return TransformSystem::Instance().GetWorldMatrix(mTransform);
+}
+
+BoundingBox Drawable::GetWorldBounds() {
+	return mLocalBounds.Transform(GetModelMat());
+}
+
+NNUInt Drawable::GetBoundsVersion() {
+	return mBoundsVersion + TransformSystem::Instance().GetVersion(mTransform);
 }
 
 void Drawable::SetModelMat(const NNMat4& model) {
-	mModelMat = model;
+	TransformSystem::Instance().SetLocalMatrix(mTransform, model);
+}
+
+void Drawable::SetParent(const std::shared_ptr<Drawable>& parent) {
+	TransformSystem::Instance().SetParent(mTransform, parent != nullptr ? parent->mTransform : TransformSystem::INVALID_HANDLE);
 }
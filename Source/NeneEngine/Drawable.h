@@ -4,9 +4,14 @@
 
 #include "Shader.h"
 #include "Camera.h"
+#include "Bounds.h"
+#include "TransformSystem.h"
 
 #include <memory>
 
+class InstanceStream;
+class RenderQueue;
+
 //
 //    Drawable: Abstract Drawable Class
 //
@@ -19,32 +24,46 @@ public:
 	// 绘制
 	virtual void Draw(const std::shared_ptr<Shader> pShader = nullptr, 
 		const std::shared_ptr<Camera> pCamera = nullptr) = 0;
-	// 实例化绘制
-	virtual void DrawInstanced(const std::shared_ptr<Shader> pShader = nullptr,
+	// 实例化绘制, 绑定 VAO 后由 instances 设置每实例的属性
+	virtual void DrawInstanced(const InstanceStream& instances, const std::shared_ptr<Shader> pShader = nullptr,
 		const std::shared_ptr<Camera> pCamera = nullptr) = 0;
-	// 变换函数
+	// 记录到渲染队列, 由队列排序后统一绘制
+	virtual void Submit(RenderQueue& queue, const std::shared_ptr<Shader> pShader, const NNUInt pass = 0, const bool blended = false) = 0;
+	// 变换函数, 修改局部变换
 	virtual void MoveTo(const NNVec3& position);
 	virtual void ScaleTo(const NNVec3& scale);
 	virtual void ScaleTo(const NNFloat& scale);
 	virtual void RotateX(const NNFloat& radians);
 	virtual void RotateY(const NNFloat& radians);
 	virtual void RotateZ(const NNFloat& radians);
-	// 获取变换矩阵
-	const NNMat4& GetModelMat();
-	// 更改变换矩阵
+	// 获取世界矩阵, 返回副本, 创建物体时变换数组可能重新分配
+	NNMat4 GetModelMat();
+	// 直接指定局部矩阵
 	void SetModelMat(const NNMat4& model);
+	// 挂到另一个物体下, 为空时成为根节点
+	void SetParent(const std::shared_ptr<Drawable>& parent);
+	// TransformSystem 中的句柄
+	inline TransformSystem::Handle GetTransform() const { return mTransform; }
+	// 模型空间的包围盒, 创建时计算
+	inline const BoundingBox& GetLocalBounds() const { return mLocalBounds; }
+	// 按世界矩阵变换后的包围盒
+	BoundingBox GetWorldBounds();
+	// 世界矩阵或包围盒改变时变化, 用于增量更新层次包围盒
+	NNUInt GetBoundsVersion();
+protected:
+	// 按欧拉角更新旋转
+	void UpdateRotation();
 protected:
-	// 变换矩阵
-	NNMat4 mModelMat;
-	// 记录位移
-	NNVec3 mTranslation;
-	NNMat4 mTranslationMat;
-	// 记录旋转
+	// 变换
+	TransformSystem::Handle mTransform;
+	// 记录欧拉角, RotateX/Y/Z 分别修改一个分量
 	NNVec3 mRotation;
-	NNMat4 mRotationMat;
-	// 记录缩放
-	NNVec3 mScale;
-	NNMat4 mScaleMat;
+	// 包围盒
+	BoundingBox mLocalBounds;
+	NNUInt mBoundsVersion;
+private:
+	Drawable(const Drawable& rhs) = delete;
+	Drawable& operator=(const Drawable& rhs) = delete;
 };
 
 
@@ -0,0 +1,175 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include "Debug.h"
+#include "Camera.h"
+#include "Drawable.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "FrameBuilder.h"
+#include "TransformSystem.h"
+
+using namespace std;
+
+/** DrawList >>> */
+
+DrawList::DrawList() : m_queue(RenderQueue::Create())
+{}
+
+void DrawList::Execute(const shared_ptr<Camera> camera) const
+{
+	m_queue->Execute(camera);
+}
+
+/** FrameBuilder >>> */
+
+FrameBuilder::FrameBuilder() : m_stats({ 0, 0, 0, 0, 0 })
+{}
+
+FrameBuilder::~FrameBuilder()
+{}
+
+shared_ptr<FrameBuilder> FrameBuilder::Create()
+{
+	return shared_ptr<FrameBuilder>(new FrameBuilder());
+}
+
+void FrameBuilder::Add(const shared_ptr<Drawable>& drawable, const shared_ptr<Shader>& shader, const NNUInt pass, const bool blended)
+{
+	Add(vector<shared_ptr<Drawable>>(1, drawable), vector<NNFloat>(1, FLT_MAX), shader, pass, blended);
+}
+
+void FrameBuilder::Add(const vector<shared_ptr<Drawable>>& lods, const vector<NNFloat>& distances, const shared_ptr<Shader>& shader, const NNUInt pass, const bool blended)
+{
+	//
+	if (lods.empty() || lods.size() != distances.size() || lods[0] == nullptr)
+	{
+		dLog("[Error] Adding an object with mismatched levels of detail.\n");
+		return;
+	}
+	if (m_indices.find(lods[0].get()) != m_indices.end())
+	{
+		return;
+	}
+	for (size_t i = 1; i < lods.size(); ++i)
+	{
+		lods[i]->SetParent(lods[0]);
+	}
+	m_indices[lods[0].get()] = (NNUInt)m_objects.size();
+	m_objects.push_back({ lods, distances, shader, pass, blended });
+}
+
+void FrameBuilder::Remove(const shared_ptr<Drawable>& drawable)
+{
+	auto it = m_indices.find(drawable.get());
+	if (it == m_indices.end())
+	{
+		return;
+	}
+	// 最后一个物体移到空位
+	const NNUInt index = it->second;
+	m_indices.erase(it);
+	if (index + 1 != m_objects.size())
+	{
+		m_objects[index] = move(m_objects.back());
+		m_indices[m_objects[index].lods[0].get()] = index;
+	}
+	m_objects.pop_back();
+}
+
+void FrameBuilder::Clear()
+{
+	m_objects.clear();
+	m_indices.clear();
+}
+
+shared_ptr<const DrawList> FrameBuilder::Build(const shared_ptr<Camera>& camera)
+{
+	//
+	NN_PROFILE_CPU_ZONE("FrameBuilder::Build");
+	ThreadPool& pool = ThreadPool::Instance();
+	const NNUInt num = (NNUInt)m_objects.size();
+	const NNUInt chunks = (num + OBJECT_CHUNK - 1) / OBJECT_CHUNK;
+	// 主线程读取摄像机
+	Frustum frustum;
+	const bool culling = camera != nullptr;
+	if (culling)
+	{
+		frustum = camera->GetFrustum();
+	}
+	const NNVec3 eye = culling ? camera->GetPosition() : NNVec3(0.0f);
+	// 世界矩阵全部更新后, 之后的任务只读取变换
+	TransformSystem::Instance().Update();
+	// 每块物体一个任务, 记录到各自的队列
+	while (m_chunk_queues.size() < chunks)
+	{
+		m_chunk_queues.push_back(RenderQueue::Create(OBJECT_CHUNK));
+	}
+	m_chunk_visible.assign(chunks, 0);
+	pool.ParallelFor(chunks, [&](NNUInt chunk) {
+		NN_PROFILE_CPU_ZONE("FrameBuilder::BuildChunk");
+		BuildChunk(chunk, culling ? &frustum : nullptr, eye);
+	});
+	// 上一帧的列表已经没有其它引用时复用
+	shared_ptr<DrawList> list = m_last_list;
+	if (list == nullptr || list.use_count() > 2)
+	{
+		list.reset(new DrawList());
+	}
+	list->m_queue->Clear();
+	const vector<shared_ptr<RenderQueue>> parts(m_chunk_queues.begin(), m_chunk_queues.begin() + chunks);
+	list->m_queue->Append(parts, true);
+	list->m_queue->Sort(eye, true);
+	m_last_list = list;
+	//
+	m_stats.objects = num;
+	m_stats.visible = 0;
+	for (const NNUInt visible : m_chunk_visible)
+	{
+		m_stats.visible += visible;
+	}
+	m_stats.culled = num - m_stats.visible;
+	m_stats.items = list->GetItemNum();
+	m_stats.chunks = chunks;
+	return list;
+}
+
+void FrameBuilder::BuildChunk(const NNUInt chunk, const Frustum* frustum, const NNVec3& eye)
+{
+	//
+	RenderQueue& queue = *m_chunk_queues[chunk];
+	const NNUInt begin = chunk * OBJECT_CHUNK;
+	const NNUInt end = min(begin + OBJECT_CHUNK, (NNUInt)m_objects.size());
+	NNUInt visible = 0;
+	for (NNUInt i = begin; i < end; ++i)
+	{
+		const Object& object = m_objects[i];
+		// 以第 0 级的包围盒剔除和计算距离
+		const BoundingBox bounds = object.lods[0]->GetWorldBounds();
+		NNVec3 center = NNVec3(object.lods[0]->GetModelMat()[3]);
+		if (!bounds.IsEmpty())
+		{
+			if (frustum != nullptr && frustum->Test(bounds) == Frustum::OUTSIDE)
+			{
+				continue;
+			}
+			center = bounds.GetCenter();
+		}
+		const NNVec3 offset = center - eye;
+		const NNFloat distance = sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+		NNUInt level = 0;
+		while (level < object.distances.size() && distance >= object.distances[level])
+		{
+			++level;
+		}
+		if (level == object.lods.size())
+		{
+			continue;
+		}
+		object.lods[level]->Submit(queue, object.shader, object.pass, object.blended);
+		++visible;
+	}
+	m_chunk_visible[chunk] = visible;
+}
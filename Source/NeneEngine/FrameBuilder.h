@@ -0,0 +1,105 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef FRAME_BUILDER_H
+#define FRAME_BUILDER_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "Types.h"
+#include "Bounds.h"
+#include "RenderQueue.h"
+
+class Camera;
+class Shader;
+class Drawable;
+
+//
+//    DrawList: Draw items culled and sorted off the graphics thread; only executed afterwards
+//
+
+class DrawList
+{
+public:
+	// 在图形线程执行, 可以重复执行
+	void Execute(const std::shared_ptr<Camera> camera = nullptr) const;
+	//
+	inline NNUInt GetItemNum() const { return m_queue->GetItemNum(); }
+	// 上一次 Execute 的状态切换统计
+	inline const RenderQueue::Stats& GetStats() const { return m_queue->GetStats(); }
+
+private:
+	friend class FrameBuilder;
+	std::shared_ptr<RenderQueue> m_queue;
+
+private:
+	DrawList();
+	DrawList(const DrawList& rhs) = delete;
+	DrawList& operator=(const DrawList& rhs) = delete;
+};
+
+//
+//    FrameBuilder: Prepares a frame as jobs on the thread pool: transforms, culling, LOD selection, draw keys and sorting
+//
+
+class FrameBuilder
+{
+public:
+	// 上一次 Build 的统计
+	struct Stats
+	{
+		NNUInt objects;
+		NNUInt visible;
+		NNUInt culled;
+		NNUInt items;
+		NNUInt chunks;
+	};
+	// 每个任务处理的物体数
+	static const NNUInt OBJECT_CHUNK = 256;
+
+public:
+	static std::shared_ptr<FrameBuilder> Create();
+	~FrameBuilder();
+	// 物体用 shader 在 pass 中绘制, 没有包围盒的物体总是可见
+	void Add(const std::shared_ptr<Drawable>& drawable, const std::shared_ptr<Shader>& shader, const NNUInt pass = 0, const bool blended = false);
+	// 距离小于 distances[i] 时使用 lods[i], 超过最后一个距离时不绘制; 其它级别挂在第 0 级下面, 跟随第 0 级移动
+	void Add(const std::vector<std::shared_ptr<Drawable>>& lods, const std::vector<NNFloat>& distances, const std::shared_ptr<Shader>& shader, const NNUInt pass = 0, const bool blended = false);
+	// drawable 为 Add 时的第 0 级
+	void Remove(const std::shared_ptr<Drawable>& drawable);
+	void Clear();
+	// 在主线程调用, 期间不能修改物体; 返回的列表不再改变, 上一帧的列表不再被引用时复用它的内存
+	std::shared_ptr<const DrawList> Build(const std::shared_ptr<Camera>& camera);
+	//
+	inline NNUInt GetObjectNum() const { return (NNUInt)m_objects.size(); }
+	inline const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Object
+	{
+		std::vector<std::shared_ptr<Drawable>> lods;
+		std::vector<NNFloat> distances;
+		std::shared_ptr<Shader> shader;
+		NNUInt pass;
+		bool blended;
+	};
+
+private:
+	// 剔除, 选择细节级别并记录绘制, 只读取物体
+	void BuildChunk(const NNUInt chunk, const Frustum* frustum, const NNVec3& eye);
+
+private:
+	std::vector<Object> m_objects;
+	std::unordered_map<const Drawable*, NNUInt> m_indices;
+	// 每个任务一个队列, 合并后排序
+	std::vector<std::shared_ptr<RenderQueue>> m_chunk_queues;
+	std::vector<NNUInt> m_chunk_visible;
+	std::shared_ptr<DrawList> m_last_list;
+	Stats m_stats;
+
+private:
+	FrameBuilder();
+	FrameBuilder(const FrameBuilder& rhs) = delete;
+	FrameBuilder& operator=(const FrameBuilder& rhs) = delete;
+};
+
+#endif // FRAME_BUILDER_H
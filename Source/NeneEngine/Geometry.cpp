@@ -2,6 +2,7 @@
 
 #include "Geometry.h"
 #include "Debug.h"
+#include "MeshOptimizer.h"
 #include <unordered_map>
 
 using namespace std;
@@ -11,6 +12,30 @@ struct NNUVec3 {
 	NNUInt x, y, z;
 };
 
+static bool s_optimization = false;
+
+void Geometry::SetOptimization(bool enable)
+{
+	s_optimization = enable;
+}
+
+void Geometry::Optimize(vector<NNFloat> &vertices, vector<NNUInt> &indices, NNVertexFormat vf, bool overdraw)
+{
+	//
+	const NNUInt stride = vf * sizeof(NNFloat);
+	const NNUInt vNum = (NNUInt)(vertices.size() / vf);
+	const NNUInt iNum = (NNUInt)indices.size();
+	MeshOptimizer::CacheStats before = MeshOptimizer::AnalyzeVertexCache(indices.data(), iNum, vNum);
+	if (overdraw) {
+		MeshOptimizer::OptimizeOverdraw(indices.data(), iNum, (const NNByte*)vertices.data(), vNum, stride);
+	} else {
+		MeshOptimizer::OptimizeVertexCache(indices.data(), iNum, vNum);
+	}
+	vertices.resize(MeshOptimizer::OptimizeVertexFetch((NNByte*)vertices.data(), vNum, stride, indices.data(), iNum) * vf);
+	MeshOptimizer::CacheStats after = MeshOptimizer::AnalyzeVertexCache(indices.data(), iNum, (NNUInt)(vertices.size() / vf));
+	dLog("    ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f", before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
 void Geometry::InvertIndexOrder(NNUInt *indices, NNUInt iNum)
 {
 	dLogIf(iNum % 3 != 0, "[Error] Inverting vertex order of a non-trianglized mesh may cause undefine behavior.");
@@ -289,6 +314,10 @@ shared_ptr<Shape> Geometry::CreateSphereUV(const NNUInt& latLines, const NNUInt&
 		InvertIndexOrder(indices.data(), (NNUInt)indices.size());
 	}
 	//
+	if (s_optimization) {
+		Optimize(verticesPNT, indices, POSITION_NORMAL_TEXTURE);
+	}
+	//
 	return Shape::Create(verticesPNT, indices, POSITION_NORMAL_TEXTURE);
 }
 
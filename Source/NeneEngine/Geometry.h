@@ -26,6 +26,10 @@ public:
 	static void CalcNormals(std::vector<NNFloat> &vertices, std::vector<NNUInt> &indices);
 	//
 	static void InvertIndexOrder(NNUInt *indices, NNUInt iNum);
+	// 重排三角形和顶点以提高后变换缓存和顶点读取的命中率, overdraw 为 true 时额外按簇排序
+	static void Optimize(std::vector<NNFloat> &vertices, std::vector<NNUInt> &indices, NNVertexFormat vf, bool overdraw = false);
+	// 带索引的几何体在创建时是否自动优化, 默认关闭
+	static void SetOptimization(bool enable);
 };
 
 #endif // GEOMETRY_H
\ No newline at end of file
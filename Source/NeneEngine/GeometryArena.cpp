@@ -0,0 +1,177 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include "Debug.h"
+#include "GeometryArena.h"
+#include "RenderThread.h"
+
+using namespace std;
+
+/** RangeAllocator >>> */
+
+bool GeometryArena::RangeAllocator::Allocate(const NNUInt num, NNUInt& offset)
+{
+	for (auto it = m_free.begin(); it != m_free.end(); ++it)
+	{
+		if (it->second >= num)
+		{
+			offset = it->first;
+			const NNUInt remain = it->second - num;
+			m_free.erase(it);
+			if (remain > 0)
+			{
+				m_free[offset + num] = remain;
+			}
+			m_allocated += num;
+			return true;
+		}
+	}
+	return false;
+}
+
+void GeometryArena::RangeAllocator::Free(const NNUInt offset, const NNUInt num)
+{
+	if (num == 0)
+	{
+		return;
+	}
+	m_allocated -= num;
+	NNUInt begin = offset, end = offset + num;
+	// 与后一个空闲区间合并
+	auto next = m_free.lower_bound(begin);
+	if (next != m_free.end() && next->first == end)
+	{
+		end += next->second;
+		next = m_free.erase(next);
+	}
+	// 与前一个空闲区间合并
+	if (next != m_free.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == begin)
+		{
+			begin = prev->first;
+			m_free.erase(prev);
+		}
+	}
+	m_free[begin] = end - begin;
+}
+
+void GeometryArena::RangeAllocator::Grow(const NNUInt capacity)
+{
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+	// 新增的空间当作一次释放, 与末尾的空闲区间合并
+	const NNUInt old_capacity = m_capacity;
+	m_capacity = capacity;
+	m_allocated += capacity - old_capacity;
+	Free(old_capacity, capacity - old_capacity);
+}
+
+/** RangeAllocator <<< */
+
+GeometryArena::~GeometryArena()
+{
+	// 单例析构时上下文已经销毁, 图形资源由 Release 释放
+}
+
+GeometryArena& GeometryArena::Instance()
+{
+	static GeometryArena instance;
+	return instance;
+}
+
+NNUInt GeometryArena::FindPool(const VertexLayoutDesc& layout, const NNUInt index_size)
+{
+	for (NNUInt i = 0; i < (NNUInt)m_pools.size(); ++i)
+	{
+		if (m_pools[i].layout == &layout && m_pools[i].index_size == index_size)
+		{
+			return i;
+		}
+	}
+	Pool pool;
+	pool.layout = &layout;
+	pool.index_size = index_size;
+	pool.vertex_array = 0;
+	pool.vertex_buffer = 0;
+	pool.index_buffer = 0;
+	m_pools.push_back(pool);
+	return (NNUInt)m_pools.size() - 1;
+}
+
+GeometryArena::Range GeometryArena::Allocate(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNByte* indices, const NNUInt index_num, const NNUInt index_size)
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Allocate(layout, vertices, vertex_num, indices, index_num, index_size));
+	Range range = { 0, 0, 0, 0, 0 };
+	if (vertex_num == 0 || index_num == 0)
+	{
+		dLog("[Error] Allocating an empty geometry range.\n");
+		return range;
+	}
+	range.pool = FindPool(layout, index_size);
+	Pool& pool = m_pools[range.pool];
+	//
+	const bool vertex_ok = pool.vertices.Allocate(vertex_num, range.base_vertex);
+	const bool index_ok = vertex_ok && pool.indices.Allocate(index_num, range.first_index);
+	if (!index_ok)
+	{
+		if (vertex_ok)
+		{
+			pool.vertices.Free(range.base_vertex, vertex_num);
+		}
+		// 按两倍扩大直到末尾放得下, 已有网格的区间不变
+		NNUInt vertex_capacity = pool.vertices.GetCapacity() > 0 ? pool.vertices.GetCapacity() : INITIAL_VERTEX_NUM;
+		NNUInt index_capacity = pool.indices.GetCapacity() > 0 ? pool.indices.GetCapacity() : INITIAL_INDEX_NUM;
+		while (vertex_capacity < pool.vertices.GetCapacity() + vertex_num) vertex_capacity *= 2;
+		while (index_capacity < pool.indices.GetCapacity() + index_num) index_capacity *= 2;
+		Grow(pool, vertex_capacity, index_capacity);
+		if (!pool.vertices.Allocate(vertex_num, range.base_vertex) || !pool.indices.Allocate(index_num, range.first_index))
+		{
+			dLog("[Error] Failed to allocate %u vertices and %u indices from geometry arena.\n", vertex_num, index_num);
+			return { 0, 0, 0, 0, 0 };
+		}
+	}
+	range.vertex_num = vertex_num;
+	range.index_num = index_num;
+	Upload(pool, range, vertices, indices);
+	return range;
+}
+
+void GeometryArena::Free(Range& range)
+{
+	if (range.IsValid() && range.pool < m_pools.size())
+	{
+		Pool& pool = m_pools[range.pool];
+		pool.vertices.Free(range.base_vertex, range.vertex_num);
+		pool.indices.Free(range.first_index, range.index_num);
+	}
+	range = { 0, 0, 0, 0, 0 };
+}
+
+NNUInt GeometryArena::GetIndexSize(const NNUInt pool) const
+{
+	return pool < m_pools.size() ? m_pools[pool].index_size : 0;
+}
+
+size_t GeometryArena::GetCapacityBytes() const
+{
+	size_t bytes = 0;
+	for (const Pool& pool : m_pools)
+	{
+		bytes += (size_t)pool.vertices.GetCapacity() * pool.layout->stride + (size_t)pool.indices.GetCapacity() * pool.index_size;
+	}
+	return bytes;
+}
+
+size_t GeometryArena::GetAllocatedBytes() const
+{
+	size_t bytes = 0;
+	for (const Pool& pool : m_pools)
+	{
+		bytes += (size_t)pool.vertices.GetAllocated() * pool.layout->stride + (size_t)pool.indices.GetAllocated() * pool.index_size;
+	}
+	return bytes;
+}
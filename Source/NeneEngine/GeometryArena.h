@@ -0,0 +1,99 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <map>
+#include <vector>
+
+#include "Types.h"
+#include "VertexLayout.h"
+
+//
+//    GeometryArena: A singleton packing meshes into shared vertex / index buffers, one VAO per layout and index size
+//
+
+class GeometryArena
+{
+public:
+	// 池中的一段几何, index_num 为 0 时无效; 索引是网格内的局部索引, 绘制时加上 base_vertex
+	struct Range
+	{
+		NNUInt pool;
+		NNUInt base_vertex;
+		NNUInt vertex_num;
+		NNUInt first_index;
+		NNUInt index_num;
+		inline bool IsValid() const { return index_num > 0; }
+	};
+	// 新建池的初始容量, 不够时翻倍
+	static const NNUInt INITIAL_VERTEX_NUM = 1 << 16;
+	static const NNUInt INITIAL_INDEX_NUM = 1 << 18;
+
+public:
+	// 获取单例
+	static GeometryArena& Instance();
+	// 按 layout 和索引宽度选择池并上传
+	Range Allocate(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNByte* indices, const NNUInt index_num, const NNUInt index_size);
+	// 归还区间, 相邻的空闲区间会被合并
+	void Free(Range& range);
+	// 回读编码后的顶点和打包的索引
+	bool Read(const Range& range, NNByte* vertices, NNByte* indices) const;
+	// 池的 VAO 和索引类型, 同一个池的网格可以合并成一次 MultiDraw
+	NNUInt GetVertexArray(const NNUInt pool) const;
+	NNUInt GetIndexType(const NNUInt pool) const;
+	NNUInt GetIndexSize(const NNUInt pool) const;
+	// 释放图形资源, 由 Utils::Terminate 调用
+	void Release();
+	//
+	inline NNUInt GetPoolNum() const { return (NNUInt)m_pools.size(); }
+	size_t GetCapacityBytes() const;
+	size_t GetAllocatedBytes() const;
+
+public:
+	~GeometryArena();
+
+private:
+	// 首次适配的区间分配器, 以元素为单位
+	class RangeAllocator
+	{
+	public:
+		RangeAllocator() : m_capacity(0), m_allocated(0) {}
+		// 空间不够时返回 false
+		bool Allocate(const NNUInt num, NNUInt& offset);
+		void Free(const NNUInt offset, const NNUInt num);
+		// 扩大容量, 新增的空间加入空闲区间
+		void Grow(const NNUInt capacity);
+		//
+		inline NNUInt GetCapacity() const { return m_capacity; }
+		inline NNUInt GetAllocated() const { return m_allocated; }
+	private:
+		NNUInt m_capacity;
+		NNUInt m_allocated;
+		// 起始位置 -> 长度
+		std::map<NNUInt, NNUInt> m_free;
+	};
+	struct Pool
+	{
+		const VertexLayoutDesc* layout;
+		NNUInt index_size;
+		RangeAllocator vertices;
+		RangeAllocator indices;
+		NNUInt vertex_array;
+		NNUInt vertex_buffer;
+		NNUInt index_buffer;
+	};
+	NNUInt FindPool(const VertexLayoutDesc& layout, const NNUInt index_size);
+	// 扩大池的缓冲并拷贝已有数据, 第一次调用时创建 VAO
+	void Grow(Pool& pool, const NNUInt vertex_capacity, const NNUInt index_capacity);
+	void Upload(Pool& pool, const Range& range, const NNByte* vertices, const NNByte* indices);
+
+private:
+	std::vector<Pool> m_pools;
+
+private:
+	GeometryArena() = default;
+	GeometryArena(const GeometryArena& rhs) = delete;
+	GeometryArena& operator=(const GeometryArena& rhs) = delete;
+};
+
+#endif // GEOMETRY_ARENA_H
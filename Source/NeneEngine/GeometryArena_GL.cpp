@@ -0,0 +1,131 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include "Debug.h"
+#include "GeometryArena.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+void GeometryArena::Grow(Pool& pool, const NNUInt vertex_capacity, const NNUInt index_capacity)
+{
+	//
+	RenderContext& ctx = RenderContext::instance();
+	const size_t stride = pool.layout->stride;
+	GLuint vbo = pool.vertex_buffer, ebo = pool.index_buffer;
+	// 新建更大的缓冲并拷贝已有数据, 使用 COPY 绑定点, 不影响当前的 VAO
+	if (vertex_capacity > pool.vertices.GetCapacity())
+	{
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+		glBufferData(GL_COPY_WRITE_BUFFER, vertex_capacity * stride, nullptr, GL_STATIC_DRAW);
+		if (pool.vertex_buffer != 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, pool.vertex_buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, pool.vertices.GetCapacity() * stride);
+		}
+	}
+	if (index_capacity > pool.indices.GetCapacity())
+	{
+		glGenBuffers(1, &ebo);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+		glBufferData(GL_COPY_WRITE_BUFFER, (size_t)index_capacity * pool.index_size, nullptr, GL_STATIC_DRAW);
+		if (pool.index_buffer != 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, pool.index_buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)pool.indices.GetCapacity() * pool.index_size);
+		}
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	// VAO 不变, 重新指向新的缓冲
+	if (pool.vertex_array == 0)
+	{
+		glGenVertexArrays(1, &pool.vertex_array);
+	}
+	ctx.bindVertexArray(pool.vertex_array);
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		pool.layout->Apply();
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	}
+	ctx.bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// 旧的缓冲已经不再被引用
+	if (vbo != pool.vertex_buffer && pool.vertex_buffer != 0)
+	{
+		ctx.forgetBuffer(pool.vertex_buffer);
+		glDeleteBuffers(1, &pool.vertex_buffer);
+	}
+	if (ebo != pool.index_buffer && pool.index_buffer != 0)
+	{
+		ctx.forgetBuffer(pool.index_buffer);
+		glDeleteBuffers(1, &pool.index_buffer);
+	}
+	pool.vertex_buffer = vbo;
+	pool.index_buffer = ebo;
+	pool.vertices.Grow(vertex_capacity);
+	pool.indices.Grow(index_capacity);
+	//
+	dLog("[Info] Geometry arena pool grows to %u vertices (stride %u) and %u indices.\n", vertex_capacity, pool.layout->stride, index_capacity);
+}
+
+void GeometryArena::Upload(Pool& pool, const Range& range, const NNByte* vertices, const NNByte* indices)
+{
+	const size_t stride = pool.layout->stride;
+	RenderStats::Add(NN_COUNTER_BUFFER_BYTES, range.vertex_num * stride + (size_t)range.index_num * pool.index_size);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool.vertex_buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, range.base_vertex * stride, range.vertex_num * stride, vertices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, pool.index_buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (size_t)range.first_index * pool.index_size, (size_t)range.index_num * pool.index_size, indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool GeometryArena::Read(const Range& range, NNByte* vertices, NNByte* indices) const
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Read(range, vertices, indices));
+	if (!range.IsValid() || range.pool >= m_pools.size())
+	{
+		return false;
+	}
+	const Pool& pool = m_pools[range.pool];
+	const size_t stride = pool.layout->stride;
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.vertex_buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, range.base_vertex * stride, range.vertex_num * stride, vertices);
+	glBindBuffer(GL_COPY_READ_BUFFER, pool.index_buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, (size_t)range.first_index * pool.index_size, (size_t)range.index_num * pool.index_size, indices);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return true;
+}
+
+NNUInt GeometryArena::GetVertexArray(const NNUInt pool) const
+{
+	return pool < m_pools.size() ? m_pools[pool].vertex_array : 0;
+}
+
+NNUInt GeometryArena::GetIndexType(const NNUInt pool) const
+{
+	return GetIndexSize(pool) == sizeof(GLuint) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
+void GeometryArena::Release()
+{
+	RenderContext& ctx = RenderContext::instance();
+	for (Pool& pool : m_pools)
+	{
+		if (pool.vertex_array != 0)
+		{
+			ctx.forgetVertexArray(pool.vertex_array);
+			glDeleteVertexArrays(1, &pool.vertex_array);
+		}
+		if (pool.vertex_buffer != 0) glDeleteBuffers(1, &pool.vertex_buffer);
+		if (pool.index_buffer != 0) glDeleteBuffers(1, &pool.index_buffer);
+	}
+	// 之后归还的区间会被忽略
+	m_pools.clear();
+}
+
+#endif // NENE_GL
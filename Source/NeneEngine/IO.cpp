@@ -5,6 +5,15 @@
 #include <fstream>
 #include <sstream>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 using namespace std;
 
 string IO::ReadFile(const NNChar *filepath) {
@@ -45,6 +54,134 @@ void IO::SaveFile(const NNChar* filepath, const string &content) {
 	}
 }
 
+bool IO::SaveBinaryFile(const NNChar* filepath, const void* data, const size_t size) {
+	FILE* file = fopen(filepath, "wb");
+	if (file == nullptr) {
+		dLog("[Error]: Fail to write target file(%s)!\n", filepath);
+		return false;
+	}
+	size_t written = fwrite(data, 1, size, file);
+	fclose(file);
+	return written == size;
+}
+
+bool IO::FileExist(const NNChar* filepath) {
+	FILE* file = fopen(filepath, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	fclose(file);
+	return true;
+}
+
+NNULong IO::Hash(const void* data, const size_t size, const NNULong seed) {
+	const NNByte* bytes = (const NNByte*)data;
+	NNULong hash = seed;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+NNULong IO::HashFile(const NNChar* filepath) {
+	shared_ptr<MappedFile> file = MappedFile::Open(filepath);
+	if (file == nullptr) {
+		return 0;
+	}
+	return Hash(file->Data(), file->Size());
+}
+
+bool IO::GetFileStamp(const NNChar* filepath, NNULong& size, NNULong& mtime) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(filepath, GetFileExInfoStandard, &info)) {
+		return false;
+	}
+	size = ((NNULong)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	mtime = ((NNULong)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat info;
+	if (stat(filepath, &info) != 0) {
+		return false;
+	}
+	size = (NNULong)info.st_size;
+	// 纳秒精度, 同一秒内的修改也能区分
+#if defined __APPLE__
+	mtime = (NNULong)info.st_mtimespec.tv_sec * 1000000000ULL + (NNULong)info.st_mtimespec.tv_nsec;
+#else
+	mtime = (NNULong)info.st_mtim.tv_sec * 1000000000ULL + (NNULong)info.st_mtim.tv_nsec;
+#endif
+#endif
+	return true;
+}
+
+/** MappedFile >>> */
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+}
+
+shared_ptr<MappedFile> MappedFile::Open(const NNChar* filepath) {
+	shared_ptr<MappedFile> result(new MappedFile());
+	result->m_file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (result->m_file == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(result->m_file, &size) || size.QuadPart == 0) {
+		return nullptr;
+	}
+	result->m_size = (size_t)size.QuadPart;
+	result->m_mapping = CreateFileMappingA(result->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (result->m_mapping == nullptr) {
+		return nullptr;
+	}
+	result->m_data = (const NNByte*)MapViewOfFile(result->m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (result->m_data == nullptr) {
+		return nullptr;
+	}
+	return result;
+}
+
+#else
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(-1) {}
+
+MappedFile::~MappedFile() {
+	if (m_data != nullptr) munmap((void*)m_data, m_size);
+	if (m_file != -1) close(m_file);
+}
+
+shared_ptr<MappedFile> MappedFile::Open(const NNChar* filepath) {
+	shared_ptr<MappedFile> result(new MappedFile());
+	result->m_file = open(filepath, O_RDONLY);
+	if (result->m_file == -1) {
+		return nullptr;
+	}
+	struct stat info;
+	if (fstat(result->m_file, &info) != 0 || info.st_size == 0) {
+		return nullptr;
+	}
+	result->m_size = (size_t)info.st_size;
+	void* data = mmap(nullptr, result->m_size, PROT_READ, MAP_PRIVATE, result->m_file, 0);
+	if (data == MAP_FAILED) {
+		return nullptr;
+	}
+	result->m_data = (const NNByte*)data;
+	return result;
+}
+
+#endif
+
+/** MappedFile <<< */
+
 #ifdef NENE_DX
 
 string IO::WS2S(const wstring& origin) {
@@ -4,17 +4,54 @@
 
 #include "Types.h"
 #include <string>
+#include <vector>
+#include <memory>
 
 //
-//    IO: File's Reading and Writing Class
+//    OBJData: Welded triangle data parsed from a wavefront obj file
 //
 
+struct OBJGroup {
+	// 所属对象 (o/g) 和材质 (usemtl)
+	std::string name;
+	std::string material;
+	// 顶点范围, 组内索引从 vertex_offset 开始计数
+	NNUInt vertex_offset, vertex_num;
+	// 索引范围
+	NNUInt index_offset, index_num;
+};
+
+struct OBJData {
+	// 焊接后的顶点属性, 三个数组等长; 文件中缺少法线时生成平滑法线, 缺少纹理坐标时填 0
+	std::vector<NNVec3> positions;
+	std::vector<NNVec3> normals;
+	std::vector<NNVec2> texcoords;
+	// 三角形索引 (相对所在组的 vertex_offset)
+	std::vector<NNUInt> indices;
+	// 每个三角形角点在文件中的原始位置索引 (与 indices 一一对应), 用于拓扑计算
+	std::vector<NNUInt> position_indices;
+	//
+	std::vector<OBJGroup> groups;
+	std::string mtllib;
+	bool has_normals, has_texcoords;
+};
+
 class IO {
 public:
 	// 读取文件
 	static std::string ReadFile(const NNChar* filepath);
 	// 写入文件
 	static void SaveFile(const NNChar* filepath, const std::string &content);
+	static bool SaveBinaryFile(const NNChar* filepath, const void* data, const size_t size);
+	// 文件是否存在
+	static bool FileExist(const NNChar* filepath);
+	// 64 位 FNV-1a 散列
+	static NNULong Hash(const void* data, const size_t size, const NNULong seed = 0xcbf29ce484222325ULL);
+	static NNULong HashFile(const NNChar* filepath);
+	// 文件大小和修改时间, 不读取内容; 时间只用于比较是否改变
+	static bool GetFileStamp(const NNChar* filepath, NNULong& size, NNULong& mtime);
+	// 读取 OBJ: 映射文件后按行切块并行解析, 然后合并和焊接顶点
+	static bool ReadOBJ(const NNChar* filepath, OBJData& result, const bool parallel = true);
 #ifdef NENE_DX
 	// 宽字符和字符转换
 	static std::string WS2S(const std::wstring&);
@@ -22,4 +59,32 @@ public:
 #endif
 };
 
+//
+//    MappedFile: Read-only memory mapped file
+//
+
+class MappedFile {
+public:
+	// 映射整个文件, 失败返回空指针
+	static std::shared_ptr<MappedFile> Open(const NNChar* filepath);
+	//
+	~MappedFile();
+	//
+	inline const NNByte* Data() const { return m_data; }
+	inline size_t Size() const { return m_size; }
+private:
+	const NNByte* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+private:
+	MappedFile();
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+};
+
 #endif // IO_H
\ No newline at end of file
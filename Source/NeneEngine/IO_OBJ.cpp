@@ -0,0 +1,451 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include "IO.h"
+#include "Debug.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+/** Implementation Functions >>> */
+
+// 每块至少 1MB, 再小就不值得分发了
+static const size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+// 缺省的纹理坐标/法线索引
+static const NNInt OBJ_ABSENT = INT_MIN;
+static const NNUInt OBJ_WELD_EMPTY = 0xffffffffu;
+
+// 一个角点的原始索引 (0 起始), 负数索引在合并前相对于块内计数
+struct OBJCorner
+{
+	NNInt v, t, n;
+	NNByte relative;
+};
+
+// 块内对象/材质的切换位置
+struct OBJGroupMark
+{
+	size_t corner_offset;
+	bool has_name, has_material;
+	string name, material;
+};
+
+// 单个块的解析结果
+struct OBJChunk
+{
+	vector<NNVec3> positions;
+	vector<NNVec3> normals;
+	vector<NNVec2> texcoords;
+	vector<OBJCorner> corners;
+	vector<OBJGroupMark> marks;
+	string mtllib;
+};
+
+// 焊接表的槽
+struct OBJWeldSlot
+{
+	NNInt v, t, n;
+	NNUInt index;
+};
+
+static inline bool IsBlank(const char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipBlanks(const char* p, const char* end)
+{
+	while (p < end && IsBlank(*p)) ++p;
+	return p;
+}
+
+static inline bool IsKeyword(const char* p, const char* end, const char* keyword, const size_t length)
+{
+	return size_t(end - p) > length && memcmp(p, keyword, length) == 0 && IsBlank(p[length]);
+}
+
+static inline string ReadRestOfLine(const char* p, const char* end)
+{
+	p = SkipBlanks(p, end);
+	while (end > p && IsBlank(end[-1])) --end;
+	return string(p, end);
+}
+
+static inline const char* ParseFloat(const char* p, const char* end, NNFloat& value)
+{
+	p = SkipBlanks(p, end);
+	// from_chars 不接受前导 '+'
+	if (p < end && *p == '+') ++p;
+	from_chars_result res = from_chars(p, end, value);
+	if (res.ec != errc())
+	{
+		value = 0.0f;
+	}
+	return res.ptr;
+}
+
+static inline const char* ParseIndex(const char* p, const char* end, NNInt& value, bool& ok)
+{
+	from_chars_result res = from_chars(p, end, value);
+	ok = (res.ec == errc());
+	return res.ptr;
+}
+
+// 把 OBJ 的 1 起始/负数索引转为 0 起始, 负数索引暂时相对于块内计数
+static inline NNInt ResolveIndex(const NNInt index, const size_t local_count, NNByte& relative, const NNByte bit)
+{
+	if (index < 0)
+	{
+		relative |= bit;
+		return NNInt(local_count) + index;
+	}
+	return index - 1;
+}
+
+static void ParseOBJLine(const char* p, const char* end, OBJChunk& chunk, vector<OBJCorner>& polygon)
+{
+	if (p[0] == 'v')
+	{
+		if (end - p > 1 && IsBlank(p[1]))
+		{
+			NNVec3 position;
+			p = ParseFloat(p + 1, end, position.x);
+			p = ParseFloat(p, end, position.y);
+			p = ParseFloat(p, end, position.z);
+			chunk.positions.push_back(position);
+		}
+		else if (IsKeyword(p, end, "vn", 2))
+		{
+			NNVec3 normal;
+			p = ParseFloat(p + 2, end, normal.x);
+			p = ParseFloat(p, end, normal.y);
+			p = ParseFloat(p, end, normal.z);
+			chunk.normals.push_back(normal);
+		}
+		else if (IsKeyword(p, end, "vt", 2))
+		{
+			NNVec2 texcoord;
+			p = ParseFloat(p + 2, end, texcoord.x);
+			p = ParseFloat(p, end, texcoord.y);
+			chunk.texcoords.push_back(texcoord);
+		}
+	}
+	else if (p[0] == 'f' && end - p > 1 && IsBlank(p[1]))
+	{
+		// 读取多边形的所有角点: v, v/t, v//n, v/t/n
+		polygon.clear();
+		p += 1;
+		while (true)
+		{
+			p = SkipBlanks(p, end);
+			if (p >= end)
+			{
+				break;
+			}
+			bool ok;
+			NNInt v = 0, t = 0, n = 0;
+			p = ParseIndex(p, end, v, ok);
+			if (!ok)
+			{
+				break;
+			}
+			OBJCorner corner = { 0, OBJ_ABSENT, OBJ_ABSENT, 0 };
+			corner.v = ResolveIndex(v, chunk.positions.size(), corner.relative, 1);
+			if (p < end && *p == '/')
+			{
+				++p;
+				if (p < end && *p != '/')
+				{
+					p = ParseIndex(p, end, t, ok);
+					if (ok) corner.t = ResolveIndex(t, chunk.texcoords.size(), corner.relative, 2);
+				}
+				if (p < end && *p == '/')
+				{
+					++p;
+					p = ParseIndex(p, end, n, ok);
+					if (ok) corner.n = ResolveIndex(n, chunk.normals.size(), corner.relative, 4);
+				}
+			}
+			polygon.push_back(corner);
+		}
+		// 扇形三角化
+		for (size_t i = 2; i < polygon.size(); ++i)
+		{
+			chunk.corners.push_back(polygon[0]);
+			chunk.corners.push_back(polygon[i - 1]);
+			chunk.corners.push_back(polygon[i]);
+		}
+	}
+	else if ((p[0] == 'o' || p[0] == 'g') && (end - p == 1 || IsBlank(p[1])))
+	{
+		OBJGroupMark mark = { chunk.corners.size(), true, false, ReadRestOfLine(p + 1, end), "" };
+		chunk.marks.push_back(move(mark));
+	}
+	else if (IsKeyword(p, end, "usemtl", 6))
+	{
+		OBJGroupMark mark = { chunk.corners.size(), false, true, "", ReadRestOfLine(p + 6, end) };
+		chunk.marks.push_back(move(mark));
+	}
+	else if (IsKeyword(p, end, "mtllib", 6) && chunk.mtllib.empty())
+	{
+		chunk.mtllib = ReadRestOfLine(p + 6, end);
+	}
+}
+
+static void ParseOBJChunk(const char* begin, const char* end, OBJChunk& chunk)
+{
+	// 按平均每行字节数粗略预留
+	const size_t estimate = size_t(end - begin) / 32;
+	chunk.positions.reserve(estimate / 2);
+	chunk.corners.reserve(estimate * 3);
+	//
+	vector<OBJCorner> polygon;
+	const char* p = begin;
+	while (p < end)
+	{
+		const char* line_end = (const char*)memchr(p, '\n', size_t(end - p));
+		if (line_end == nullptr)
+		{
+			line_end = end;
+		}
+		p = SkipBlanks(p, line_end);
+		if (p < line_end && *p != '#')
+		{
+			ParseOBJLine(p, line_end, chunk, polygon);
+		}
+		p = line_end + 1;
+	}
+}
+
+// 当前线程也参与执行, 在工作线程中调用也不会阻塞等待池中的其它任务
+static void RunTasks(const NNUInt count, const bool parallel, const function<void(NNUInt)>& task)
+{
+	if (!parallel || count <= 1)
+	{
+		for (NNUInt i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+	ThreadPool::Instance().ParallelFor(count, task);
+}
+
+static inline NNUInt HashCorner(const OBJCorner& c)
+{
+	NNUInt h = NNUInt(c.v) * 0x9e3779b1u;
+	h ^= (NNUInt(c.t) + 0x7f4a7c15u + (h << 6) + (h >> 2));
+	h ^= (NNUInt(c.n) + 0x165667b1u + (h << 6) + (h >> 2));
+	return h;
+}
+
+// 组内焊接: 相同 (v, t, n) 的角点共用一个顶点, 顶点按首次出现的顺序编号
+static void WeldOBJGroup(const OBJCorner* corners, const size_t corner_num, vector<OBJCorner>& unique, vector<NNUInt>& indices)
+{
+	size_t capacity = 16;
+	while (capacity < corner_num * 2) capacity <<= 1;
+	vector<OBJWeldSlot> table(capacity, OBJWeldSlot{ 0, 0, 0, OBJ_WELD_EMPTY });
+	const size_t mask = capacity - 1;
+	//
+	indices.resize(corner_num);
+	for (size_t i = 0; i < corner_num; ++i)
+	{
+		const OBJCorner& c = corners[i];
+		size_t slot = HashCorner(c) & mask;
+		while (true)
+		{
+			OBJWeldSlot& s = table[slot];
+			if (s.index == OBJ_WELD_EMPTY)
+			{
+				s = OBJWeldSlot{ c.v, c.t, c.n, NNUInt(unique.size()) };
+				unique.push_back(c);
+				indices[i] = s.index;
+				break;
+			}
+			if (s.v == c.v && s.t == c.t && s.n == c.n)
+			{
+				indices[i] = s.index;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+/** Implementation Functions <<< */
+
+bool IO::ReadOBJ(const NNChar* filepath, OBJData& result, const bool parallel)
+{
+	//
+	shared_ptr<MappedFile> file = MappedFile::Open(filepath);
+	if (file == nullptr)
+	{
+		dLog("[Error] Cannot open obj file. (%s)", filepath);
+		return false;
+	}
+	const char* data = (const char*)file->Data();
+	const size_t size = file->Size();
+	// 按行对齐切块
+	NNUInt chunk_num = 1;
+	if (parallel)
+	{
+		chunk_num = NNUInt(min<size_t>(size / OBJ_MIN_CHUNK_SIZE, ThreadPool::Instance().GetWorkerNum() + 1));
+		chunk_num = chunk_num > 0 ? chunk_num : 1;
+	}
+	vector<size_t> bounds(chunk_num + 1, size);
+	bounds[0] = 0;
+	for (NNUInt i = 1; i < chunk_num; ++i)
+	{
+		size_t pos = max(bounds[i - 1], size * i / chunk_num);
+		const char* line_end = (const char*)memchr(data + pos, '\n', size - pos);
+		bounds[i] = line_end == nullptr ? size : size_t(line_end - data) + 1;
+	}
+	// 并行解析
+	vector<OBJChunk> chunks(chunk_num);
+	RunTasks(chunk_num, parallel, [&](NNUInt i) {
+		ParseOBJChunk(data + bounds[i], data + bounds[i + 1], chunks[i]);
+	});
+	// 合并原始属性, 修正相对索引
+	vector<NNVec3> positions, normals;
+	vector<NNVec2> texcoords;
+	vector<OBJCorner> corners;
+	vector<OBJGroupMark> marks;
+	size_t position_num = 0, normal_num = 0, texcoord_num = 0, corner_num = 0;
+	for (const OBJChunk& chunk : chunks)
+	{
+		position_num += chunk.positions.size();
+		normal_num += chunk.normals.size();
+		texcoord_num += chunk.texcoords.size();
+		corner_num += chunk.corners.size();
+	}
+	positions.reserve(position_num);
+	normals.reserve(normal_num);
+	texcoords.reserve(texcoord_num);
+	corners.reserve(corner_num);
+	result.mtllib.clear();
+	for (OBJChunk& chunk : chunks)
+	{
+		const NNInt v_offset = NNInt(positions.size()), t_offset = NNInt(texcoords.size()), n_offset = NNInt(normals.size());
+		const size_t c_offset = corners.size();
+		for (OBJCorner c : chunk.corners)
+		{
+			if (c.relative & 1) c.v += v_offset;
+			if (c.relative & 2) c.t += t_offset;
+			if (c.relative & 4) c.n += n_offset;
+			corners.push_back(c);
+		}
+		for (OBJGroupMark& mark : chunk.marks)
+		{
+			mark.corner_offset += c_offset;
+			marks.push_back(move(mark));
+		}
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+		if (result.mtllib.empty())
+		{
+			result.mtllib = chunk.mtllib;
+		}
+		chunk = OBJChunk();
+	}
+	// 越界检查
+	result.has_normals = !corners.empty();
+	result.has_texcoords = !corners.empty();
+	for (OBJCorner& c : corners)
+	{
+		if (c.v < 0 || c.v >= NNInt(positions.size()) ||
+			(c.t != OBJ_ABSENT && (c.t < 0 || c.t >= NNInt(texcoords.size()))) ||
+			(c.n != OBJ_ABSENT && (c.n < 0 || c.n >= NNInt(normals.size()))))
+		{
+			dLog("[Error] Obj file has out of range index. (%s)", filepath);
+			return false;
+		}
+		result.has_normals = result.has_normals && c.n != OBJ_ABSENT;
+		result.has_texcoords = result.has_texcoords && c.t != OBJ_ABSENT;
+	}
+	// 划分组: 对象或材质切换时开始新组
+	result.groups.clear();
+	string name, material;
+	size_t mark = 0, group_begin = 0;
+	while (group_begin < corners.size())
+	{
+		// 应用所有位于当前位置的切换
+		while (mark < marks.size() && marks[mark].corner_offset <= group_begin)
+		{
+			if (marks[mark].has_name) name = marks[mark].name;
+			if (marks[mark].has_material) material = marks[mark].material;
+			++mark;
+		}
+		size_t group_end = mark < marks.size() ? marks[mark].corner_offset : corners.size();
+		if (group_end > group_begin)
+		{
+			OBJGroup group = { name, material, 0, 0, NNUInt(group_begin), NNUInt(group_end - group_begin) };
+			result.groups.push_back(group);
+		}
+		group_begin = group_end;
+	}
+	// 组内并行焊接
+	const NNUInt group_num = NNUInt(result.groups.size());
+	vector<vector<OBJCorner>> uniques(group_num);
+	result.indices.resize(corners.size());
+	RunTasks(group_num, parallel, [&](NNUInt g) {
+		const OBJGroup& group = result.groups[g];
+		vector<NNUInt> indices;
+		WeldOBJGroup(corners.data() + group.index_offset, group.index_num, uniques[g], indices);
+		memcpy(result.indices.data() + group.index_offset, indices.data(), indices.size() * sizeof(NNUInt));
+	});
+	// 缺少法线时按面积加权生成平滑法线
+	vector<NNVec3> smooth_normals;
+	if (!result.has_normals)
+	{
+		smooth_normals.assign(positions.size(), NNVec3(0.0f));
+		for (size_t i = 0; i + 2 < corners.size(); i += 3)
+		{
+			const NNVec3& a = positions[corners[i + 0].v];
+			const NNVec3& b = positions[corners[i + 1].v];
+			const NNVec3& c = positions[corners[i + 2].v];
+			const NNVec3 face_normal = glm::cross(b - a, c - a);
+			smooth_normals[corners[i + 0].v] += face_normal;
+			smooth_normals[corners[i + 1].v] += face_normal;
+			smooth_normals[corners[i + 2].v] += face_normal;
+		}
+		for (NNVec3& normal : smooth_normals)
+		{
+			const NNFloat length = glm::length(normal);
+			normal = length > 0.0f ? normal / length : NNVec3(0.0f);
+		}
+	}
+	// 输出焊接后的顶点
+	NNUInt vertex_num = 0;
+	for (NNUInt g = 0; g < group_num; ++g)
+	{
+		result.groups[g].vertex_offset = vertex_num;
+		result.groups[g].vertex_num = NNUInt(uniques[g].size());
+		vertex_num += result.groups[g].vertex_num;
+	}
+	result.positions.resize(vertex_num);
+	result.normals.resize(vertex_num);
+	result.texcoords.resize(vertex_num);
+	result.position_indices.resize(corners.size());
+	RunTasks(group_num, parallel, [&](NNUInt g) {
+		const OBJGroup& group = result.groups[g];
+		const vector<OBJCorner>& unique = uniques[g];
+		for (NNUInt i = 0; i < group.vertex_num; ++i)
+		{
+			const OBJCorner& c = unique[i];
+			const NNUInt dst = group.vertex_offset + i;
+			result.positions[dst] = positions[c.v];
+			result.normals[dst] = c.n != OBJ_ABSENT ? normals[c.n] : smooth_normals[c.v];
+			result.texcoords[dst] = c.t != OBJ_ABSENT ? texcoords[c.t] : NNVec2(0.0f);
+		}
+		for (NNUInt i = group.index_offset; i < group.index_offset + group.index_num; ++i)
+		{
+			result.position_indices[i] = NNUInt(corners[i].v);
+		}
+	});
+	//
+	return true;
+}
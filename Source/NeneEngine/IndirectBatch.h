@@ -0,0 +1,114 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef INDIRECT_BATCH_H
+#define INDIRECT_BATCH_H
+
+#include <vector>
+#include <memory>
+
+#include "Types.h"
+#include "Material.h"
+#include "RenderQueue.h"
+
+class Mesh;
+class Shader;
+class Camera;
+
+//
+//    IndirectBatch: Draws arena meshes with one glMultiDrawElementsIndirect per (vertex pool, texture binding) group
+//
+
+class IndirectBatch
+{
+public:
+	// 每次绘制的数据, 着色器中按 std430 声明并用 gl_DrawIDARB 索引
+	struct DrawData
+	{
+		NNMat4 model;
+		NNVec4 params;
+		// 网格材质在纹理数组中的层, 同 MaterialCBDS::layers
+		NNVec4 layers[(NNTextureTypeNum + 3) / 4];
+	};
+	// 绘制数据绑定的 SSBO 位置
+	static const NNUInt DRAW_DATA_SLOT = 0;
+	// 上一次 Draw 的统计
+	struct Stats
+	{
+		NNUInt draws;
+		NNUInt multi_draws;
+	};
+
+public:
+	// 需要 GL_ARB_multi_draw_indirect 和 GL_ARB_shader_draw_parameters, 不支持时返回空
+	static std::shared_ptr<IndirectBatch> Create();
+	~IndirectBatch();
+	// 记录一个网格, 网格需要有索引 (即位于 GeometryArena 中)
+	void Add(const std::shared_ptr<Mesh>& mesh, const NNMat4& model, const NNVec4& params = NNVec4(0.0f));
+	// 修改已记录的绘制数据, index 为 Add 的顺序
+	void SetDrawData(const NNUInt index, const NNMat4& model, const NNVec4& params = NNVec4(0.0f));
+	void Clear();
+	// 分组并上传命令和绘制数据; 静态场景只需要构建一次, Add 之后的第一次 Draw 会自动调用
+	void Build();
+	// 每组绑定一次纹理和 VAO, 发出一次 MultiDraw
+	void Draw(const std::shared_ptr<Shader> pShader = nullptr, const std::shared_ptr<Camera> pCamera = nullptr);
+	//
+	inline NNUInt GetDrawNum() const { return (NNUInt)m_items.size(); }
+	inline NNUInt GetGroupNum() const { return (NNUInt)m_groups.size(); }
+	inline const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Item
+	{
+		std::shared_ptr<Mesh> mesh;
+		RenderGeometry geometry;
+		// 材质的纹理绑定, 没有材质时为网格的纹理组
+		const void* binding;
+		DrawData data;
+	};
+	// 同一组的命令和绘制数据连续存放
+	struct Group
+	{
+		RenderGeometry geometry;
+		const void* binding;
+		const Mesh* mesh;
+		NNUInt first_command;
+		NNUInt command_num;
+		size_t data_offset;
+		// 组内所有命令的索引数之和
+		NNULong index_num;
+	};
+	// 与 GL 的 DrawElementsIndirectCommand 相同
+	struct Command
+	{
+		NNUInt count;
+		NNUInt instance_count;
+		NNUInt first_index;
+		NNInt base_vertex;
+		NNUInt base_instance;
+	};
+
+private:
+	// 从网格的材质取出纹理绑定和层号
+	static void SetLayers(Item& item);
+
+private:
+	std::vector<Item> m_items;
+	std::vector<Group> m_groups;
+	// Add 的顺序 -> 绘制数据在缓冲中的位置
+	std::vector<size_t> m_data_offsets;
+	bool m_dirty;
+	Stats m_stats;
+#if defined NENE_GL
+	GLuint m_command_buffer;
+	GLuint m_data_buffer;
+	size_t m_command_capacity;
+	size_t m_data_capacity;
+	GLint m_alignment;
+#endif
+
+private:
+	IndirectBatch();
+	IndirectBatch(const IndirectBatch& rhs) = delete;
+	IndirectBatch& operator=(const IndirectBatch& rhs) = delete;
+};
+
+#endif // INDIRECT_BATCH_H
@@ -0,0 +1,234 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <numeric>
+#include <cstring>
+#include <algorithm>
+#include "Mesh.h"
+#include "Debug.h"
+#include "Camera.h"
+#include "Shader.h"
+#include "Profiler.h"
+#include "IndirectBatch.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+IndirectBatch::IndirectBatch() :
+	m_dirty(true), m_stats({ 0, 0 }), m_command_buffer(0), m_data_buffer(0), m_command_capacity(0), m_data_capacity(0), m_alignment(1)
+{}
+
+IndirectBatch::~IndirectBatch()
+{
+	RenderContext& ctx = RenderContext::instance();
+	ctx.forgetBuffer(m_command_buffer);
+	ctx.forgetBuffer(m_data_buffer);
+	// 在已经录制的绘制之后删除
+	const GLuint command_buffer = m_command_buffer, data_buffer = m_data_buffer;
+	RenderThread::Defer([command_buffer, data_buffer]()
+	{
+		if (command_buffer != 0) glDeleteBuffers(1, &command_buffer);
+		if (data_buffer != 0) glDeleteBuffers(1, &data_buffer);
+	});
+}
+
+// allocate 为真时按 size 重新分配存储, 否则写入 offset 处; 渲染线程运行时录制数据后回放
+static void UploadBuffer(const GLenum target, const GLuint buffer, const bool allocate, const GLenum usage, const size_t offset, const void* data, const size_t size)
+{
+	RenderStats::Add(NN_COUNTER_BUFFER_BYTES, size);
+	glBindBuffer(target, buffer);
+	if (allocate)
+	{
+		glBufferData(target, size, data, usage);
+	}
+	else
+	{
+		glBufferSubData(target, offset, size, data);
+	}
+	glBindBuffer(target, 0);
+}
+
+static void MultiDrawGroup(const GLuint data_buffer, const size_t data_offset, const size_t data_size, const GLenum mode, const GLenum type, const size_t command_offset, const GLsizei command_num)
+{
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, IndirectBatch::DRAW_DATA_SLOT, data_buffer, data_offset, data_size);
+	glMultiDrawElementsIndirect(mode, type, (const GLvoid*)command_offset, command_num, 0);
+}
+
+shared_ptr<IndirectBatch> IndirectBatch::Create()
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Create());
+	if (!GLEW_ARB_multi_draw_indirect || !GLEW_ARB_shader_draw_parameters || !GLEW_ARB_shader_storage_buffer_object)
+	{
+		dLog("[Error] Multi-draw indirect is not supported by this context.\n");
+		return nullptr;
+	}
+	IndirectBatch* result = new IndirectBatch();
+	glGenBuffers(1, &result->m_command_buffer);
+	glGenBuffers(1, &result->m_data_buffer);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &result->m_alignment);
+	result->m_alignment = max(result->m_alignment, 1);
+	return shared_ptr<IndirectBatch>(result);
+}
+
+void IndirectBatch::SetLayers(Item& item)
+{
+	const shared_ptr<Material>& material = item.mesh->GetMaterial();
+	if (material != nullptr)
+	{
+		item.binding = material->GetBindingKey();
+		const auto& layers = material->GetData().layers;
+		copy(begin(layers), end(layers), item.data.layers);
+	}
+	else
+	{
+		for (NNVec4& layer : item.data.layers)
+		{
+			layer = NNVec4(-1.0f);
+		}
+	}
+}
+
+void IndirectBatch::Add(const shared_ptr<Mesh>& mesh, const NNMat4& model, const NNVec4& params)
+{
+	//
+	const RenderGeometry geometry = mesh->GetGeometry();
+	if (geometry.index_type == 0)
+	{
+		dLog("[Error] Only indexed meshes can be drawn indirectly.\n");
+		return;
+	}
+	DrawData data{};
+	data.model = model;
+	data.params = params;
+	Item item = { mesh, geometry, &mesh->GetTextures(), data };
+	SetLayers(item);
+	m_items.push_back(item);
+	m_dirty = true;
+}
+
+void IndirectBatch::SetDrawData(const NNUInt index, const NNMat4& model, const NNVec4& params)
+{
+	//
+	if (index >= m_items.size())
+	{
+		return;
+	}
+	m_items[index].data.model = model;
+	m_items[index].data.params = params;
+	SetLayers(m_items[index]);
+	// 已经构建过时直接改写缓冲中的这一项
+	if (!m_dirty)
+	{
+		RenderThread::RecordData(&UploadBuffer, &m_items[index].data, sizeof(DrawData), (GLenum)GL_SHADER_STORAGE_BUFFER, m_data_buffer, false, (GLenum)GL_DYNAMIC_DRAW, m_data_offsets[index]);
+	}
+}
+
+void IndirectBatch::Clear()
+{
+	m_items.clear();
+	m_groups.clear();
+	m_data_offsets.clear();
+	m_dirty = true;
+}
+
+void IndirectBatch::Build()
+{
+	//
+	const size_t alignment = m_alignment;
+	// 按 (VAO, 图元, 纹理绑定) 排序, 相同的记录合并为一组
+	vector<NNUInt> order(m_items.size());
+	iota(order.begin(), order.end(), 0);
+	auto group_key = [](const RenderGeometry& g, const void* binding) {
+		return make_tuple(g.vertex_array, g.draw_mode, g.index_type, binding);
+	};
+	stable_sort(order.begin(), order.end(), [&](const NNUInt a, const NNUInt b) {
+		return group_key(m_items[a].geometry, m_items[a].binding) < group_key(m_items[b].geometry, m_items[b].binding);
+	});
+	//
+	vector<Command> commands;
+	vector<NNByte> data;
+	commands.reserve(m_items.size());
+	m_groups.clear();
+	m_data_offsets.assign(m_items.size(), 0);
+	for (const NNUInt i : order)
+	{
+		const Item& item = m_items[i];
+		if (m_groups.empty() || group_key(item.geometry, item.binding) != group_key(m_groups.back().geometry, m_groups.back().binding))
+		{
+			// gl_DrawIDARB 每次 MultiDraw 从 0 开始, 每组的数据从对齐的位置开始
+			const size_t offset = (data.size() + alignment - 1) / alignment * alignment;
+			data.resize(offset);
+			m_groups.push_back({ item.geometry, item.binding, item.mesh.get(), (NNUInt)commands.size(), 0, offset, 0 });
+		}
+		const NNUInt index_size = item.geometry.index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+		commands.push_back({ item.geometry.index_num, 1, item.geometry.index_offset / index_size, (NNInt)item.geometry.base_vertex, 0 });
+		m_groups.back().command_num += 1;
+		m_groups.back().index_num += item.geometry.index_num;
+		m_data_offsets[i] = data.size();
+		data.insert(data.end(), (const NNByte*)&item.data, (const NNByte*)&item.data + sizeof(DrawData));
+	}
+	// 上传, 容量不够时重新分配
+	const size_t command_bytes = commands.size() * sizeof(Command);
+	if (!commands.empty())
+	{
+		const bool allocate = command_bytes > m_command_capacity;
+		m_command_capacity = max(m_command_capacity, command_bytes);
+		RenderThread::RecordData(&UploadBuffer, commands.data(), command_bytes, (GLenum)GL_DRAW_INDIRECT_BUFFER, m_command_buffer, allocate, (GLenum)GL_STATIC_DRAW, (size_t)0);
+	}
+	if (!data.empty())
+	{
+		const bool allocate = data.size() > m_data_capacity;
+		m_data_capacity = max(m_data_capacity, data.size());
+		RenderThread::RecordData(&UploadBuffer, data.data(), data.size(), (GLenum)GL_SHADER_STORAGE_BUFFER, m_data_buffer, allocate, (GLenum)GL_DYNAMIC_DRAW, (size_t)0);
+	}
+	m_dirty = false;
+}
+
+void IndirectBatch::Draw(const shared_ptr<Shader> shader, const shared_ptr<Camera> camera)
+{
+	//
+	NN_PROFILE_ZONE("IndirectBatch");
+	if (m_dirty)
+	{
+		Build();
+	}
+	if (shader) shader->Use();
+	if (camera) camera->Use();
+	//
+	RenderContext& ctx = RenderContext::instance();
+	const void* current_binding = nullptr;
+	RenderThread::Record([](const GLuint buffer) { glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer); }, m_command_buffer);
+	for (const Group& group : m_groups)
+	{
+		// 打包到同一组纹理数组的材质只绑定一次, 层号在每次绘制的数据中
+		if (group.binding != current_binding)
+		{
+			if (group.mesh->GetMaterial() != nullptr)
+			{
+				group.mesh->GetMaterial()->UseTextures();
+			}
+			else
+			{
+				for (const auto& texture : group.mesh->GetTextures())
+				{
+					get<0>(texture)->Use(get<1>(texture));
+				}
+			}
+			current_binding = group.binding;
+		}
+		ctx.bindVertexArray(group.geometry.vertex_array);
+		RenderThread::Record(&MultiDrawGroup, m_data_buffer, group.data_offset, (size_t)group.command_num * sizeof(DrawData),
+			(GLenum)group.geometry.draw_mode, (GLenum)group.geometry.index_type, (size_t)group.first_command * sizeof(Command), (GLsizei)group.command_num);
+		RenderStats::Add(NN_COUNTER_DRAW_CALLS, 1);
+		RenderStats::Add(NN_COUNTER_PRIMITIVES, RenderContext::getPrimitiveNum(group.geometry.draw_mode, group.index_num));
+	}
+	RenderThread::Record([](const GLuint buffer) { glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer); }, (GLuint)0);
+	//
+	m_stats.draws = (NNUInt)m_items.size();
+	m_stats.multi_draws = (NNUInt)m_groups.size();
+}
+
+#endif // NENE_GL
@@ -4,35 +4,139 @@
 
 #include "Drawable.h"
 #include <vector>
+#include <memory>
+#include <type_traits>
+
+// 实例属性的位置: 模型矩阵占 8 ~ 11, 用户数据占 12 ~ 15
+static const NNUInt INSTANCE_MODEL_LOCATION = 8;
+static const NNUInt INSTANCE_DATA_LOCATION = 12;
+static const NNUInt INSTANCE_DATA_MAX_SIZE = 4 * sizeof(NNVec4);
 
 //
-//    Instance: 
+//    InstanceStream: Streaming buffer of per-instance attributes, bound as divisor-1 attributes by DrawInstanced
 //
+class InstanceStream {
+public:
+	// stride 为每个实例的字节数, 开头是模型矩阵, 之后 data_size 字节的用户数据
+	static std::shared_ptr<InstanceStream> Create(const NNUInt stride, const NNUInt data_size);
+	~InstanceStream();
+	// 写入流式缓冲的下一段, 不等待 GPU 读完之前的段; 写满时孤立旧的存储
+	void Upload(const void* data, const NNUInt instance_num);
+	// 由 DrawInstanced 在绑定 VAO 之后调用
+	void Bind() const;
+	void Unbind() const;
+	//
+	inline NNUInt GetInstanceNum() const { return m_instance_num; }
+private:
+	InstanceStream(const NNUInt stride, const NNUInt data_size);
+	InstanceStream(const InstanceStream& rhs) = delete;
+	InstanceStream& operator=(const InstanceStream& rhs) = delete;
+	//
+	NNUInt m_stride;
+	NNUInt m_data_size;
+	NNUInt m_instance_num;
+	// 缓冲大小, 本次绘制的段和下一次写入的位置
+	size_t m_capacity;
+	size_t m_offset;
+	size_t m_write;
+#if defined NENE_GL
+	NNUInt m_buffer;
+#elif defined NENE_DX
+	ID3D11Buffer* mpInstanceBuffer;
+#else
+	#error Please define NENE_GL or NENE_DX to select which Graphic-API you want to Use!
+#endif
+};
+
+// 没有用户数据的实例
+struct InstanceNoData {};
+
+template<typename T, bool Empty = std::is_empty<T>::value>
+struct InstanceElement {
+	NNMat4 model;
+	T data;
+};
+
 template<typename T>
+struct InstanceElement<T, true> {
+	NNMat4 model;
+};
+
+//
+//    Instance: Draw a drawable many times with per-instance model matrix and user data T (up to 4 vec4 of floats)
+//
+template<typename T = InstanceNoData>
 class Instance {
 public:
-	std::shared_ptr<Instance> Create(std::shared_ptr<Drawable> shape, std::vector<T> &data);
-	~Instance();
-	void Draw(Shader *pShader, Camera *pCamera);
+	static std::shared_ptr<Instance> Create(std::shared_ptr<Drawable> drawable, const NNUInt instance_num = 0);
+	~Instance() = default;
+	// 修改实例数据后调用 Update 上传
+	inline NNMat4& Model(const NNUInt index) { return mElements[index].model; }
+	inline T& Data(const NNUInt index) { return mElements[index].data; }
+	void Resize(const NNUInt instance_num);
+	inline NNUInt GetInstanceNum() const { return (NNUInt)mElements.size(); }
+	// 上传实例数据
+	void Update();
+	// 绘制所有实例, 每个实例的变换为 drawable 的模型矩阵乘以实例的模型矩阵
+	void Draw(const std::shared_ptr<Shader> pShader = nullptr, const std::shared_ptr<Camera> pCamera = nullptr);
 private:
 	//
 	Instance();
-	Instance(const Instance &rhs);
-	Instance& operator=(const Instance& rhs);
+	Instance(const Instance &rhs) = delete;
+	Instance& operator=(const Instance& rhs) = delete;
 	//
-	NNUInt mOffset;
-	NNUInt mInstancesNum;
-	NNUInt mPerInstanceSize;
+	static const NNUInt DATA_SIZE = std::is_empty<T>::value ? 0 : sizeof(T);
+	static_assert(DATA_SIZE % sizeof(NNFloat) == 0 && DATA_SIZE <= INSTANCE_DATA_MAX_SIZE, "Instance data should be made of at most 16 floats.");
 	//
-	std::shared_ptr<Drawable> mpShape;
+	bool mDirty;
+	std::vector<InstanceElement<T>> mElements;
 	//
-#if defined NENE_GL
-	NNUInt mVBO;
-#elif defined NENE_DX
-	ID3D11Buffer* pInstanceBuffer;
-#else
-	#error Please define NENE_GL or NENE_DX to select which Graphic-API you want to Use!
-#endif
+	std::shared_ptr<Drawable> mpDrawable;
+	std::shared_ptr<InstanceStream> mpStream;
 };
 
+template<typename T>
+Instance<T>::Instance() : mDirty(true) {}
+
+template<typename T>
+std::shared_ptr<Instance<T>> Instance<T>::Create(std::shared_ptr<Drawable> drawable, const NNUInt instance_num)
+{
+	//
+	std::shared_ptr<InstanceStream> stream = InstanceStream::Create(sizeof(InstanceElement<T>), DATA_SIZE);
+	if (drawable == nullptr || stream == nullptr)
+	{
+		return nullptr;
+	}
+	Instance* result = new Instance();
+	result->mpDrawable = drawable;
+	result->mpStream = stream;
+	result->Resize(instance_num);
+	return std::shared_ptr<Instance>(result);
+}
+
+template<typename T>
+void Instance<T>::Resize(const NNUInt instance_num)
+{
+	mElements.resize(instance_num, InstanceElement<T>{ NNMat4(1.0f) });
+	mDirty = true;
+}
+
+template<typename T>
+void Instance<T>::Update()
+{
+	mpStream->Upload(mElements.data(), (NNUInt)mElements.size());
+	mDirty = false;
+}
+
+template<typename T>
+void Instance<T>::Draw(const std::shared_ptr<Shader> pShader, const std::shared_ptr<Camera> pCamera)
+{
+	// 从未上传过时先上传一次
+	if (mDirty)
+	{
+		Update();
+	}
+	mpDrawable->DrawInstanced(*mpStream, pShader, pCamera);
+}
+
 #endif // INSTANCE_H
@@ -0,0 +1,137 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <cstring>
+#include <algorithm>
+#include "Debug.h"
+#include "Instance.h"
+#include "RenderThread.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+// 流式缓冲可以容纳的段数, 写满后孤立旧的存储
+static const size_t INSTANCE_STREAM_SEGMENTS = 3;
+
+InstanceStream::InstanceStream(const NNUInt stride, const NNUInt data_size) :
+	m_stride(stride), m_data_size(data_size), m_instance_num(0), m_capacity(0), m_offset(0), m_write(0), m_buffer(0)
+{}
+
+InstanceStream::~InstanceStream()
+{
+	// 在已经录制的绘制之后删除
+	const GLuint buffer = m_buffer;
+	RenderThread::Defer([buffer]() { if (buffer != 0) glDeleteBuffers(1, &buffer); });
+}
+
+shared_ptr<InstanceStream> InstanceStream::Create(const NNUInt stride, const NNUInt data_size)
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Create(stride, data_size));
+	if (stride < sizeof(NNMat4) + data_size)
+	{
+		dLog("[Error] Instance stride (%u) is smaller than its attributes (%u).\n", stride, (NNUInt)(sizeof(NNMat4) + data_size));
+		return nullptr;
+	}
+	InstanceStream* result = new InstanceStream(stride, data_size);
+	glGenBuffers(1, &result->m_buffer);
+	return shared_ptr<InstanceStream>(result);
+}
+
+// 写入一段实例数据, capacity 不为 0 时先重新分配 (孤立) 存储; 渲染线程运行时录制数据后回放
+static void WriteInstances(const GLuint buffer, const size_t capacity, const size_t offset, const void* data, const size_t size)
+{
+	RenderStats::Add(NN_COUNTER_BUFFER_BYTES, size);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (capacity != 0)
+	{
+		// 孤立: 驱动为正在使用的旧存储保留副本, 不需要等待 GPU
+		glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	}
+	// 写入的段在孤立之后没有被绘制使用过, 可以不同步
+	void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mapped != nullptr)
+	{
+		memcpy(mapped, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void BindInstanceAttributes(const GLuint buffer, const NNUInt stride, const NNUInt data_size, const size_t offset)
+{
+	//
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	// 模型矩阵按列占用 4 个位置
+	for (NNUInt i = 0; i < 4; ++i)
+	{
+		const NNUInt location = INSTANCE_MODEL_LOCATION + i;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (const void*)(offset + i * sizeof(NNVec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+	// 用户数据每 4 个浮点数占用 1 个位置
+	const NNUInt components = data_size / sizeof(NNFloat);
+	for (NNUInt i = 0; i * 4 < components; ++i)
+	{
+		const NNUInt location = INSTANCE_DATA_LOCATION + i;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, min(4u, components - i * 4), GL_FLOAT, GL_FALSE, stride, (const void*)(offset + sizeof(NNMat4) + i * sizeof(NNVec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void UnbindInstanceAttributes(const NNUInt data_size)
+{
+	// 恢复 VAO, 之后的普通绘制不受影响
+	const NNUInt locations = 4 + (data_size / sizeof(NNFloat) + 3) / 4;
+	for (NNUInt i = 0; i < locations; ++i)
+	{
+		glVertexAttribDivisor(INSTANCE_MODEL_LOCATION + i, 0);
+		glDisableVertexAttribArray(INSTANCE_MODEL_LOCATION + i);
+	}
+}
+
+void InstanceStream::Upload(const void* data, const NNUInt instance_num)
+{
+	//
+	m_instance_num = instance_num;
+	const size_t size = (size_t)instance_num * m_stride;
+	if (size == 0)
+	{
+		return;
+	}
+	size_t capacity = 0;
+	if (size > m_capacity)
+	{
+		m_capacity = size * INSTANCE_STREAM_SEGMENTS;
+		capacity = m_capacity;
+		m_write = 0;
+	}
+	else if (m_write + size > m_capacity)
+	{
+		capacity = m_capacity;
+		m_write = 0;
+	}
+	RenderThread::RecordData(&WriteInstances, data, size, (GLuint)m_buffer, capacity, m_write);
+	//
+	m_offset = m_write;
+	m_write += (size + 15) / 16 * 16;
+}
+
+void InstanceStream::Bind() const
+{
+	RenderThread::Record(&BindInstanceAttributes, (GLuint)m_buffer, m_stride, m_data_size, m_offset);
+}
+
+void InstanceStream::Unbind() const
+{
+	RenderThread::Record(&UnbindInstanceAttributes, m_data_size);
+}
+
+#endif // NENE_GL
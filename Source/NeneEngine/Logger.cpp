@@ -0,0 +1,322 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#include <cstdarg>
+#include <algorithm>
+#include "Debug.h"
+#include "Logger.h"
+
+using namespace std;
+
+// 每个线程的缓冲大小
+static const size_t RING_CAPACITY = 256 << 10;
+// 记录按 8 字节对齐, 保证头部可以直接读写
+static const size_t RECORD_ALIGNMENT = 8;
+// 缓冲末尾放不下时写入的跳过标记
+static const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+// 后台线程没有刷新请求时的输出间隔
+static const chrono::milliseconds FLUSH_INTERVAL(10);
+
+static const char* s_category_names[NNLogCategoryNum] = { "General", "Render", "Resource", "Shader", "Sample" };
+
+atomic<int> Logger::s_levels[NNLogCategoryNum] = {};
+
+// 线程退出时标记它的缓冲
+struct LoggerThreadRing
+{
+	shared_ptr<void> ring;
+	atomic<bool>* retired = nullptr;
+	~LoggerThreadRing()
+	{
+		if (retired != nullptr)
+		{
+			*retired = true;
+		}
+	}
+};
+
+static thread_local LoggerThreadRing tLoggerRing;
+
+Logger::Logger() :
+	m_thread_num(0), m_flush_requested(0), m_flush_done(0), m_stopping(false), m_console(true), m_file(nullptr), m_dropped(0), m_reported_dropped(0)
+{
+	// 调试级别 2 时保留原来 ddLog 的输出
+	SetLevel(NNDEBUG >= 2 ? NN_LOG_TRACE : NN_LOG_INFO);
+	m_thread = thread(&Logger::FlushLoop, this);
+}
+
+Logger::~Logger()
+{
+	//
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+	if (m_file != nullptr)
+	{
+		fclose(m_file);
+	}
+}
+
+Logger& Logger::Instance()
+{
+	static Logger instance;
+	return instance;
+}
+
+void Logger::SetLevel(const int level)
+{
+	for (atomic<int>& category_level : s_levels)
+	{
+		category_level = level;
+	}
+}
+
+void Logger::SetLevel(const NNLogCategory category, const int level)
+{
+	s_levels[category] = level;
+}
+
+int Logger::GetLevel(const NNLogCategory category)
+{
+	return s_levels[category];
+}
+
+const char* Logger::GetCategoryName(const NNLogCategory category)
+{
+	return s_category_names[category];
+}
+
+void Logger::Print(string& out, const char* format, ...)
+{
+	//
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	const int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	if (length < 0)
+	{
+		return;
+	}
+	if ((size_t)length < sizeof(buffer))
+	{
+		out.append(buffer, length);
+		return;
+	}
+	// 很长的消息再格式化一次
+	const size_t offset = out.size();
+	out.resize(offset + length + 1);
+	va_start(args, format);
+	vsnprintf(&out[offset], length + 1, format, args);
+	va_end(args);
+	out.resize(offset + length);
+}
+
+Logger::Ring& Logger::GetThreadRing()
+{
+	//
+	LoggerThreadRing& local = tLoggerRing;
+	if (local.ring == nullptr)
+	{
+		shared_ptr<Ring> ring = make_shared<Ring>();
+		ring->buffer.reset(new char[RING_CAPACITY]);
+		ring->capacity = RING_CAPACITY;
+		ring->head = 0;
+		ring->tail = 0;
+		ring->retired = false;
+		{
+			lock_guard<mutex> lock(m_rings_mutex);
+			ring->thread = m_thread_num++;
+			m_rings.push_back(ring);
+		}
+		local.retired = &ring->retired;
+		local.ring = ring;
+	}
+	return *(Ring*)local.ring.get();
+}
+
+char* Logger::Reserve(Ring& ring, const size_t size)
+{
+	//
+	const size_t aligned = (size + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+	size_t head = ring.head.load(memory_order_relaxed);
+	const size_t tail = ring.tail.load(memory_order_acquire);
+	const size_t offset = head % ring.capacity;
+	const size_t contiguous = ring.capacity - offset;
+	const size_t needed = contiguous < aligned ? contiguous + aligned : aligned;
+	if (aligned > ring.capacity / 2 || head + needed - tail > ring.capacity)
+	{
+		// 不阻塞写入的线程, 记录丢弃的数量
+		m_dropped += 1;
+		return nullptr;
+	}
+	if (contiguous < aligned)
+	{
+		memcpy(ring.buffer.get() + offset, &WRAP_MARKER, sizeof(uint32_t));
+		head += contiguous;
+		ring.head.store(head, memory_order_release);
+	}
+	char* record = ring.buffer.get() + head % ring.capacity;
+	((Header*)record)->size = (uint32_t)aligned;
+	return record;
+}
+
+void Logger::Commit(Ring& ring, char* record)
+{
+	ring.head.store(ring.head.load(memory_order_relaxed) + ((Header*)record)->size, memory_order_release);
+}
+
+bool Logger::Drain(vector<Entry>& entries)
+{
+	//
+	vector<shared_ptr<Ring>> rings;
+	{
+		lock_guard<mutex> lock(m_rings_mutex);
+		rings = m_rings;
+	}
+	bool retired_empty = false;
+	for (const shared_ptr<Ring>& ring : rings)
+	{
+		// 先读 retired, 之后读到的 head 一定包含线程退出前的所有记录
+		const bool retired = ring->retired.load(memory_order_acquire);
+		const size_t head = ring->head.load(memory_order_acquire);
+		size_t tail = ring->tail.load(memory_order_relaxed);
+		while (tail < head)
+		{
+			const char* record = ring->buffer.get() + tail % ring->capacity;
+			uint32_t size;
+			memcpy(&size, record, sizeof(uint32_t));
+			if (size == WRAP_MARKER)
+			{
+				tail += ring->capacity - tail % ring->capacity;
+				continue;
+			}
+			const Header* header = (const Header*)record;
+			Entry entry;
+			entry.timestamp = header->timestamp;
+			entry.thread = ring->thread;
+			if (header->category != NN_LOG_GENERAL)
+			{
+				entry.text.append("[").append(s_category_names[header->category]).append("] ");
+			}
+			header->formatter(header->format, record + sizeof(Header), entry.text);
+			// 和原来的 dLog 一样每条一行, 格式串自带的换行不重复
+			if (entry.text.empty() || entry.text.back() != '\n')
+			{
+				entry.text.push_back('\n');
+			}
+			entries.push_back(move(entry));
+			tail += size;
+		}
+		ring->tail.store(tail, memory_order_release);
+		retired_empty = retired_empty || retired;
+	}
+	return retired_empty;
+}
+
+void Logger::Output(vector<Entry>& entries)
+{
+	//
+	const uint64_t dropped = m_dropped;
+	if (dropped != m_reported_dropped)
+	{
+		Entry entry;
+		entry.timestamp = 0;
+		entry.thread = 0;
+		Print(entry.text, "[Warning] Logger dropped %llu records, the ring buffer is full.\n", (unsigned long long)(dropped - m_reported_dropped));
+		entries.push_back(move(entry));
+		m_reported_dropped = dropped;
+	}
+	if (entries.empty())
+	{
+		return;
+	}
+	// 不同线程的记录按时间排序
+	stable_sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.timestamp < rhs.timestamp; });
+	for (const Entry& entry : entries)
+	{
+		if (m_console)
+		{
+			fwrite(entry.text.data(), 1, entry.text.size(), stdout);
+		}
+		if (m_file != nullptr)
+		{
+			fwrite(entry.text.data(), 1, entry.text.size(), m_file);
+		}
+	}
+	fflush(stdout);
+	if (m_file != nullptr)
+	{
+		fflush(m_file);
+	}
+	entries.clear();
+}
+
+void Logger::FlushLoop()
+{
+	//
+	vector<Entry> entries;
+	while (true)
+	{
+		uint64_t requested;
+		bool stopping;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_condition.wait_for(lock, FLUSH_INTERVAL, [this]() { return m_stopping || m_flush_requested != m_flush_done; });
+			requested = m_flush_requested;
+			stopping = m_stopping;
+		}
+		if (Drain(entries))
+		{
+			// 已经退出的线程的缓冲输出完后移除
+			lock_guard<mutex> lock(m_rings_mutex);
+			m_rings.erase(remove_if(m_rings.begin(), m_rings.end(), [](const shared_ptr<Ring>& ring) {
+				return ring->retired && ring->tail.load() == ring->head.load();
+			}), m_rings.end());
+		}
+		{
+			lock_guard<mutex> lock(m_mutex);
+			Output(entries);
+			m_flush_done = requested;
+		}
+		m_flushed_condition.notify_all();
+		if (stopping)
+		{
+			break;
+		}
+	}
+}
+
+void Logger::Flush()
+{
+	//
+	unique_lock<mutex> lock(m_mutex);
+	if (m_stopping)
+	{
+		return;
+	}
+	const uint64_t ticket = ++m_flush_requested;
+	m_condition.notify_all();
+	m_flushed_condition.wait(lock, [this, ticket]() { return m_flush_done >= ticket || m_stopping; });
+}
+
+bool Logger::SetFile(const char* filepath)
+{
+	//
+	lock_guard<mutex> lock(m_mutex);
+	if (m_file != nullptr)
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+	if (filepath == nullptr)
+	{
+		return true;
+	}
+	m_file = fopen(filepath, "w");
+	return m_file != nullptr;
+}
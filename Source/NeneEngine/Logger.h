@@ -0,0 +1,208 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <condition_variable>
+#include <type_traits>
+
+// 日志级别, 编译期的阈值 NN_LOG_MIN_LEVEL 也用它们比较
+#define NN_LOG_TRACE 0
+#define NN_LOG_DEBUG 1
+#define NN_LOG_INFO 2
+#define NN_LOG_WARNING 3
+#define NN_LOG_ERROR 4
+#define NN_LOG_OFF 5
+
+// 日志分类, 每个分类可以单独设置级别
+enum NNLogCategory {
+	NN_LOG_GENERAL = 0, NN_LOG_RENDER, NN_LOG_RESOURCE, NN_LOG_SHADER, NN_LOG_SAMPLE,
+	NNLogCategoryNum
+};
+
+// 参数在记录中的编码: 数值和指针按原样拷贝, 字符串拷贝内容 (输出时原来的字符串可能已经释放)
+template<typename T, typename Enable = void>
+struct LogArgCodec
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Log arguments must be numbers, pointers or strings.");
+	typedef T Decoded;
+	static size_t Size(const T&) { return sizeof(T); }
+	static void Encode(char*& dst, const T& value) { memcpy(dst, &value, sizeof(T)); dst += sizeof(T); }
+	static T Decode(const char*& src) { T value; memcpy(&value, src, sizeof(T)); src += sizeof(T); return value; }
+};
+
+struct LogStringCodec
+{
+	typedef const char* Decoded;
+	static size_t Size(const char* value) { return sizeof(uint32_t) + (value != nullptr ? strlen(value) : 0) + 1; }
+	static void Encode(char*& dst, const char* value)
+	{
+		const uint32_t length = value != nullptr ? (uint32_t)strlen(value) : 0;
+		memcpy(dst, &length, sizeof(uint32_t));
+		memcpy(dst + sizeof(uint32_t), value != nullptr ? value : "", length + 1);
+		dst += sizeof(uint32_t) + length + 1;
+	}
+	static const char* Decode(const char*& src)
+	{
+		uint32_t length;
+		memcpy(&length, src, sizeof(uint32_t));
+		const char* value = src + sizeof(uint32_t);
+		src += sizeof(uint32_t) + length + 1;
+		return value;
+	}
+};
+
+template<>
+struct LogArgCodec<const char*> : LogStringCodec {};
+template<>
+struct LogArgCodec<char*> : LogStringCodec {};
+template<>
+struct LogArgCodec<std::string> : LogStringCodec
+{
+	static size_t Size(const std::string& value) { return LogStringCodec::Size(value.c_str()); }
+	static void Encode(char*& dst, const std::string& value) { LogStringCodec::Encode(dst, value.c_str()); }
+};
+
+//
+//    Logger: A singleton writing binary records (format + arguments) into per-thread lock-free rings, formatted and flushed on a background thread
+//
+
+class Logger
+{
+public:
+	// 获取单例
+	static Logger& Instance();
+	// 运行时的级别检查, 不需要访问单例
+	static inline bool IsEnabled(const int level, const int category) { return level >= s_levels[category].load(std::memory_order_relaxed); }
+	// 设置所有分类或一个分类的最低级别
+	static void SetLevel(const int level);
+	static void SetLevel(const NNLogCategory category, const int level);
+	static int GetLevel(const NNLogCategory category);
+	static const char* GetCategoryName(const NNLogCategory category);
+	// 格式串必须是字面量, 记录中只保存它的地址
+	template<typename... Args>
+	void Write(const int level, const int category, const char* format, const Args&... args);
+	// 阻塞到之前写入的记录都已输出
+	void Flush();
+	// 同时写入文件, 传入 nullptr 关闭
+	bool SetFile(const char* filepath);
+	inline void SetConsole(const bool enabled) { m_console = enabled; }
+	// 环形缓冲满时丢弃的记录数
+	inline uint64_t GetDroppedNum() const { return m_dropped; }
+
+public:
+	~Logger();
+
+private:
+	typedef void (*FormatFunction)(const char* format, const char* data, std::string& out);
+	// 每个线程一个单生产者单消费者的环形缓冲, head 和 tail 单调递增
+	struct Ring
+	{
+		std::unique_ptr<char[]> buffer;
+		size_t capacity;
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+		// 线程退出后, 输出完剩余记录再移除
+		std::atomic<bool> retired;
+		uint32_t thread;
+	};
+	struct Header
+	{
+		uint32_t size;
+		uint8_t level;
+		uint8_t category;
+		uint16_t reserved;
+		const char* format;
+		FormatFunction formatter;
+		uint64_t timestamp;
+	};
+	struct Entry
+	{
+		uint64_t timestamp;
+		uint32_t thread;
+		std::string text;
+	};
+
+private:
+	template<typename... Args>
+	static void Format(const char* format, const char* data, std::string& out);
+	static void Print(std::string& out, const char* format, ...);
+	// 预留 size 字节, 缓冲满时返回 nullptr
+	char* Reserve(Ring& ring, const size_t size);
+	void Commit(Ring& ring, char* record);
+	Ring& GetThreadRing();
+	void FlushLoop();
+	bool Drain(std::vector<Entry>& entries);
+	void Output(std::vector<Entry>& entries);
+
+private:
+	static std::atomic<int> s_levels[NNLogCategoryNum];
+	//
+	std::mutex m_rings_mutex;
+	std::vector<std::shared_ptr<Ring>> m_rings;
+	uint32_t m_thread_num;
+	// 后台线程
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::condition_variable m_flushed_condition;
+	uint64_t m_flush_requested;
+	uint64_t m_flush_done;
+	bool m_stopping;
+	//
+	std::atomic<bool> m_console;
+	FILE* m_file;
+	std::atomic<uint64_t> m_dropped;
+	uint64_t m_reported_dropped;
+
+private:
+	Logger();
+	Logger(const Logger& rhs) = delete;
+	Logger& operator=(const Logger& rhs) = delete;
+};
+
+template<typename... Args>
+void Logger::Format(const char* format, const char* data, std::string& out)
+{
+	// 花括号初始化保证从左到右解码
+	const char* cursor = data;
+	std::tuple<typename LogArgCodec<Args>::Decoded...> values{ LogArgCodec<Args>::Decode(cursor)... };
+	(void)cursor;
+	std::apply([&](const auto&... decoded) { Print(out, format, decoded...); }, values);
+}
+
+template<typename... Args>
+void Logger::Write(const int level, const int category, const char* format, const Args&... args)
+{
+	//
+	const size_t payload = (size_t(0) + ... + LogArgCodec<std::decay_t<Args>>::Size(args));
+	Ring& ring = GetThreadRing();
+	char* record = Reserve(ring, sizeof(Header) + payload);
+	if (record == nullptr)
+	{
+		return;
+	}
+	Header* header = (Header*)record;
+	header->level = (uint8_t)level;
+	header->category = (uint8_t)category;
+	header->reserved = 0;
+	header->format = format;
+	header->formatter = &Format<std::decay_t<Args>...>;
+	header->timestamp = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+	char* cursor = record + sizeof(Header);
+	(LogArgCodec<std::decay_t<Args>>::Encode(cursor, args), ...);
+	(void)cursor;
+	Commit(ring, record);
+}
+
+#endif // LOGGER_H
@@ -0,0 +1,214 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <map>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+#include "Debug.h"
+#include "NeneCB.h"
+#include "Shader.h"
+#include "Material.h"
+#include "Texture2D.h"
+#include "TextureArray.h"
+
+using namespace std;
+
+// 编号只在主线程分配, 0 表示没有着色器
+static NNUInt s_material_num = 0;
+static NNUInt s_binding_num = 0;
+static unordered_map<const Shader*, NNUInt> s_shader_ids;
+
+static NNUInt GetShaderID(const Shader* shader)
+{
+	if (shader == nullptr)
+	{
+		return 0;
+	}
+	auto it = s_shader_ids.find(shader);
+	if (it != s_shader_ids.end())
+	{
+		return it->second;
+	}
+	const NNUInt id = (NNUInt)s_shader_ids.size() + 1;
+	s_shader_ids.insert(make_pair(shader, id));
+	return id;
+}
+
+static void ResetLayers(MaterialCBDS& data)
+{
+	for (NNVec4& layer : data.layers)
+	{
+		layer = NNVec4(-1.0f);
+	}
+}
+
+Material::Material() : m_block({ 0, 0, 0 }), m_id(0), m_shader_id(0), m_dirty(true), m_packed(false)
+{}
+
+Material::~Material()
+{
+	UniformPool::Instance().Free(m_block);
+}
+
+shared_ptr<Material> Material::Create(shared_ptr<Shader> shader, const TextureBindings& textures)
+{
+	//
+	UniformPool::Block block = UniformPool::Instance().Allocate(sizeof(MaterialCBDS));
+	if (!block.IsValid())
+	{
+		return nullptr;
+	}
+	Material* result = new Material();
+	result->m_block = block;
+	result->m_id = ++s_material_num;
+	result->m_textures = textures;
+	// 未打包时纹理类型即为槽位, 与 Texture2D::Use(type) 相同
+	result->m_binding = make_shared<Binding>();
+	result->m_binding->id = ++s_binding_num;
+	for (const auto& texture : textures)
+	{
+		result->m_binding->textures.emplace_back(get<0>(texture), (NNUInt)get<1>(texture));
+	}
+	result->m_data.color = NNVec4(1.0f, 1.0f, 1.0f, 1.0f);
+	result->m_data.params = NNVec4(0.0f, 0.0f, 0.0f, 0.0f);
+	ResetLayers(result->m_data);
+	result->SetShader(shader);
+	return shared_ptr<Material>(result);
+}
+
+void Material::SetShader(shared_ptr<Shader> shader)
+{
+	m_shader = shader;
+	m_shader_id = GetShaderID(shader.get());
+}
+
+MaterialCBDS& Material::Data()
+{
+	m_dirty = true;
+	return m_data;
+}
+
+void Material::Use()
+{
+	if (m_shader) m_shader->Use();
+	UseTextures();
+	UseParams();
+}
+
+void Material::UseTextures() const
+{
+	for (const auto& texture : m_binding->textures)
+	{
+		get<0>(texture)->Use(get<1>(texture));
+	}
+}
+
+void Material::UseParams()
+{
+	// 参数块常驻在 UniformPool 中, 只在修改后上传
+	UniformPool& pool = UniformPool::Instance();
+	if (m_dirty)
+	{
+		pool.Write(m_block, m_data);
+		m_dirty = false;
+	}
+	pool.Bind(m_block, MATERIAL_SLOT);
+}
+
+NNUInt Material::GetSortKey() const
+{
+	const NNUInt shader_id = m_shader_id < 0xFFFF ? m_shader_id : 0xFFFF;
+	return (shader_id << 16) | (m_binding->id & 0xFFFF);
+}
+
+NNUInt Material::Pack(const vector<shared_ptr<Material>>& materials)
+{
+	// 按 (类型, 宽, 高, 格式) 收集不重复的纹理
+	typedef tuple<NNUInt, NNUInt, NNUInt, NNUInt> GroupKey;
+	map<GroupKey, vector<shared_ptr<Texture2D>>> groups;
+	unordered_set<const Texture2D*> visited;
+	for (const shared_ptr<Material>& material : materials)
+	{
+		for (const auto& texture : material->m_textures)
+		{
+			const shared_ptr<Texture2D>& texture2d = get<0>(texture);
+			if (texture2d == nullptr || texture2d->GetWidth() == 0 || !visited.insert(texture2d.get()).second)
+			{
+				continue;
+			}
+			groups[GroupKey(get<1>(texture), texture2d->GetWidth(), texture2d->GetHeight(), texture2d->GetFormat())].push_back(texture2d);
+		}
+	}
+	// 每组拷贝到一个或多个纹理数组
+	unordered_map<const Texture2D*, tuple<shared_ptr<TextureArray>, NNUInt>> placements;
+	const NNUInt max_layers = TextureArray::GetMaxLayerNum();
+	for (const auto& group : groups)
+	{
+		const vector<shared_ptr<Texture2D>>& textures = group.second;
+		for (size_t begin = 0; begin < textures.size(); begin += max_layers)
+		{
+			const size_t end = begin + max_layers < textures.size() ? begin + max_layers : textures.size();
+			vector<shared_ptr<Texture2D>> layers(textures.begin() + begin, textures.begin() + end);
+			shared_ptr<TextureArray> array = TextureArray::Create(layers);
+			if (array == nullptr)
+			{
+				continue;
+			}
+			for (NNUInt layer = 0; layer < layers.size(); ++layer)
+			{
+				placements[layers[layer].get()] = make_tuple(array, layer);
+			}
+		}
+	}
+	// 所有纹理都打包成功的材质换用纹理数组, 相同的数组组合共享一个绑定
+	map<vector<tuple<const Texture*, NNUInt>>, shared_ptr<Binding>> bindings;
+	unordered_set<const Binding*> used;
+	for (const shared_ptr<Material>& material : materials)
+	{
+		vector<tuple<shared_ptr<Texture>, NNUInt>> textures;
+		vector<tuple<NNUInt, NNUInt>> layers;
+		bool packed = !material->m_textures.empty();
+		for (const auto& texture : material->m_textures)
+		{
+			auto it = placements.find(get<0>(texture).get());
+			if (it == placements.end())
+			{
+				packed = false;
+				break;
+			}
+			textures.emplace_back(get<0>(it->second), (NNUInt)get<1>(texture));
+			layers.emplace_back((NNUInt)get<1>(texture), get<1>(it->second));
+		}
+		if (!packed)
+		{
+			used.insert(material->m_binding.get());
+			continue;
+		}
+		sort(textures.begin(), textures.end(), [](const tuple<shared_ptr<Texture>, NNUInt>& a, const tuple<shared_ptr<Texture>, NNUInt>& b) {
+			return get<1>(a) < get<1>(b);
+		});
+		vector<tuple<const Texture*, NNUInt>> key;
+		for (const auto& texture : textures)
+		{
+			key.emplace_back(get<0>(texture).get(), get<1>(texture));
+		}
+		shared_ptr<Binding>& binding = bindings[key];
+		if (binding == nullptr)
+		{
+			binding = make_shared<Binding>();
+			binding->id = ++s_binding_num;
+			binding->textures = textures;
+		}
+		material->m_binding = binding;
+		material->m_packed = true;
+		MaterialCBDS& data = material->Data();
+		ResetLayers(data);
+		for (const auto& layer : layers)
+		{
+			reinterpret_cast<NNFloat*>(data.layers)[get<0>(layer)] = (NNFloat)get<1>(layer);
+		}
+		used.insert(binding.get());
+	}
+	dLog("[Info] Packed %zd materials into %zd texture bindings.\n", materials.size(), used.size());
+	return (NNUInt)used.size();
+}
@@ -0,0 +1,81 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <tuple>
+#include <vector>
+#include <memory>
+
+#include "Types.h"
+#include "UniformPool.h"
+#include "RenderQueue.h"
+
+class Shader;
+class Texture;
+
+// 材质参数, 按 std140 绑定到 MATERIAL_SLOT
+struct MaterialCBDS {
+	NNVec4 color;
+	NNVec4 params;
+	// 每种纹理在纹理数组中的层, 按 NNTextureType 排列, 未打包时为 -1
+	NNVec4 layers[(NNTextureTypeNum + 3) / 4];
+};
+
+//
+//    Material: Shader, parameter block and textures shared by meshes; packed materials share texture array bindings
+//
+
+class Material
+{
+public:
+	// 一组纹理绑定, 打包到同一组纹理数组的材质共享同一个对象
+	struct Binding
+	{
+		NNUInt id;
+		std::vector<std::tuple<std::shared_ptr<Texture>, NNUInt>> textures;
+	};
+
+public:
+	// shader 可以为空, 由绘制时传入的着色器代替
+	static std::shared_ptr<Material> Create(std::shared_ptr<Shader> shader, const TextureBindings& textures = TextureBindings());
+	~Material();
+	//
+	void SetShader(std::shared_ptr<Shader> shader);
+	inline const std::shared_ptr<Shader>& GetShader() const { return m_shader; }
+	inline const TextureBindings& GetTextures() const { return m_textures; }
+	// 修改参数, 下次 UseParams 时上传
+	MaterialCBDS& Data();
+	inline const MaterialCBDS& GetData() const { return m_data; }
+	// 绑定着色器 (非空时), 纹理和参数
+	void Use();
+	// 纹理绑定相同的材质之间切换时只需要 UseParams
+	void UseTextures() const;
+	void UseParams();
+	//
+	inline NNUInt GetID() const { return m_id; }
+	inline bool IsPacked() const { return m_packed; }
+	// 纹理绑定的标识, 可以作为渲染队列的材质键
+	inline const void* GetBindingKey() const { return m_binding.get(); }
+	// 高 16 位为着色器编号, 低 16 位为纹理绑定编号, 编号在程序运行期间不变
+	NNUInt GetSortKey() const;
+	// 尺寸和格式相同的纹理按类型打包成纹理数组, 材质通过参数中的层号选择纹理; 返回不同纹理绑定的数量
+	static NNUInt Pack(const std::vector<std::shared_ptr<Material>>& materials);
+
+private:
+	std::shared_ptr<Shader> m_shader;
+	TextureBindings m_textures;
+	std::shared_ptr<Binding> m_binding;
+	MaterialCBDS m_data;
+	UniformPool::Block m_block;
+	NNUInt m_id;
+	NNUInt m_shader_id;
+	bool m_dirty;
+	bool m_packed;
+
+private:
+	Material();
+	Material(const Material& rhs) = delete;
+	Material& operator=(const Material& rhs) = delete;
+};
+
+#endif // MATERIAL_H
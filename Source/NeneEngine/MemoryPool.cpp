@@ -0,0 +1,104 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include "MemoryPool.h"
+
+using namespace std;
+
+// 最小 4KB, 默认最多缓存 256MB 空闲内存
+static const NNUInt MIN_SIZE_CLASS = 12;
+static const size_t DEFAULT_CAPACITY = 256 << 20;
+
+static NNUInt GetSizeClass(const size_t size)
+{
+	NNUInt size_class = MIN_SIZE_CLASS;
+	while (((size_t)1 << size_class) < size)
+	{
+		++size_class;
+	}
+	return size_class;
+}
+
+MemoryPool::MemoryPool() : m_state(make_shared<State>())
+{
+	m_state->cached_bytes = 0;
+	m_state->capacity = DEFAULT_CAPACITY;
+}
+
+MemoryPool::~MemoryPool()
+{
+	Trim();
+}
+
+MemoryPool& MemoryPool::Instance()
+{
+	static MemoryPool instance;
+	return instance;
+}
+
+shared_ptr<NNByte[]> MemoryPool::Acquire(const size_t size)
+{
+	//
+	const NNUInt size_class = GetSizeClass(size);
+	NNByte* buffer = nullptr;
+	{
+		lock_guard<mutex> lock(m_state->mutex);
+		vector<NNByte*>& free_list = m_state->free_lists[size_class];
+		if (!free_list.empty())
+		{
+			buffer = free_list.back();
+			free_list.pop_back();
+			m_state->cached_bytes -= (size_t)1 << size_class;
+		}
+	}
+	if (buffer == nullptr)
+	{
+		buffer = new NNByte[(size_t)1 << size_class];
+	}
+	// 归还到空闲列表
+	shared_ptr<State> state = m_state;
+	return shared_ptr<NNByte[]>(buffer, [state, size_class](NNByte* buffer) {
+		const size_t bytes = (size_t)1 << size_class;
+		{
+			lock_guard<mutex> lock(state->mutex);
+			if (state->cached_bytes + bytes <= state->capacity)
+			{
+				state->free_lists[size_class].push_back(buffer);
+				state->cached_bytes += bytes;
+				return;
+			}
+		}
+		delete[] buffer;
+	});
+}
+
+void MemoryPool::SetCapacity(const size_t bytes)
+{
+	{
+		lock_guard<mutex> lock(m_state->mutex);
+		m_state->capacity = bytes;
+	}
+	if (GetCachedBytes() > bytes)
+	{
+		Trim();
+	}
+}
+
+void MemoryPool::Trim()
+{
+	lock_guard<mutex> lock(m_state->mutex);
+	for (vector<NNByte*>& free_list : m_state->free_lists)
+	{
+		for (NNByte* buffer : free_list)
+		{
+			delete[] buffer;
+		}
+		free_list.clear();
+	}
+	m_state->cached_bytes = 0;
+}
+
+size_t MemoryPool::GetCachedBytes() const
+{
+	lock_guard<mutex> lock(m_state->mutex);
+	return m_state->cached_bytes;
+}
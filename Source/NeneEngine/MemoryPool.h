@@ -0,0 +1,50 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+#include "Types.h"
+
+//
+//    MemoryPool: A thread safe singleton recycling large CPU buffers (e.g. decoded images) by power-of-two size class
+//
+
+class MemoryPool
+{
+public:
+	// 获取单例
+	static MemoryPool& Instance();
+	// 获取至少 size 字节的内存, 最后一个引用释放时自动归还
+	std::shared_ptr<NNByte[]> Acquire(const size_t size);
+	// 空闲内存的上限, 超出时归还的内存直接释放
+	void SetCapacity(const size_t bytes);
+	// 释放所有空闲内存
+	void Trim();
+	//
+	size_t GetCachedBytes() const;
+
+public:
+	~MemoryPool();
+
+private:
+	// 归还内存的删除器持有这份状态, 单例析构后归还也是安全的
+	struct State
+	{
+		std::mutex mutex;
+		std::array<std::vector<NNByte*>, 64> free_lists;
+		size_t cached_bytes;
+		size_t capacity;
+	};
+	std::shared_ptr<State> m_state;
+
+private:
+	MemoryPool();
+	MemoryPool(const MemoryPool& rhs) = delete;
+	MemoryPool& operator=(const MemoryPool& rhs) = delete;
+};
+
+#endif // MEMORY_POOL_H
@@ -0,0 +1,148 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cstring>
+#include <unordered_set>
+#include "Mesh.h"
+#include "Debug.h"
+
+using namespace std;
+
+/** Residency >>> */
+
+// 所有存活的网格, 只在主线程访问
+static unordered_set<const Mesh*> s_all_meshes;
+static NNMeshResidency s_default_residency = NN_RESIDENCY_GPU_ONLY;
+
+void Mesh::SetDefaultResidency(const NNMeshResidency residency)
+{
+	s_default_residency = residency;
+}
+
+NNMeshResidency Mesh::GetDefaultResidency()
+{
+	return s_default_residency;
+}
+
+void Mesh::Track()
+{
+	s_all_meshes.insert(this);
+	SetResidency(s_default_residency);
+}
+
+void Mesh::Untrack()
+{
+	s_all_meshes.erase(this);
+}
+
+size_t Mesh::GetCPUBytes() const
+{
+	return m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(NNUInt) +
+		m_compact_positions.size() * sizeof(NNVec3) + m_compact_indices.size();
+}
+
+size_t Mesh::GetGPUBytes() const
+{
+	return (size_t)m_vertex_num * m_layout->stride + (size_t)m_index_num * m_index_size;
+}
+
+Mesh::MemoryStats Mesh::GetMemoryStats()
+{
+	MemoryStats stats = { 0, 0, 0, 0 };
+	for (const Mesh* mesh : s_all_meshes)
+	{
+		const size_t full_bytes = mesh->m_vertex_num * sizeof(Vertex) + mesh->m_index_num * sizeof(NNUInt);
+		const size_t cpu_bytes = mesh->GetCPUBytes();
+		stats.mesh_num += 1;
+		stats.gpu_bytes += mesh->GetGPUBytes();
+		stats.cpu_bytes += cpu_bytes;
+		stats.cpu_bytes_saved += full_bytes > cpu_bytes ? full_bytes - cpu_bytes : 0;
+	}
+	return stats;
+}
+
+void Mesh::SetPageInSource(PageInSource source)
+{
+	m_page_in_source = source;
+}
+
+bool Mesh::PageIn() const
+{
+	//
+	if (m_residency == NN_RESIDENCY_CPU_GPU)
+	{
+		return true;
+	}
+	// 优先从缓存换入, 避免同步等待 GPU
+	vector<Vertex> vertices;
+	vector<NNUInt> indices;
+	bool loaded = m_page_in_source && m_page_in_source(vertices, indices) && vertices.size() == m_vertex_num && indices.size() == m_index_num;
+	if (!loaded && !ReadBack(vertices, indices))
+	{
+		dLog("[Error] Failed to page in mesh data.");
+		return false;
+	}
+	m_vertices = move(vertices);
+	m_indices = move(indices);
+	m_residency = NN_RESIDENCY_CPU_GPU;
+	return true;
+}
+
+void Mesh::SetResidency(const NNMeshResidency residency)
+{
+	//
+	if (residency == m_residency)
+	{
+		return;
+	}
+	if (residency == NN_RESIDENCY_CPU_COMPACT)
+	{
+		if (!PageIn())
+		{
+			return;
+		}
+		m_compact_positions.resize(m_vertices.size());
+		for (size_t i = 0; i < m_vertices.size(); ++i)
+		{
+			m_compact_positions[i] = m_vertices[i].m_position;
+		}
+		// 与显存使用相同的索引宽度
+		m_compact_index_size = IndexPacking::GetIndexSize(m_vertex_num);
+		m_compact_indices.resize(m_indices.size() * m_compact_index_size);
+		IndexPacking::Pack(m_indices.data(), (NNUInt)m_indices.size(), m_compact_index_size, m_compact_indices.data());
+	}
+	else if (residency == NN_RESIDENCY_CPU_GPU)
+	{
+		if (!PageIn())
+		{
+			return;
+		}
+	}
+	// 释放不再需要的数据
+	if (residency != NN_RESIDENCY_CPU_GPU)
+	{
+		vector<Vertex>().swap(m_vertices);
+		vector<NNUInt>().swap(m_indices);
+	}
+	if (residency != NN_RESIDENCY_CPU_COMPACT)
+	{
+		vector<NNVec3>().swap(m_compact_positions);
+		vector<NNByte>().swap(m_compact_indices);
+		m_compact_index_size = 0;
+	}
+	m_residency = residency;
+}
+
+NNUInt Mesh::GetCompactIndex(const NNUInt i) const
+{
+	if (m_compact_index_size == sizeof(uint16_t))
+	{
+		uint16_t index;
+		memcpy(&index, m_compact_indices.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+		return index;
+	}
+	NNUInt index;
+	memcpy(&index, m_compact_indices.data() + i * sizeof(NNUInt), sizeof(NNUInt));
+	return index;
+}
+
+/** Residency <<< */
@@ -4,43 +4,105 @@
 
 #include "Shader.h"
 #include "Texture2D.h"
+#include "VertexLayout.h"
+#include "Bounds.h"
+#include "Material.h"
+#include "RenderQueue.h"
 #include <vector>
+#include <functional>
 
 class MeshImpl;
-
-//
-//    Vertex:
-//
-struct Vertex 
-{
-	NNVec3 m_position;
-	NNVec3 m_normal;
-	NNVec2 m_texcoord;
-};
+class InstanceStream;
 
 //
 //    Mesh:
 //
 class Mesh 
 {
+public:
+	// 所有网格的内存占用
+	struct MemoryStats
+	{
+		NNUInt mesh_num;
+		size_t gpu_bytes;
+		size_t cpu_bytes;
+		// 与全部保留完整 CPU 数据相比节省的内存
+		size_t cpu_bytes_saved;
+	};
+	// 从缓存等来源换入 CPU 数据, 返回 false 时从显存回读
+	typedef std::function<bool(std::vector<Vertex>&, std::vector<NNUInt>&)> PageInSource;
+
 public:
 	//
 	~Mesh();
 	//
 	static std::shared_ptr<Mesh> Create(const std::vector<Vertex>& vertices);
+	// 按 layout 编码后上传, 顶点数小于 65536 时使用 16 位索引
 	static std::shared_ptr<Mesh> Create(const std::vector<Vertex>& vertices, const std::vector<NNUInt>& indices,
+		const std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures, const VertexLayoutDesc& layout = StandardVertexLayout::Desc());
+	// Create from raw blobs (e.g. a mapped mesh cache) without per-vertex work
+	static std::shared_ptr<Mesh> Create(const Vertex* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
+		const std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures, const VertexLayoutDesc& layout = StandardVertexLayout::Desc());
+	// 已经按 layout 编码的顶点
+	static std::shared_ptr<Mesh> Create(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
 		const std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures);
+	template<typename Layout>
+	static std::shared_ptr<Mesh> Create(const std::vector<typename Layout::Packed>& vertices, const std::vector<NNUInt>& indices,
+		const std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures)
+	{
+		return Create(Layout::Desc(), (const NNByte*)vertices.data(), (NNUInt)vertices.size(), indices.data(), (NNUInt)indices.size(), textures);
+	}
 	//
 	void Draw();
-	void DrawInstance();
+	void DrawInstanced(const InstanceStream& instances);
+	// 渲染队列使用的几何和纹理
+	RenderGeometry GetGeometry() const;
+	inline const TextureBindings& GetTextures() const { return m_textures; }
+	// 设置材质后绘制时绑定材质的纹理和参数, 代替 m_textures
+	inline void SetMaterial(std::shared_ptr<Material> material) { m_material = material; }
+	inline const std::shared_ptr<Material>& GetMaterial() const { return m_material; }
 	//
 	void SetDrawMode(const NNDrawMode mode);
+	// CPU 数据不在内存中时会先换入 (驻留方式变为 CPU_GPU)
+	std::vector<NNUInt>& GetIndexData() { PageIn(); return m_indices; }
+	std::vector<Vertex>& GetVertexData() { PageIn(); return m_vertices; };
+	//
+	const std::vector<NNUInt>& GetIndexData() const { PageIn(); return m_indices; }
+	const std::vector<Vertex>& GetVertexData() const { PageIn(); return m_vertices; }
+	// 紧凑数据, 驻留方式为 CPU_COMPACT 时可用
+	const std::vector<NNVec3>& GetPositionData() const { return m_compact_positions; }
+	NNUInt GetCompactIndex(const NNUInt i) const;
 	//
-	std::vector<NNUInt>& GetIndexData() { return m_indices; }
-	std::vector<Vertex>& GetVertexData() { return m_vertices; };
+	inline NNUInt GetVertexNum() const { return m_vertex_num; }
+	inline NNUInt GetIndexNum() const { return m_index_num; }
+	// 模型空间的包围盒, 创建时计算
+	inline const BoundingBox& GetBounds() const { return m_bounds; }
+	// 显存中的顶点布局和索引字节数
+	inline const VertexLayoutDesc& GetVertexLayout() const { return *m_layout; }
+	inline NNUInt GetIndexSize() const { return m_index_size; }
+	// 驻留方式
+	void SetResidency(const NNMeshResidency residency);
+	inline NNMeshResidency GetResidency() const { return m_residency; }
+	void SetPageInSource(PageInSource source);
+	// 换入完整的 CPU 数据, 失败时返回 false
+	bool PageIn() const;
+	// 新建网格使用的驻留方式, 默认 GPU_ONLY
+	static void SetDefaultResidency(const NNMeshResidency residency);
+	static NNMeshResidency GetDefaultResidency();
 	//
-	const std::vector<NNUInt>& GetIndexData() const { return m_indices; }
-	const std::vector<Vertex>& GetVertexData() const { return m_vertices; }
+	static MemoryStats GetMemoryStats();
+
+protected:
+	// source 为编码前的顶点, 非空时直接作为 CPU 数据
+	static std::shared_ptr<Mesh> CreateFromLayout(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
+		const std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures, const Vertex* source);
+	// 显存回读
+	bool ReadBack(std::vector<Vertex>& vertices, std::vector<NNUInt>& indices) const;
+	// 上传完成后按驻留方式处理 CPU 数据
+	void Track();
+	void Untrack();
+	size_t GetCPUBytes() const;
+	size_t GetGPUBytes() const;
 
 protected:
 	//
@@ -48,10 +110,22 @@ protected:
 	//
 	NNVertexFormat m_vertex_format;
 	//
-	std::vector<NNUInt> m_indices;
-	std::vector<Vertex> m_vertices;
+	NNUInt m_vertex_num = 0;
+	NNUInt m_index_num = 0;
+	const VertexLayoutDesc* m_layout = &StandardVertexLayout::Desc();
+	NNUInt m_index_size = sizeof(NNUInt);
+	BoundingBox m_bounds;
+	// CPU 数据, 按需换入
+	mutable NNMeshResidency m_residency = NN_RESIDENCY_CPU_GPU;
+	mutable std::vector<NNUInt> m_indices;
+	mutable std::vector<Vertex> m_vertices;
+	std::vector<NNVec3> m_compact_positions;
+	std::vector<NNByte> m_compact_indices;
+	NNUInt m_compact_index_size = 0;
+	PageInSource m_page_in_source;
 	//
 	std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>> m_textures;
+	std::shared_ptr<Material> m_material;
 
 protected:
 	//
@@ -0,0 +1,261 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include "Debug.h"
+#include "MeshCache.h"
+
+using namespace std;
+
+/** File Layout >>> */
+
+//
+//  [FileHeader][MeshRecord * mesh_num][NodeRecord * node_num] then for each mesh:
+//  [TextureRecord + path]* [Vertex blob, 16 aligned] [Index blob, 16 aligned]
+//
+
+static const uint32_t MESH_CACHE_MAGIC = 0x484d4e4e; // "NNMH"
+// 3: 内置 OBJ 解析也写入节点
+static const uint32_t MESH_CACHE_VERSION = 3;
+static const uint32_t MESH_CACHE_ALIGNMENT = 16;
+
+struct FileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t source_hash;
+	uint64_t source_size;
+	float scale;
+	uint32_t flags;
+	uint32_t vertex_stride;
+	uint32_t mesh_num;
+	uint32_t node_num;
+};
+
+struct MeshRecord
+{
+	uint64_t texture_offset;
+	uint64_t vertex_offset;
+	uint64_t index_offset;
+	uint32_t texture_num;
+	uint32_t vertex_num;
+	uint32_t index_num;
+	float bounds_min[3];
+	float bounds_max[3];
+	int32_t node;
+};
+
+struct NodeRecord
+{
+	int32_t parent;
+	float local[16];
+};
+
+struct TextureRecord
+{
+	uint32_t type;
+	uint32_t path_length;
+};
+
+static inline size_t Align(const size_t offset, const size_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/** File Layout <<< */
+
+string MeshCache::GetCachePath(const NNChar* source_filepath)
+{
+	return string(source_filepath) + ".nnmesh";
+}
+
+shared_ptr<MeshCache> MeshCache::Open(const NNChar* source_filepath, const NNFloat scale, const NNUInt flags)
+{
+	//
+	string cachepath = GetCachePath(source_filepath);
+	shared_ptr<MappedFile> file = MappedFile::Open(cachepath.c_str());
+	if (file == nullptr || file->Size() < sizeof(FileHeader))
+	{
+		return nullptr;
+	}
+	// 校验文件头
+	const NNByte* base = file->Data();
+	const size_t size = file->Size();
+	const FileHeader* header = (const FileHeader*)base;
+	if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION || header->vertex_stride != sizeof(Vertex) ||
+		header->scale != scale || header->flags != flags)
+	{
+		dLog("[Info] Mesh cache is outdated. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	// 校验源文件
+	shared_ptr<MappedFile> source = MappedFile::Open(source_filepath);
+	if (source == nullptr || source->Size() != header->source_size || IO::Hash(source->Data(), source->Size()) != header->source_hash)
+	{
+		dLog("[Info] Mesh cache does not match source file. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	//
+	if (sizeof(FileHeader) + header->mesh_num * sizeof(MeshRecord) + header->node_num * sizeof(NodeRecord) > size)
+	{
+		dLog("[Error] Broken mesh cache. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	const MeshRecord* records = (const MeshRecord*)(base + sizeof(FileHeader));
+	//
+	shared_ptr<MeshCache> result(new MeshCache());
+	result->m_file = file;
+	result->m_submeshes.resize(header->mesh_num);
+	// 节点
+	const NodeRecord* nodes = (const NodeRecord*)(records + header->mesh_num);
+	result->m_nodes.resize(header->node_num);
+	for (NNUInt i = 0; i < header->node_num; ++i)
+	{
+		if (nodes[i].parent >= (int32_t)i)
+		{
+			dLog("[Error] Broken mesh cache. (%s)", cachepath.c_str());
+			return nullptr;
+		}
+		result->m_nodes[i].parent = nodes[i].parent;
+		memcpy(&result->m_nodes[i].local[0][0], nodes[i].local, sizeof(nodes[i].local));
+	}
+	for (NNUInt i = 0; i < header->mesh_num; ++i)
+	{
+		const MeshRecord& record = records[i];
+		SubMesh& submesh = result->m_submeshes[i];
+		// 越界检查
+		if (record.vertex_offset + record.vertex_num * sizeof(Vertex) > size || record.index_offset + record.index_num * sizeof(NNUInt) > size)
+		{
+			dLog("[Error] Broken mesh cache. (%s)", cachepath.c_str());
+			return nullptr;
+		}
+		// 纹理引用
+		size_t offset = (size_t)record.texture_offset;
+		for (NNUInt t = 0; t < record.texture_num; ++t)
+		{
+			if (offset + sizeof(TextureRecord) > size)
+			{
+				dLog("[Error] Broken mesh cache. (%s)", cachepath.c_str());
+				return nullptr;
+			}
+			const TextureRecord* texture = (const TextureRecord*)(base + offset);
+			offset += sizeof(TextureRecord);
+			if (offset + texture->path_length > size)
+			{
+				dLog("[Error] Broken mesh cache. (%s)", cachepath.c_str());
+				return nullptr;
+			}
+			submesh.textures.emplace_back(string((const char*)(base + offset), texture->path_length), (NNTextureType)texture->type);
+			offset = Align(offset + texture->path_length, sizeof(uint32_t));
+		}
+		// 顶点和索引直接指向映射内存
+		submesh.vertices = (const Vertex*)(base + record.vertex_offset);
+		submesh.vertex_num = record.vertex_num;
+		submesh.indices = (const NNUInt*)(base + record.index_offset);
+		submesh.index_num = record.index_num;
+		submesh.bounds_min = NNVec3(record.bounds_min[0], record.bounds_min[1], record.bounds_min[2]);
+		submesh.bounds_max = NNVec3(record.bounds_max[0], record.bounds_max[1], record.bounds_max[2]);
+		submesh.node = record.node < (int32_t)header->node_num ? record.node : -1;
+	}
+	//
+	return result;
+}
+
+bool MeshCache::Write(const NNChar* source_filepath, const NNFloat scale, const NNUInt flags, const vector<CookedMesh>& meshes, const vector<Node>& nodes)
+{
+	//
+	shared_ptr<MappedFile> source = MappedFile::Open(source_filepath);
+	if (source == nullptr)
+	{
+		return false;
+	}
+	// 计算布局
+	vector<MeshRecord> records(meshes.size());
+	size_t offset = sizeof(FileHeader) + meshes.size() * sizeof(MeshRecord) + nodes.size() * sizeof(NodeRecord);
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		const CookedMesh& mesh = meshes[i];
+		MeshRecord& record = records[i];
+		memset(&record, 0, sizeof(MeshRecord));
+		record.node = mesh.node;
+		//
+		record.texture_offset = offset;
+		record.texture_num = (uint32_t)mesh.textures.size();
+		for (const auto& texture : mesh.textures)
+		{
+			offset = Align(offset + sizeof(TextureRecord) + get<0>(texture).size(), sizeof(uint32_t));
+		}
+		//
+		offset = Align(offset, MESH_CACHE_ALIGNMENT);
+		record.vertex_offset = offset;
+		record.vertex_num = (uint32_t)mesh.vertices.size();
+		offset += mesh.vertices.size() * sizeof(Vertex);
+		//
+		offset = Align(offset, MESH_CACHE_ALIGNMENT);
+		record.index_offset = offset;
+		record.index_num = (uint32_t)mesh.indices.size();
+		offset += mesh.indices.size() * sizeof(NNUInt);
+		// 包围盒
+		NNVec3 bmin(mesh.vertices.empty() ? 0.0f : FLT_MAX), bmax(mesh.vertices.empty() ? 0.0f : -FLT_MAX);
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			bmin = glm::min(bmin, vertex.m_position);
+			bmax = glm::max(bmax, vertex.m_position);
+		}
+		memcpy(record.bounds_min, &bmin[0], sizeof(record.bounds_min));
+		memcpy(record.bounds_max, &bmax[0], sizeof(record.bounds_max));
+	}
+	// 写入数据
+	vector<NNByte> blob(offset, 0);
+	FileHeader* header = (FileHeader*)blob.data();
+	header->magic = MESH_CACHE_MAGIC;
+	header->version = MESH_CACHE_VERSION;
+	header->source_hash = IO::Hash(source->Data(), source->Size());
+	header->source_size = source->Size();
+	header->scale = scale;
+	header->flags = flags;
+	header->vertex_stride = sizeof(Vertex);
+	header->mesh_num = (uint32_t)meshes.size();
+	header->node_num = (uint32_t)nodes.size();
+	memcpy(blob.data() + sizeof(FileHeader), records.data(), records.size() * sizeof(MeshRecord));
+	NodeRecord* node_records = (NodeRecord*)(blob.data() + sizeof(FileHeader) + records.size() * sizeof(MeshRecord));
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		node_records[i].parent = nodes[i].parent;
+		memcpy(node_records[i].local, &nodes[i].local[0][0], sizeof(node_records[i].local));
+	}
+	for (size_t i = 0; i < meshes.size(); ++i)
+	{
+		const CookedMesh& mesh = meshes[i];
+		const MeshRecord& record = records[i];
+		//
+		size_t texture_offset = (size_t)record.texture_offset;
+		for (const auto& texture : mesh.textures)
+		{
+			const string& path = get<0>(texture);
+			TextureRecord texture_record = { (uint32_t)get<1>(texture), (uint32_t)path.size() };
+			memcpy(blob.data() + texture_offset, &texture_record, sizeof(TextureRecord));
+			memcpy(blob.data() + texture_offset + sizeof(TextureRecord), path.data(), path.size());
+			texture_offset = Align(texture_offset + sizeof(TextureRecord) + path.size(), sizeof(uint32_t));
+		}
+		//
+		if (!mesh.vertices.empty())
+		{
+			memcpy(blob.data() + record.vertex_offset, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+		}
+		if (!mesh.indices.empty())
+		{
+			memcpy(blob.data() + record.index_offset, mesh.indices.data(), mesh.indices.size() * sizeof(NNUInt));
+		}
+	}
+	//
+	string cachepath = GetCachePath(source_filepath);
+	if (!IO::SaveBinaryFile(cachepath.c_str(), blob.data(), blob.size()))
+	{
+		dLog("[Error] Failed to write mesh cache. (%s)", cachepath.c_str());
+		return false;
+	}
+	dLog("[Info] Mesh cache written. (%s)", cachepath.c_str());
+	return true;
+}
@@ -0,0 +1,73 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <tuple>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "IO.h"
+#include "Mesh.h"
+
+//
+//    MeshCache: Cooked binary mesh container (.nnmesh) written after the first import
+//
+
+class MeshCache
+{
+public:
+	// 导入时烘焙的网格数据
+	struct CookedMesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<NNUInt> indices;
+		std::vector<std::tuple<std::string, NNTextureType>> textures;
+		// 所在的场景节点, -1 表示直接挂在模型上
+		NNInt node = -1;
+	};
+	// 场景节点, 父节点总在前面
+	struct Node
+	{
+		NNInt parent;
+		NNMat4 local;
+	};
+	// 从映射文件中读出的网格数据, 指针指向映射内存
+	struct SubMesh
+	{
+		const Vertex* vertices;
+		NNUInt vertex_num;
+		const NNUInt* indices;
+		NNUInt index_num;
+		NNVec3 bounds_min;
+		NNVec3 bounds_max;
+		std::vector<std::tuple<std::string, NNTextureType>> textures;
+		NNInt node;
+	};
+
+public:
+	// 缓存文件路径
+	static std::string GetCachePath(const NNChar* source_filepath);
+	// 打开缓存, 版本或源文件散列不匹配时返回空指针
+	static std::shared_ptr<MeshCache> Open(const NNChar* source_filepath, const NNFloat scale, const NNUInt flags);
+	// 写入缓存
+	static bool Write(const NNChar* source_filepath, const NNFloat scale, const NNUInt flags, const std::vector<CookedMesh>& meshes,
+		const std::vector<Node>& nodes = std::vector<Node>());
+
+public:
+	//
+	inline const std::vector<SubMesh>& GetSubMeshes() const { return m_submeshes; }
+	inline const std::vector<Node>& GetNodes() const { return m_nodes; }
+
+private:
+	std::shared_ptr<MappedFile> m_file;
+	std::vector<SubMesh> m_submeshes;
+	std::vector<Node> m_nodes;
+
+private:
+	MeshCache() = default;
+	MeshCache(const MeshCache& rhs) = delete;
+	MeshCache& operator=(const MeshCache& rhs) = delete;
+};
+
+#endif // MESH_CACHE_H
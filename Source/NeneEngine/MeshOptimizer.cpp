@@ -0,0 +1,295 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include "MeshOptimizer.h"
+
+using namespace std;
+
+static const NNUInt INVALID_INDEX = 0xffffffff;
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const NNUInt* indices, const NNUInt index_num, const NNUInt vertex_num, const NNUInt cache_size)
+{
+	CacheStats stats = { 0.0f, 0.0f };
+	const NNUInt triangle_num = index_num / 3;
+	if (triangle_num == 0 || vertex_num == 0)
+	{
+		return stats;
+	}
+	// 插入缓存后又发生了 cache_size 次未命中的顶点已被挤出
+	vector<NNUInt> cache_time(vertex_num, 0);
+	NNUInt time = cache_size + 1;
+	NNUInt misses = 0, used = 0;
+	for (NNUInt i = 0; i < triangle_num * 3; ++i)
+	{
+		const NNUInt v = indices[i];
+		if (cache_time[v] == 0)
+		{
+			++used;
+		}
+		if (time - cache_time[v] > cache_size)
+		{
+			cache_time[v] = time++;
+			++misses;
+		}
+	}
+	stats.acmr = (NNFloat)misses / triangle_num;
+	stats.atvr = (NNFloat)misses / used;
+	return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(NNUInt* indices, const NNUInt index_num, const NNUInt vertex_num, const NNUInt cache_size, vector<NNUInt>* clusters)
+{
+	//
+	const NNUInt triangle_num = index_num / 3;
+	if (clusters != nullptr)
+	{
+		clusters->clear();
+	}
+	if (triangle_num == 0 || vertex_num == 0)
+	{
+		return;
+	}
+	// 顶点到三角形的邻接表
+	vector<NNUInt> live(vertex_num, 0);
+	for (NNUInt i = 0; i < triangle_num * 3; ++i)
+	{
+		++live[indices[i]];
+	}
+	vector<NNUInt> offsets(vertex_num + 1, 0);
+	for (NNUInt v = 0; v < vertex_num; ++v)
+	{
+		offsets[v + 1] = offsets[v] + live[v];
+	}
+	vector<NNUInt> adjacency(triangle_num * 3);
+	{
+		vector<NNUInt> cursor(offsets.begin(), offsets.end() - 1);
+		for (NNUInt t = 0; t < triangle_num; ++t)
+		{
+			for (NNUInt k = 0; k < 3; ++k)
+			{
+				adjacency[cursor[indices[t * 3 + k]]++] = t;
+			}
+		}
+	}
+	// Tipsify: 围绕一个顶点输出所有未输出的三角形, 再从刚输出的顶点中选下一个扇形中心
+	vector<NNUInt> cache_time(vertex_num, 0);
+	vector<bool> emitted(triangle_num, false);
+	vector<NNUInt> dead_end;
+	vector<NNUInt> candidates;
+	vector<NNUInt> result;
+	dead_end.reserve(triangle_num * 3);
+	result.reserve(triangle_num * 3);
+	NNUInt time = cache_size + 1;
+	NNUInt next_input = 0;
+	NNUInt fanning = indices[0];
+	bool boundary = true;
+	while (fanning != INVALID_INDEX)
+	{
+		if (boundary && clusters != nullptr)
+		{
+			clusters->push_back((NNUInt)result.size() / 3);
+		}
+		candidates.clear();
+		for (NNUInt a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+		{
+			const NNUInt t = adjacency[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			for (NNUInt k = 0; k < 3; ++k)
+			{
+				const NNUInt v = indices[t * 3 + k];
+				result.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cache_time[v] > cache_size)
+				{
+					cache_time[v] = time++;
+				}
+			}
+			emitted[t] = true;
+		}
+		// 优先选择输出后仍在缓存中, 且在缓存中最久的顶点
+		fanning = INVALID_INDEX;
+		NNInt best = -1;
+		for (const NNUInt v : candidates)
+		{
+			if (live[v] == 0)
+			{
+				continue;
+			}
+			NNInt priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size)
+			{
+				priority = (NNInt)(time - cache_time[v]);
+			}
+			if (priority > best)
+			{
+				best = priority;
+				fanning = v;
+			}
+		}
+		boundary = false;
+		if (fanning != INVALID_INDEX)
+		{
+			continue;
+		}
+		// 死路: 先回溯最近输出的顶点, 再按输入顺序扫描
+		boundary = true;
+		while (!dead_end.empty() && fanning == INVALID_INDEX)
+		{
+			const NNUInt v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0)
+			{
+				fanning = v;
+			}
+		}
+		while (next_input < vertex_num && fanning == INVALID_INDEX)
+		{
+			if (live[next_input] > 0)
+			{
+				fanning = next_input;
+			}
+			++next_input;
+		}
+	}
+	memcpy(indices, result.data(), result.size() * sizeof(NNUInt));
+}
+
+void MeshOptimizer::OptimizeOverdraw(NNUInt* indices, const NNUInt index_num, const NNByte* positions, const NNUInt vertex_num, const NNUInt stride,
+	const NNFloat threshold, const NNUInt cache_size)
+{
+	//
+	const NNUInt triangle_num = index_num / 3;
+	if (triangle_num == 0 || vertex_num == 0)
+	{
+		return;
+	}
+	vector<NNUInt> hard_clusters;
+	OptimizeVertexCache(indices, index_num, vertex_num, cache_size, &hard_clusters);
+	const NNFloat acmr = AnalyzeVertexCache(indices, index_num, vertex_num, cache_size).acmr;
+	hard_clusters.push_back(triangle_num);
+	// 簇内 ACMR 降到阈值以下时切分, 每个新簇从空缓存开始计算
+	vector<NNUInt> clusters;
+	vector<NNUInt> cache_time(vertex_num, 0);
+	NNUInt time = cache_size + 1;
+	for (size_t c = 0; c + 1 < hard_clusters.size(); ++c)
+	{
+		NNUInt start = hard_clusters[c];
+		const NNUInt end = hard_clusters[c + 1];
+		NNUInt misses = 0;
+		clusters.push_back(start);
+		time += cache_size + 1;
+		for (NNUInt t = start; t < end; ++t)
+		{
+			for (NNUInt k = 0; k < 3; ++k)
+			{
+				const NNUInt v = indices[t * 3 + k];
+				if (time - cache_time[v] > cache_size)
+				{
+					cache_time[v] = time++;
+					++misses;
+				}
+			}
+			if (t + 1 < end && misses <= threshold * acmr * (t - start + 1))
+			{
+				clusters.push_back(t + 1);
+				time += cache_size + 1;
+				misses = 0;
+				start = t + 1;
+			}
+		}
+	}
+	clusters.push_back(triangle_num);
+	// 每个簇的面积加权中心和法线
+	auto position = [&](const NNUInt v) { return (const NNFloat*)(positions + (size_t)v * stride); };
+	const size_t cluster_num = clusters.size() - 1;
+	vector<NNFloat> centroids(cluster_num * 3, 0.0f), normals(cluster_num * 3, 0.0f), areas(cluster_num, 0.0f);
+	NNFloat mesh_centroid[3] = { 0.0f, 0.0f, 0.0f };
+	NNFloat mesh_area = 0.0f;
+	for (size_t c = 0; c < cluster_num; ++c)
+	{
+		for (NNUInt t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const NNFloat* p0 = position(indices[t * 3 + 0]);
+			const NNFloat* p1 = position(indices[t * 3 + 1]);
+			const NNFloat* p2 = position(indices[t * 3 + 2]);
+			const NNFloat e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			const NNFloat e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			const NNFloat n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			const NNFloat area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (NNUInt i = 0; i < 3; ++i)
+			{
+				const NNFloat center = (p0[i] + p1[i] + p2[i]) / 3.0f;
+				centroids[c * 3 + i] += center * area;
+				normals[c * 3 + i] += n[i];
+				mesh_centroid[i] += center * area;
+			}
+			areas[c] += area;
+			mesh_area += area;
+		}
+	}
+	if (mesh_area > 0.0f)
+	{
+		for (NNUInt i = 0; i < 3; ++i) mesh_centroid[i] /= mesh_area;
+	}
+	// 簇中心相对模型中心越朝外, 越不容易被遮挡, 越先绘制
+	vector<NNFloat> keys(cluster_num, 0.0f);
+	for (size_t c = 0; c < cluster_num; ++c)
+	{
+		const NNFloat* n = &normals[c * 3];
+		const NNFloat length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (areas[c] <= 0.0f || length <= 0.0f)
+		{
+			continue;
+		}
+		for (NNUInt i = 0; i < 3; ++i)
+		{
+			keys[c] += (centroids[c * 3 + i] / areas[c] - mesh_centroid[i]) * n[i] / length;
+		}
+	}
+	vector<NNUInt> order(cluster_num);
+	iota(order.begin(), order.end(), 0);
+	stable_sort(order.begin(), order.end(), [&](const NNUInt a, const NNUInt b) { return keys[a] > keys[b]; });
+	//
+	vector<NNUInt> result;
+	result.reserve(triangle_num * 3);
+	for (const NNUInt c : order)
+	{
+		result.insert(result.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+	}
+	memcpy(indices, result.data(), result.size() * sizeof(NNUInt));
+}
+
+NNUInt MeshOptimizer::OptimizeVertexFetch(NNByte* vertices, const NNUInt vertex_num, const NNUInt stride, NNUInt* indices, const NNUInt index_num)
+{
+	//
+	vector<NNUInt> remap(vertex_num, INVALID_INDEX);
+	NNUInt next = 0;
+	for (NNUInt i = 0; i < index_num; ++i)
+	{
+		NNUInt& index = remap[indices[i]];
+		if (index == INVALID_INDEX)
+		{
+			index = next++;
+		}
+		indices[i] = index;
+	}
+	//
+	vector<NNByte> reordered((size_t)next * stride);
+	for (NNUInt v = 0; v < vertex_num; ++v)
+	{
+		if (remap[v] != INVALID_INDEX)
+		{
+			memcpy(reordered.data() + (size_t)remap[v] * stride, vertices + (size_t)v * stride, stride);
+		}
+	}
+	memcpy(vertices, reordered.data(), reordered.size());
+	return next;
+}
@@ -0,0 +1,43 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+
+#include "Types.h"
+
+//
+//    MeshOptimizer: Triangle and vertex reordering for post-transform cache, overdraw and fetch locality
+//
+
+class MeshOptimizer
+{
+public:
+	// 后变换缓存统计
+	struct CacheStats
+	{
+		// 每个三角形的平均缓存未命中数, 理想值 0.5 ~ 0.7
+		NNFloat acmr;
+		// 每个顶点的平均变换次数, 理想值 1.0
+		NNFloat atvr;
+	};
+	// Tipsify 使用的缓存大小, 同时用于统计
+	static const NNUInt DEFAULT_CACHE_SIZE = 16;
+
+public:
+	// 模拟 FIFO 缓存
+	static CacheStats AnalyzeVertexCache(const NNUInt* indices, const NNUInt index_num, const NNUInt vertex_num, const NNUInt cache_size = DEFAULT_CACHE_SIZE);
+	// Tipsify 重排三角形; clusters 非空时输出每个簇 (缓存断开处) 的起始三角形
+	static void OptimizeVertexCache(NNUInt* indices, const NNUInt index_num, const NNUInt vertex_num, const NNUInt cache_size = DEFAULT_CACHE_SIZE, std::vector<NNUInt>* clusters = nullptr);
+	// 在 Tipsify 的基础上按簇排序, 朝外的簇先绘制; 簇内 ACMR 不超过整体的 threshold 倍时切分
+	// positions 为每个顶点开头的 3 个浮点数, 相邻顶点间隔 stride 字节
+	static void OptimizeOverdraw(NNUInt* indices, const NNUInt index_num, const NNByte* positions, const NNUInt vertex_num, const NNUInt stride,
+		const NNFloat threshold = 1.05f, const NNUInt cache_size = DEFAULT_CACHE_SIZE);
+	// 按首次使用的顺序重排顶点并重写索引, 丢弃未使用的顶点, 返回新的顶点数
+	static NNUInt OptimizeVertexFetch(NNByte* vertices, const NNUInt vertex_num, const NNUInt stride, NNUInt* indices, const NNUInt index_num);
+
+private:
+	MeshOptimizer() = delete;
+};
+
+#endif // MESH_OPTIMIZER_H
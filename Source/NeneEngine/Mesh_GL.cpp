@@ -3,6 +3,11 @@
 
 #include "Mesh.h"
 #include "Debug.h"
+#include "Instance.h"
+#include "GeometryArena.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -13,9 +18,12 @@ class MeshImpl
 public:
 	//
 	~MeshImpl();
-	MeshImpl(GLuint vao, GLuint vbo, GLuint ebo, GLuint index_num, GLuint vertex_num);
+	MeshImpl(GLuint vao, GLuint vbo, GLuint ebo, GLuint index_num, GLuint vertex_num, GLenum index_type);
+	// 使用几何池中的一段, 不拥有缓冲
+	MeshImpl(const GeometryArena::Range& range);
 	//
 	void Draw();
+	void DrawInstanced(const InstanceStream& instances);
 public:
 	//
 	GLuint m_vao;
@@ -24,41 +32,84 @@ public:
 	//
 	GLuint m_index_num;
 	GLuint m_vertex_num;
+	GLenum m_index_type;
+	// 在共享缓冲中的位置
+	GeometryArena::Range m_range;
+	GLuint m_index_offset;
+	GLint m_base_vertex;
 	//
 	NNDrawMode m_draw_mode;
 };
 
-MeshImpl::MeshImpl(GLuint vao, GLuint vbo, GLuint ebo, GLuint index_num, GLuint vertex_num)
-	: m_vao(vao), m_vbo(vbo), m_ebo(ebo), m_index_num(index_num), m_vertex_num(vertex_num), m_draw_mode(NNDrawMode::NN_TRIANGLE)
+MeshImpl::MeshImpl(GLuint vao, GLuint vbo, GLuint ebo, GLuint index_num, GLuint vertex_num, GLenum index_type)
+	: m_vao(vao), m_vbo(vbo), m_ebo(ebo), m_index_num(index_num), m_vertex_num(vertex_num), m_index_type(index_type),
+	m_range({ 0, 0, 0, 0, 0 }), m_index_offset(0), m_base_vertex(0), m_draw_mode(NNDrawMode::NN_TRIANGLE)
+{}
+
+MeshImpl::MeshImpl(const GeometryArena::Range& range)
+	: m_vao(GeometryArena::Instance().GetVertexArray(range.pool)), m_vbo(0), m_ebo(0), m_index_num(range.index_num), m_vertex_num(range.vertex_num),
+	m_index_type(GeometryArena::Instance().GetIndexType(range.pool)), m_range(range),
+	m_index_offset(range.first_index * GeometryArena::Instance().GetIndexSize(range.pool)), m_base_vertex((GLint)range.base_vertex), m_draw_mode(NNDrawMode::NN_TRIANGLE)
 {}
 
 MeshImpl::~MeshImpl()
 {
-	if (m_ebo != 0) glDeleteBuffers(1, &m_ebo);
-	if (m_vbo != 0) glDeleteBuffers(1, &m_vbo);
-	if (m_vao != 0) glDeleteVertexArrays(1, &m_vao);
+	if (m_range.IsValid())
+	{
+		GeometryArena::Instance().Free(m_range);
+		return;
+	}
+	if (m_vao != 0)
+	{
+		RenderContext::instance().forgetVertexArray(m_vao);
+	}
+	// 在已经录制的绘制之后删除
+	const GLuint vao = m_vao, vbo = m_vbo, ebo = m_ebo;
+	RenderThread::Defer([vao, vbo, ebo]()
+	{
+		if (ebo != 0) glDeleteBuffers(1, &ebo);
+		if (vbo != 0) glDeleteBuffers(1, &vbo);
+		if (vao != 0) glDeleteVertexArrays(1, &vao);
+	});
 }
 
 void MeshImpl::Draw()
 {
-	glBindVertexArray(m_vao);
+	RenderContext::instance().bindVertexArray(m_vao);
+	{
+		if (m_index_num != 0)
+		{
+			RenderContext::instance().drawElements(m_draw_mode, m_index_num, m_index_type, m_index_offset, m_base_vertex);
+		}
+		else
+		{
+			RenderContext::instance().drawArrays(m_draw_mode, 0, m_vertex_num);
+		}
+	}
+}
+
+void MeshImpl::DrawInstanced(const InstanceStream& instances)
+{
+	RenderContext::instance().bindVertexArray(m_vao);
+	instances.Bind();
 	{
-		if (m_ebo != 0)
+		if (m_index_num != 0)
 		{
-			glDrawElements(m_draw_mode, m_index_num, GL_UNSIGNED_INT, 0);
+			RenderContext::instance().drawElements(m_draw_mode, m_index_num, m_index_type, m_index_offset, m_base_vertex, instances.GetInstanceNum());
 		}
 		else
 		{
-			glDrawArrays(m_draw_mode, 0, m_vertex_num);
+			RenderContext::instance().drawArrays(m_draw_mode, 0, m_vertex_num, instances.GetInstanceNum());
 		}
 	}
-	glBindVertexArray(0);
+	instances.Unbind();
 }
 
 /** GL Implementation <<< */
 
 Mesh::~Mesh() 
 {
+	Untrack();
 	if (m_impl != nullptr)
 	{
 		delete m_impl;
@@ -69,97 +120,225 @@ Mesh::~Mesh()
 shared_ptr<Mesh> Mesh::Create(const vector<Vertex>& vertices)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(Create(vertices));
 	GLuint vao, vbo;
 	// 
 	glGenBuffers(1, &(vbo));
 	glGenVertexArrays(1, &(vao));
 	// 
-	glBindVertexArray(vao);
+	RenderContext::instance().bindVertexArray(vao);
 	{
 		// VBO
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-		// POS
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(0 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(0);
-		// NORMAL
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(3 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(1);
-		// TEXCOORD
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(6 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(2);
-	}
-	glBindVertexArray(0);
+		RenderStats::Add(NN_COUNTER_BUFFER_BYTES, vertices.size() * sizeof(Vertex));
+		// POS, NORMAL, TEXCOORD
+		StandardVertexLayout::Desc().Apply();
+	}
+	RenderContext::instance().bindVertexArray(0);
 	//
 	Mesh* result = new Mesh();
 	//
-	result->m_impl = new MeshImpl(vao, vbo, 0, 0, (NNUInt)vertices.size());
+	result->m_impl = new MeshImpl(vao, vbo, 0, 0, (NNUInt)vertices.size(), GL_UNSIGNED_INT);
 	//
+	result->m_vertex_num = (NNUInt)vertices.size();
+	result->m_bounds = BoundingBox::FromPoints(vertices.data(), (NNUInt)vertices.size(), sizeof(Vertex));
 	result->m_vertices = vertices;
+	result->Track();
 	//
 	return shared_ptr<Mesh>(result);
 }
 
 shared_ptr<Mesh> Mesh::Create(const vector<Vertex>& vertices, const vector<NNUInt>& indices,
+	const vector<tuple<shared_ptr<Texture2D>, NNTextureType>>& textures, const VertexLayoutDesc& layout)
+{
+	return Create(vertices.data(), (NNUInt)vertices.size(), indices.data(), (NNUInt)indices.size(), textures, layout);
+}
+
+shared_ptr<Mesh> Mesh::Create(const Vertex* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
+	const vector<tuple<shared_ptr<Texture2D>, NNTextureType>>& textures, const VertexLayoutDesc& layout)
+{
+	// 标准布局直接上传
+	if (&layout == &StandardVertexLayout::Desc())
+	{
+		return CreateFromLayout(layout, (const NNByte*)vertices, vertex_num, indices, index_num, textures, vertices);
+	}
+	vector<NNByte> encoded((size_t)vertex_num * layout.stride);
+	layout.encode(vertices, vertex_num, encoded.data());
+	return CreateFromLayout(layout, encoded.data(), vertex_num, indices, index_num, textures, vertices);
+}
+
+shared_ptr<Mesh> Mesh::Create(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
 	const vector<tuple<shared_ptr<Texture2D>, NNTextureType>>& textures)
+{
+	return CreateFromLayout(layout, vertices, vertex_num, indices, index_num, textures, nullptr);
+}
+
+shared_ptr<Mesh> Mesh::CreateFromLayout(const VertexLayoutDesc& layout, const NNByte* vertices, const NNUInt vertex_num, const NNUInt* indices, const NNUInt index_num,
+	const vector<tuple<shared_ptr<Texture2D>, NNTextureType>>& textures, const Vertex* source)
 {
 	//
-	GLuint vao, vbo, ebo;
-	// 
-	glGenBuffers(1, &(vbo));
-	glGenBuffers(1, &(ebo));
-	glGenVertexArrays(1, &(vao));
-	// 
-	glBindVertexArray(vao);
+	NN_RENDER_THREAD_FORWARD(CreateFromLayout(layout, vertices, vertex_num, indices, index_num, textures, source));
+	const NNUInt index_size = IndexPacking::GetIndexSize(vertex_num);
+	vector<NNByte> packed_indices;
+	const void* index_data = indices;
+	if (index_size != sizeof(NNUInt))
 	{
-		// VBO
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-		// EBO
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-		// POS
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(0 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(0);
-		// NORMAL
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(3 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(1);
-		// TEXCOORD
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid*)(6 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(2);
-	}
-	glBindVertexArray(0);
+		packed_indices.resize((size_t)index_num * index_size);
+		IndexPacking::Pack(indices, index_num, index_size, packed_indices.data());
+		index_data = packed_indices.data();
+	}
 	//
-	if (vao == 0)
+	MeshImpl* impl = nullptr;
+	if (index_num != 0)
+	{
+		// 放入布局和索引宽度对应的共享缓冲
+		GeometryArena::Range range = GeometryArena::Instance().Allocate(layout, vertices, vertex_num, (const NNByte*)index_data, index_num, index_size);
+		if (!range.IsValid())
+		{
+			dLog("[Error] Failed to create vertex buffer.");
+			return nullptr;
+		}
+		impl = new MeshImpl(range);
+	}
+	else
 	{
-		dLog("[Error] Failed to create vertex buffer.");
-		return nullptr;
+		// 没有索引时单独使用一个 VAO
+		GLuint vao, vbo;
+		glGenBuffers(1, &(vbo));
+		glGenVertexArrays(1, &(vao));
+		RenderContext::instance().bindVertexArray(vao);
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, vbo);
+			glBufferData(GL_ARRAY_BUFFER, (size_t)vertex_num * layout.stride, vertices, GL_STATIC_DRAW);
+			RenderStats::Add(NN_COUNTER_BUFFER_BYTES, (size_t)vertex_num * layout.stride);
+			layout.Apply();
+		}
+		RenderContext::instance().bindVertexArray(0);
+		impl = new MeshImpl(vao, vbo, 0, 0, vertex_num, GL_UNSIGNED_INT);
 	}
 	//
 	Mesh* result = new Mesh();
-	result->m_impl = new MeshImpl(vao, vbo, ebo, (NNUInt)indices.size(), (NNUInt)vertices.size());
+	result->m_impl = impl;
 	//
-	result->m_indices = indices;
-	result->m_vertices = vertices;
+	result->m_vertex_num = vertex_num;
+	result->m_index_num = index_num;
+	result->m_layout = &layout;
+	result->m_index_size = index_size;
 	result->m_textures = textures;
+	// 包围盒使用编码前的位置
+	if (source != nullptr)
+	{
+		result->m_bounds = BoundingBox::FromPoints(source, vertex_num, sizeof(Vertex));
+	}
+	else
+	{
+		vector<Vertex> decoded(vertex_num);
+		layout.decode(vertices, vertex_num, decoded.data());
+		result->m_bounds = BoundingBox::FromPoints(decoded.data(), vertex_num, sizeof(Vertex));
+	}
+	// GPU_ONLY 时不拷贝
+	if (GetDefaultResidency() != NN_RESIDENCY_GPU_ONLY)
+	{
+		result->m_indices.assign(indices, indices + index_num);
+		if (source != nullptr)
+		{
+			result->m_vertices.assign(source, source + vertex_num);
+		}
+		else
+		{
+			result->m_vertices.resize(vertex_num);
+			layout.decode(vertices, vertex_num, result->m_vertices.data());
+		}
+	}
+	else
+	{
+		result->m_residency = NN_RESIDENCY_GPU_ONLY;
+	}
+	result->Track();
 	//
 	return shared_ptr<Mesh>(result);
 }
 
 void Mesh::Draw() 
 {
-	// 绑定纹理贴图
-	for (NNUInt i = 0; i < m_textures.size(); ++i) 
+	// 绑定材质或纹理贴图
+	if (m_material != nullptr)
 	{
-		std::get<0>(m_textures[i])->Use(std::get<1>(m_textures[i]));
+		m_material->UseTextures();
+		m_material->UseParams();
+	}
+	else
+	{
+		for (NNUInt i = 0; i < m_textures.size(); ++i) 
+		{
+			std::get<0>(m_textures[i])->Use(std::get<1>(m_textures[i]));
+		}
 	}
 	// 绘制网格数据
 	m_impl->Draw();
 }
 
-void Mesh::DrawInstance()
+bool Mesh::ReadBack(vector<Vertex>& vertices, vector<NNUInt>& indices) const
+{
+	NN_RENDER_THREAD_FORWARD(ReadBack(vertices, indices));
+	// 使用 COPY_READ 绑定点, 不影响当前的 VAO
+	vertices.resize(m_vertex_num);
+	indices.resize(m_index_num);
+	// 量化过的布局回读后解码
+	vector<NNByte> encoded((size_t)m_vertex_num * m_layout->stride);
+	if (m_impl->m_range.IsValid())
+	{
+		vector<NNByte> packed((size_t)m_index_num * m_index_size);
+		if (!GeometryArena::Instance().Read(m_impl->m_range, encoded.data(), packed.data()))
+		{
+			return false;
+		}
+		m_layout->decode(encoded.data(), m_vertex_num, vertices.data());
+		IndexPacking::Unpack(packed.data(), m_index_num, m_index_size, indices.data());
+		return true;
+	}
+	if (m_impl->m_vbo == 0)
+	{
+		return false;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, m_impl->m_vbo);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, encoded.size(), encoded.data());
+	m_layout->decode(encoded.data(), m_vertex_num, vertices.data());
+	if (m_impl->m_ebo != 0)
+	{
+		vector<NNByte> packed((size_t)m_index_num * m_index_size);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_impl->m_ebo);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, packed.size(), packed.data());
+		IndexPacking::Unpack(packed.data(), m_index_num, m_index_size, indices.data());
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	return true;
+}
+
+void Mesh::DrawInstanced(const InstanceStream& instances)
 {
+	// 绑定材质或纹理贴图
+	if (m_material != nullptr)
+	{
+		m_material->UseTextures();
+		m_material->UseParams();
+	}
+	else
+	{
+		for (NNUInt i = 0; i < m_textures.size(); ++i) 
+		{
+			std::get<0>(m_textures[i])->Use(std::get<1>(m_textures[i]));
+		}
+	}
+	// 绘制所有实例
+	m_impl->DrawInstanced(instances);
+}
 
+RenderGeometry Mesh::GetGeometry() const
+{
+	return { m_impl->m_vao, (NNUInt)m_impl->m_draw_mode, m_impl->m_vertex_num, m_impl->m_index_num, m_impl->m_index_num != 0 ? m_impl->m_index_type : 0,
+		m_impl->m_index_offset, (NNUInt)m_impl->m_base_vertex };
 }
 
 void Mesh::SetDrawMode(const NNDrawMode mode)
@@ -7,13 +7,23 @@
 #include "ShaderCross.h"
 #include "StaticMesh.h"
 #include "Camera.h"
+#include "Bounds.h"
+#include "CullingTree.h"
+#include "TransformSystem.h"
 #include "Shape.h"
+#include "Instance.h"
+#include "RenderQueue.h"
+#include "FrameBuilder.h"
+#include "IndirectBatch.h"
+#include "GeometryArena.h"
 #include "Observable.h"
 #include "Observer.h"
 #include "Keyboard.h"
 #include "Texture2D.h"
 #include "Texture3D.h"
 #include "TextureCube.h"
+#include "TextureArray.h"
+#include "Material.h"
 #include "CameraController.h"
 #include "Geometry.h"
 #include "UserInterface.h"
@@ -26,5 +36,12 @@
 #include "ConstantBufferPool.h"
 #include "ShadowMap.h"
 #include "Light.h"
+#include "ThreadPool.h"
+#include "ResourceLoader.h"
+#include "RenderThread.h"
+#include "DebugLayer.h"
+#include "Profiler.h"
+#include "Logger.h"
+#include "RenderStats.h"
 
 #endif // NENE_H
\ No newline at end of file
@@ -1,10 +1,19 @@
 /*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 
 #include "NeneCB.h"
+#include "ConstantRing.h"
 
 NeneCB::NeneCB() {}
 
 NeneCB& NeneCB::Instance() {
 	static NeneCB instance;
 	return instance;
-}
\ No newline at end of file
+}
+
+void NeneCB::UpdatePerObject() {
+#if defined NENE_GL
+	ConstantRing::Instance().Bind(PER_OBJECT_SLOT, m_per_object.Data());
+#else
+	m_per_object.Update(PER_OBJECT_SLOT);
+#endif
+}
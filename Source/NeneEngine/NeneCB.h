@@ -14,6 +14,7 @@ enum NNConstantBufferSlot {
 	PER_OBJECT_SLOT = 1,
 	CUSTOM_LIGHT_SLOT = 2,
 	CUSTOM_DATA_SLOT = 3,
+	MATERIAL_SLOT = 4,
 	NNConstantBufferSoltNum
 };
 
@@ -44,6 +45,8 @@ public:
 	inline ConstantBuffer<PerFrameCBDS>& PerFrame() { return m_per_frame; };
 	// 每物体更新的常量缓冲
 	inline ConstantBuffer<PerObjectCBDS>& PerObject() { return m_per_object; };
+	// 每次绘制提交 PerObject 的数据: 从常量环中分配, 不覆盖 GPU 仍在使用的数据
+	void UpdatePerObject();
 protected:
 	//
 	ConstantBuffer<PerFrameCBDS> m_per_frame;
@@ -19,6 +19,22 @@ enum NNPixelFormat
 	R32G32B32_FLOAT = PixelFormatEnum(FLOAT, RGB, RGB32F),
 };
 
+// 每个像素的字节数
+inline NNUInt GetPixelBytes(const NNPixelFormat& format)
+{
+	switch (format)
+	{
+	case NNPixelFormat::D24S8_UNORM: return 4;
+	case NNPixelFormat::B8G8R8_UNORM: return 3;
+	case NNPixelFormat::R8G8B8_UNORM: return 3;
+	case NNPixelFormat::B8G8R8A8_UNORM: return 4;
+	case NNPixelFormat::R8G8B8A8_UNORM: return 4;
+	case NNPixelFormat::R32G32_FLOAT: return 8;
+	case NNPixelFormat::R32G32B32_FLOAT: return 12;
+	default: return 0;
+	}
+}
+
 #include "Pixel_GL_S.inl"
 
 #endif // PIXEL_H
@@ -0,0 +1,385 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#include <cstdio>
+#include <algorithm>
+#include "Profiler.h"
+
+#include "ImGui/imgui.h"
+
+using namespace std;
+
+// 每个线程的编号和未结束的区间
+struct ProfilerThreadState
+{
+	NNInt index = -1;
+	NNUInt frame = 0;
+	vector<NNInt> stack;
+};
+
+static thread_local ProfilerThreadState tProfilerThread;
+
+Profiler::Profiler() :
+	m_enabled(true), m_start(chrono::steady_clock::now()), m_main_thread(this_thread::get_id()), m_thread_num(1), m_current(), m_current_gpu(false), m_query_num(0), m_query_nums(), m_last_frame(), m_capture_remain(0)
+{
+	m_current.index = 0;
+	m_current.cpu_begin = m_current.cpu_end = 0.0;
+	m_current.gpu_milliseconds = -1.0f;
+	m_last_frame = m_current;
+}
+
+Profiler::~Profiler()
+{
+	// 单例析构时上下文已经销毁, 图形资源由 Release 释放
+}
+
+Profiler& Profiler::Instance()
+{
+	static Profiler instance;
+	return instance;
+}
+
+double Profiler::Now() const
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - m_start).count();
+}
+
+Profiler::Handle Profiler::BeginZone(const NNChar* name, const bool gpu)
+{
+	//
+	if (!m_enabled)
+	{
+		return { 0, -1 };
+	}
+	ProfilerThreadState& state = tProfilerThread;
+	if (state.index < 0)
+	{
+		state.index = this_thread::get_id() == m_main_thread ? 0 : m_thread_num++;
+	}
+	const double now = Now();
+	lock_guard<mutex> lock(m_mutex);
+	// 上一帧没有结束的区间已经被丢弃
+	if (state.frame != m_current.index)
+	{
+		state.stack.clear();
+		state.frame = m_current.index;
+	}
+	Zone zone;
+	zone.name = name;
+	zone.parent = state.stack.empty() ? -1 : state.stack.back();
+	zone.depth = (NNUInt)state.stack.size();
+	zone.thread = (NNUInt)state.index;
+	zone.cpu_begin = now;
+	zone.cpu_end = -1.0;
+	zone.gpu_begin = zone.gpu_end = -1.0f;
+	zone.query = -1;
+	// 只有主线程录制图形调用
+	if (gpu && m_current_gpu && this_thread::get_id() == m_main_thread)
+	{
+		zone.query = AllocateQueries(2);
+		WriteTimestamp(zone.query);
+	}
+	//
+	const NNInt index = (NNInt)m_current.zones.size();
+	m_current.zones.push_back(zone);
+	state.stack.push_back(index);
+	return { m_current.index, index };
+}
+
+void Profiler::EndZone(const Handle& handle)
+{
+	//
+	if (handle.zone < 0)
+	{
+		return;
+	}
+	const double now = Now();
+	ProfilerThreadState& state = tProfilerThread;
+	lock_guard<mutex> lock(m_mutex);
+	if (handle.frame != m_current.index)
+	{
+		return;
+	}
+	Zone& zone = m_current.zones[handle.zone];
+	zone.cpu_end = now;
+	if (zone.query >= 0)
+	{
+		WriteTimestamp(zone.query + 1);
+	}
+	if (!state.stack.empty() && state.stack.back() == handle.zone)
+	{
+		state.stack.pop_back();
+	}
+}
+
+void Profiler::BeginFrame()
+{
+	//
+	m_current.index += 1;
+	m_current.cpu_begin = m_current.cpu_end = Now();
+	m_current.gpu_milliseconds = -1.0f;
+	m_current.zones.clear();
+	m_query_num = 0;
+	m_current_gpu = m_enabled && IsGPUAvailable();
+	if (m_current_gpu)
+	{
+		// 帧开始和结束的时间戳
+		WriteTimestamp(AllocateQueries(FRAME_QUERY_NUM));
+	}
+}
+
+void Profiler::EndFrame()
+{
+	//
+	m_main_thread = this_thread::get_id();
+	{
+		lock_guard<mutex> lock(m_mutex);
+		const double now = Now();
+		m_current.cpu_end = now;
+		// 没有结束的区间截断到帧末, 保证所有查询都发出过
+		for (Zone& zone : m_current.zones)
+		{
+			if (zone.cpu_end < 0.0)
+			{
+				zone.cpu_end = now;
+				if (zone.query >= 0)
+				{
+					WriteTimestamp(zone.query + 1);
+				}
+			}
+		}
+		if (m_current_gpu)
+		{
+			WriteTimestamp(1);
+		}
+		m_query_nums[m_current.index % QUERY_FRAMES] = m_current_gpu ? m_query_num : 0;
+		m_pending.push_back(move(m_current));
+		// 下一帧复用查询对象之前读取它们的结果
+		const NNUInt last = m_pending.back().index;
+		if (last >= GPU_LATENCY)
+		{
+			ResolveQueries(last - GPU_LATENCY);
+		}
+		m_current = Frame();
+		m_current.index = last;
+		BeginFrame();
+	}
+	// 处理已经读取的结果
+	vector<Resolved> resolved;
+	{
+		lock_guard<mutex> lock(m_resolve_mutex);
+		resolved.swap(m_resolved);
+	}
+	for (const Resolved& result : resolved)
+	{
+		while (!m_pending.empty() && m_pending.front().index < result.frame)
+		{
+			m_pending.pop_front();
+		}
+		if (!m_pending.empty() && m_pending.front().index == result.frame)
+		{
+			Finalize(m_pending.front(), result.timestamps);
+			m_pending.pop_front();
+		}
+	}
+}
+
+void Profiler::Finalize(Frame& frame, const vector<NNULong>& timestamps)
+{
+	//
+	if (timestamps.size() >= (size_t)FRAME_QUERY_NUM)
+	{
+		const NNULong base = timestamps[0];
+		auto to_milliseconds = [base](const NNULong timestamp) {
+			return timestamp > base ? (NNFloat)((timestamp - base) / 1e6) : 0.0f;
+		};
+		frame.gpu_milliseconds = to_milliseconds(timestamps[1]);
+		for (Zone& zone : frame.zones)
+		{
+			if (zone.query >= 0 && (size_t)zone.query + 1 < timestamps.size())
+			{
+				zone.gpu_begin = to_milliseconds(timestamps[zone.query]);
+				zone.gpu_end = to_milliseconds(timestamps[zone.query + 1]);
+			}
+		}
+	}
+	// 关闭后不再覆盖最近的结果
+	if (!m_enabled && frame.zones.empty())
+	{
+		return;
+	}
+	if (m_capture_remain > 0)
+	{
+		m_captured.push_back(frame);
+		m_capture_remain -= 1;
+	}
+	m_last_frame = move(frame);
+}
+
+void Profiler::Capture(const NNUInt frames)
+{
+	m_captured.clear();
+	m_capture_remain = frames;
+}
+
+// 区间名是字面量, 只处理引号和反斜杠
+static void WriteJsonString(FILE* file, const NNChar* text)
+{
+	fputc('"', file);
+	for (const NNChar* c = text; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+bool Profiler::ExportTrace(const NNChar* filepath) const
+{
+	//
+	FILE* file = fopen(filepath, "w");
+	if (file == nullptr)
+	{
+		dLog("[Error] Could not write profiler trace (%s).", filepath);
+		return false;
+	}
+	// CPU 和 GPU 分成两个进程显示, GPU 时间按帧对齐到 CPU 的时间轴上
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}");
+	for (const Frame& frame : m_captured)
+	{
+		const double frame_begin = frame.cpu_begin * 1000.0;
+		fprintf(file, ",\n{\"name\":\"Frame %u\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0}",
+			frame.index, frame_begin, (frame.cpu_end - frame.cpu_begin) * 1000.0);
+		if (frame.gpu_milliseconds >= 0.0f)
+		{
+			fprintf(file, ",\n{\"name\":\"Frame %u\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0}",
+				frame.index, frame_begin, frame.gpu_milliseconds * 1000.0);
+		}
+		for (const Zone& zone : frame.zones)
+		{
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, zone.name);
+			fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+				zone.cpu_begin * 1000.0, (zone.cpu_end - zone.cpu_begin) * 1000.0, zone.thread);
+			if (zone.gpu_begin >= 0.0f)
+			{
+				fprintf(file, ",\n{\"name\":");
+				WriteJsonString(file, zone.name);
+				fprintf(file, ",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0}",
+					frame_begin + zone.gpu_begin * 1000.0, (zone.gpu_end - zone.gpu_begin) * 1000.0);
+			}
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+void Profiler::DrawZone(const Frame& frame, const vector<vector<NNUInt>>& children, const NNUInt index)
+{
+	//
+	const Zone& zone = frame.zones[index];
+	ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
+	if (children[index].empty())
+	{
+		flags |= ImGuiTreeNodeFlags_Leaf;
+	}
+	const bool open = zone.thread == 0 ?
+		ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s", zone.name) :
+		ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s [thread %u]", zone.name, zone.thread);
+	ImGui::NextColumn();
+	ImGui::Text("%.3f", zone.cpu_end - zone.cpu_begin);
+	ImGui::NextColumn();
+	if (zone.gpu_begin >= 0.0f)
+	{
+		ImGui::Text("%.3f", zone.gpu_end - zone.gpu_begin);
+	}
+	else
+	{
+		ImGui::TextDisabled("-");
+	}
+	ImGui::NextColumn();
+	if (open)
+	{
+		for (const NNUInt child : children[index])
+		{
+			DrawZone(frame, children, child);
+		}
+		ImGui::TreePop();
+	}
+}
+
+void Profiler::DrawPanel()
+{
+	//
+	ImGui::Begin("Profiler");
+	{
+		bool enabled = m_enabled;
+		if (ImGui::Checkbox("Enabled", &enabled))
+		{
+			SetEnabled(enabled);
+		}
+		ImGui::SameLine();
+		if (IsCapturing())
+		{
+			ImGui::Text("Capturing %u frames...", m_capture_remain);
+		}
+		else
+		{
+			if (ImGui::Button("Capture 120 frames"))
+			{
+				Capture(120);
+			}
+			if (!m_captured.empty())
+			{
+				ImGui::SameLine();
+				if (ImGui::Button("Export trace.json"))
+				{
+					ExportTrace("trace.json");
+				}
+			}
+		}
+		//
+		const Frame& frame = m_last_frame;
+		if (frame.gpu_milliseconds >= 0.0f)
+		{
+			ImGui::Text("Frame %u: CPU %.2f ms, GPU %.2f ms", frame.index, frame.cpu_end - frame.cpu_begin, frame.gpu_milliseconds);
+		}
+		else
+		{
+			ImGui::Text("Frame %u: CPU %.2f ms, GPU n/a", frame.index, frame.cpu_end - frame.cpu_begin);
+		}
+		// 按父区间建立层级
+		vector<vector<NNUInt>> children(frame.zones.size());
+		vector<NNUInt> roots;
+		for (NNUInt i = 0; i < (NNUInt)frame.zones.size(); ++i)
+		{
+			const NNInt parent = frame.zones[i].parent;
+			if (parent >= 0)
+			{
+				children[parent].push_back(i);
+			}
+			else
+			{
+				roots.push_back(i);
+			}
+		}
+		ImGui::Columns(3, "profiler_zones");
+		ImGui::Text("Zone");
+		ImGui::NextColumn();
+		ImGui::Text("CPU ms");
+		ImGui::NextColumn();
+		ImGui::Text("GPU ms");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (const NNUInt root : roots)
+		{
+			DrawZone(frame, children, root);
+		}
+		ImGui::Columns(1);
+	}
+	ImGui::End();
+}
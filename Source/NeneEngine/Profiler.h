@@ -0,0 +1,164 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Debug.h"
+#include "Types.h"
+
+// 为 0 时 NN_PROFILE_* 宏展开为空
+#ifndef NN_PROFILER
+	#define NN_PROFILER 1
+#endif
+
+//
+//    Profiler: A singleton collecting scoped CPU zones and GL timestamp queries per frame, read back a few frames later without stalling
+//
+
+class Profiler
+{
+public:
+	struct Zone
+	{
+		// 必须是字符串字面量等不会释放的字符串
+		const NNChar* name;
+		// 同一线程上的父区间, 没有时为 -1
+		NNInt parent;
+		NNUInt depth;
+		// 主线程为 0, 其它线程按第一次记录区间的顺序编号
+		NNUInt thread;
+		// 相对于分析器启动的时间 (毫秒)
+		double cpu_begin, cpu_end;
+		// 相对于本帧 GPU 开始的时间 (毫秒), 没有 GPU 计时时为负数
+		NNFloat gpu_begin, gpu_end;
+		// 本帧查询对象中的编号, 没有 GPU 计时时为 -1
+		NNInt query;
+	};
+
+	struct Frame
+	{
+		NNUInt index;
+		double cpu_begin, cpu_end;
+		// 没有 GPU 计时 (不支持或结果还没准备好被丢弃) 时为负数
+		NNFloat gpu_milliseconds;
+		std::vector<Zone> zones;
+	};
+
+	// 区间句柄, 跨帧结束的区间被丢弃
+	struct Handle
+	{
+		NNUInt frame;
+		NNInt zone;
+	};
+
+	class Scope
+	{
+	public:
+		Scope(const NNChar* name, const bool gpu) : m_handle(Instance().BeginZone(name, gpu)) {}
+		~Scope() { Instance().EndZone(m_handle); }
+		Scope(const Scope& rhs) = delete;
+		Scope& operator=(const Scope& rhs) = delete;
+	private:
+		Handle m_handle;
+	};
+
+public:
+	// 获取单例
+	static Profiler& Instance();
+	//
+	inline void SetEnabled(const bool enabled) { m_enabled = enabled; }
+	inline bool IsEnabled() const { return m_enabled; }
+	// gpu 为真时在主线程上额外记录 GPU 时间, 其它线程只记录 CPU 时间
+	Handle BeginZone(const NNChar* name, const bool gpu);
+	void EndZone(const Handle& handle);
+	// 结束当前帧并读取几帧之前的 GPU 结果, 由 Utils::SwapBuffers 调用
+	void EndFrame();
+	// 最近一帧完整的结果 (比当前帧晚 GPU_LATENCY 帧)
+	inline const Frame& GetLastFrame() const { return m_last_frame; }
+	// 记录之后的 frames 帧用于导出
+	void Capture(const NNUInt frames);
+	inline bool IsCapturing() const { return m_capture_remain > 0; }
+	inline NNUInt GetCapturedFrameNum() const { return (NNUInt)m_captured.size(); }
+	// 导出已记录的帧为 Chrome 的 trace event 格式 (chrome://tracing 或 Perfetto 打开)
+	bool ExportTrace(const NNChar* filepath) const;
+	// 按层级显示最近一帧的 ImGui 窗口, 在 UserInterface 的绘制函数中调用
+	void DrawPanel();
+	// 释放查询对象, 由 Utils::Terminate 调用
+	void Release();
+
+public:
+	~Profiler();
+
+private:
+	// 每帧一组查询对象, 轮流使用; 第 GPU_LATENCY 帧之后才读取结果
+	static const NNUInt QUERY_FRAMES = 3;
+	static const NNUInt GPU_LATENCY = QUERY_FRAMES - 1;
+	// 每帧的前两个查询是帧开始和结束的时间戳
+	static const NNInt FRAME_QUERY_NUM = 2;
+	// 在执行图形调用的线程上读取的结果
+	struct Resolved
+	{
+		NNUInt frame;
+		std::vector<NNULong> timestamps;
+	};
+
+private:
+	double Now() const;
+	// 分配当前帧的 count 个查询对象, 返回第一个的编号
+	NNInt AllocateQueries(const NNInt count);
+	void WriteTimestamp(const NNInt query);
+	// 录制读取结果的命令, 在执行图形调用的线程上按顺序执行
+	void ResolveQueries(const NNUInt frame);
+	static void ReadQueries(Profiler* profiler, const NNUInt frame, const NNUInt count);
+	bool IsGPUAvailable() const;
+	void Finalize(Frame& frame, const std::vector<NNULong>& timestamps);
+	void BeginFrame();
+	void DrawZone(const Frame& frame, const std::vector<std::vector<NNUInt>>& children, const NNUInt index);
+
+private:
+	std::atomic<bool> m_enabled;
+	std::chrono::steady_clock::time_point m_start;
+	std::thread::id m_main_thread;
+	std::atomic<NNUInt> m_thread_num;
+	// 正在记录的帧, 其它线程的区间也写到这里
+	std::mutex m_mutex;
+	Frame m_current;
+	bool m_current_gpu;
+	NNInt m_query_num;
+	std::array<NNInt, QUERY_FRAMES> m_query_nums;
+	// 等待 GPU 结果的帧
+	std::deque<Frame> m_pending;
+	std::mutex m_resolve_mutex;
+	std::vector<Resolved> m_resolved;
+	//
+	Frame m_last_frame;
+	NNUInt m_capture_remain;
+	std::deque<Frame> m_captured;
+#if defined NENE_GL
+	std::array<std::vector<GLuint>, QUERY_FRAMES> m_queries;
+#endif
+
+private:
+	Profiler();
+	Profiler(const Profiler& rhs) = delete;
+	Profiler& operator=(const Profiler& rhs) = delete;
+};
+
+#if NN_PROFILER > 0
+	// 记录 CPU 和 GPU 时间
+	#define NN_PROFILE_ZONE(name) Profiler::Scope CONNECT(__profile_zone, __LINE__)(name, true)
+	// 只记录 CPU 时间, 可以在工作线程中使用
+	#define NN_PROFILE_CPU_ZONE(name) Profiler::Scope CONNECT(__profile_zone, __LINE__)(name, false)
+#else
+	#define NN_PROFILE_ZONE(name)
+	#define NN_PROFILE_CPU_ZONE(name)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,92 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <algorithm>
+#include "Utils.h"
+#include "Profiler.h"
+#include "RenderThread.h"
+
+using namespace std;
+
+// 查询对象不够时一次分配的数量
+static const NNUInt QUERY_GROW_NUM = 64;
+
+bool Profiler::IsGPUAvailable() const
+{
+	return Utils::GetWindow() != nullptr && (GLEW_ARB_timer_query || GLEW_VERSION_3_3);
+}
+
+NNInt Profiler::AllocateQueries(const NNInt count)
+{
+	//
+	vector<GLuint>& queries = m_queries[m_current.index % QUERY_FRAMES];
+	const NNInt first = m_query_num;
+	m_query_num += count;
+	if ((size_t)m_query_num > queries.size())
+	{
+		// 只在预热时同步一次, 之后每帧复用
+		const NNUInt grow = max(QUERY_GROW_NUM, (NNUInt)(m_query_num - queries.size()));
+		const size_t old_size = queries.size();
+		queries.resize(old_size + grow);
+		GLuint* names = queries.data() + old_size;
+		RenderThread::Invoke([names, grow]() { glGenQueries(grow, names); });
+	}
+	return first;
+}
+
+void Profiler::WriteTimestamp(const NNInt query)
+{
+	const GLuint name = m_queries[m_current.index % QUERY_FRAMES][query];
+	RenderThread::Record([](const GLuint query_name) { glQueryCounter(query_name, GL_TIMESTAMP); }, name);
+}
+
+void Profiler::ResolveQueries(const NNUInt frame)
+{
+	// 没有 GPU 计时的帧也按顺序经过渲染线程, 保证结果按帧的顺序返回
+	RenderThread::Record(&Profiler::ReadQueries, this, frame, (NNUInt)m_query_nums[frame % QUERY_FRAMES]);
+}
+
+void Profiler::ReadQueries(Profiler* profiler, const NNUInt frame, const NNUInt count)
+{
+	//
+	Resolved resolved;
+	resolved.frame = frame;
+	if (count >= (NNUInt)FRAME_QUERY_NUM)
+	{
+		const vector<GLuint>& queries = profiler->m_queries[frame % QUERY_FRAMES];
+		// 帧结束的时间戳最后发出, 它可用时之前的都可用; 还没准备好时丢弃, 不等待 GPU
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_TRUE)
+		{
+			resolved.timestamps.resize(count);
+			for (NNUInt i = 0; i < count; ++i)
+			{
+				glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &resolved.timestamps[i]);
+			}
+		}
+	}
+	lock_guard<mutex> lock(profiler->m_resolve_mutex);
+	profiler->m_resolved.push_back(move(resolved));
+}
+
+void Profiler::Release()
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Release());
+	for (vector<GLuint>& queries : m_queries)
+	{
+		if (!queries.empty())
+		{
+			glDeleteQueries((GLsizei)queries.size(), queries.data());
+		}
+		queries.clear();
+	}
+	lock_guard<mutex> lock(m_mutex);
+	m_pending.clear();
+	m_query_num = 0;
+	m_current_gpu = false;
+	m_query_nums.fill(0);
+}
+
+#endif // NENE_GL
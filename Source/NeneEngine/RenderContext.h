@@ -34,7 +34,13 @@ public:
 	virtual void commit();
 protected:
 #if defined NENE_GL
-	;
+	bool mDepthTest, mDepthWrite;
+	NNTestFunc mDepthFunc;
+	bool mStencilTest;
+	NNUInt mStencilWriteMask;
+	NNTestFunc mStencilFunc;
+	NNUInt mStencilRef, mStencilReadMask;
+	NNStencilOp mStencilFail, mDepthFail, mDepthPass;
 #elif defined NENE_DX
 	UINT mStencilRef;
 	ID3D11DepthStencilState *mpDSState;
@@ -44,12 +50,30 @@ protected:
 
 class BlendState : public RenderContextState {
 public:
-	virtual void commit() {}
+	//
+	BlendState();
+	//
+	void blend(const bool& enabled);
+	void blendFunc(const NNBlendFactor& src, const NNBlendFactor& dst);
+	//
+	virtual void commit();
+protected:
+	bool mBlend;
+	NNBlendFactor mSrcFactor, mDstFactor;
 };
 
 class RasterizerState : public RenderContextState {
 public:
-	virtual void commit() {}
+	//
+	RasterizerState();
+	// FILL_CULL 剔除背面, WIRE_FRAME 和 VERTEX 不剔除
+	void polygonMode(const NNPolygonMode& mode);
+	void frontFace(const NNVertexOrder& order);
+	//
+	virtual void commit();
+protected:
+	NNPolygonMode mPolygonMode;
+	NNVertexOrder mFrontFace;
 };
 
 class RenderContext {
@@ -67,6 +91,84 @@ public:
 	//
 	inline std::shared_ptr<RasterizerState> pRasterizer() { return mpRasterizer; }
 	inline void setRasterizer(std::shared_ptr<RasterizerState> new_state) { new_state->mDirty = true; mpRasterizer = new_state; }
+#if defined NENE_GL
+public:
+	// 状态缓存: 和当前状态相同的调用不会发给驱动
+	void useProgram(const GLuint program);
+	void bindVertexArray(const GLuint vao);
+	void bindTexture(const NNUInt slot, const GLenum target, const GLuint texture);
+	void bindSampler(const NNUInt slot, const GLuint sampler);
+	void bindUniformBuffer(const NNUInt slot, const GLuint buffer, const GLintptr offset, const GLsizeiptr size);
+	void bindFramebuffer(const GLenum target, const GLuint fbo);
+	void viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height);
+	// 缓存 DEPTH_TEST, STENCIL_TEST, BLEND 和 CULL_FACE, 其他开关直接调用
+	void enable(const GLenum cap, const bool enabled);
+	void depthMask(const bool write);
+	void depthFunc(const GLenum func);
+	void stencilMask(const GLuint mask);
+	void stencilFunc(const GLenum func, const GLint ref, const GLuint mask);
+	void stencilOp(const GLenum sfail, const GLenum dpfail, const GLenum dppass);
+	void blendFunc(const GLenum src, const GLenum dst);
+	void cullFace(const GLenum face);
+	void frontFace(const GLenum order);
+	void polygonMode(const GLenum mode);
+	// 绘制调用, 渲染线程运行时录制到命令流
+	void drawArrays(const GLenum mode, const GLint first, const GLsizei count, const GLsizei instances = 1);
+	void drawElements(const GLenum mode, const GLsizei count, const GLenum type, const size_t offset, const GLint base_vertex = 0, const GLsizei instances = 1);
+	// count 个顶点组成的图元数
+	static NNULong getPrimitiveNum(const GLenum mode, const NNULong count);
+	// 未知时返回 GL_FILL
+	GLenum getPolygonMode() const;
+	// 删除对象时调用, 名字可能被新对象重新使用
+	void forgetProgram(const GLuint program);
+	void forgetVertexArray(const GLuint vao);
+	void forgetTexture(const GLuint texture);
+	void forgetFramebuffer(const GLuint fbo);
+	void forgetBuffer(const GLuint buffer);
+	// 外部代码直接修改了状态时调用, 之后的调用都会发给驱动
+	void invalidate();
+	// 上一帧发出和省去的调用数
+	struct Stats {
+		NNUInt calls;
+		NNUInt saved;
+	};
+	inline const Stats& getStats() const { return mLastStats; }
+	// 由 Utils::SwapBuffers 调用
+	void endFrame();
+public:
+	static const NNUInt MAX_TEXTURE_SLOTS = 32;
+	static const NNUInt MAX_UNIFORM_SLOTS = 16;
+	static const NNUInt TEXTURE_TARGET_NUM = 5;
+	static const NNUInt CAP_NUM = 4;
+private:
+	// 所有位为 1 表示未知
+	struct GLState {
+		GLuint program;
+		GLuint vertex_array;
+		GLuint draw_framebuffer, read_framebuffer;
+		GLuint active_slot;
+		GLuint textures[MAX_TEXTURE_SLOTS][TEXTURE_TARGET_NUM];
+		GLuint samplers[MAX_TEXTURE_SLOTS];
+		struct {
+			GLuint buffer;
+			GLintptr offset;
+			GLsizeiptr size;
+		} uniform_buffers[MAX_UNIFORM_SLOTS];
+		GLint viewport[4];
+		GLint caps[CAP_NUM];
+		GLint depth_mask;
+		GLenum depth_func;
+		GLuint stencil_write_mask;
+		GLenum stencil_func;
+		GLint stencil_ref;
+		GLuint stencil_read_mask;
+		GLenum stencil_ops[3];
+		GLenum blend_src, blend_dst;
+		GLenum cull_face, front_face, polygon_mode;
+	};
+	GLState mState;
+	Stats mStats, mLastStats;
+#endif
 protected:
 	std::shared_ptr<BlendState> mpBlend;
 	std::shared_ptr<RasterizerState> mpRasterizer;
@@ -78,4 +180,4 @@ private:
 	void operator=(RenderContext const&) = delete;
 };
 
-#endif // RENDER_CONTEXT_H
\ No newline at end of file
+#endif // RENDER_CONTEXT_H
@@ -70,6 +70,39 @@ void DepthStencilState::commit() {
 	}
 }
 
+BlendState::BlendState() : mBlend(true), mSrcFactor(BLEND_SRC_ALPHA), mDstFactor(BLEND_ONE_MINUS_SRC_ALPHA) {}
+
+void BlendState::blend(const bool& enabled) {
+	mBlend = enabled;
+	mDirty = true;
+}
+
+void BlendState::blendFunc(const NNBlendFactor& src, const NNBlendFactor& dst) {
+	mSrcFactor = src;
+	mDstFactor = dst;
+	mDirty = true;
+}
+
+void BlendState::commit() {
+	mDirty = false;
+}
+
+RasterizerState::RasterizerState() : mPolygonMode(FILL_NO_CULL), mFrontFace(COUNTER_CLOCK_WISE) {}
+
+void RasterizerState::polygonMode(const NNPolygonMode& mode) {
+	mPolygonMode = mode;
+	mDirty = true;
+}
+
+void RasterizerState::frontFace(const NNVertexOrder& order) {
+	mFrontFace = order;
+	mDirty = true;
+}
+
+void RasterizerState::commit() {
+	mDirty = false;
+}
+
 RenderContext& RenderContext::instance() {
 	static RenderContext ins;
 	return ins;
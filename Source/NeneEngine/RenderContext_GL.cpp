@@ -1,48 +1,123 @@
-/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
+﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 #ifdef NENE_GL
 
+#include <cstring>
 #include "RenderContext.h"
+#include "RenderThread.h"
+#include "RenderStats.h"
 #include "Utils.h"
 
+static const GLuint UNKNOWN = 0xffffffff;
 
-DepthStencilState::DepthStencilState() {
+// 渲染线程运行时录制到命令流, 否则直接调用
+#define GL_CALL(function, ...) RenderThread::Record([](auto... args) { function(args...); }, __VA_ARGS__)
 
-}
+DepthStencilState::DepthStencilState() :
+	mDepthTest(true), mDepthWrite(true), mDepthFunc(LEQUAL),
+	mStencilTest(false), mStencilWriteMask(0xff), mStencilFunc(ALWAYS), mStencilRef(0), mStencilReadMask(0xff),
+	mStencilFail(KEEP), mDepthFail(KEEP), mDepthPass(KEEP)
+{}
 
 void DepthStencilState::depthTest(const bool& enabled) {
-	if (enabled) {
-		glEnable(GL_DEPTH_TEST);
-	} else {
-		glDisable(GL_DEPTH_TEST);
-	}
+	mDepthTest = enabled;
+	mDirty = true;
 }
 
 void DepthStencilState::depthMask(const bool& write) {
-	
+	mDepthWrite = write;
+	mDirty = true;
 }
 
 void DepthStencilState::depthFunc(const NNTestFunc& func) {
-	
+	mDepthFunc = func;
+	mDirty = true;
 }
 
 void DepthStencilState::stencilTest(const bool& enabled) {
-	
+	mStencilTest = enabled;
+	mDirty = true;
 }
 
 void DepthStencilState::stencilMask(const NNUInt& mask) {
-	
+	mStencilWriteMask = mask;
+	mDirty = true;
 }
 
 void DepthStencilState::stencilFunc(const NNTestFunc& func, const NNUInt& ref, const NNUInt& mask) {
-
+	mStencilFunc = func;
+	mStencilRef = ref;
+	mStencilReadMask = mask;
+	mDirty = true;
 }
 
 void DepthStencilState::stencilOp(const NNStencilOp& sfail, const NNStencilOp& dpfail, const NNStencilOp& dppass) {
-
+	mStencilFail = sfail;
+	mDepthFail = dpfail;
+	mDepthPass = dppass;
+	mDirty = true;
 }
 
 void DepthStencilState::commit() {
-	
+	if (!mDirty) {
+		return;
+	}
+	RenderContext& ctx = RenderContext::instance();
+	ctx.enable(GL_DEPTH_TEST, mDepthTest);
+	ctx.depthMask(mDepthWrite);
+	ctx.depthFunc(mDepthFunc);
+	ctx.enable(GL_STENCIL_TEST, mStencilTest);
+	ctx.stencilMask(mStencilWriteMask);
+	ctx.stencilFunc(mStencilFunc, mStencilRef, mStencilReadMask);
+	ctx.stencilOp(mStencilFail, mDepthFail, mDepthPass);
+	mDirty = false;
+}
+
+BlendState::BlendState() : mBlend(true), mSrcFactor(BLEND_SRC_ALPHA), mDstFactor(BLEND_ONE_MINUS_SRC_ALPHA) {}
+
+void BlendState::blend(const bool& enabled) {
+	mBlend = enabled;
+	mDirty = true;
+}
+
+void BlendState::blendFunc(const NNBlendFactor& src, const NNBlendFactor& dst) {
+	mSrcFactor = src;
+	mDstFactor = dst;
+	mDirty = true;
+}
+
+void BlendState::commit() {
+	if (!mDirty) {
+		return;
+	}
+	RenderContext& ctx = RenderContext::instance();
+	ctx.enable(GL_BLEND, mBlend);
+	ctx.blendFunc(mSrcFactor, mDstFactor);
+	mDirty = false;
+}
+
+RasterizerState::RasterizerState() : mPolygonMode(FILL_NO_CULL), mFrontFace(COUNTER_CLOCK_WISE) {}
+
+void RasterizerState::polygonMode(const NNPolygonMode& mode) {
+	mPolygonMode = mode;
+	mDirty = true;
+}
+
+void RasterizerState::frontFace(const NNVertexOrder& order) {
+	mFrontFace = order;
+	mDirty = true;
+}
+
+void RasterizerState::commit() {
+	if (!mDirty) {
+		return;
+	}
+	static const GLenum modes[NNPolygonModeNum] = { GL_FILL, GL_FILL, GL_LINE, GL_POINT };
+	RenderContext& ctx = RenderContext::instance();
+	ctx.polygonMode(modes[mPolygonMode]);
+	ctx.enable(GL_CULL_FACE, mPolygonMode == FILL_CULL);
+	ctx.cullFace(GL_BACK);
+	ctx.frontFace(mFrontFace == COUNTER_CLOCK_WISE ? GL_CCW : GL_CW);
+	mDirty = false;
 }
 
 RenderContext& RenderContext::instance() {
@@ -54,7 +129,11 @@ RenderContext::RenderContext() :
 	mpBlend(new BlendState()),
 	mpRasterizer(new RasterizerState()),
 	mpDepthStencil(new DepthStencilState())
-{}
+{
+	invalidate();
+	mStats = { 0, 0 };
+	mLastStats = { 0, 0 };
+}
 
 void RenderContext::commit() {
 	//
@@ -63,4 +142,262 @@ void RenderContext::commit() {
 	mpDepthStencil->commit();
 }
 
-#endif // NENE_GL
\ No newline at end of file
+// 缓存命中时计入省去的调用, 否则更新缓存并执行
+#define CACHED_CALL(cached, value, call) \
+	if ((cached) == (value)) { ++mStats.saved; return; } \
+	(cached) = (value); ++mStats.calls; call;
+
+void RenderContext::useProgram(const GLuint program) {
+	CACHED_CALL(mState.program, program, GL_CALL(glUseProgram, program));
+	RenderStats::Add(NN_COUNTER_PROGRAM_BINDS, 1);
+}
+
+void RenderContext::bindVertexArray(const GLuint vao) {
+	CACHED_CALL(mState.vertex_array, vao, GL_CALL(glBindVertexArray, vao));
+	RenderStats::Add(NN_COUNTER_VERTEX_ARRAY_BINDS, 1);
+}
+
+static NNUInt textureTargetIndex(const GLenum target) {
+	switch (target) {
+	case GL_TEXTURE_2D: return 0;
+	case GL_TEXTURE_2D_MULTISAMPLE: return 1;
+	case GL_TEXTURE_3D: return 2;
+	case GL_TEXTURE_CUBE_MAP: return 3;
+	case GL_TEXTURE_2D_ARRAY: return 4;
+	default: return UNKNOWN;
+	}
+}
+
+void RenderContext::bindTexture(const NNUInt slot, const GLenum target, const GLuint texture) {
+	//
+	const NNUInt index = textureTargetIndex(target);
+	if (slot < MAX_TEXTURE_SLOTS && index != UNKNOWN && mState.textures[slot][index] == texture) {
+		++mStats.saved;
+		return;
+	}
+	if (mState.active_slot != slot) {
+		mState.active_slot = slot;
+		++mStats.calls;
+		GL_CALL(glActiveTexture, GL_TEXTURE0 + slot);
+	}
+	if (slot < MAX_TEXTURE_SLOTS && index != UNKNOWN) {
+		mState.textures[slot][index] = texture;
+	}
+	++mStats.calls;
+	RenderStats::Add(NN_COUNTER_TEXTURE_BINDS, 1);
+	GL_CALL(glBindTexture, target, texture);
+}
+
+void RenderContext::bindSampler(const NNUInt slot, const GLuint sampler) {
+	if (slot >= MAX_TEXTURE_SLOTS) {
+		++mStats.calls;
+		GL_CALL(glBindSampler, slot, sampler);
+		return;
+	}
+	CACHED_CALL(mState.samplers[slot], sampler, GL_CALL(glBindSampler, slot, sampler));
+}
+
+void RenderContext::bindUniformBuffer(const NNUInt slot, const GLuint buffer, const GLintptr offset, const GLsizeiptr size) {
+	//
+	if (slot < MAX_UNIFORM_SLOTS) {
+		auto& binding = mState.uniform_buffers[slot];
+		if (binding.buffer == buffer && binding.offset == offset && binding.size == size) {
+			++mStats.saved;
+			return;
+		}
+		binding.buffer = buffer;
+		binding.offset = offset;
+		binding.size = size;
+	}
+	++mStats.calls;
+	GL_CALL(glBindBufferRange, GL_UNIFORM_BUFFER, slot, buffer, offset, size);
+}
+
+void RenderContext::bindFramebuffer(const GLenum target, const GLuint fbo) {
+	//
+	const bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+	const bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+	if ((!draw || mState.draw_framebuffer == fbo) && (!read || mState.read_framebuffer == fbo)) {
+		++mStats.saved;
+		return;
+	}
+	if (draw) mState.draw_framebuffer = fbo;
+	if (read) mState.read_framebuffer = fbo;
+	++mStats.calls;
+	RenderStats::Add(NN_COUNTER_FRAMEBUFFER_BINDS, 1);
+	GL_CALL(glBindFramebuffer, target, fbo);
+}
+
+void RenderContext::viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height) {
+	//
+	GLint* v = mState.viewport;
+	if (v[0] == x && v[1] == y && v[2] == width && v[3] == height) {
+		++mStats.saved;
+		return;
+	}
+	v[0] = x; v[1] = y; v[2] = width; v[3] = height;
+	++mStats.calls;
+	GL_CALL(glViewport, x, y, width, height);
+}
+
+void RenderContext::enable(const GLenum cap, const bool enabled) {
+	//
+	NNUInt index = UNKNOWN;
+	switch (cap) {
+	case GL_DEPTH_TEST: index = 0; break;
+	case GL_STENCIL_TEST: index = 1; break;
+	case GL_BLEND: index = 2; break;
+	case GL_CULL_FACE: index = 3; break;
+	default: break;
+	}
+	if (index != UNKNOWN) {
+		if (mState.caps[index] == (GLint)enabled) {
+			++mStats.saved;
+			return;
+		}
+		mState.caps[index] = enabled;
+	}
+	++mStats.calls;
+	if (enabled) {
+		GL_CALL(glEnable, cap);
+	} else {
+		GL_CALL(glDisable, cap);
+	}
+}
+
+void RenderContext::depthMask(const bool write) {
+	CACHED_CALL(mState.depth_mask, (GLint)write, GL_CALL(glDepthMask, (GLboolean)(write ? GL_TRUE : GL_FALSE)));
+}
+
+void RenderContext::depthFunc(const GLenum func) {
+	CACHED_CALL(mState.depth_func, func, GL_CALL(glDepthFunc, func));
+}
+
+void RenderContext::stencilMask(const GLuint mask) {
+	CACHED_CALL(mState.stencil_write_mask, mask, GL_CALL(glStencilMask, mask));
+}
+
+void RenderContext::stencilFunc(const GLenum func, const GLint ref, const GLuint mask) {
+	if (mState.stencil_func == func && mState.stencil_ref == ref && mState.stencil_read_mask == mask) {
+		++mStats.saved;
+		return;
+	}
+	mState.stencil_func = func;
+	mState.stencil_ref = ref;
+	mState.stencil_read_mask = mask;
+	++mStats.calls;
+	GL_CALL(glStencilFunc, func, ref, mask);
+}
+
+void RenderContext::stencilOp(const GLenum sfail, const GLenum dpfail, const GLenum dppass) {
+	GLenum* ops = mState.stencil_ops;
+	if (ops[0] == sfail && ops[1] == dpfail && ops[2] == dppass) {
+		++mStats.saved;
+		return;
+	}
+	ops[0] = sfail; ops[1] = dpfail; ops[2] = dppass;
+	++mStats.calls;
+	GL_CALL(glStencilOp, sfail, dpfail, dppass);
+}
+
+void RenderContext::blendFunc(const GLenum src, const GLenum dst) {
+	if (mState.blend_src == src && mState.blend_dst == dst) {
+		++mStats.saved;
+		return;
+	}
+	mState.blend_src = src;
+	mState.blend_dst = dst;
+	++mStats.calls;
+	GL_CALL(glBlendFunc, src, dst);
+}
+
+void RenderContext::cullFace(const GLenum face) {
+	CACHED_CALL(mState.cull_face, face, GL_CALL(glCullFace, face));
+}
+
+void RenderContext::frontFace(const GLenum order) {
+	CACHED_CALL(mState.front_face, order, GL_CALL(glFrontFace, order));
+}
+
+void RenderContext::polygonMode(const GLenum mode) {
+	CACHED_CALL(mState.polygon_mode, mode, GL_CALL(glPolygonMode, (GLenum)GL_FRONT_AND_BACK, mode));
+}
+
+#undef CACHED_CALL
+
+void RenderContext::drawArrays(const GLenum mode, const GLint first, const GLsizei count, const GLsizei instances) {
+	RenderStats::Add(NN_COUNTER_DRAW_CALLS, 1);
+	RenderStats::Add(NN_COUNTER_PRIMITIVES, getPrimitiveNum(mode, count) * instances);
+	if (instances == 1) {
+		GL_CALL(glDrawArrays, mode, first, count);
+	} else {
+		GL_CALL(glDrawArraysInstanced, mode, first, count, instances);
+	}
+}
+
+void RenderContext::drawElements(const GLenum mode, const GLsizei count, const GLenum type, const size_t offset, const GLint base_vertex, const GLsizei instances) {
+	RenderStats::Add(NN_COUNTER_DRAW_CALLS, 1);
+	RenderStats::Add(NN_COUNTER_PRIMITIVES, getPrimitiveNum(mode, count) * instances);
+	GLvoid* indices = (GLvoid*)offset;
+	if (instances == 1) {
+		GL_CALL(glDrawElementsBaseVertex, mode, count, type, indices, base_vertex);
+	} else {
+		GL_CALL(glDrawElementsInstancedBaseVertex, mode, count, type, indices, instances, base_vertex);
+	}
+}
+
+#undef GL_CALL
+
+NNULong RenderContext::getPrimitiveNum(const GLenum mode, const NNULong count) {
+	switch (mode) {
+	case GL_POINTS: return count;
+	case GL_LINES: return count / 2;
+	case GL_LINE_LOOP: return count;
+	case GL_LINE_STRIP: return count > 1 ? count - 1 : 0;
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN: return count > 2 ? count - 2 : 0;
+	default: return count / 3;
+	}
+}
+
+GLenum RenderContext::getPolygonMode() const {
+	return mState.polygon_mode == UNKNOWN ? GL_FILL : mState.polygon_mode;
+}
+
+void RenderContext::forgetProgram(const GLuint program) {
+	if (mState.program == program) mState.program = UNKNOWN;
+}
+
+void RenderContext::forgetVertexArray(const GLuint vao) {
+	if (mState.vertex_array == vao) mState.vertex_array = UNKNOWN;
+}
+
+void RenderContext::forgetTexture(const GLuint texture) {
+	for (auto& slot : mState.textures) {
+		for (GLuint& bound : slot) {
+			if (bound == texture) bound = UNKNOWN;
+		}
+	}
+}
+
+void RenderContext::forgetFramebuffer(const GLuint fbo) {
+	if (mState.draw_framebuffer == fbo) mState.draw_framebuffer = UNKNOWN;
+	if (mState.read_framebuffer == fbo) mState.read_framebuffer = UNKNOWN;
+}
+
+void RenderContext::forgetBuffer(const GLuint buffer) {
+	for (auto& binding : mState.uniform_buffers) {
+		if (binding.buffer == buffer) binding.buffer = UNKNOWN;
+	}
+}
+
+void RenderContext::invalidate() {
+	memset(&mState, 0xff, sizeof(mState));
+}
+
+void RenderContext::endFrame() {
+	mLastStats = mStats;
+	mStats = { 0, 0 };
+}
+
+#endif // NENE_GL
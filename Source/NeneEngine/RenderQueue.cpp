@@ -0,0 +1,328 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "Debug.h"
+#include "Camera.h"
+#include "Material.h"
+#include "ThreadPool.h"
+#include "RenderQueue.h"
+
+using namespace std;
+
+// 记录数超过该值时 Sort 才分块并行
+static const NNUInt PARALLEL_THRESHOLD = 8192;
+static const NNUInt PARALLEL_CHUNK = 4096;
+
+static inline const void* GetBinding(const Material* material, const TextureBindings* textures)
+{
+	return material != nullptr ? material->GetBindingKey() : textures;
+}
+
+RenderQueue::RenderQueue() : m_stats({ 0, 0, 0, 0 })
+{}
+
+RenderQueue::~RenderQueue()
+{}
+
+shared_ptr<RenderQueue> RenderQueue::Create(const NNUInt capacity)
+{
+	RenderQueue* result = new RenderQueue();
+	result->m_items.reserve(capacity);
+	result->m_sort_items.reserve(capacity);
+	result->m_sort_temp.reserve(capacity);
+	return shared_ptr<RenderQueue>(result);
+}
+
+void RenderQueue::Push(const NNUInt pass, Shader* shader, const TextureBindings* textures, const RenderGeometry& geometry, const NNMat4& model, const bool blended)
+{
+	if (shader == nullptr)
+	{
+		dLog("[Error] Pushing a draw item without shader.\n");
+		return;
+	}
+	m_items.push_back({ shader, textures, nullptr, geometry, model, pass, blended });
+}
+
+void RenderQueue::Push(const NNUInt pass, Material* material, Shader* shader, const RenderGeometry& geometry, const NNMat4& model, const bool blended)
+{
+	if (material == nullptr)
+	{
+		dLog("[Error] Pushing a draw item without material.\n");
+		return;
+	}
+	if (shader == nullptr)
+	{
+		shader = material->GetShader().get();
+	}
+	if (shader == nullptr)
+	{
+		dLog("[Error] Pushing a draw item without shader.\n");
+		return;
+	}
+	m_items.push_back({ shader, nullptr, material, geometry, model, pass, blended });
+}
+
+void RenderQueue::Flush(const shared_ptr<Camera> camera)
+{
+	//
+	m_stats = { 0, 0, 0, 0 };
+	if (m_items.empty())
+	{
+		return;
+	}
+	Sort(camera != nullptr ? camera->GetPosition() : NNVec3(0.0f));
+	Execute(camera);
+	Clear();
+}
+
+void RenderQueue::Sort(const NNVec3& eye, const bool parallel)
+{
+	//
+	const NNUInt num = (NNUInt)m_items.size();
+	m_sort_items.resize(num);
+	if (!parallel || num < PARALLEL_THRESHOLD)
+	{
+		for (NNUInt i = 0; i < num; ++i)
+		{
+			const Item& item = m_items[i];
+			m_sort_items[i] = { MakeKey(item.pass, item.blended, GetShaderID(item.shader), GetMaterialID(GetBinding(item.material, item.textures)), GetDepth(item, eye)), i };
+		}
+		RadixSort(m_sort_items, m_sort_temp);
+		return;
+	}
+	ThreadPool& pool = ThreadPool::Instance();
+	const NNUInt chunks = (num + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+	// 不同的着色器和材质很少: 每块并行收集第一次出现的指针, 再按块的顺序分配编号, 与串行的编号相同
+	vector<vector<const void*>> shaders(chunks), bindings(chunks);
+	pool.ParallelFor(chunks, [&](NNUInt chunk) {
+		const NNUInt begin = chunk * PARALLEL_CHUNK, end = min(begin + PARALLEL_CHUNK, num);
+		const void* last_shader = nullptr;
+		const void* last_binding = nullptr;
+		for (NNUInt i = begin; i < end; ++i)
+		{
+			const Item& item = m_items[i];
+			const void* binding = GetBinding(item.material, item.textures);
+			if (item.shader != last_shader && find(shaders[chunk].begin(), shaders[chunk].end(), item.shader) == shaders[chunk].end())
+			{
+				shaders[chunk].push_back(item.shader);
+			}
+			if (binding != last_binding && find(bindings[chunk].begin(), bindings[chunk].end(), binding) == bindings[chunk].end())
+			{
+				bindings[chunk].push_back(binding);
+			}
+			last_shader = item.shader;
+			last_binding = binding;
+		}
+	});
+	for (NNUInt chunk = 0; chunk < chunks; ++chunk)
+	{
+		for (const void* shader : shaders[chunk])
+		{
+			GetShaderID((const Shader*)shader);
+		}
+		for (const void* binding : bindings[chunk])
+		{
+			GetMaterialID(binding);
+		}
+	}
+	// 编号表只读, 每块计算键并排序
+	m_sort_temp.resize(num);
+	pool.ParallelFor(chunks, [&](NNUInt chunk) {
+		const NNUInt begin = chunk * PARALLEL_CHUNK, end = min(begin + PARALLEL_CHUNK, num);
+		MakeKeys(eye, begin, end);
+		RadixSort(m_sort_items.data() + begin, m_sort_temp.data() + begin, end - begin);
+	});
+	// 相邻的有序段两两归并, 先取前一段保持稳定
+	for (NNUInt width = PARALLEL_CHUNK; width < num; width *= 2)
+	{
+		const NNUInt pairs = (num + 2 * width - 1) / (2 * width);
+		pool.ParallelFor(pairs, [&](NNUInt pair) {
+			const NNUInt begin = pair * 2 * width;
+			const NNUInt middle = min(begin + width, num), end = min(begin + 2 * width, num);
+			merge(m_sort_items.begin() + begin, m_sort_items.begin() + middle, m_sort_items.begin() + middle, m_sort_items.begin() + end,
+				m_sort_temp.begin() + begin, [](const SortItem& lhs, const SortItem& rhs) { return lhs.key < rhs.key; });
+		});
+		m_sort_items.swap(m_sort_temp);
+	}
+}
+
+NNFloat RenderQueue::GetDepth(const Item& item, const NNVec3& eye)
+{
+	const NNVec3 position(item.model[3]);
+	const NNVec3 offset = position - eye;
+	return sqrtf(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+}
+
+void RenderQueue::MakeKeys(const NNVec3& eye, const NNUInt begin, const NNUInt end)
+{
+	for (NNUInt i = begin; i < end; ++i)
+	{
+		const Item& item = m_items[i];
+		const NNUInt shader = m_shader_ids.find(item.shader)->second;
+		const NNUInt material = m_material_ids.find(GetBinding(item.material, item.textures))->second;
+		m_sort_items[i] = { MakeKey(item.pass, item.blended, shader, material, GetDepth(item, eye)), i };
+	}
+}
+
+void RenderQueue::Execute(const shared_ptr<Camera> camera)
+{
+	//
+	m_stats = { 0, 0, 0, 0 };
+	if (m_sort_items.empty())
+	{
+		return;
+	}
+	if (camera != nullptr)
+	{
+		camera->Use();
+	}
+	ExecuteSorted();
+}
+
+void RenderQueue::Append(const vector<shared_ptr<RenderQueue>>& others, const bool parallel)
+{
+	//
+	vector<NNUInt> offsets(others.size() + 1, (NNUInt)m_items.size());
+	for (size_t i = 0; i < others.size(); ++i)
+	{
+		offsets[i + 1] = offsets[i] + (NNUInt)others[i]->m_items.size();
+	}
+	m_items.resize(offsets.back());
+	auto copy = [&](NNUInt i) {
+		std::copy(others[i]->m_items.begin(), others[i]->m_items.end(), m_items.begin() + offsets[i]);
+		others[i]->Clear();
+	};
+	if (parallel && offsets.back() - offsets.front() >= PARALLEL_THRESHOLD)
+	{
+		ThreadPool::Instance().ParallelFor((NNUInt)others.size(), copy);
+	}
+	else
+	{
+		for (NNUInt i = 0; i < (NNUInt)others.size(); ++i)
+		{
+			copy(i);
+		}
+	}
+	m_sort_items.clear();
+}
+
+void RenderQueue::Clear()
+{
+	m_items.clear();
+	m_sort_items.clear();
+	m_shader_ids.clear();
+	m_material_ids.clear();
+}
+
+NNUInt RenderQueue::GetShaderID(const Shader* shader)
+{
+	// 超出位数的编号合并到最后一个, 只影响排序质量, 执行时仍按指针判断
+	auto it = m_shader_ids.find(shader);
+	if (it != m_shader_ids.end())
+	{
+		return it->second;
+	}
+	const NNUInt id = min((NNUInt)m_shader_ids.size(), (1u << SHADER_BITS) - 1);
+	m_shader_ids[shader] = id;
+	return id;
+}
+
+NNUInt RenderQueue::GetMaterialID(const void* binding)
+{
+	auto it = m_material_ids.find(binding);
+	if (it != m_material_ids.end())
+	{
+		return it->second;
+	}
+	const NNUInt id = min((NNUInt)m_material_ids.size(), (1u << MATERIAL_BITS) - 1);
+	m_material_ids[binding] = id;
+	return id;
+}
+
+uint64_t RenderQueue::QuantizeDepth(const NNFloat depth)
+{
+	NNFloat value = max(depth, 0.0f);
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits >> (32 - DEPTH_BITS);
+}
+
+uint64_t RenderQueue::MakeKey(const NNUInt pass, const bool blended, const NNUInt shader, const NNUInt material, const NNFloat depth)
+{
+	//
+	const uint64_t depth_mask = (1ull << DEPTH_BITS) - 1;
+	const uint64_t state = ((uint64_t)shader << MATERIAL_BITS) | material;
+	uint64_t key = (uint64_t)(pass & ((1u << PASS_BITS) - 1)) << (64 - PASS_BITS);
+	if (blended)
+	{
+		// 混合: 由远到近, 同样深度时再按状态
+		key |= 1ull << (63 - PASS_BITS);
+		key |= ((~QuantizeDepth(depth)) & depth_mask) << (SHADER_BITS + MATERIAL_BITS);
+		key |= state;
+	}
+	else
+	{
+		// 不透明: 先按状态, 同样状态时由近到远
+		key |= state << DEPTH_BITS;
+		key |= QuantizeDepth(depth);
+	}
+	return key;
+}
+
+void RenderQueue::RadixSort(vector<SortItem>& items, vector<SortItem>& temp)
+{
+	temp.resize(items.size());
+	RadixSort(items.data(), temp.data(), (NNUInt)items.size());
+}
+
+void RenderQueue::RadixSort(SortItem* items, SortItem* temp, const NNUInt num)
+{
+	//
+	static const NNUInt RADIX_BITS = 8;
+	static const NNUInt RADIX = 1 << RADIX_BITS;
+	static const NNUInt DIGITS = 64 / RADIX_BITS;
+	if (num < 2)
+	{
+		return;
+	}
+	SortItem* source = items;
+	SortItem* target = temp;
+	// 一次遍历统计所有段的直方图
+	NNUInt counts[DIGITS][RADIX];
+	memset(counts, 0, sizeof(counts));
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		for (NNUInt d = 0; d < DIGITS; ++d)
+		{
+			++counts[d][(items[i].key >> (d * RADIX_BITS)) & (RADIX - 1)];
+		}
+	}
+	for (NNUInt d = 0; d < DIGITS; ++d)
+	{
+		const NNUInt shift = d * RADIX_BITS;
+		// 这一段所有键都相同, 不需要移动
+		if (counts[d][(source[0].key >> shift) & (RADIX - 1)] == num)
+		{
+			continue;
+		}
+		NNUInt sum = 0;
+		for (NNUInt& count : counts[d])
+		{
+			const NNUInt c = count;
+			count = sum;
+			sum += c;
+		}
+		for (NNUInt i = 0; i < num; ++i)
+		{
+			target[counts[d][(source[i].key >> shift) & (RADIX - 1)]++] = source[i];
+		}
+		swap(source, target);
+	}
+	// 移动了奇数次时结果在 temp 中
+	if (source != items)
+	{
+		memcpy(items, source, num * sizeof(SortItem));
+	}
+}
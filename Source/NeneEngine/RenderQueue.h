@@ -0,0 +1,130 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Types.h"
+
+class Shader;
+class Camera;
+class Material;
+class Texture2D;
+
+// 一组纹理绑定, 作为材质参与排序
+typedef std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>> TextureBindings;
+
+// 绘制一段几何需要的全部信息, 由 Mesh / Shape 提供
+struct RenderGeometry
+{
+	NNUInt vertex_array;
+	NNUInt draw_mode;
+	NNUInt vertex_num;
+	NNUInt index_num;
+	// 索引类型, 为 0 时不使用索引
+	NNUInt index_type;
+	// 在共享缓冲中的位置, 索引偏移以字节为单位
+	NNUInt index_offset;
+	NNUInt base_vertex;
+};
+
+//
+//    RenderQueue: Records draw items and executes them sorted by a 64-bit state key, skipping redundant binds
+//
+
+class RenderQueue
+{
+public:
+	// 每帧的状态切换统计
+	struct Stats
+	{
+		NNUInt draws;
+		NNUInt shader_binds;
+		NNUInt texture_binds;
+		NNUInt vertex_array_binds;
+	};
+
+public:
+	static std::shared_ptr<RenderQueue> Create(const NNUInt capacity = 1024);
+	~RenderQueue();
+	// 记录一次绘制; shader 和 textures 在 Flush 之前必须有效
+	// 不透明物体按 (pass, shader, 材质, 由近到远) 排序, 混合物体在同一 pass 的最后由远到近绘制
+	void Push(const NNUInt pass, Shader* shader, const TextureBindings* textures, const RenderGeometry& geometry, const NNMat4& model, const bool blended = false);
+	// 使用材质的纹理和参数; shader 为空时使用材质的着色器; 纹理绑定相同的材质排在一起, 之间只切换参数
+	void Push(const NNUInt pass, Material* material, Shader* shader, const RenderGeometry& geometry, const NNMat4& model, const bool blended = false);
+	// 排序并执行所有记录, 结束后清空
+	void Flush(const std::shared_ptr<Camera> camera = nullptr);
+	// 只计算排序键并排序, 不访问图形接口, 可以在工作线程调用; parallel 时分块计算并归并
+	void Sort(const NNVec3& eye, const bool parallel = false);
+	// 按 Sort 的结果执行, 不清空记录
+	void Execute(const std::shared_ptr<Camera> camera = nullptr);
+	// 把 others 的记录依次移到末尾并清空 others, 之后需要重新 Sort; parallel 时并行复制
+	void Append(const std::vector<std::shared_ptr<RenderQueue>>& others, const bool parallel = false);
+	// 丢弃所有记录
+	void Clear();
+	//
+	inline NNUInt GetItemNum() const { return (NNUInt)m_items.size(); }
+	inline const Stats& GetStats() const { return m_stats; }
+
+public:
+	// 排序键的布局
+	static const NNUInt PASS_BITS = 4;
+	static const NNUInt SHADER_BITS = 12;
+	static const NNUInt MATERIAL_BITS = 16;
+	static const NNUInt DEPTH_BITS = 31;
+	// 按 8 位一段的 LSD 基数排序, 所有键都相同的段会被跳过
+	struct SortItem
+	{
+		uint64_t key;
+		NNUInt index;
+	};
+	static void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& temp);
+	// 结果写回 items, temp 至少与 items 一样长
+	static void RadixSort(SortItem* items, SortItem* temp, const NNUInt num);
+	// 非负浮点数的位模式保持大小顺序, 取高 31 位
+	static uint64_t QuantizeDepth(const NNFloat depth);
+	static uint64_t MakeKey(const NNUInt pass, const bool blended, const NNUInt shader, const NNUInt material, const NNFloat depth);
+
+private:
+	// 按第一次出现的顺序分配紧凑的编号
+	NNUInt GetShaderID(const Shader* shader);
+	// 纹理组或材质的纹理绑定
+	NNUInt GetMaterialID(const void* binding);
+	// 计算 [begin, end) 的排序键, 编号需要已经分配
+	void MakeKeys(const NNVec3& eye, const NNUInt begin, const NNUInt end);
+	// 执行排好序的记录
+	void ExecuteSorted();
+
+private:
+	struct Item
+	{
+		Shader* shader;
+		const TextureBindings* textures;
+		Material* material;
+		RenderGeometry geometry;
+		NNMat4 model;
+		NNUInt pass;
+		bool blended;
+	};
+	// 物体原点到视点的距离
+	static NNFloat GetDepth(const Item& item, const NNVec3& eye);
+
+private:
+	std::vector<Item> m_items;
+	std::vector<SortItem> m_sort_items;
+	std::vector<SortItem> m_sort_temp;
+	std::unordered_map<const void*, NNUInt> m_shader_ids;
+	std::unordered_map<const void*, NNUInt> m_material_ids;
+	Stats m_stats;
+
+private:
+	RenderQueue();
+	RenderQueue(const RenderQueue& rhs) = delete;
+	RenderQueue& operator=(const RenderQueue& rhs) = delete;
+};
+
+#endif // RENDER_QUEUE_H
@@ -0,0 +1,81 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include "Debug.h"
+#include "Profiler.h"
+#include "DebugLayer.h"
+#include "NeneCB.h"
+#include "Shader.h"
+#include "Material.h"
+#include "Texture2D.h"
+#include "RenderContext.h"
+#include "RenderQueue.h"
+
+using namespace std;
+
+void RenderQueue::ExecuteSorted()
+{
+	//
+	NN_DEBUG_GROUP("RenderQueue");
+	NN_PROFILE_ZONE("RenderQueue");
+	NeneCB& CB = NeneCB::Instance();
+	const Shader* current_shader = nullptr;
+	const void* current_binding = nullptr;
+	Material* current_material = nullptr;
+	NNUInt current_vertex_array = 0;
+	for (const SortItem& sort_item : m_sort_items)
+	{
+		const Item& item = m_items[sort_item.index];
+		// 只在状态变化时绑定
+		if (item.shader != current_shader)
+		{
+			item.shader->Use();
+			current_shader = item.shader;
+			++m_stats.shader_binds;
+		}
+		const void* binding = item.material != nullptr ? item.material->GetBindingKey() : item.textures;
+		if (binding != current_binding)
+		{
+			if (item.material != nullptr)
+			{
+				item.material->UseTextures();
+				++m_stats.texture_binds;
+			}
+			else if (item.textures != nullptr)
+			{
+				for (const auto& texture : *item.textures)
+				{
+					get<0>(texture)->Use(get<1>(texture));
+				}
+				++m_stats.texture_binds;
+			}
+			current_binding = binding;
+		}
+		// 共享纹理数组的材质之间只切换参数
+		if (item.material != nullptr && item.material != current_material)
+		{
+			item.material->UseParams();
+			current_material = item.material;
+		}
+		if (item.geometry.vertex_array != current_vertex_array)
+		{
+			RenderContext::instance().bindVertexArray(item.geometry.vertex_array);
+			current_vertex_array = item.geometry.vertex_array;
+			++m_stats.vertex_array_binds;
+		}
+		//
+		CB.PerObject().Data().model = item.model;
+		CB.UpdatePerObject();
+		if (item.geometry.index_type != 0)
+		{
+			RenderContext::instance().drawElements(item.geometry.draw_mode, item.geometry.index_num, item.geometry.index_type, item.geometry.index_offset, item.geometry.base_vertex);
+		}
+		else
+		{
+			RenderContext::instance().drawArrays(item.geometry.draw_mode, 0, item.geometry.vertex_num);
+		}
+		++m_stats.draws;
+	}
+}
+
+#endif // NENE_GL
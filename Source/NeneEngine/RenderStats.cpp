@@ -0,0 +1,127 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#include <algorithm>
+#include "RenderStats.h"
+
+#include "ImGui/imgui.h"
+
+using namespace std;
+
+static const NNChar* s_counter_names[NNRenderCounterNum] = {
+	"Draw calls", "Primitives", "Program binds", "Texture binds", "VAO binds", "FBO binds", "Uniform bytes", "Texture bytes", "Buffer bytes"
+};
+
+atomic<NNULong> RenderStats::s_counters[NNRenderCounterNum] = {};
+
+RenderStats::RenderStats() :
+	m_next(0), m_frame_num(0), m_summaries()
+{
+	m_history.resize(DEFAULT_WINDOW);
+}
+
+RenderStats& RenderStats::Instance()
+{
+	static RenderStats instance;
+	return instance;
+}
+
+const NNChar* RenderStats::GetCounterName(const NNRenderCounter counter)
+{
+	return s_counter_names[counter];
+}
+
+void RenderStats::EndFrame()
+{
+	//
+	Counters& frame = m_history[m_next];
+	for (NNUInt i = 0; i < NNRenderCounterNum; ++i)
+	{
+		frame[i] = s_counters[i].exchange(0, memory_order_relaxed);
+	}
+	m_next = (m_next + 1) % (NNUInt)m_history.size();
+	m_frame_num = min(m_frame_num + 1, (NNUInt)m_history.size());
+	// 窗口只有几百帧, 每帧重新统计
+	for (NNUInt i = 0; i < NNRenderCounterNum; ++i)
+	{
+		Summary& summary = m_summaries[i];
+		summary.last = frame[i];
+		summary.min = summary.max = frame[i];
+		NNULong total = 0;
+		for (NNUInt f = 0; f < m_frame_num; ++f)
+		{
+			const NNULong value = m_history[f][i];
+			summary.min = min(summary.min, value);
+			summary.max = max(summary.max, value);
+			total += value;
+		}
+		summary.avg = (double)total / m_frame_num;
+	}
+}
+
+void RenderStats::SetWindow(const NNUInt frames)
+{
+	m_history.assign(max(frames, 1u), Counters());
+	Reset();
+}
+
+void RenderStats::Reset()
+{
+	m_next = 0;
+	m_frame_num = 0;
+	m_summaries = {};
+}
+
+void RenderStats::DrawPanel()
+{
+	//
+	ImGui::Begin("Render Stats");
+	{
+		ImGui::Text("Last %u frames", m_frame_num);
+		ImGui::SameLine();
+		if (ImGui::Button("Reset"))
+		{
+			Reset();
+		}
+		ImGui::Columns(5, "render_stats");
+		ImGui::Text("Counter");
+		ImGui::NextColumn();
+		ImGui::Text("Last");
+		ImGui::NextColumn();
+		ImGui::Text("Min");
+		ImGui::NextColumn();
+		ImGui::Text("Avg");
+		ImGui::NextColumn();
+		ImGui::Text("Max");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (NNUInt i = 0; i < NNRenderCounterNum; ++i)
+		{
+			const Summary& summary = m_summaries[i];
+			ImGui::Text("%s", s_counter_names[i]);
+			ImGui::NextColumn();
+			// 字节数按 KB 显示
+			if (i >= NN_COUNTER_UNIFORM_BYTES)
+			{
+				ImGui::Text("%.1f KB", summary.last / 1024.0);
+				ImGui::NextColumn();
+				ImGui::Text("%.1f KB", summary.min / 1024.0);
+				ImGui::NextColumn();
+				ImGui::Text("%.1f KB", summary.avg / 1024.0);
+				ImGui::NextColumn();
+				ImGui::Text("%.1f KB", summary.max / 1024.0);
+			}
+			else
+			{
+				ImGui::Text("%llu", (unsigned long long)summary.last);
+				ImGui::NextColumn();
+				ImGui::Text("%llu", (unsigned long long)summary.min);
+				ImGui::NextColumn();
+				ImGui::Text("%.1f", summary.avg);
+				ImGui::NextColumn();
+				ImGui::Text("%llu", (unsigned long long)summary.max);
+			}
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+	ImGui::End();
+}
@@ -0,0 +1,79 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "Types.h"
+
+// 每帧统计的计数器; 绑定只计入状态缓存未命中、真正发给驱动的调用
+enum NNRenderCounter {
+	NN_COUNTER_DRAW_CALLS = 0,
+	NN_COUNTER_PRIMITIVES,
+	NN_COUNTER_PROGRAM_BINDS,
+	NN_COUNTER_TEXTURE_BINDS,
+	NN_COUNTER_VERTEX_ARRAY_BINDS,
+	NN_COUNTER_FRAMEBUFFER_BINDS,
+	NN_COUNTER_UNIFORM_BYTES,
+	NN_COUNTER_TEXTURE_BYTES,
+	NN_COUNTER_BUFFER_BYTES,
+	NNRenderCounterNum
+};
+
+//
+//    RenderStats: A singleton counting draw calls, binds and uploads per frame, with min / avg / max over a rolling window of frames
+//
+
+class RenderStats
+{
+public:
+	// 最近一帧和窗口内各帧的统计
+	struct Summary
+	{
+		NNULong last;
+		NNULong min;
+		NNULong max;
+		double avg;
+	};
+	// 默认统计最近 120 帧
+	static const NNUInt DEFAULT_WINDOW = 120;
+
+public:
+	// 获取单例
+	static RenderStats& Instance();
+	// 累加到当前帧, 可以在任意线程调用 (渲染线程上的上传可能计入下一帧)
+	static inline void Add(const NNRenderCounter counter, const NNULong value) { s_counters[counter].fetch_add(value, std::memory_order_relaxed); }
+	static const NNChar* GetCounterName(const NNRenderCounter counter);
+	// 结束当前帧并更新窗口内的统计, 由 Utils::SwapBuffers 调用
+	void EndFrame();
+	inline const Summary& GetSummary(const NNRenderCounter counter) const { return m_summaries[counter]; }
+	inline NNULong GetLast(const NNRenderCounter counter) const { return m_summaries[counter].last; }
+	// 修改窗口大小会清空已有的统计
+	void SetWindow(const NNUInt frames);
+	inline NNUInt GetWindow() const { return (NNUInt)m_history.size(); }
+	// 窗口内已经统计的帧数
+	inline NNUInt GetFrameNum() const { return m_frame_num; }
+	void Reset();
+	// 显示各计数器的 ImGui 窗口, 在 UserInterface 的绘制函数中调用
+	void DrawPanel();
+
+private:
+	typedef std::array<NNULong, NNRenderCounterNum> Counters;
+
+private:
+	static std::atomic<NNULong> s_counters[NNRenderCounterNum];
+	// 环形的历史记录, m_next 为下一帧写入的位置
+	std::vector<Counters> m_history;
+	NNUInt m_next;
+	NNUInt m_frame_num;
+	std::array<Summary, NNRenderCounterNum> m_summaries;
+
+private:
+	RenderStats();
+	RenderStats(const RenderStats& rhs) = delete;
+	RenderStats& operator=(const RenderStats& rhs) = delete;
+};
+
+#endif // RENDER_STATS_H
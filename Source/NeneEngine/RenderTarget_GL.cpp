@@ -3,13 +3,18 @@
 
 #include "RenderTarget.h"
 #include "Debug.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
 
 using namespace std;
 
 
 RenderTarget::~RenderTarget() {
 	if (mFBO != 0) {
-		glDeleteBuffers(1, &mFBO);
+		RenderContext::instance().forgetFramebuffer(mFBO);
+		// 在已经录制的绘制之后删除
+		const GLuint fbo = mFBO;
+		RenderThread::Defer([fbo]() { glDeleteFramebuffers(1, &fbo); });
 	}
 }
 
@@ -21,6 +26,7 @@ shared_ptr<RenderTarget> RenderTarget::Create(const NNUInt& width, const NNUInt&
 shared_ptr<RenderTarget> RenderTarget::Create(const NNUInt& width, const NNUInt& height, const NNUInt& count, const NNPixelFormat& format)
 {
 	// 
+	NN_RENDER_THREAD_FORWARD(Create(width, height, count, format));
 	RenderTarget *ret = new RenderTarget();
 	ret->format = format;
 	ret->mWidth = width;
@@ -37,7 +43,7 @@ shared_ptr<RenderTarget> RenderTarget::Create(const NNUInt& width, const NNUInt&
 	// DepthStencil textures
 	ret->mDepthStencilTex = Texture2D::CreateFromMemory(width, height, NNPixelFormat::D24S8_UNORM);
 	// 
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, FBO);
 	// Bind as color attacments
 	vector<unsigned int> attachments;
 	for (unsigned int i = 0; i < count; ++i) {
@@ -54,7 +60,7 @@ shared_ptr<RenderTarget> RenderTarget::Create(const NNUInt& width, const NNUInt&
 	}
 	// Check if multi render targets is used
 	glDrawBuffers((NNUInt)attachments.size(), attachments.data());
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 	// 
 	return shared_ptr<RenderTarget>(ret);
 }
@@ -62,13 +68,16 @@ shared_ptr<RenderTarget> RenderTarget::Create(const NNUInt& width, const NNUInt&
 
 
 void RenderTarget::Blit(const RenderTarget& src, const RenderTarget& dest, NNUInt field, NNUInt filter) {
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest.mFBO);
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, src.mFBO);
-	glDrawBuffer(GL_BACK);
-	glBlitFramebuffer(0, 0,src.mWidth, src.mHeight, 0, 0, dest.mWidth, dest.mHeight, field, filter);
+	RenderContext::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, dest.mFBO);
+	RenderContext::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, src.mFBO);
+	RenderThread::Record([](const GLint src_width, const GLint src_height, const GLint dest_width, const GLint dest_height, const GLbitfield mask, const GLenum blit_filter) {
+		glDrawBuffer(GL_BACK);
+		glBlitFramebuffer(0, 0, src_width, src_height, 0, 0, dest_width, dest_height, mask, blit_filter);
+	}, (GLint)src.mWidth, (GLint)src.mHeight, (GLint)dest.mWidth, (GLint)dest.mHeight, (GLbitfield)field, (GLenum)filter);
 }
 
 shared_ptr<RenderTarget> RenderTarget::CreateMultisample(const NNUInt& width, const NNUInt& height, const NNUInt& samples, const NNUInt& count) {
+	NN_RENDER_THREAD_FORWARD(CreateMultisample(width, height, samples, count));
 	// 构造对象
 	RenderTarget *ret = new RenderTarget();
 	ret->mWidth = width;
@@ -84,7 +93,7 @@ shared_ptr<RenderTarget> RenderTarget::CreateMultisample(const NNUInt& width, co
 	// 深度模板附件
 	ret->mDepthStencilTex = Texture2D::CreateMultisample(width, height, samples, GL_DEPTH24_STENCIL8);
 	// 绑定附件
-	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, FBO);
 	// 颜色
 	vector<unsigned int> attachments;
 	for (unsigned int i = 0; i < count; ++i) {
@@ -101,7 +110,7 @@ shared_ptr<RenderTarget> RenderTarget::CreateMultisample(const NNUInt& width, co
 	}
 	// 绑定渲染对象
 	glDrawBuffers(3, attachments.data());
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 	// 返回
 	return shared_ptr<RenderTarget>(ret);
 }
@@ -119,26 +128,27 @@ const shared_ptr<Texture2D> RenderTarget::GetDepthStencilTex() {
 
 void RenderTarget::Begin()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
-	glViewport(0, 0, mWidth, mHeight);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, mFBO);
+	RenderContext::instance().viewport(0, 0, mWidth, mHeight);
 }
 
 void RenderTarget::End()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glViewport(0, 0, Utils::GetWindowWidth(), Utils::GetWindowHeight());
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderContext::instance().viewport(0, 0, Utils::GetWindowWidth(), Utils::GetWindowHeight());
 }
 
 void RenderTarget::SavePixelData(const NNChar* filepath)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(SavePixelData(filepath));
 	NNByte* buffer = new NNByte[mWidth * mHeight * 4 * sizeof(NNByte)];
-	glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, mFBO);
 	glReadBuffer(GL_COLOR_ATTACHMENT0);
 	{
 		glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, buffer);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 	//
 	shared_ptr<NNByte[]> bits = shared_ptr<NNByte[]>(buffer);
 	Texture::SaveImage(bits, mWidth, mHeight, format, filepath);
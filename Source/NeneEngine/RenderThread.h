@@ -0,0 +1,150 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "Types.h"
+#include "CommandStream.h"
+
+//
+//    RenderThread: Optional singleton owning the graphics context, replaying command streams recorded by the main thread one frame behind
+//
+
+class RenderThread
+{
+public:
+	// 上一帧的统计
+	struct Stats
+	{
+		NNUInt commands;
+		size_t bytes;
+		// 同步调用的次数, 每次都要等渲染线程执行完之前录制的命令
+		NNUInt invokes;
+		// 主线程在帧末等待渲染线程的时间
+		NNFloat wait_milliseconds;
+	};
+
+public:
+	// 获取单例
+	static RenderThread& Instance();
+	// 把当前线程的上下文交给渲染线程, 由 Utils::Init 调用
+	void Start(NNWindow window);
+	// 执行完所有命令后把上下文交回当前线程, 由 Utils::Terminate 调用
+	void Stop();
+	inline bool IsRunning() const { return m_running; }
+	// 渲染线程运行时, 其它线程的图形调用都录制到命令流中
+	static bool IsRecording();
+	// 录制一次调用, 不在录制时直接执行
+	template<typename F, typename... Args>
+	static void Record(F function, Args... args);
+	template<typename F, typename... Args>
+	static void RecordData(F function, const void* data, const size_t size, Args... args);
+	// 录制一个函数对象 (如释放资源), 不在录制时直接执行
+	static void Defer(std::function<void()>&& call);
+	// 在渲染线程上同步执行并返回结果 (创建资源, 回读数据), 会先执行完之前录制的所有命令
+	template<typename F>
+	static auto Invoke(F&& task) -> decltype(task());
+	// 提交本帧的命令并等待上一帧执行完, 由 Utils::SwapBuffers 调用
+	void EndFrame();
+	//
+	inline CommandStream& GetStream() { return *m_recording; }
+	inline const Stats& GetStats() const { return m_last_stats; }
+	// 主线程正在录制的帧序号, 渲染线程执行完的帧数大于它时这一帧录制的数据可以释放
+	inline NNUInt GetSubmittedFrameNum() const { return m_submitted_frames; }
+	NNUInt GetCompletedFrameNum();
+
+public:
+	~RenderThread();
+
+private:
+	// 按提交顺序执行: 命令流, 同步任务, 或帧结束标记
+	struct Work
+	{
+		std::shared_ptr<CommandStream> stream;
+		std::function<void()> task;
+		bool end_frame;
+	};
+
+private:
+	void RenderLoop();
+	// 把已经录制的命令交给渲染线程, 换一个空的命令流继续录制
+	void Flush(const bool end_frame);
+	void Push(Work&& work);
+
+private:
+	NNWindow m_window;
+	std::thread m_thread;
+	std::atomic<bool> m_running;
+	// 主线程正在录制的命令流, 执行完的命令流回收复用
+	std::shared_ptr<CommandStream> m_recording;
+	std::vector<std::shared_ptr<CommandStream>> m_free_streams;
+	std::deque<Work> m_queue;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::condition_variable m_done_condition;
+	// 已提交和已执行完的帧数
+	NNUInt m_submitted_frames;
+	NNUInt m_completed_frames;
+	bool m_stopping;
+	//
+	Stats m_stats, m_last_stats;
+
+private:
+	RenderThread();
+	RenderThread(const RenderThread& rhs) = delete;
+	RenderThread& operator=(const RenderThread& rhs) = delete;
+};
+
+template<typename F, typename... Args>
+void RenderThread::Record(F function, Args... args)
+{
+	if (IsRecording())
+	{
+		Instance().GetStream().Record(function, args...);
+		return;
+	}
+	std::invoke(function, args...);
+}
+
+template<typename F, typename... Args>
+void RenderThread::RecordData(F function, const void* data, const size_t size, Args... args)
+{
+	if (IsRecording())
+	{
+		Instance().GetStream().RecordData(function, data, size, args...);
+		return;
+	}
+	std::invoke(function, args..., data, size);
+}
+
+template<typename F>
+auto RenderThread::Invoke(F&& task) -> decltype(task())
+{
+	using R = decltype(task());
+	if (!IsRecording())
+	{
+		return task();
+	}
+	RenderThread& instance = Instance();
+	std::packaged_task<R()> packaged(std::forward<F>(task));
+	std::future<R> result = packaged.get_future();
+	instance.m_stats.invokes += 1;
+	instance.Flush(false);
+	instance.Push({ nullptr, [&packaged]() { packaged(); }, false });
+	return result.get();
+}
+
+// 渲染线程运行时转发到渲染线程同步执行, 用在创建资源等需要立即得到结果的函数开头
+#define NN_RENDER_THREAD_FORWARD(call) \
+	if (RenderThread::IsRecording()) { return RenderThread::Invoke([&]() { return call; }); }
+
+#endif // RENDER_THREAD_H
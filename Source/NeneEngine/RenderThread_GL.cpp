@@ -0,0 +1,193 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <chrono>
+#include "Debug.h"
+#include "RenderThread.h"
+
+using namespace std;
+
+// 当前线程是否为渲染线程
+static thread_local bool tIsRenderThread = false;
+
+RenderThread::RenderThread() :
+	m_window(nullptr), m_running(false), m_submitted_frames(0), m_completed_frames(0), m_stopping(false), m_stats(), m_last_stats()
+{}
+
+RenderThread::~RenderThread()
+{
+	// 上下文由 Utils::Terminate 之前的 Stop 交回
+	if (m_thread.joinable())
+	{
+		Stop();
+	}
+}
+
+RenderThread& RenderThread::Instance()
+{
+	static RenderThread instance;
+	return instance;
+}
+
+bool RenderThread::IsRecording()
+{
+	return !tIsRenderThread && Instance().m_running;
+}
+
+void RenderThread::Start(NNWindow window)
+{
+	//
+	if (m_running)
+	{
+		dLog("[Error] Render thread is already running.\n");
+		return;
+	}
+	m_window = window;
+	m_recording = CommandStream::Create();
+	m_submitted_frames = 0;
+	m_completed_frames = 0;
+	m_stopping = false;
+	m_stats = {};
+	m_last_stats = {};
+	// 一个上下文同时只能在一个线程上使用
+	glfwMakeContextCurrent(nullptr);
+	m_running = true;
+	m_thread = thread(&RenderThread::RenderLoop, this);
+}
+
+void RenderThread::Stop()
+{
+	//
+	if (!m_running)
+	{
+		return;
+	}
+	Flush(true);
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+	m_running = false;
+	m_recording = nullptr;
+	m_free_streams.clear();
+	glfwMakeContextCurrent(m_window);
+}
+
+void RenderThread::Defer(function<void()>&& call)
+{
+	if (IsRecording())
+	{
+		Instance().GetStream().RecordCall(move(call));
+		return;
+	}
+	call();
+}
+
+void RenderThread::Push(Work&& work)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (work.end_frame)
+		{
+			m_submitted_frames += 1;
+		}
+		m_queue.push_back(move(work));
+	}
+	m_condition.notify_one();
+}
+
+void RenderThread::Flush(const bool end_frame)
+{
+	//
+	if (m_recording->GetCommandNum() == 0 && !end_frame)
+	{
+		return;
+	}
+	shared_ptr<CommandStream> next;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if (!m_free_streams.empty())
+		{
+			next = move(m_free_streams.back());
+			m_free_streams.pop_back();
+		}
+	}
+	if (next == nullptr)
+	{
+		next = CommandStream::Create();
+	}
+	m_stats.commands += m_recording->GetCommandNum();
+	m_stats.bytes += m_recording->GetBytes();
+	Push({ move(m_recording), nullptr, end_frame });
+	m_recording = move(next);
+}
+
+void RenderThread::EndFrame()
+{
+	//
+	if (!m_running)
+	{
+		return;
+	}
+	Flush(true);
+	// 等待上一帧执行完, 渲染线程上最多有一帧未完成
+	const auto begin = chrono::steady_clock::now();
+	{
+		unique_lock<mutex> lock(m_mutex);
+		m_done_condition.wait(lock, [this]() { return m_completed_frames + 1 >= m_submitted_frames; });
+	}
+	m_stats.wait_milliseconds = chrono::duration<NNFloat, milli>(chrono::steady_clock::now() - begin).count();
+	m_last_stats = m_stats;
+	m_stats = {};
+}
+
+NNUInt RenderThread::GetCompletedFrameNum()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_completed_frames;
+}
+
+void RenderThread::RenderLoop()
+{
+	//
+	tIsRenderThread = true;
+	glfwMakeContextCurrent(m_window);
+	while (true)
+	{
+		Work work;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			// 停止前执行完所有提交的工作
+			if (m_queue.empty())
+			{
+				break;
+			}
+			work = move(m_queue.front());
+			m_queue.pop_front();
+		}
+		if (work.stream != nullptr)
+		{
+			work.stream->Execute();
+			lock_guard<mutex> lock(m_mutex);
+			m_free_streams.push_back(move(work.stream));
+		}
+		if (work.task)
+		{
+			work.task();
+		}
+		if (work.end_frame)
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				m_completed_frames += 1;
+			}
+			m_done_condition.notify_all();
+		}
+	}
+	glfwMakeContextCurrent(nullptr);
+}
+
+#endif // NENE_GL
@@ -0,0 +1,117 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef RESOURCE_LOADER_H
+#define RESOURCE_LOADER_H
+
+#include <list>
+#include <array>
+#include <future>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "Types.h"
+
+//
+//    ResourceLoader: A singleton draining GPU uploads of asynchronously loaded resources under a per-frame budget
+//
+
+class ResourceLoader
+{
+public:
+	// 异步任务: 工作线程解码完成后, 主线程分多步调用 upload, 返回 true 表示全部上传完成
+	struct Job
+	{
+		std::vector<std::shared_future<void>> decoding;
+		std::function<bool()> upload;
+		bool ready;
+	};
+
+public:
+	// 获取单例
+	static ResourceLoader& Instance();
+	// 每帧的上传预算 (毫秒, 字节), 每帧至少执行一步
+	void SetBudget(const NNFloat milliseconds, const size_t bytes);
+	// 提交任务
+	std::shared_ptr<Job> Enqueue(std::vector<std::shared_future<void>> decoding, std::function<bool()> upload);
+	// 在预算内处理上传, 由 Utils::Update 每帧调用
+	void Update();
+	// 阻塞直到任务完成, 不受预算限制
+	void Finish(const std::shared_ptr<Job>& job);
+	// 丢弃所有任务并释放暂存缓冲, 由 Utils::Terminate 调用
+	void Release();
+	//
+	inline size_t GetPendingNum() const { return m_jobs.size(); }
+	inline size_t GetFrameUploadedBytes() const { return m_frame_bytes; }
+	// 非像素数据 (如顶点) 的上传量也计入预算
+	inline void AddUploadedBytes(const size_t size) { m_frame_bytes += size; }
+
+#if defined NENE_GL
+	// 把数据拷贝到暂存环中的下一个 PBO 并绑定为 GL_PIXEL_UNPACK_BUFFER, 返回值作为像素指针传给 glTex(Sub)Image
+	const void* Stage(const void* data, const size_t size);
+	// 上传命令提交后调用, 插入围栏并解绑 PBO
+	void Unstage();
+#endif
+
+public:
+	~ResourceLoader();
+
+private:
+	bool IsDecoded(const Job& job) const;
+
+private:
+	std::list<std::shared_ptr<Job>> m_jobs;
+	//
+	NNFloat m_budget_milliseconds;
+	size_t m_budget_bytes;
+	size_t m_frame_bytes;
+#if defined NENE_GL
+	// 暂存环: 围栏保证 GPU 读完之前不会覆盖
+	struct StagingBuffer
+	{
+		GLuint pbo;
+		size_t capacity;
+		GLsync fence;
+	};
+	static const NNUInt STAGING_RING_SIZE = 3;
+	std::array<StagingBuffer, STAGING_RING_SIZE> m_staging;
+	NNUInt m_staging_index;
+#endif
+
+private:
+	ResourceLoader();
+	ResourceLoader(const ResourceLoader& rhs) = delete;
+	ResourceLoader& operator=(const ResourceLoader& rhs) = delete;
+};
+
+//
+//    AsyncHandle: Resource returned by LoadAsync, usable at once with placeholder data until its upload finishes
+//
+
+template<typename T>
+class AsyncHandle
+{
+public:
+	AsyncHandle() = default;
+	AsyncHandle(std::shared_ptr<T> resource, std::shared_ptr<ResourceLoader::Job> job) : m_resource(resource), m_job(job) {}
+	//
+	inline T* operator->() const { return m_resource.get(); }
+	inline operator std::shared_ptr<T>() const { return m_resource; }
+	inline std::shared_ptr<T> Get() const { return m_resource; }
+	// 数据是否已经替换占位资源
+	inline bool IsReady() const { return m_job == nullptr || m_job->ready; }
+	// 在主线程阻塞等待完成
+	inline std::shared_ptr<T> Wait() const
+	{
+		if (m_job != nullptr)
+		{
+			ResourceLoader::Instance().Finish(m_job);
+		}
+		return m_resource;
+	}
+
+private:
+	std::shared_ptr<T> m_resource;
+	std::shared_ptr<ResourceLoader::Job> m_job;
+};
+
+#endif // RESOURCE_LOADER_H
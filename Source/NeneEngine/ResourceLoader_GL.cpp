@@ -0,0 +1,193 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <chrono>
+#include <cstring>
+#include "Debug.h"
+#include "RenderThread.h"
+#include "ResourceLoader.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+// 默认预算: 每帧 4ms 或 16MB
+static const NNFloat DEFAULT_BUDGET_MILLISECONDS = 4.0f;
+static const size_t DEFAULT_BUDGET_BYTES = 16 << 20;
+// 等待 PBO 围栏的超时 (纳秒)
+static const GLuint64 STAGING_FENCE_TIMEOUT = 1000000000;
+
+ResourceLoader::ResourceLoader() :
+	m_budget_milliseconds(DEFAULT_BUDGET_MILLISECONDS), m_budget_bytes(DEFAULT_BUDGET_BYTES), m_frame_bytes(0), m_staging(), m_staging_index(0)
+{}
+
+ResourceLoader::~ResourceLoader()
+{
+	// 单例析构时上下文已经销毁, 图形资源由 Release 释放
+}
+
+ResourceLoader& ResourceLoader::Instance()
+{
+	static ResourceLoader instance;
+	return instance;
+}
+
+void ResourceLoader::SetBudget(const NNFloat milliseconds, const size_t bytes)
+{
+	m_budget_milliseconds = milliseconds;
+	m_budget_bytes = bytes;
+}
+
+shared_ptr<ResourceLoader::Job> ResourceLoader::Enqueue(vector<shared_future<void>> decoding, function<bool()> upload)
+{
+	shared_ptr<Job> job = make_shared<Job>();
+	job->decoding = move(decoding);
+	job->upload = move(upload);
+	job->ready = false;
+	m_jobs.push_back(job);
+	return job;
+}
+
+bool ResourceLoader::IsDecoded(const Job& job) const
+{
+	for (const shared_future<void>& decoding : job.decoding)
+	{
+		if (decoding.wait_for(chrono::seconds(0)) != future_status::ready)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ResourceLoader::Update()
+{
+	//
+	m_frame_bytes = 0;
+	// 渲染线程运行时在渲染线程上上传, 没有任务时不需要同步
+	if (m_jobs.empty())
+	{
+		return;
+	}
+	NN_RENDER_THREAD_FORWARD(Update());
+	auto begin = chrono::high_resolution_clock::now();
+	auto within_budget = [&]() {
+		NNFloat elapsed = chrono::duration<NNFloat, milli>(chrono::high_resolution_clock::now() - begin).count();
+		return elapsed < m_budget_milliseconds && m_frame_bytes < m_budget_bytes;
+	};
+	// 按提交顺序处理, 还没解码完成的任务先跳过
+	bool first_step = true;
+	for (auto it = m_jobs.begin(); it != m_jobs.end(); )
+	{
+		Job& job = **it;
+		if (!IsDecoded(job))
+		{
+			++it;
+			continue;
+		}
+		bool done = false;
+		while (!done && (first_step || within_budget()))
+		{
+			done = job.upload();
+			first_step = false;
+		}
+		if (!done)
+		{
+			break;
+		}
+		job.ready = true;
+		job.upload = nullptr;
+		it = m_jobs.erase(it);
+	}
+}
+
+void ResourceLoader::Finish(const shared_ptr<Job>& job)
+{
+	if (job->ready)
+	{
+		return;
+	}
+	NN_RENDER_THREAD_FORWARD(Finish(job));
+	for (const shared_future<void>& decoding : job->decoding)
+	{
+		decoding.wait();
+	}
+	while (!job->upload());
+	job->ready = true;
+	job->upload = nullptr;
+	m_jobs.remove(job);
+}
+
+void ResourceLoader::Release()
+{
+	// 等工作线程结束, 避免它们访问已释放的资源
+	for (const shared_ptr<Job>& job : m_jobs)
+	{
+		for (const shared_future<void>& decoding : job->decoding)
+		{
+			decoding.wait();
+		}
+	}
+	m_jobs.clear();
+	NN_RENDER_THREAD_FORWARD(Release());
+	for (StagingBuffer& staging : m_staging)
+	{
+		if (staging.fence != nullptr) glDeleteSync(staging.fence);
+		if (staging.pbo != 0) glDeleteBuffers(1, &staging.pbo);
+		staging = StagingBuffer();
+	}
+	m_staging_index = 0;
+}
+
+const void* ResourceLoader::Stage(const void* data, const size_t size)
+{
+	//
+	StagingBuffer& staging = m_staging[m_staging_index];
+	m_staging_index = (m_staging_index + 1) % STAGING_RING_SIZE;
+	// 等待 GPU 读完上一轮的数据
+	if (staging.fence != nullptr)
+	{
+		glClientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, STAGING_FENCE_TIMEOUT);
+		glDeleteSync(staging.fence);
+		staging.fence = nullptr;
+	}
+	if (staging.pbo == 0)
+	{
+		glGenBuffers(1, &staging.pbo);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
+	if (staging.capacity < size)
+	{
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		staging.capacity = size;
+	}
+	// 只用于纹理数据
+	RenderStats::Add(NN_COUNTER_TEXTURE_BYTES, size);
+	// 写入数据
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped == nullptr)
+	{
+		// 映射失败时直接从内存上传
+		dLog("[Error] Failed to map staging buffer.");
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_frame_bytes += size;
+		return data;
+	}
+	memcpy(mapped, data, size);
+	glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	//
+	m_frame_bytes += size;
+	return nullptr;
+}
+
+void ResourceLoader::Unstage()
+{
+	// 上一个 Stage 使用的缓冲
+	StagingBuffer& staging = m_staging[(m_staging_index + STAGING_RING_SIZE - 1) % STAGING_RING_SIZE];
+	if (staging.fence == nullptr)
+	{
+		staging.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+#endif // NENE_GL
@@ -8,6 +8,7 @@
 #include <memory>
 
 #include "Utils.h"
+#include "ResourceLoader.h"
 
 class ShaderImpl;
 
@@ -25,6 +26,9 @@ public:
 		const NNVertexFormat vf=POSITION_NORMAL_TEXTURE, const bool try_link=true);
 	static std::shared_ptr<Shader> CreateFromSource(const NNChar *vs_source, const NNChar *fs_source, 
 		const NNVertexFormat vf=POSITION_NORMAL_TEXTURE, const bool try_link=true);
+	// Read sources on a worker thread, compile and link later on the main thread (Use does nothing until then)
+	static AsyncHandle<Shader> LoadAsync(const NNChar *vs_filepath, const NNChar *fs_filepath,
+		const NNVertexFormat vf=POSITION_NORMAL_TEXTURE);
 	
 	// Set vertex format
 	void SetLayoutFormat(const NNVertexFormat vf) { m_vf = vf; }
@@ -3,8 +3,12 @@
 
 #include "NeneCB.h"
 #include "Shader.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
 #include "IO.h"
 #include "Debug.h"
+#include "DebugLayer.h"
+#include "ThreadPool.h"
 #include <string>
 #include <cmath>
 #include <map>
@@ -53,7 +57,10 @@ ShaderImpl::~ShaderImpl()
 {
 	if (m_program_id != 0)
 	{
-		glDeleteProgram(m_program_id);
+		RenderContext::instance().forgetProgram(m_program_id);
+		// 在已经录制的绘制之后删除
+		const GLuint program = m_program_id;
+		RenderThread::Defer([program]() { glDeleteProgram(program); });
 		m_program_id = 0;
 	}
 }
@@ -62,7 +69,7 @@ void ShaderImpl::Use()
 {
 	if (m_is_linked)
 	{
-		glUseProgram(m_program_id);
+		RenderContext::instance().useProgram(m_program_id);
 	}
 }
 
@@ -126,6 +133,7 @@ shared_ptr<Shader> Shader::Create(const NNChar *vs_filepath, const NNChar *fs_fi
 	{
 		result->m_filepaths[NNShaderType::VERTEX_SHADER] = string(vs_filepath);
 		result->m_filepaths[NNShaderType::FRAGMENT_SHADER] = string(fs_filepath);
+		DebugLayer::SetLabel(GL_PROGRAM, result->m_impl->m_program_id, string(vs_filepath) + " | " + fs_filepath);
 	}
 	//
 	return result;
@@ -134,6 +142,7 @@ shared_ptr<Shader> Shader::Create(const NNChar *vs_filepath, const NNChar *fs_fi
 shared_ptr<Shader> Shader::CreateFromSource(const NNChar *vs_source, const NNChar *fs_source, const NNVertexFormat vf, const bool try_link)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(CreateFromSource(vs_source, fs_source, vf, try_link));
 	GLuint pid = glCreateProgram();
 	if (!pid)
 	{
@@ -162,6 +171,41 @@ shared_ptr<Shader> Shader::CreateFromSource(const NNChar *vs_source, const NNCha
 	return (result);
 }
 
+AsyncHandle<Shader> Shader::LoadAsync(const NNChar *vs_filepath, const NNChar *fs_filepath, const NNVertexFormat vf)
+{
+	// 未链接的着色器作为占位
+	shared_ptr<Shader> result(new Shader());
+	result->m_impl = new ShaderImpl();
+	result->m_filepaths[NNShaderType::VERTEX_SHADER] = string(vs_filepath);
+	result->m_filepaths[NNShaderType::FRAGMENT_SHADER] = string(fs_filepath);
+	result->SetLayoutFormat(vf);
+	// 工作线程读取源码 (不持有着色器对象, 保证它只在主线程析构)
+	shared_ptr<array<string, 2>> sources = make_shared<array<string, 2>>();
+	vector<shared_future<void>> decoding;
+	decoding.push_back(ThreadPool::Instance().Submit([sources, vs = string(vs_filepath), fs = string(fs_filepath)]() {
+		(*sources)[0] = IO::ReadFile(vs.c_str());
+		(*sources)[1] = IO::ReadFile(fs.c_str());
+	}).share());
+	// 主线程编译链接
+	shared_ptr<ResourceLoader::Job> job = ResourceLoader::Instance().Enqueue(move(decoding), [result, sources]() {
+		GLuint pid = glCreateProgram();
+		if (!pid)
+		{
+			dLog("[Error] Unable to create shader program!");
+			return true;
+		}
+		result->m_impl->m_program_id = pid;
+		result->AddOptionalShaderFromSource((*sources)[0].c_str(), VERTEX_SHADER, false);
+		result->AddOptionalShaderFromSource((*sources)[1].c_str(), FRAGMENT_SHADER, false);
+		glLinkProgram(pid);
+		dCall(result->CheckLinkInfo());
+		s_all_shaders.push_back(result);
+		ResourceLoader::Instance().AddUploadedBytes((*sources)[0].size() + (*sources)[1].size());
+		return true;
+	});
+	return AsyncHandle<Shader>(result, job);
+}
+
 bool Shader::AddOptionalShader(const NNChar *filepath, const NNShaderType st, const bool& try_link)
 {
 	string source = IO::ReadFile(filepath);
@@ -172,6 +216,7 @@ bool Shader::AddOptionalShader(const NNChar *filepath, const NNShaderType st, co
 bool Shader::AddOptionalShaderFromSource(const NNChar *source, const NNShaderType st, const bool& try_link)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(AddOptionalShaderFromSource(source, st, try_link));
 	if (st >= NNShaderType::NNShaderTypeNum)
 	{
 		dLog("[Error]: Unknown Shader Type(%d)", st);
@@ -214,6 +259,7 @@ void Shader::Use()
 bool Shader::Recompile()
 {
 	//
+	NN_RENDER_THREAD_FORWARD(Recompile());
 	for (NNUInt st = 0; st < NNShaderType::NNShaderTypeNum; ++st)
 	{
 		if (m_filepaths[st].size() > 0)
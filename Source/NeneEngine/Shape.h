@@ -3,6 +3,7 @@
 #define SHAPE_H
 
 #include "Drawable.h"
+#include "VertexLayout.h"
 #include <vector>
 #include <memory>
 
@@ -22,13 +23,16 @@ public:
 	// 绘制函数
 	virtual void Draw(const std::shared_ptr<Shader> pShader = nullptr,
 		const std::shared_ptr<Camera> pCamera = nullptr) override;
-	virtual void DrawInstanced(const std::shared_ptr<Shader> pShader = nullptr,
+	virtual void DrawInstanced(const InstanceStream& instances, const std::shared_ptr<Shader> pShader = nullptr,
 		const std::shared_ptr<Camera> pCamera = nullptr) override;
+	virtual void Submit(RenderQueue& queue, const std::shared_ptr<Shader> pShader, const NNUInt pass = 0, const bool blended = false) override;
 	// 设置绘制模式
 	void SetDrawMode(NNDrawMode newMode);
 protected:
 	// 顶点数，索引数
 	NNUInt mVertexNum, mIndexNum;
+	// 索引字节数
+	NNUInt mIndexSize;
 	// 顶点格式
 	NNVertexFormat mVertexFormat;
 	// 绘制模式
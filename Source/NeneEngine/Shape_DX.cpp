@@ -100,7 +100,7 @@ void Shape::Draw(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCam
 	}
 	// 更新常量缓冲
 	NeneCB& CB = NeneCB::Instance();
-	CB.PerObject().data.model = mModelMat;
+	CB.PerObject().data.model = GetModelMat();
 	CB.PerObject().Update(PER_OBJECT_SLOT);
 	// 设置顶点缓冲
 	Utils::getContext()->IASetVertexBuffers(0, 1, &mpVertexBuffer, &mPerVertexSize, &mOffset);
@@ -116,8 +116,12 @@ void Shape::Draw(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCam
 	}
 }
 
-void Shape::DrawInstanced(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCamera) {
-	;
+void Shape::DrawInstanced(const InstanceStream& instances, const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCamera) {
+	dLog("[Error] Shape::DrawInstanced is unsupported on DX!\n");
+}
+
+void Shape::Submit(RenderQueue& queue, const shared_ptr<Shader> pShader, const NNUInt pass, const bool blended) {
+	dLog("[Error] Shape::Submit is unsupported on DX!\n");
 }
 
 void Shape::SetDrawMode(NNDrawMode newMode) {
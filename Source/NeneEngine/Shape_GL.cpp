@@ -3,6 +3,11 @@
 
 #include "Shape.h"
 #include "Debug.h"
+#include "Instance.h"
+#include "RenderQueue.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -14,19 +19,28 @@ Shape::Shape() : Drawable() {
 	//
 	mVertexNum = 0;
 	mIndexNum = 0;
+	mIndexSize = sizeof(NNUInt);
 	// 默认顶点格式
 	mVertexFormat = POSITION;
 	mDrawMode = NN_TRIANGLE;
 }
 
 Shape::~Shape() {
-	if (mEBO != 0) glDeleteBuffers(1, &mEBO);
-	if (mVBO != 0) glDeleteBuffers(1, &mVBO);
-	if (mVAO != 0) glDeleteVertexArrays(1, &mVAO);
+	if (mVAO != 0) {
+		RenderContext::instance().forgetVertexArray(mVAO);
+	}
+	// 在已经录制的绘制之后删除
+	const GLuint vao = mVAO, vbo = mVBO, ebo = mEBO;
+	RenderThread::Defer([vao, vbo, ebo]() {
+		if (ebo != 0) glDeleteBuffers(1, &ebo);
+		if (vbo != 0) glDeleteBuffers(1, &vbo);
+		if (vao != 0) glDeleteVertexArrays(1, &vao);
+	});
 }
 
 shared_ptr<Shape> Shape::Create(NNFloat* pVertices, NNUInt vArrayLen, NNVertexFormat vf) {
 	//
+	NN_RENDER_THREAD_FORWARD(Create(pVertices, vArrayLen, vf));
 	assert(vArrayLen > 0);
 	// 检查长度对齐
 	dLogIf(vArrayLen % vf != 0, "[Error]: Vertices Array's length(%d) is not aligned in decleared format(%d).\n",
@@ -35,50 +49,26 @@ shared_ptr<Shape> Shape::Create(NNFloat* pVertices, NNUInt vArrayLen, NNVertexFo
 	Shape* res = new Shape();
 	res->mVertexNum = vArrayLen / vf;
 	res->mVertexFormat = vf;
+	// 所有顶点格式都以位置开头
+	res->mLocalBounds = BoundingBox::FromPoints(pVertices, res->mVertexNum, vf * sizeof(NNFloat));
 	// 创建顶点数组
 	glGenVertexArrays(1, &(res->mVAO));
 	// 申请显存
 	glGenBuffers(1, &(res->mVBO));
-	glBindVertexArray(res->mVAO);
+	RenderContext::instance().bindVertexArray(res->mVAO);
 	glBindBuffer(GL_ARRAY_BUFFER, res->mVBO);
 		// 写入顶点数据
 		glBufferData(GL_ARRAY_BUFFER, vArrayLen * sizeof(GLfloat), pVertices, GL_STATIC_DRAW);
+		RenderStats::Add(NN_COUNTER_BUFFER_BYTES, vArrayLen * sizeof(GLfloat));
 		// 根据顶点格式写入 Layout
-		switch (vf) {
-			case POSITION: {
-				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
-				glEnableVertexAttribArray(0);
-				break;
-			}
-			case POSITION_TEXTURE: {
-				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
-				glEnableVertexAttribArray(0);
-				glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-				glEnableVertexAttribArray(1);
-				break;
-			}
-			case POSITION_NORMAL: {
-				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)0);
-				glEnableVertexAttribArray(0);
-				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-				glEnableVertexAttribArray(1);
-				break;
-			}
-			case POSITION_NORMAL_TEXTURE: {
-				glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
-				glEnableVertexAttribArray(0);
-				glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-				glEnableVertexAttribArray(1);
-				glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-				glEnableVertexAttribArray(2);
-				break;
-			}
-			default: {
-				dLog("[Info]: Unknown Vertex Format(%d)\n", vf);
-			}
+		const VertexLayoutDesc* layout = VertexLayoutDesc::FromFormat(vf);
+		if (layout != nullptr) {
+			layout->Apply();
+		} else {
+			dLog("[Info]: Unknown Vertex Format(%d)\n", vf);
 		}
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	RenderContext::instance().bindVertexArray(0);
 	//
 	return shared_ptr<Shape>(res);
 }
@@ -89,17 +79,23 @@ shared_ptr<Shape> Shape::Create(std::vector<NNFloat> vertices, NNVertexFormat vf
 
 shared_ptr<Shape> Shape::Create(NNFloat* pVertices, NNUInt vArrayLen, NNUInt* pIndices, NNUInt iArrayLen, NNVertexFormat vf) {
 	//
+	NN_RENDER_THREAD_FORWARD(Create(pVertices, vArrayLen, pIndices, iArrayLen, vf));
 	assert(iArrayLen > 0);
 	//
 	shared_ptr<Shape> res = Create(pVertices, vArrayLen, vf);
 	res->mIndexNum = iArrayLen;
+	// 顶点数小于 65536 时使用 16 位索引
+	res->mIndexSize = IndexPacking::GetIndexSize(res->mVertexNum);
+	vector<NNByte> indices((size_t)iArrayLen * res->mIndexSize);
+	IndexPacking::Pack(pIndices, iArrayLen, res->mIndexSize, indices.data());
 	// 申请下标显存
 	glGenBuffers(1, &(res->mEBO));
 	// 绑定到顶点数组中
-	glBindVertexArray(res->mVAO);
+	RenderContext::instance().bindVertexArray(res->mVAO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, res->mEBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, iArrayLen * sizeof(GLuint), pIndices, GL_STATIC_DRAW);
-	glBindVertexArray(0);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size(), indices.data(), GL_STATIC_DRAW);
+		RenderStats::Add(NN_COUNTER_BUFFER_BYTES, indices.size());
+	RenderContext::instance().bindVertexArray(0);
 	//
 	return res;
 }
@@ -117,20 +113,43 @@ void Shape::Draw(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCam
 	}
 	//
 	NeneCB& CB = NeneCB::Instance();
-	CB.PerObject().Data().model = mModelMat;
-	CB.PerObject().Update(PER_OBJECT_SLOT);
+	CB.PerObject().Data().model = GetModelMat();
+	CB.UpdatePerObject();
 	//
-	glBindVertexArray(mVAO);
+	// 绘制后不再解绑, 下一次绑定同一个 VAO 时由状态缓存跳过
+	RenderContext::instance().bindVertexArray(mVAO);
 	if (mEBO != 0) {
-		glDrawElements(mDrawMode, mIndexNum, GL_UNSIGNED_INT, 0);
+		RenderContext::instance().drawElements(mDrawMode, mIndexNum, mIndexSize == sizeof(GLuint) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, 0);
 	} else {
-		glDrawArrays(mDrawMode, 0, mVertexNum);
+		RenderContext::instance().drawArrays(mDrawMode, 0, mVertexNum);
 	}
-	glBindVertexArray(0);
 }
 
-void Shape::DrawInstanced(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCamera) {
+void Shape::DrawInstanced(const InstanceStream& instances, const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCamera) {
+	if (pShader != nullptr) {
+		pShader->Use();
+	}
+	if (pCamera != nullptr) {
+		pCamera->Use();
+	}
+	//
+	NeneCB& CB = NeneCB::Instance();
+	CB.PerObject().Data().model = GetModelMat();
+	CB.UpdatePerObject();
+	//
+	RenderContext::instance().bindVertexArray(mVAO);
+	instances.Bind();
+	if (mEBO != 0) {
+		RenderContext::instance().drawElements(mDrawMode, mIndexNum, mIndexSize == sizeof(GLuint) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, 0, 0, instances.GetInstanceNum());
+	} else {
+		RenderContext::instance().drawArrays(mDrawMode, 0, mVertexNum, instances.GetInstanceNum());
+	}
+	instances.Unbind();
+}
 
+void Shape::Submit(RenderQueue& queue, const shared_ptr<Shader> pShader, const NNUInt pass, const bool blended) {
+	GLenum indexType = mEBO != 0 ? (mIndexSize == sizeof(GLuint) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT) : 0;
+	queue.Push(pass, pShader.get(), nullptr, { mVAO, (NNUInt)mDrawMode, mVertexNum, mIndexNum, indexType, 0, 0 }, GetModelMat(), blended);
 }
 
 void Shape::SetDrawMode(NNDrawMode newMode) {
@@ -1,8 +1,12 @@
 ﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 
+#include <sstream>
+#include <unordered_set>
 #include "IO.h"
 #include "Debug.h"
 #include "StaticMesh.h"
+#include "ThreadPool.h"
+#include "MeshOptimizer.h"
 
 using namespace std;
 
@@ -13,10 +17,97 @@ string GetDirectoryPath(const NNChar* filepath)
 	return result.substr(0, pos + 1);
 }
 
-shared_ptr<StaticMesh> StaticMesh::Create(const NNChar* filepath, const NNFloat scale)
+// 会影响导入结果的选项, 需要写进缓存
+static const NNUInt CACHE_FLAGS_MASK = NN_IMPORT_NATIVE_OBJ | NN_IMPORT_OPTIMIZE_VERTEX_CACHE | NN_IMPORT_OPTIMIZE_OVERDRAW;
+
+static const VertexLayoutDesc* GetVertexLayout(const NNUInt flags)
+{
+	return (flags & NN_IMPORT_COMPACT_VERTICES) ? &CompactVertexLayout::Desc() : &StandardVertexLayout::Desc();
+}
+
+// 导入后的重排, 在写入缓存之前完成, 可以在工作线程调用
+static void OptimizeMesh(MeshCache::CookedMesh& mesh, const NNUInt flags)
+{
+	if (!(flags & (NN_IMPORT_OPTIMIZE_VERTEX_CACHE | NN_IMPORT_OPTIMIZE_OVERDRAW)) || mesh.indices.empty())
+	{
+		return;
+	}
+	const NNUInt vertex_num = (NNUInt)mesh.vertices.size();
+	const NNUInt index_num = (NNUInt)mesh.indices.size();
+	MeshOptimizer::CacheStats before = MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), index_num, vertex_num);
+	if (flags & NN_IMPORT_OPTIMIZE_OVERDRAW)
+	{
+		MeshOptimizer::OptimizeOverdraw(mesh.indices.data(), index_num, (const NNByte*)mesh.vertices.data(), vertex_num, sizeof(Vertex));
+	}
+	else
+	{
+		MeshOptimizer::OptimizeVertexCache(mesh.indices.data(), index_num, vertex_num);
+	}
+	mesh.vertices.resize(MeshOptimizer::OptimizeVertexFetch((NNByte*)mesh.vertices.data(), vertex_num, sizeof(Vertex), mesh.indices.data(), index_num));
+	MeshOptimizer::CacheStats after = MeshOptimizer::AnalyzeVertexCache(mesh.indices.data(), index_num, (NNUInt)mesh.vertices.size());
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            ACMR        : %.3f -> %.3f", before.acmr, after.acmr);
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            ATVR        : %.3f -> %.3f", before.atvr, after.atvr);
+}
+
+static bool IsOBJFile(const NNChar* filepath)
+{
+	string path(filepath);
+	if (path.size() < 4)
+	{
+		return false;
+	}
+	string extension = path.substr(path.size() - 4);
+	for (char& c : extension) c = (char)tolower(c);
+	return extension == ".obj";
+}
+
+shared_ptr<StaticMesh> StaticMesh::Create(const NNChar* filepath, const NNFloat scale, const NNUInt flags)
 {
 	//
 	checkFileExist(filepath);
+	// 优先读取烘焙缓存
+	if (!(flags & NN_IMPORT_IGNORE_CACHE))
+	{
+		shared_ptr<MeshCache> cache = MeshCache::Open(filepath, scale, flags & CACHE_FLAGS_MASK);
+		if (cache != nullptr)
+		{
+			StaticMesh* result = new StaticMesh();
+			result->m_filepath = filepath;
+			result->m_dirpath = GetDirectoryPath(filepath);
+			result->m_vertex_layout = GetVertexLayout(flags);
+			result->m_import_flags = flags;
+			//
+			dLog("[Info] ===== Loading model from cache: %zd meshes ===== ", cache->GetSubMeshes().size());
+			result->ProcessCache(*cache, (flags & NN_IMPORT_PARALLEL) != 0);
+			result->SetPageInSources(scale, flags);
+			dLog("[Info] ===== Model loading finished. ===== \n");
+			//
+			return shared_ptr<StaticMesh>(result);
+		}
+	}
+	// 内置 OBJ 解析
+	if ((flags & NN_IMPORT_NATIVE_OBJ) && IsOBJFile(filepath))
+	{
+		StaticMesh* result = new StaticMesh();
+		result->m_filepath = filepath;
+		result->m_dirpath = GetDirectoryPath(filepath);
+		result->m_vertex_layout = GetVertexLayout(flags);
+		result->m_import_flags = flags;
+		result->m_cooking = true;
+		//
+		dLog("[Info] ===== Loading obj model with native parser ===== ");
+		if (result->ProcessOBJ(filepath, scale, (flags & NN_IMPORT_PARALLEL) != 0))
+		{
+			MeshCache::Write(filepath, scale, flags & CACHE_FLAGS_MASK, result->m_cooked_meshes, result->m_nodes);
+			result->m_cooking = false;
+			result->m_cooked_meshes.clear();
+			result->SetPageInSources(scale, flags);
+			dLog("[Info] ===== Model loading finished. ===== \n");
+			return shared_ptr<StaticMesh>(result);
+		}
+		// 解析失败时回退到 Assimp
+		delete result;
+	}
 	// 载入器
 	Assimp::Importer importer;
 	// 读取文件
@@ -30,62 +121,444 @@ shared_ptr<StaticMesh> StaticMesh::Create(const NNChar* filepath, const NNFloat
 	StaticMesh* result = new StaticMesh();
 	result->m_filepath = filepath;
 	result->m_dirpath = GetDirectoryPath(filepath);
+	result->m_vertex_layout = GetVertexLayout(flags);
+	result->m_import_flags = flags;
 	// 
 	dLog("[Info] ===== Loading model begined:  ===== ");
 	dLog("    Total %d meshes: ", scene->mNumMeshes);
 	// 从根节点开始遍历加载模型
-	result->ProcessNode(scene->mRootNode, scene, scale);
+	result->m_cooking = true;
+	if (flags & NN_IMPORT_PARALLEL)
+	{
+		result->ProcessSceneParallel(scene, scale);
+	}
+	else
+	{
+		result->ProcessNode(scene->mRootNode, scene, scale);
+	}
+	// 写入烘焙缓存
+	MeshCache::Write(filepath, scale, flags & CACHE_FLAGS_MASK, result->m_cooked_meshes, result->m_nodes);
+	result->m_cooking = false;
+	result->m_cooked_meshes.clear();
+	result->SetPageInSources(scale, flags);
 	//
 	dLog("[Info] ===== Model loading finished. ===== \n");
 	//
 	return shared_ptr<StaticMesh>(result);
 }
 
+AsyncHandle<StaticMesh> StaticMesh::LoadAsync(const NNChar* filepath, const NNFloat scale, const NNUInt flags)
+{
+	// 先返回空模型
+	shared_ptr<StaticMesh> result(new StaticMesh());
+	result->m_filepath = filepath;
+	result->m_dirpath = GetDirectoryPath(filepath);
+	result->m_vertex_layout = GetVertexLayout(flags);
+	result->m_import_flags = flags;
+	// 工作线程导入, 使用单独的对象, 保证模型只在主线程析构.
+	// 在工作线程中等待线程池会死锁, 所以这里不使用 NN_IMPORT_PARALLEL
+	shared_ptr<StaticMesh> importer(new StaticMesh());
+	importer->m_filepath = result->m_filepath;
+	importer->m_dirpath = result->m_dirpath;
+	importer->m_import_flags = flags;
+	shared_ptr<vector<MeshCache::CookedMesh>> meshes = make_shared<vector<MeshCache::CookedMesh>>();
+	shared_ptr<vector<MeshCache::Node>> nodes = make_shared<vector<MeshCache::Node>>();
+	vector<shared_future<void>> decoding;
+	decoding.push_back(ThreadPool::Instance().Submit([importer, meshes, nodes, scale, flags]() {
+		importer->Import(importer->m_filepath.c_str(), scale, flags & ~NN_IMPORT_PARALLEL, *meshes, *nodes);
+	}).share());
+	// 主线程每步创建一个网格, 纹理另外异步载入
+	shared_ptr<ResourceLoader::Job> job = ResourceLoader::Instance().Enqueue(move(decoding), [result, meshes, nodes, scale, flags, next = size_t(0)]() mutable {
+		if (next == 0)
+		{
+			result->m_nodes = move(*nodes);
+			for (const MeshCache::CookedMesh& mesh : *meshes)
+			{
+				for (const auto& texture : mesh.textures)
+				{
+					const string& texFilePath = get<0>(texture);
+					if (result->m_textures.find(texFilePath) == result->m_textures.end())
+					{
+						result->m_textures.insert(make_pair(texFilePath, Texture2D::LoadAsync(texFilePath.c_str()).Get()));
+					}
+				}
+			}
+		}
+		if (next < meshes->size())
+		{
+			MeshCache::CookedMesh& mesh = (*meshes)[next++];
+			ResourceLoader::Instance().AddUploadedBytes(mesh.vertices.size() * result->m_vertex_layout->stride + mesh.indices.size() * IndexPacking::GetIndexSize((NNUInt)mesh.vertices.size()));
+			result->AddMesh(mesh);
+			mesh = MeshCache::CookedMesh();
+		}
+		if (next < meshes->size())
+		{
+			return false;
+		}
+		result->SetPageInSources(scale, flags);
+		return true;
+	});
+	return AsyncHandle<StaticMesh>(result, job);
+}
+
 void StaticMesh::Draw(const shared_ptr<Shader> shader, const shared_ptr<Camera> camera)
 {
 	// 
 	if (shader) shader->Use();
 	if (camera) camera->Use();
-	// 更新矩阵
-	NeneCB::Instance().PerObject().Data().model = mModelMat;
-	NeneCB::Instance().PerObject().Update(PER_OBJECT_SLOT);
-	// 绘制所有网格
+	// 绘制所有网格, 所在节点变化时更新矩阵
+	TransformSystem::Handle current = TransformSystem::INVALID_HANDLE;
 	for (NNUInt i = 0; i < m_meshes.size(); ++i)
 	{
+		if (m_mesh_transforms[i] != current)
+		{
+			current = m_mesh_transforms[i];
+			NeneCB::Instance().PerObject().Data().model = TransformSystem::Instance().GetWorldMatrix(current);
+			NeneCB::Instance().UpdatePerObject();
+		}
 		m_meshes[i]->Draw();
 	}
 }
 
-void StaticMesh::DrawInstanced(const shared_ptr<Shader> pShader, const shared_ptr<Camera> pCamera)
+void StaticMesh::DrawInstanced(const InstanceStream& instances, const shared_ptr<Shader> shader, const shared_ptr<Camera> camera)
+{
+	// 
+	if (shader) shader->Use();
+	if (camera) camera->Use();
+	// 每个网格一次实例化绘制, 实例的矩阵乘在网格节点的矩阵之后
+	TransformSystem::Handle current = TransformSystem::INVALID_HANDLE;
+	for (NNUInt i = 0; i < m_meshes.size(); ++i)
+	{
+		if (m_mesh_transforms[i] != current)
+		{
+			current = m_mesh_transforms[i];
+			NeneCB::Instance().PerObject().Data().model = TransformSystem::Instance().GetWorldMatrix(current);
+			NeneCB::Instance().UpdatePerObject();
+		}
+		m_meshes[i]->DrawInstanced(instances);
+	}
+}
+
+void StaticMesh::Submit(RenderQueue& queue, const shared_ptr<Shader> shader, const NNUInt pass, const bool blended)
 {
+	// 每个网格一条记录, 使用所在节点的矩阵
+	TransformSystem& transforms = TransformSystem::Instance();
+	for (NNUInt i = 0; i < m_meshes.size(); ++i)
+	{
+		const NNMat4& model = transforms.GetWorldMatrix(m_mesh_transforms[i]);
+		if (m_meshes[i]->GetMaterial() != nullptr)
+		{
+			queue.Push(pass, m_meshes[i]->GetMaterial().get(), shader.get(), m_meshes[i]->GetGeometry(), model, blended);
+		}
+		else
+		{
+			queue.Push(pass, shader.get(), &m_meshes[i]->GetTextures(), m_meshes[i]->GetGeometry(), model, blended);
+		}
+	}
+}
 
+void StaticMesh::Submit(IndirectBatch& batch, const NNVec4& params)
+{
+	for (NNUInt i = 0; i < m_meshes.size(); ++i)
+	{
+		batch.Add(m_meshes[i], TransformSystem::Instance().GetWorldMatrix(m_mesh_transforms[i]), params);
+	}
 }
 
-void StaticMesh::ProcessNode(aiNode* pNode, const aiScene* pScene, const NNFloat scale)
+void StaticMesh::ProcessNode(aiNode* pNode, const aiScene* pScene, const NNFloat scale, const NNInt parent)
 {
 	// 
-	dLog("    |-- Load %d meshes from a node. (%s)", pNode->mNumMeshes, pNode->mName.C_Str());
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "    |-- Load %d meshes from a node. (%s)", pNode->mNumMeshes, pNode->mName.C_Str());
+	// 保留节点的变换
+	const NNInt node = (NNInt)m_nodes.size();
+	m_nodes.push_back(ConvertNode(pNode, scale, parent));
 	// 处理当前节点网格
 	for (NNUInt i = 0; i < pNode->mNumMeshes; ++i)
 	{
 		aiMesh* pMesh = pScene->mMeshes[pNode->mMeshes[i]];
-		ProcessMesh(pMesh, pScene, scale);
+		ProcessMesh(pMesh, pScene, scale, node);
 	}
 	// 递归处理子节点
 	for (NNUInt i = 0; i < pNode->mNumChildren; ++i)
 	{
-		this->ProcessNode(pNode->mChildren[i], pScene, scale);
+		this->ProcessNode(pNode->mChildren[i], pScene, scale, node);
 	}
 }
 
-void StaticMesh::ProcessMesh(aiMesh* pMesh, const aiScene* pScene, const NNFloat scale) {
+void StaticMesh::ProcessMesh(aiMesh* pMesh, const aiScene* pScene, const NNFloat scale, const NNInt node) {
+	//
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "        |-- Load %d vertices from a mesh.", pMesh->mNumVertices);
 	// 构造Mesh需要的数据
-	vector<Vertex> vertices;
-	vector<NNUInt> indices;
-	vector<tuple<shared_ptr<Texture2D>, NNTextureType>> textures;
+	MeshCache::CookedMesh mesh;
+	ConvertMesh(pMesh, scale, mesh);
+	CollectTextures(pMesh, pScene, mesh.textures);
+	OptimizeMesh(mesh, m_import_flags);
+	mesh.node = node;
+	// 把生成的网格对象压入成员变量
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            HasNormal   : %s.", pMesh->mNormals ? "Yes" : "No");
+	AddMesh(mesh);
+}
+
+void StaticMesh::ProcessSceneParallel(const aiScene* pScene, const NNFloat scale)
+{
+	// 按节点遍历顺序收集网格, 保证和串行导入结果一致
+	vector<aiMesh*> meshes;
+	vector<NNInt> mesh_nodes;
+	CollectMeshes(pScene->mRootNode, pScene, scale, -1, meshes, mesh_nodes, m_nodes);
+	// 读取材质 (很快, 直接在主线程做)
+	vector<vector<tuple<string, NNTextureType>>> mesh_textures(meshes.size());
+	vector<string> texFilePaths;
+	for (NNUInt i = 0; i < meshes.size(); ++i)
+	{
+		CollectTextures(meshes[i], pScene, mesh_textures[i]);
+		for (const auto& texture : mesh_textures[i])
+		{
+			texFilePaths.push_back(get<0>(texture));
+		}
+	}
+	// 分发网格转换
+	ThreadPool& pool = ThreadPool::Instance();
+	vector<future<MeshCache::CookedMesh>> converted;
+	for (aiMesh* pMesh : meshes)
+	{
+		converted.push_back(pool.Submit([pMesh, scale, flags = m_import_flags]() {
+			MeshCache::CookedMesh mesh;
+			ConvertMesh(pMesh, scale, mesh);
+			OptimizeMesh(mesh, flags);
+			return mesh;
+		}));
+	}
+	// 纹理解码同样在工作线程, 这里等待并上传
+	LoadTextures(texFilePaths, true);
+	// 按顺序创建网格
+	for (NNUInt i = 0; i < meshes.size(); ++i)
+	{
+		MeshCache::CookedMesh mesh = converted[i].get();
+		mesh.textures = move(mesh_textures[i]);
+		mesh.node = mesh_nodes[i];
+		AddMesh(mesh);
+	}
+}
+
+bool StaticMesh::ProcessOBJ(const NNChar* filepath, const NNFloat scale, const bool parallel)
+{
+	//
+	vector<MeshCache::CookedMesh> meshes;
+	if (!ReadOBJMeshes(filepath, scale, parallel, meshes, m_nodes))
+	{
+		return false;
+	}
+	// 纹理
+	vector<string> texFilePaths;
+	for (const MeshCache::CookedMesh& mesh : meshes)
+	{
+		for (const auto& texture : mesh.textures)
+		{
+			texFilePaths.push_back(get<0>(texture));
+		}
+	}
+	LoadTextures(texFilePaths, parallel);
+	// 每组一个网格
+	dLog("    Total %zd meshes: ", meshes.size());
+	for (MeshCache::CookedMesh& mesh : meshes)
+	{
+		AddMesh(mesh);
+	}
+	return true;
+}
+
+bool StaticMesh::ReadOBJMeshes(const NNChar* filepath, const NNFloat scale, const bool parallel, vector<MeshCache::CookedMesh>& meshes, vector<MeshCache::Node>& nodes)
+{
+	//
+	OBJData data;
+	if (!IO::ReadOBJ(filepath, data, parallel))
+	{
+		return false;
+	}
+	// 材质
+	unordered_map<string, vector<tuple<string, NNTextureType>>> materials;
+	if (!data.mtllib.empty())
+	{
+		ProcessOBJMaterials(m_dirpath + data.mtllib, materials);
+	}
+	// 每组一个网格, 和 Assimp 导入一样记录节点, 写入缓存后层级不变
+	nodes.assign(1, MeshCache::Node{ -1, NNMat4Identity });
+	for (const OBJGroup& group : data.groups)
+	{
+		MeshCache::CookedMesh mesh;
+		mesh.node = (NNInt)nodes.size();
+		nodes.push_back(MeshCache::Node{ 0, NNMat4Identity });
+		mesh.vertices.resize(group.vertex_num);
+		for (NNUInt i = 0; i < group.vertex_num; ++i)
+		{
+			const NNUInt src = group.vertex_offset + i;
+			mesh.vertices[i] = Vertex{ data.positions[src] * scale, data.normals[src], data.texcoords[src] };
+		}
+		mesh.indices.assign(data.indices.begin() + group.index_offset, data.indices.begin() + group.index_offset + group.index_num);
+		mesh.textures = materials[group.material];
+		//
+		nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "    |-- Read mesh from group. (%s)", group.name.c_str());
+		OptimizeMesh(mesh, m_import_flags);
+		meshes.push_back(move(mesh));
+	}
+	return true;
+}
+
+bool StaticMesh::Import(const NNChar* filepath, const NNFloat scale, const NNUInt flags, vector<MeshCache::CookedMesh>& meshes, vector<MeshCache::Node>& nodes)
+{
+	//
+	const bool parallel = (flags & NN_IMPORT_PARALLEL) != 0;
+	// 缓存
+	if (!(flags & NN_IMPORT_IGNORE_CACHE))
+	{
+		shared_ptr<MeshCache> cache = MeshCache::Open(filepath, scale, flags & CACHE_FLAGS_MASK);
+		if (cache != nullptr)
+		{
+			for (const MeshCache::SubMesh& submesh : cache->GetSubMeshes())
+			{
+				MeshCache::CookedMesh mesh;
+				mesh.vertices.assign(submesh.vertices, submesh.vertices + submesh.vertex_num);
+				mesh.indices.assign(submesh.indices, submesh.indices + submesh.index_num);
+				mesh.textures = submesh.textures;
+				mesh.node = submesh.node;
+				meshes.push_back(move(mesh));
+			}
+			nodes = cache->GetNodes();
+			return true;
+		}
+	}
+	// 内置 OBJ 解析
+	if ((flags & NN_IMPORT_NATIVE_OBJ) && IsOBJFile(filepath) && ReadOBJMeshes(filepath, scale, parallel, meshes, nodes))
+	{
+		MeshCache::Write(filepath, scale, flags & CACHE_FLAGS_MASK, meshes, nodes);
+		return true;
+	}
+	meshes.clear();
+	// Assimp
+	Assimp::Importer importer;
+	const aiScene* scene = importer.ReadFile(filepath, aiProcess_GenUVCoords | aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FixInfacingNormals);
+	if (scene == nullptr || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || scene->mRootNode == nullptr) {
+		printf("[Error] Model Loading Error: %s\n", importer.GetErrorString());
+		return false;
+	}
+	vector<aiMesh*> aimeshes;
+	vector<NNInt> mesh_nodes;
+	nodes.clear();
+	CollectMeshes(scene->mRootNode, scene, scale, -1, aimeshes, mesh_nodes, nodes);
+	meshes.resize(aimeshes.size());
+	for (NNUInt i = 0; i < aimeshes.size(); ++i)
+	{
+		ConvertMesh(aimeshes[i], scale, meshes[i]);
+		CollectTextures(aimeshes[i], scene, meshes[i].textures);
+		OptimizeMesh(meshes[i], flags);
+		meshes[i].node = mesh_nodes[i];
+	}
+	MeshCache::Write(filepath, scale, flags & CACHE_FLAGS_MASK, meshes, nodes);
+	return true;
+}
+
+void StaticMesh::ProcessOBJMaterials(const string& mtlFilePath, unordered_map<string, vector<tuple<string, NNTextureType>>>& materials)
+{
+	if (!IO::FileExist(mtlFilePath.c_str()))
+	{
+		dLog("[Error] Material file not found. (%s)", mtlFilePath.c_str());
+		return;
+	}
+	// 和 Assimp 导入时的顺序保持一致: 漫反射, 高光, 法线
+	unordered_map<string, vector<tuple<string, NNTextureType>>> maps[3];
+	istringstream stream(IO::ReadFile(mtlFilePath.c_str()));
+	string line, material;
+	while (getline(stream, line))
+	{
+		istringstream tokens(line);
+		string keyword, token, filename;
+		tokens >> keyword;
+		if (keyword == "newmtl")
+		{
+			tokens >> material;
+			materials[material];
+			continue;
+		}
+		// 贴图选项忽略, 取最后一个参数作为文件名
+		while (tokens >> token)
+		{
+			filename = token;
+		}
+		if (filename.empty())
+		{
+			continue;
+		}
+		if (keyword == "map_Kd")
+		{
+			maps[0][material].emplace_back(m_dirpath + filename, DIFFUSE);
+		}
+		else if (keyword == "map_Ks")
+		{
+			maps[1][material].emplace_back(m_dirpath + filename, SPECULAR);
+		}
+		else if (keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump")
+		{
+			maps[2][material].emplace_back(m_dirpath + filename, NORMAL);
+		}
+	}
+	for (auto& keyvalue : materials)
+	{
+		for (auto& map : maps)
+		{
+			const auto& textures = map[keyvalue.first];
+			keyvalue.second.insert(keyvalue.second.end(), textures.begin(), textures.end());
+		}
+	}
+}
+
+void StaticMesh::CollectMeshes(aiNode* pNode, const aiScene* pScene, const NNFloat scale, const NNInt parent, vector<aiMesh*>& meshes, vector<NNInt>& mesh_nodes, vector<MeshCache::Node>& nodes)
+{
 	//
-	dLog("        |-- Load %d vertices from a mesh.", pMesh->mNumVertices);
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "    |-- Load %d meshes from a node. (%s)", pNode->mNumMeshes, pNode->mName.C_Str());
+	const NNInt node = (NNInt)nodes.size();
+	nodes.push_back(ConvertNode(pNode, scale, parent));
+	for (NNUInt i = 0; i < pNode->mNumMeshes; ++i)
+	{
+		meshes.push_back(pScene->mMeshes[pNode->mMeshes[i]]);
+		mesh_nodes.push_back(node);
+	}
+	for (NNUInt i = 0; i < pNode->mNumChildren; ++i)
+	{
+		CollectMeshes(pNode->mChildren[i], pScene, scale, node, meshes, mesh_nodes, nodes);
+	}
+}
+
+MeshCache::Node StaticMesh::ConvertNode(const aiNode* pNode, const NNFloat scale, const NNInt parent)
+{
+	// Assimp 为行主序; 顶点已经乘过 scale, 平移也要乘上
+	MeshCache::Node result;
+	result.parent = parent;
+	const aiMatrix4x4& m = pNode->mTransformation;
+	result.local = NNMat4(
+		m.a1, m.b1, m.c1, m.d1,
+		m.a2, m.b2, m.c2, m.d2,
+		m.a3, m.b3, m.c3, m.d3,
+		m.a4 * scale, m.b4 * scale, m.c4 * scale, m.d4);
+	return result;
+}
+
+void StaticMesh::CollectTextures(aiMesh* pMesh, const aiScene* pScene, vector<tuple<string, NNTextureType>>& textures)
+{
+	// 处理纹理数据
+	if (pMesh->mMaterialIndex >= 0) {
+		aiMaterial* material = pScene->mMaterials[pMesh->mMaterialIndex];
+		ProcessTexture(material, aiTextureType_DIFFUSE, DIFFUSE, textures);
+		ProcessTexture(material, aiTextureType_SPECULAR, SPECULAR, textures);
+		ProcessTexture(material, aiTextureType_HEIGHT, NORMAL, textures);
+	}
+}
+
+void StaticMesh::ConvertMesh(const aiMesh* pMesh, const NNFloat scale, MeshCache::CookedMesh& result)
+{
+	vector<Vertex>& vertices = result.vertices;
+	vector<NNUInt>& indices = result.indices;
 	// 处理顶点数据
+	vertices.reserve(pMesh->mNumVertices);
 	for (NNUInt i = 0; i < pMesh->mNumVertices; ++i)
 	{
 		Vertex vertex;
@@ -115,32 +588,223 @@ void StaticMesh::ProcessMesh(aiMesh* pMesh, const aiScene* pScene, const NNFloat
 		vertices.push_back(vertex);
 	}
 	// 处理索引数据
+	indices.reserve(pMesh->mNumFaces * 3);
 	for (NNUInt i = 0; i < pMesh->mNumFaces; i++)
 	{
-		aiFace face = pMesh->mFaces[i];
+		const aiFace& face = pMesh->mFaces[i];
 		for (NNUInt j = 0; j < face.mNumIndices; j++)
 		{
 			indices.push_back(face.mIndices[j]);
 		}
 	}
-	// 处理纹理数据
-	if (pMesh->mMaterialIndex >= 0) {
-		aiMaterial* material = pScene->mMaterials[pMesh->mMaterialIndex];
-		ProcessTexture(material, aiTextureType_DIFFUSE, DIFFUSE, textures);
-		ProcessTexture(material, aiTextureType_SPECULAR, SPECULAR, textures);
-		ProcessTexture(material, aiTextureType_HEIGHT, NORMAL, textures);
+}
+
+void StaticMesh::AddMesh(MeshCache::CookedMesh& mesh)
+{
+	//
+	vector<tuple<shared_ptr<Texture2D>, NNTextureType>> textures;
+	for (const auto& texture : mesh.textures)
+	{
+		// 读取失败的纹理不绑定
+		shared_ptr<Texture2D> loaded = LoadTexture(get<0>(texture));
+		if (loaded != nullptr)
+		{
+			textures.emplace_back(loaded, get<1>(texture));
+		}
 	}
 	// Debug 输出
-	dLog("        |-- Process mesh with:");
-	dLog("            HasNormal   : %s.", pMesh->mNormals ? "Yes" : "No");
-	dLog("            IndicesNum  : %zd", indices.size());
-	dLog("            VerticesNum : %zd", vertices.size());
-	dLog("            TexturesNum : %zd", textures.size());
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "        |-- Process mesh with:");
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            IndicesNum  : %zd", mesh.indices.size());
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            VerticesNum : %zd", mesh.vertices.size());
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            TexturesNum : %zd", textures.size());
 	// 把生成的网格对象压入成员变量
-	m_meshes.push_back(Mesh::Create(move(vertices), move(indices), move(textures)));
+	m_meshes.push_back(Mesh::Create(mesh.vertices, mesh.indices, textures, *m_vertex_layout));
+	AssignMaterial(m_meshes.back());
+	m_mesh_transforms.push_back(GetNodeTransform(mesh.node));
+	MergeBounds(m_meshes.back(), mesh.node);
+	// 记录烘焙数据
+	if (m_cooking)
+	{
+		m_cooked_meshes.push_back(move(mesh));
+	}
+}
+
+void StaticMesh::ProcessCache(const MeshCache& cache, const bool parallel)
+{
+	// 先把所有纹理读进来
+	vector<string> texFilePaths;
+	for (const MeshCache::SubMesh& submesh : cache.GetSubMeshes())
+	{
+		for (const auto& texture : submesh.textures)
+		{
+			texFilePaths.push_back(get<0>(texture));
+		}
+	}
+	LoadTextures(texFilePaths, parallel);
+	m_nodes = cache.GetNodes();
+	//
+	for (const MeshCache::SubMesh& submesh : cache.GetSubMeshes())
+	{
+		//
+		vector<tuple<shared_ptr<Texture2D>, NNTextureType>> textures;
+		for (const auto& texture : submesh.textures)
+		{
+			shared_ptr<Texture2D> loaded = LoadTexture(get<0>(texture));
+			if (loaded != nullptr)
+			{
+				textures.emplace_back(loaded, get<1>(texture));
+			}
+		}
+		//
+		nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "    |-- Load %d vertices, %d indices, %zd textures from cache.", submesh.vertex_num, submesh.index_num, textures.size());
+		// 映射内存直接上传
+		m_meshes.push_back(Mesh::Create(submesh.vertices, submesh.vertex_num, submesh.indices, submesh.index_num, textures, *m_vertex_layout));
+		AssignMaterial(m_meshes.back());
+		m_mesh_transforms.push_back(GetNodeTransform(submesh.node));
+		MergeBounds(m_meshes.back(), submesh.node);
+	}
+}
+
+void StaticMesh::AssignMaterial(const shared_ptr<Mesh>& mesh)
+{
+	//
+	if (mesh == nullptr)
+	{
+		return;
+	}
+	// 纹理完全相同的网格共享一个材质
+	for (const shared_ptr<Material>& material : m_materials)
+	{
+		if (material->GetTextures() == mesh->GetTextures())
+		{
+			mesh->SetMaterial(material);
+			return;
+		}
+	}
+	shared_ptr<Material> material = Material::Create(nullptr, mesh->GetTextures());
+	if (material != nullptr)
+	{
+		m_materials.push_back(material);
+		mesh->SetMaterial(material);
+	}
+}
+
+void StaticMesh::MergeBounds(const shared_ptr<Mesh>& mesh, const NNInt node)
+{
+	if (mesh == nullptr)
+	{
+		return;
+	}
+	// 网格的包围盒变换到模型空间
+	BoundingBox bounds = mesh->GetBounds();
+	for (NNInt i = node; i >= 0 && i < (NNInt)m_nodes.size(); i = m_nodes[i].parent)
+	{
+		bounds = bounds.Transform(m_nodes[i].local);
+	}
+	mLocalBounds.Merge(bounds);
+	++mBoundsVersion;
+}
+
+TransformSystem::Handle StaticMesh::GetNodeTransform(const NNInt node)
+{
+	if (node < 0 || node >= (NNInt)m_nodes.size())
+	{
+		return mTransform;
+	}
+	// 按需创建, 父节点先创建
+	if (m_node_transforms.size() < m_nodes.size())
+	{
+		m_node_transforms.resize(m_nodes.size(), TransformSystem::INVALID_HANDLE);
+	}
+	if (m_node_transforms[node] == TransformSystem::INVALID_HANDLE)
+	{
+		const TransformSystem::Handle parent = GetNodeTransform(m_nodes[node].parent);
+		TransformSystem& transforms = TransformSystem::Instance();
+		m_node_transforms[node] = transforms.Create(parent);
+		transforms.SetLocalMatrix(m_node_transforms[node], m_nodes[node].local);
+	}
+	return m_node_transforms[node];
+}
+
+StaticMesh::~StaticMesh()
+{
+	// 子节点先销毁
+	for (size_t i = m_node_transforms.size(); i > 0; --i)
+	{
+		TransformSystem::Instance().Destroy(m_node_transforms[i - 1]);
+	}
+}
+
+NNUInt StaticMesh::PackMaterials()
+{
+	return Material::Pack(m_materials);
+}
+
+void StaticMesh::LoadTextures(const vector<string>& texFilePaths, const bool parallel)
+{
+	// 去重, 并跳过已经读取过的纹理
+	vector<string> pending;
+	unordered_set<string> visited;
+	for (const string& texFilePath : texFilePaths)
+	{
+		if (m_textures.find(texFilePath) == m_textures.end() && visited.insert(texFilePath).second)
+		{
+			pending.push_back(texFilePath);
+		}
+	}
+	if (!parallel)
+	{
+		for (const string& texFilePath : pending)
+		{
+			LoadTexture(texFilePath);
+		}
+		return;
+	}
+	// 解码分发到工作线程
+	vector<future<Texture::Image>> decoded;
+	for (const string& texFilePath : pending)
+	{
+		decoded.push_back(ThreadPool::Instance().Submit([texFilePath]() {
+			return Texture::LoadImage(texFilePath.c_str());
+		}));
+	}
+	// 主线程按提交顺序等待并上传
+	for (NNUInt i = 0; i < pending.size(); ++i)
+	{
+		Texture::Image image = decoded[i].get();
+		if (image.data == nullptr)
+		{
+			// 记为空, 之后的网格跳过这张纹理, 不再重复读取
+			dLog("[Error] Broken image data! Could not load texture(%s), skipped.\n", pending[i].c_str());
+			m_textures.insert(make_pair(pending[i], nullptr));
+			continue;
+		}
+		m_textures.insert(make_pair(pending[i], Texture2D::CreateFromImages({ image })));
+		nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            loaded new texture file: %s", pending[i].c_str());
+	}
+}
+
+shared_ptr<Texture2D> StaticMesh::LoadTexture(const string& texFilePath)
+{
+	// 检测之前是否读取过
+	auto it = m_textures.find(texFilePath);
+	if (it != m_textures.end())
+	{
+		return it->second;
+	}
+	// 之前没读取过, 生成新的纹理对象; 解码失败时尺寸为 0, 记为空并跳过
+	shared_ptr<Texture2D> new_texture = Texture2D::Create(texFilePath.c_str());
+	if (new_texture != nullptr && new_texture->GetWidth() == 0)
+	{
+		dLog("[Error] Could not load texture(%s), skipped.\n", texFilePath.c_str());
+		new_texture = nullptr;
+	}
+	m_textures.insert(make_pair(texFilePath, new_texture));
+	nnLog(NN_LOG_DEBUG, NN_LOG_RESOURCE, "            loaded new texture file: %s", texFilePath.c_str());
+	return new_texture;
 }
 
-void StaticMesh::ProcessTexture(aiMaterial* pMaterial, aiTextureType aiType, NNTextureType nnType, vector<tuple<shared_ptr<Texture2D>, NNTextureType>>& textures)
+void StaticMesh::ProcessTexture(aiMaterial* pMaterial, aiTextureType aiType, NNTextureType nnType, vector<tuple<string, NNTextureType>>& textures)
 {
 	// 一次性读取同类型的纹理
 	for (NNUInt i = 0; i < pMaterial->GetTextureCount(aiType); ++i)
@@ -148,23 +812,36 @@ void StaticMesh::ProcessTexture(aiMaterial* pMaterial, aiTextureType aiType, NNT
 		// 获取纹理的文件名
 		aiString texFileName;
 		pMaterial->GetTexture(aiType, i, &texFileName);
-		// 变成纹理的文件路径
-		string texFilePath = m_dirpath + texFileName.C_Str();
-		// 检测之前是否读取过
-		auto it = m_textures.find(texFilePath);
-		if (it == m_textures.end())
-		{
-			// 之前没读取过, 生成新的纹理对象
-			shared_ptr<Texture2D> new_texture = Texture2D::Create(texFilePath.c_str());
-			m_textures.insert(make_pair(texFilePath, new_texture));
-			textures.push_back(tuple<shared_ptr<Texture2D>, NNTextureType>(new_texture, nnType));
-			dLog("            loaded new texture file (type: %d): %s", nnType, texFilePath.c_str());
-		}
-		else
-		{
-			// 之前已经读取过，避免重复读取
-			textures.push_back(tuple<shared_ptr<Texture2D>, NNTextureType>(it->second, nnType));
-			dLog("            loaded cached texture file (type: %d): %s", nnType, texFilePath.c_str());
-		}
+		// 变成纹理的文件路径, 实际读取延迟到创建网格时 (去重在 LoadTexture 中)
+		textures.emplace_back(m_dirpath + texFileName.C_Str(), nnType);
+	}
+}
+
+void StaticMesh::SetResidency(const NNMeshResidency residency)
+{
+	for (shared_ptr<Mesh>& mesh : m_meshes)
+	{
+		mesh->SetResidency(residency);
+	}
+}
+
+void StaticMesh::SetPageInSources(const NNFloat scale, const NNUInt flags)
+{
+	// 每次换入时重新打开缓存, 不长期占用映射
+	for (NNUInt idx = 0; idx < m_meshes.size(); ++idx)
+	{
+		string filepath = m_filepath;
+		NNUInt cache_flags = flags & CACHE_FLAGS_MASK;
+		m_meshes[idx]->SetPageInSource([filepath, scale, cache_flags, idx](vector<Vertex>& vertices, vector<NNUInt>& indices) {
+			shared_ptr<MeshCache> cache = MeshCache::Open(filepath.c_str(), scale, cache_flags);
+			if (cache == nullptr || idx >= cache->GetSubMeshes().size())
+			{
+				return false;
+			}
+			const MeshCache::SubMesh& submesh = cache->GetSubMeshes()[idx];
+			vertices.assign(submesh.vertices, submesh.vertices + submesh.vertex_num);
+			indices.assign(submesh.indices, submesh.indices + submesh.index_num);
+			return true;
+		});
 	}
 }
@@ -9,6 +9,9 @@
 
 #include "Mesh.h"
 #include "Drawable.h"
+#include "MeshCache.h"
+#include "IndirectBatch.h"
+#include "ResourceLoader.h"
 
 //
 //    StaticMesh: 
@@ -18,29 +21,83 @@ class StaticMesh : public Drawable
 {
 public:
 	//
-	static std::shared_ptr<StaticMesh> Create(const NNChar* filepath, const NNFloat scale=1.0f);
+	static std::shared_ptr<StaticMesh> Create(const NNChar* filepath, const NNFloat scale=1.0f, const NNUInt flags=NN_IMPORT_DEFAULT);
+	// 工作线程导入, 主线程每帧在预算内创建网格; 纹理同样异步载入
+	static AsyncHandle<StaticMesh> LoadAsync(const NNChar* filepath, const NNFloat scale=1.0f, const NNUInt flags=NN_IMPORT_DEFAULT);
 	//
 	virtual void Draw(const std::shared_ptr<Shader> pShader = nullptr,
 		const std::shared_ptr<Camera> pCamera = nullptr);
-	virtual void DrawInstanced(const std::shared_ptr<Shader> pShader = nullptr,
+	virtual void DrawInstanced(const InstanceStream& instances, const std::shared_ptr<Shader> pShader = nullptr,
 		const std::shared_ptr<Camera> pCamera = nullptr);
+	virtual void Submit(RenderQueue& queue, const std::shared_ptr<Shader> pShader, const NNUInt pass = 0, const bool blended = false);
+	// 所有网格加入间接绘制批次, 使用物体当前的模型矩阵
+	void Submit(IndirectBatch& batch, const NNVec4& params = NNVec4(0.0f));
 
 	virtual std::vector<std::shared_ptr<Mesh>>& GetMeshes() { return m_meshes; };
 	virtual const std::vector<std::shared_ptr<Mesh>>& GetMeshes() const { return m_meshes; }
+	// 设置所有网格的驻留方式
+	void SetResidency(const NNMeshResidency residency);
+	// 导入时按纹理去重的材质
+	inline const std::vector<std::shared_ptr<Material>>& GetMaterials() const { return m_materials; }
+	// 把材质的纹理打包成纹理数组, 需要在纹理载入完成后调用; 返回不同纹理绑定的数量
+	NNUInt PackMaterials();
+	// 导入时保留的节点层级, 网格使用所在节点的世界矩阵
+	inline const std::vector<MeshCache::Node>& GetNodes() const { return m_nodes; }
+	// 节点的变换以物体的变换为根, 按需创建; 无效节点返回物体的变换
+	TransformSystem::Handle GetNodeTransform(const NNInt node);
+	virtual ~StaticMesh();
 protected:
 	//
-	virtual void ProcessNode(aiNode* pNode, const aiScene* pScene, const NNFloat scale);
-	virtual void ProcessMesh(aiMesh* pMesh, const aiScene* pScene, const NNFloat scale);
-	virtual void ProcessTexture(aiMaterial* pMaterial, aiTextureType aiType, NNTextureType nnType, std::vector<std::tuple<std::shared_ptr<Texture2D>, NNTextureType>>& textures);
+	virtual void ProcessNode(aiNode* pNode, const aiScene* pScene, const NNFloat scale, const NNInt parent = -1);
+	virtual void ProcessMesh(aiMesh* pMesh, const aiScene* pScene, const NNFloat scale, const NNInt node = -1);
+	virtual void ProcessTexture(aiMaterial* pMaterial, aiTextureType aiType, NNTextureType nnType, std::vector<std::tuple<std::string, NNTextureType>>& textures);
+	virtual void ProcessCache(const MeshCache& cache, const bool parallel);
+	// 并行导入: 网格转换和纹理解码分发到线程池, 主线程只创建图形资源
+	virtual void ProcessSceneParallel(const aiScene* pScene, const NNFloat scale);
+	// 内置 OBJ 解析器导入, 失败时返回 false
+	virtual bool ProcessOBJ(const NNChar* filepath, const NNFloat scale, const bool parallel);
+	// 每组一个节点, 挂在表示整个文件的根节点下
+	bool ReadOBJMeshes(const NNChar* filepath, const NNFloat scale, const bool parallel, std::vector<MeshCache::CookedMesh>& meshes, std::vector<MeshCache::Node>& nodes);
+	void ProcessOBJMaterials(const std::string& mtlFilePath, std::unordered_map<std::string, std::vector<std::tuple<std::string, NNTextureType>>>& materials);
+	//
+	void CollectMeshes(aiNode* pNode, const aiScene* pScene, const NNFloat scale, const NNInt parent, std::vector<aiMesh*>& meshes, std::vector<NNInt>& mesh_nodes, std::vector<MeshCache::Node>& nodes);
+	void CollectTextures(aiMesh* pMesh, const aiScene* pScene, std::vector<std::tuple<std::string, NNTextureType>>& textures);
+	// 导入到 CPU 端数据, 不访问图形接口
+	bool Import(const NNChar* filepath, const NNFloat scale, const NNUInt flags, std::vector<MeshCache::CookedMesh>& meshes, std::vector<MeshCache::Node>& nodes);
+	// 只做CPU端转换, 可以在工作线程调用
+	static void ConvertMesh(const aiMesh* pMesh, const NNFloat scale, MeshCache::CookedMesh& result);
+	static MeshCache::Node ConvertNode(const aiNode* pNode, const NNFloat scale, const NNInt parent);
+	// 创建网格的图形资源
+	void AddMesh(MeshCache::CookedMesh& mesh);
+	void AssignMaterial(const std::shared_ptr<Mesh>& mesh);
+	// 物体的包围盒为所有网格包围盒 (变换到模型空间) 的并
+	void MergeBounds(const std::shared_ptr<Mesh>& mesh, const NNInt node);
+	// 读取失败的纹理记为空, LoadTexture 返回空指针
+	void LoadTextures(const std::vector<std::string>& texFilePaths, const bool parallel);
+	std::shared_ptr<Texture2D> LoadTexture(const std::string& texFilePath);
+	// 网格从烘焙缓存换入 CPU 数据
+	void SetPageInSources(const NNFloat scale, const NNUInt flags);
 
 protected:
 	std::string m_dirpath;
 	std::string m_filepath;
 	std::vector<std::shared_ptr<Mesh>> m_meshes;
+	std::vector<std::shared_ptr<Material>> m_materials;
 	std::unordered_map<std::string, std::shared_ptr<Texture2D>> m_textures;
+	// 首次导入时收集的烘焙数据
+	bool m_cooking;
+	std::vector<MeshCache::CookedMesh> m_cooked_meshes;
+	// 节点层级, 节点变换, 以及每个网格使用的变换
+	std::vector<MeshCache::Node> m_nodes;
+	std::vector<TransformSystem::Handle> m_node_transforms;
+	std::vector<TransformSystem::Handle> m_mesh_transforms;
+	// 网格上传使用的顶点布局
+	const VertexLayoutDesc* m_vertex_layout;
+	// 导入选项
+	NNUInt m_import_flags;
 
 protected:
-	StaticMesh() = default;
+	StaticMesh() : m_cooking(false), m_vertex_layout(&StandardVertexLayout::Desc()), m_import_flags(NN_IMPORT_DEFAULT) {}
 	StaticMesh(const StaticMesh& rhs) = delete;
 	StaticMesh& operator=(const StaticMesh& rhs) = delete;
 };
@@ -0,0 +1,185 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include "Swizzle.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+	#define NN_TARGET_SSSE3
+	#define NN_TARGET_AVX2
+#else
+	#include <cpuid.h>
+	#define NN_TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define NN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include <immintrin.h>
+
+/** Implementation Functions >>> */
+
+enum InstructionSet
+{
+	SCALAR = 0,
+	SSSE3,
+	AVX2,
+};
+
+static InstructionSet DetectInstructionSet()
+{
+	int info[4] = { 0, 0, 0, 0 };
+	int extended[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+	__cpuid(info, 1);
+	__cpuidex(extended, 7, 0);
+	// AVX 状态需要操作系统保存 (OSXSAVE + XCR0)
+	bool os_avx = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+#else
+	__cpuid(1, info[0], info[1], info[2], info[3]);
+	__cpuid_count(7, 0, extended[0], extended[1], extended[2], extended[3]);
+	bool os_avx = __builtin_cpu_supports("avx2");
+#endif
+	if (os_avx && (extended[1] & (1 << 5)))
+	{
+		return AVX2;
+	}
+	if (info[2] & (1 << 9))
+	{
+		return SSSE3;
+	}
+	return SCALAR;
+}
+
+static InstructionSet GetInstructionSetLevel()
+{
+	static const InstructionSet level = DetectInstructionSet();
+	return level;
+}
+
+static void BGRToRGBAScalar(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	for (size_t i = 0; i < pixel_num; ++i)
+	{
+		dst[i * 4 + 0] = src[i * 3 + 2];
+		dst[i * 4 + 1] = src[i * 3 + 1];
+		dst[i * 4 + 2] = src[i * 3 + 0];
+		dst[i * 4 + 3] = 255;
+	}
+}
+
+static void SwapRBScalar(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	for (size_t i = 0; i < pixel_num; ++i)
+	{
+		NNByte r = src[i * 4 + 2];
+		NNByte b = src[i * 4 + 0];
+		dst[i * 4 + 0] = r;
+		dst[i * 4 + 1] = src[i * 4 + 1];
+		dst[i * 4 + 2] = b;
+		dst[i * 4 + 3] = src[i * 4 + 3];
+	}
+}
+
+// 每次读 16 字节只用前 12 字节 (4 个像素), 剩余不足 16 字节的部分交给标量版本
+NN_TARGET_SSSE3 static size_t BGRToRGBASSSE3(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	size_t i = 0;
+	for (; i + 6 <= pixel_num; i += 4)
+	{
+		__m128i bgr = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), alpha));
+	}
+	return i;
+}
+
+NN_TARGET_SSSE3 static size_t SwapRBSSSE3(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 4 <= pixel_num; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(src + i * 4));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+	}
+	return i;
+}
+
+// vpshufb 只在 128 位通道内重排, 两个通道分别读入相邻的 4 个像素
+NN_TARGET_AVX2 static size_t BGRToRGBAAVX2(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	const __m256i shuffle = _mm256_setr_epi8(
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+		2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+	size_t i = 0;
+	for (; i + 10 <= pixel_num; i += 8)
+	{
+		__m128i lo = _mm_loadu_si128((const __m128i*)(src + i * 3));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(src + i * 3 + 12));
+		__m256i bgr = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		_mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(bgr, shuffle), alpha));
+	}
+	return i;
+}
+
+NN_TARGET_AVX2 static size_t SwapRBAVX2(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	const __m256i shuffle = _mm256_setr_epi8(
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+		2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	size_t i = 0;
+	for (; i + 8 <= pixel_num; i += 8)
+	{
+		__m256i pixels = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+		_mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_shuffle_epi8(pixels, shuffle));
+	}
+	return i;
+}
+
+/** Implementation Functions <<< */
+
+void Swizzle::BGRToRGBA(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	size_t done = 0;
+	switch (GetInstructionSetLevel())
+	{
+	case AVX2:
+		done = BGRToRGBAAVX2(src, dst, pixel_num);
+		break;
+	case SSSE3:
+		done = BGRToRGBASSSE3(src, dst, pixel_num);
+		break;
+	default:
+		break;
+	}
+	BGRToRGBAScalar(src + done * 3, dst + done * 4, pixel_num - done);
+}
+
+void Swizzle::SwapRB(const NNByte* src, NNByte* dst, const size_t pixel_num)
+{
+	size_t done = 0;
+	switch (GetInstructionSetLevel())
+	{
+	case AVX2:
+		done = SwapRBAVX2(src, dst, pixel_num);
+		break;
+	case SSSE3:
+		done = SwapRBSSSE3(src, dst, pixel_num);
+		break;
+	default:
+		break;
+	}
+	SwapRBScalar(src + done * 4, dst + done * 4, pixel_num - done);
+}
+
+const NNChar* Swizzle::GetInstructionSet()
+{
+	switch (GetInstructionSetLevel())
+	{
+	case AVX2:
+		return "AVX2";
+	case SSSE3:
+		return "SSSE3";
+	default:
+		return "Scalar";
+	}
+}
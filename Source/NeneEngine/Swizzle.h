@@ -0,0 +1,22 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef SWIZZLE_H
+#define SWIZZLE_H
+
+#include "Types.h"
+
+//
+//    Swizzle: 8-bit pixel channel conversion kernels, dispatched to AVX2 / SSSE3 / scalar at runtime
+//
+
+class Swizzle
+{
+public:
+	// 3 字节 BGR 扩展为 4 字节 RGBA, alpha 填 255
+	static void BGRToRGBA(const NNByte* src, NNByte* dst, const size_t pixel_num);
+	// 4 字节像素交换 R 和 B (BGRA <-> RGBA), src 和 dst 可以相同
+	static void SwapRB(const NNByte* src, NNByte* dst, const size_t pixel_num);
+	// 当前使用的指令集: "AVX2", "SSSE3" 或 "Scalar"
+	static const NNChar* GetInstructionSet();
+};
+
+#endif // SWIZZLE_H
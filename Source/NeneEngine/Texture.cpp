@@ -1,67 +1,26 @@
 ﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 #include "Debug.h"
 #include "Texture.h"
+#include "Swizzle.h"
+#include "ThreadPool.h"
+#include "MemoryPool.h"
+
+#include <atomic>
+#include <cstring>
 
 #include <FreeImage/FreeImage.h>
 
 using namespace std;
 
+/** Implementation Functions >>> */
 
-void Texture::SaveImage(std::shared_ptr<NNByte[]> bits, const NNUInt& width, const NNUInt& height, const NNPixelFormat &format, const NNChar* filepath)
-{
-	FIBITMAP *p_image = nullptr;
-	if (format == NNPixelFormat::R32G32B32_FLOAT)
-	{
-		int bpp = 8 * sizeof(FIRGBF);
-		int pitch = ((((bpp * width) + 31) / 32) * 4);
-		p_image = FreeImage_ConvertFromRawBitsEx(true, bits.get(), FIT_RGBF, width, height, pitch, bpp, 0, 0, 0);
-	}
-	else if (format == NNPixelFormat::B8G8R8A8_UNORM)
-	{
-		int bpp = 32;
-		int pitch = ((((bpp * width) + 31) / 32) * 4);
-		p_image = FreeImage_ConvertFromRawBits(bits.get(), width, height, pitch, bpp, 0, 0, 0);
-	}
-	else if (format == NNPixelFormat::R8G8B8A8_UNORM)
-	{
-		//
-		int bpp = 32;
-		int pitch = ((((bpp * width) + 31) / 32) * 4);
-		// RGBA -> BGRA
-		for (NNUInt y = 0; y < height; ++y)
-		{
-			for (NNUInt x = 0; x < width; ++x)
-			{
-				NNByte& r = bits[(y * width * (bpp / 8)) + (x * (bpp / 8)) + 0];
-				NNByte& b = bits[(y * width * (bpp / 8)) + (x * (bpp / 8)) + 2];
-				std::swap(r, b);
-			}
-		}
-		p_image = FreeImage_ConvertFromRawBits(bits.get(), width, height, pitch, bpp, 0, 0, 0);
-	}
-	if (p_image != nullptr)
-	{
-		FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(filepath);
-		if (format != FIF_UNKNOWN)
-		{
-			FreeImage_Save(format, p_image, filepath, EXR_FLOAT);
-		}
-		FreeImage_Unload(p_image);
-	}
-}
-
-shared_ptr<NNByte[]> Texture::LoadImage(const NNChar* filepath, NNUInt& width, NNUInt& height, NNUInt& bpp, NNPixelFormat& format)
+// 打开图片并判断像素格式, 失败时返回空指针
+static FIBITMAP* OpenBitmap(const NNChar* filepath, const int flags, NNPixelFormat& format)
 {
 	// 检查文件
 	checkFileExist(filepath);
-	// 图片格式
-	FREE_IMAGE_FORMAT fileFormat = FIF_UNKNOWN;
-	// 图片数据
-	BYTE *pBits = nullptr;
-	// 图片指针
-	FIBITMAP *pImage = nullptr;
 	// 获取格式
-	fileFormat = FreeImage_GetFileType(filepath, 0);
+	FREE_IMAGE_FORMAT fileFormat = FreeImage_GetFileType(filepath, 0);
 	if (fileFormat == FIF_UNKNOWN) 
 	{
 		fileFormat = FreeImage_GetFIFFromFilename(filepath);
@@ -72,9 +31,10 @@ shared_ptr<NNByte[]> Texture::LoadImage(const NNChar* filepath, NNUInt& width, N
 		return nullptr;
 	}
 	// 载入图片
+	FIBITMAP *pImage = nullptr;
 	if (FreeImage_FIFSupportsReading(fileFormat))
 	{
-		pImage = FreeImage_Load(fileFormat, filepath);
+		pImage = FreeImage_Load(fileFormat, filepath, flags);
 	}
 	else
 	{
@@ -85,20 +45,20 @@ shared_ptr<NNByte[]> Texture::LoadImage(const NNChar* filepath, NNUInt& width, N
 		dLog("[Error] Failed to load image! (%s)\n", filepath);
 		return nullptr;
 	}
-	//
+	// 位图按位深判断: 只读文件头时 FreeImage_GetColorType 无法扫描 alpha, 结果和完整载入不一致
 	FREE_IMAGE_COLOR_TYPE fic = FreeImage_GetColorType(pImage);
 	//
 	FREE_IMAGE_TYPE fit = FreeImage_GetImageType(pImage);
 	//
-	bpp = FreeImage_GetBPP(pImage);
+	NNUInt bpp = FreeImage_GetBPP(pImage);
 	//
 	format = NNPixelFormat::INVALID;
 	//
-	if (fit == FIT_BITMAP and fic == FIC_RGB)
+	if (fit == FIT_BITMAP and bpp == 24 and (fic == FIC_RGB or fic == FIC_RGBALPHA))
 	{
 		format = NNPixelFormat::B8G8R8_UNORM;
 	}
-	else if (fit == FIT_BITMAP and fic == FIC_RGBALPHA)
+	else if (fit == FIT_BITMAP and bpp == 32 and (fic == FIC_RGB or fic == FIC_RGBALPHA))
 	{
 		format = NNPixelFormat::B8G8R8A8_UNORM;
 	}
@@ -110,18 +70,240 @@ shared_ptr<NNByte[]> Texture::LoadImage(const NNChar* filepath, NNUInt& width, N
 	if (format == NNPixelFormat::INVALID)
 	{
 		dLog("[Error] Unsupport image format! (%s)\n", filepath);
+		FreeImage_Unload(pImage);
+		return nullptr;
+	}
+	return pImage;
+}
+
+// 逐行转换为解码格式, 去掉 FreeImage 每行末尾的对齐填充, dst_pitch 为目标内存每行的字节数
+static void ConvertBitmapBits(FIBITMAP* pImage, const NNPixelFormat format, NNByte* dst, const size_t dst_pitch)
+{
+	const BYTE *pBits = FreeImage_GetBits(pImage);
+	const NNUInt pitch = FreeImage_GetPitch(pImage);
+	const NNUInt width = FreeImage_GetWidth(pImage);
+	const NNUInt height = FreeImage_GetHeight(pImage);
+	const size_t row = (size_t)width * (FreeImage_GetBPP(pImage) / 8);
+	for (NNUInt y = 0; y < height; ++y)
+	{
+		const BYTE *src = pBits + (size_t)pitch * y;
+		NNByte *dst_row = dst + dst_pitch * y;
+		switch (format)
+		{
+		case NNPixelFormat::B8G8R8_UNORM:
+			Swizzle::BGRToRGBA(src, dst_row, width);
+			break;
+		case NNPixelFormat::B8G8R8A8_UNORM:
+			Swizzle::SwapRB(src, dst_row, width);
+			break;
+		default:
+			memcpy(dst_row, src, row);
+			break;
+		}
+	}
+}
+
+/** Implementation Functions <<< */
+
+
+void Texture::SaveImage(std::shared_ptr<NNByte[]> bits, const NNUInt& width, const NNUInt& height, const NNPixelFormat &format, const NNChar* filepath)
+{
+	FIBITMAP *p_image = nullptr;
+	if (format == NNPixelFormat::R32G32B32_FLOAT)
+	{
+		int bpp = 8 * sizeof(FIRGBF);
+		int pitch = ((((bpp * width) + 31) / 32) * 4);
+		p_image = FreeImage_ConvertFromRawBitsEx(true, bits.get(), FIT_RGBF, width, height, pitch, bpp, 0, 0, 0);
+	}
+	else if (format == NNPixelFormat::B8G8R8A8_UNORM)
+	{
+		int bpp = 32;
+		int pitch = ((((bpp * width) + 31) / 32) * 4);
+		p_image = FreeImage_ConvertFromRawBits(bits.get(), width, height, pitch, bpp, 0, 0, 0);
+	}
+	else if (format == NNPixelFormat::R8G8B8A8_UNORM)
+	{
+		//
+		int bpp = 32;
+		int pitch = ((((bpp * width) + 31) / 32) * 4);
+		// RGBA -> BGRA, 转换到临时内存, 不修改调用者的数据
+		shared_ptr<NNByte[]> swapped = MemoryPool::Instance().Acquire((size_t)pitch * height);
+		Swizzle::SwapRB(bits.get(), swapped.get(), (size_t)width * height);
+		p_image = FreeImage_ConvertFromRawBits(swapped.get(), width, height, pitch, bpp, 0, 0, 0);
+	}
+	if (p_image != nullptr)
+	{
+		FREE_IMAGE_FORMAT format = FreeImage_GetFIFFromFilename(filepath);
+		if (format != FIF_UNKNOWN)
+		{
+			FreeImage_Save(format, p_image, filepath, EXR_FLOAT);
+		}
+		FreeImage_Unload(p_image);
+	}
+}
+
+Texture::Image Texture::LoadImage(const NNChar* filepath)
+{
+	Image image;
+	image.data = LoadImage(filepath, image.width, image.height, image.bpp, image.format);
+	return image;
+}
+
+shared_ptr<NNByte[]> Texture::LoadImage(const NNChar* filepath, NNUInt& width, NNUInt& height, NNUInt& bpp, NNPixelFormat& format)
+{
+	// 载入图片
+	NNPixelFormat source_format;
+	FIBITMAP *pImage = OpenBitmap(filepath, 0, source_format);
+	if (!pImage)
+	{
 		return nullptr;
 	}
 	// 获取数据
-	pBits = FreeImage_GetBits(pImage);
+	format = GetDecodedFormat(source_format);
+	bpp = GetDecodedBitsPerPixel(format);
 	width = FreeImage_GetWidth(pImage);
 	height = FreeImage_GetHeight(pImage);
-	NNUInt pitch = FreeImage_GetPitch(pImage);
-	// 拷贝一份数据返回
-	BYTE *res = new BYTE[width * height * (bpp / 8)];
-	memcpy(res, pBits, width * height * (bpp / 8));
+	// 转换到池中的内存返回
+	shared_ptr<NNByte[]> res = MemoryPool::Instance().Acquire((size_t)width * height * (bpp / 8));
+	ConvertBitmapBits(pImage, source_format, res.get(), (size_t)width * (bpp / 8));
 	// 释放原来的指针
 	FreeImage_Unload(pImage);
 	// 返回
-	return std::unique_ptr<BYTE[]>(res);
+	return res;
+}
+
+NNPixelFormat Texture::GetDecodedFormat(const NNPixelFormat& format)
+{
+	if (format == NNPixelFormat::B8G8R8_UNORM || format == NNPixelFormat::B8G8R8A8_UNORM)
+	{
+		return NNPixelFormat::R8G8B8A8_UNORM;
+	}
+	return format;
+}
+
+NNUInt Texture::GetDecodedBitsPerPixel(const NNPixelFormat& format)
+{
+	return format == NNPixelFormat::R32G32B32_FLOAT ? 96 : 32;
+}
+
+bool Texture::ReadImageInfo(const NNChar* filepath, NNUInt& width, NNUInt& height, NNUInt& bpp, NNPixelFormat& format)
+{
+	// 只读文件头
+	FIBITMAP *pImage = OpenBitmap(filepath, FIF_LOAD_NOPIXELS, format);
+	if (!pImage)
+	{
+		return false;
+	}
+	format = GetDecodedFormat(format);
+	bpp = GetDecodedBitsPerPixel(format);
+	width = FreeImage_GetWidth(pImage);
+	height = FreeImage_GetHeight(pImage);
+	FreeImage_Unload(pImage);
+	return true;
+}
+
+bool Texture::DecodeImage(const NNChar* filepath, NNByte* dst, const size_t row_pitch, const NNUInt width, const NNUInt height, const NNPixelFormat& format)
+{
+	//
+	NNPixelFormat source_format;
+	FIBITMAP *pImage = OpenBitmap(filepath, 0, source_format);
+	if (!pImage)
+	{
+		return false;
+	}
+	// 文件可能在读取文件头之后被修改
+	const size_t pitch = row_pitch != 0 ? row_pitch : (size_t)width * (GetDecodedBitsPerPixel(format) / 8);
+	bool matched = FreeImage_GetWidth(pImage) == width && FreeImage_GetHeight(pImage) == height && GetDecodedFormat(source_format) == format;
+	if (matched)
+	{
+		ConvertBitmapBits(pImage, source_format, dst, pitch);
+	}
+	else
+	{
+		dLog("[Error] Image size or format mismatch! (%s)\n", filepath);
+	}
+	FreeImage_Unload(pImage);
+	return matched;
+}
+
+Texture::Image Texture::ImageBatch::GetImage(const NNUInt idx) const
+{
+	Image image = Image();
+	if (!decoded[idx])
+	{
+		return image;
+	}
+	image.data = shared_ptr<NNByte[]>(data, data.get() + image_size * idx);
+	image.width = width;
+	image.height = height;
+	image.bpp = bpp;
+	image.format = format;
+	return image;
+}
+
+shared_ptr<Texture::ImageBatch> Texture::CreateImageBatch(const vector<string>& filepaths)
+{
+	//
+	if (filepaths.empty())
+	{
+		return nullptr;
+	}
+	shared_ptr<ImageBatch> batch = make_shared<ImageBatch>();
+	batch->filepaths = filepaths;
+	// 只读文件头, 先检查所有图片是否一致
+	for (NNUInt idx = 0; idx < filepaths.size(); ++idx)
+	{
+		const NNChar* filepath = filepaths[idx].c_str();
+		NNUInt width, height, bpp;
+		NNPixelFormat format;
+		if (!ReadImageInfo(filepath, width, height, bpp, format))
+		{
+			return nullptr;
+		}
+		if (idx == 0)
+		{
+			batch->width = width;
+			batch->height = height;
+			batch->bpp = bpp;
+			batch->format = format;
+		}
+		else if (width != batch->width || height != batch->height || bpp != batch->bpp || format != batch->format)
+		{
+			dLog("[Error] Image size or format mismatch! (%s)\n", filepath);
+			return nullptr;
+		}
+	}
+	// 整块分配
+	batch->image_size = (size_t)batch->width * batch->height * (batch->bpp / 8);
+	batch->data = MemoryPool::Instance().Acquire(batch->image_size * filepaths.size());
+	batch->decoded.assign(filepaths.size(), 0);
+	return batch;
+}
+
+bool Texture::DecodeImage(ImageBatch& batch, const NNUInt idx)
+{
+	bool decoded = DecodeImage(batch.filepaths[idx].c_str(), batch.data.get() + batch.image_size * idx, 0, batch.width, batch.height, batch.format);
+	batch.decoded[idx] = decoded ? 1 : 0;
+	return decoded;
+}
+
+bool Texture::DecodeImageBatches(const vector<shared_ptr<ImageBatch>>& batches)
+{
+	// 展开成 (批次, 图片) 列表, 所有批次的图片一起分配到各个线程
+	vector<pair<ImageBatch*, NNUInt>> items;
+	for (const shared_ptr<ImageBatch>& batch : batches)
+	{
+		for (NNUInt idx = 0; batch != nullptr && idx < batch->filepaths.size(); ++idx)
+		{
+			items.emplace_back(batch.get(), idx);
+		}
+	}
+	atomic<bool> succeeded(true);
+	ThreadPool::Instance().ParallelFor((NNUInt)items.size(), [&](NNUInt item) {
+		if (!DecodeImage(*items[item].first, items[item].second))
+		{
+			succeeded = false;
+		}
+	});
+	return succeeded;
 }
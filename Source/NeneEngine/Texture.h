@@ -5,6 +5,8 @@
 #include "Utils.h"
 #include "Pixel.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 //
 //    Texture: Abstract Class for Texture Class
@@ -12,11 +14,48 @@
 
 class Texture : public std::enable_shared_from_this<Texture>
 {
+public:
+	// 解码后的图片
+	struct Image
+	{
+		std::shared_ptr<NNByte[]> data;
+		NNUInt width, height, bpp;
+		NNPixelFormat format;
+	};
+	// 批量解码: 尺寸和格式一致的图片连续存放在一整块内存中
+	struct ImageBatch
+	{
+		std::vector<std::string> filepaths;
+		std::shared_ptr<NNByte[]> data;
+		NNUInt width, height, bpp;
+		NNPixelFormat format;
+		size_t image_size;
+		// 每张图片是否解码成功
+		std::vector<NNByte> decoded;
+		// 第 idx 张图片, 与整块内存共享所有权, 未解码时数据为空
+		Image GetImage(const NNUInt idx) const;
+	};
+
 public:
 	// 
 	virtual void Use(const NNUInt& slot = 0) = 0;
-	//
+	// 解码到池中的内存, 8 位图片统一转为 RGBA8 (驱动不需要再重排通道), 浮点图片保持 RGB32F
 	static std::shared_ptr<NNByte[]> LoadImage(const NNChar* filepath, NNUInt& width, NNUInt& height, NNUInt& bpp, NNPixelFormat& format);
+	// 只做解码, 不访问图形接口, 可以在工作线程调用
+	static Image LoadImage(const NNChar* filepath);
+	// 文件中的像素格式解码后对应的格式和位深
+	static NNPixelFormat GetDecodedFormat(const NNPixelFormat& format);
+	static NNUInt GetDecodedBitsPerPixel(const NNPixelFormat& format);
+	// 只读取文件头, 返回解码后的尺寸和格式, 用于预先分配内存
+	static bool ReadImageInfo(const NNChar* filepath, NNUInt& width, NNUInt& height, NNUInt& bpp, NNPixelFormat& format);
+	// 解码到调用者提供的内存, 每行 row_pitch 字节 (0 表示紧密排列), 尺寸和格式必须与 ReadImageInfo 一致
+	static bool DecodeImage(const NNChar* filepath, NNByte* dst, const size_t row_pitch, const NNUInt width, const NNUInt height, const NNPixelFormat& format);
+	// 只读取文件头, 检查尺寸和格式一致后分配整块内存, 不一致时返回空指针
+	static std::shared_ptr<ImageBatch> CreateImageBatch(const std::vector<std::string>& filepaths);
+	// 解码第 idx 张图片到整块内存中的对应位置, 不同的 idx 可以在不同线程同时解码
+	static bool DecodeImage(ImageBatch& batch, const NNUInt idx);
+	// 在线程池上并行解码所有批次的所有图片
+	static bool DecodeImageBatches(const std::vector<std::shared_ptr<ImageBatch>>& batches);
 	//
 	static void SaveImage(std::shared_ptr<NNByte[]> data, const NNUInt& width, const NNUInt& height, const NNPixelFormat &format, const NNChar* filepath);
 };
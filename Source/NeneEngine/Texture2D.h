@@ -6,6 +6,7 @@
 #include "Pixel.h"
 #include "Texture.h"
 #include "Sampler.h"
+#include "ResourceLoader.h"
 
 //
 //    Texture2D: Single Image Texture Class
@@ -21,6 +22,11 @@ public:
 	static std::shared_ptr<Texture2D> Create(const NNChar* filePath);
 	// Create texture with multi image paths as mipmaps
 	static std::shared_ptr<Texture2D> Create(std::vector<const NNChar*> filepaths);
+	// Create texture with decoded images as mipmaps
+	static std::shared_ptr<Texture2D> CreateFromImages(const std::vector<Image>& images);
+	// Decode on worker threads and upload in the background, a placeholder is bound until then
+	static AsyncHandle<Texture2D> LoadAsync(const NNChar* filepath);
+	static AsyncHandle<Texture2D> LoadAsync(std::vector<const NNChar*> filepaths);
 	// 
 	static std::shared_ptr<Texture2D> CreateFromMemory(const NNUInt& width, const NNUInt& height, const NNPixelFormat& format, const void *pInitData = nullptr);
 	//
@@ -33,6 +39,10 @@ public:
 	//
 	virtual std::shared_ptr<NNByte[]> GetPixelData();
 	virtual void SavePixelData(const NNChar* filepath);
+	//
+	inline NNUInt GetWidth() const { return m_width; }
+	inline NNUInt GetHeight() const { return m_height; }
+	inline NNPixelFormat GetFormat() const { return m_format; }
 
 protected:
 	NNPixelFormat m_format;
@@ -55,6 +65,7 @@ protected:
 	Texture2D& operator=(const Texture2D& rhs) = delete;
 
 friend class RenderTarget;
+friend class TextureArray;
 };
 
 #endif // TEXTURE2D_H
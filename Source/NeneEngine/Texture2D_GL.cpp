@@ -2,7 +2,13 @@
 #ifdef NENE_GL
 #include <vector>
 #include "Debug.h"
+#include "DebugLayer.h"
 #include "Texture2D.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+#include "TextureCache.h"
 
 using namespace std;
 
@@ -13,29 +19,52 @@ void GenerateTextures(vector<GLuint> IN tex_ids)
 
 }
 
+// 文件载入纹理的默认参数
+static void SetImageTextureParameters(const GLint max_level)
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, -2);
+}
+
+// 异步载入完成前绑定的占位数据
+static const NNByte PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
 /** Implementation Functions <<< */
 
-Texture2D::Texture2D() : Texture(), mTextureID(0), mMode(AS_COLOR) {}
+Texture2D::Texture2D() : Texture(), m_format(NNPixelFormat::INVALID), mMode(AS_COLOR), m_width(0), m_height(0), mTextureID(0) {}
 
 
 Texture2D::~Texture2D()
 {
 	if (mTextureID != 0)
 	{
-		glDeleteTextures(1, &mTextureID);
+		RenderContext::instance().forgetTexture(mTextureID);
+		// 在已经录制的绘制之后删除
+		const GLuint texture = mTextureID;
+		RenderThread::Defer([texture]() { glDeleteTextures(1, &texture); });
 	}
 }
 
 shared_ptr<Texture2D> Texture2D::CreateFromMemory(const NNUInt& width, const NNUInt& height, const NNPixelFormat& format, const void *init_data)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(CreateFromMemory(width, height, format, init_data));
 	GLuint texID = 0;
 	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D, texID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, texID);
 		glTexImage2D(GL_TEXTURE_2D, 0, GetGLInternalFormat(format), width, height, 0, GetGLFormat(format), GetGLType(format), init_data);
+		if (init_data != nullptr)
+		{
+			RenderStats::Add(NN_COUNTER_TEXTURE_BYTES, (NNULong)width * height * GetPixelBytes(format));
+		}
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, 0);
 	//
 	if (texID == 0)
 	{
@@ -52,11 +81,12 @@ shared_ptr<Texture2D> Texture2D::CreateFromMemory(const NNUInt& width, const NNU
 shared_ptr<Texture2D> Texture2D::CreateMultisample(const NNUInt& width, const NNUInt& height, const NNUInt& samples, const NNUInt& iformat) 
 {
 	//
+	NN_RENDER_THREAD_FORWARD(CreateMultisample(width, height, samples, iformat));
 	GLuint texID = 0;
 	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, texID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, texID);
 		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, (GLenum)iformat, width, height, false);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, 0);
 	//
 	if (texID == 0) {
 		return nullptr;
@@ -76,8 +106,30 @@ shared_ptr<Texture2D> Texture2D::Create(const NNChar* filepath)
 
 
 shared_ptr<Texture2D> Texture2D::Create(vector<const NNChar*> filepaths)
+{
+	// 每个文件是一级 mipmap
+	vector<vector<string>> sources;
+	for (const NNChar* filepath : filepaths)
+	{
+		sources.push_back({ filepath });
+	}
+	vector<Image> images;
+	for (const vector<Image>& level : TextureCache::Load(sources))
+	{
+		images.push_back(level.front());
+	}
+	shared_ptr<Texture2D> result = CreateFromImages(images);
+	if (result != nullptr && !filepaths.empty())
+	{
+		DebugLayer::SetLabel(GL_TEXTURE, result->mTextureID, filepaths.front());
+	}
+	return result;
+}
+
+shared_ptr<Texture2D> Texture2D::CreateFromImages(const vector<Image>& images)
 {
 	//
+	NN_RENDER_THREAD_FORWARD(CreateFromImages(images));
 	NNUInt texID = 0;
 	glGenTextures(1, &texID);
 	//
@@ -88,68 +140,164 @@ shared_ptr<Texture2D> Texture2D::Create(vector<const NNChar*> filepaths)
 	}
 	//
 	GLuint width = 0, height = 0;
+	NNPixelFormat format = NNPixelFormat::R8G8B8A8_UNORM;
 	//
-	glBindTexture(GL_TEXTURE_2D, texID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, texID);
 	{
 		//
-		for (NNUInt idx = 0; idx < filepaths.size(); ++idx)
+		for (NNUInt idx = 0; idx < images.size(); ++idx)
 		{
 			//
-			const char* filepath = filepaths[idx];
-			shared_ptr<NNByte[]> image_data = nullptr;
-			//
-			NNUInt bpp;
-			NNPixelFormat format;
-			//
-			image_data = LoadImage(filepath, width, height, bpp, format);
-			if (image_data == nullptr || width == 0 || height == 0)
+			const Image& image = images[idx];
+			if (image.data == nullptr || image.width == 0 || image.height == 0)
 			{
-				dLog("[Error] Broken image data! Could not load texture(%s)\n", filepath);
 				continue;
 			}
+			if (idx == 0)
+			{
+				width = image.width;
+				height = image.height;
+				format = image.format;
+			}
 			//
-			glTexImage2D(GL_TEXTURE_2D, idx, GetGLInternalFormat(format), width, height, 0, GetGLFormat(format), GetGLType(format), image_data.get());
+			// 每一级按自己的尺寸上传, 第 0 级的尺寸作为纹理的尺寸
+			glTexImage2D(GL_TEXTURE_2D, idx, GetGLInternalFormat(image.format), image.width, image.height, 0, GetGLFormat(image.format), GetGLType(image.format), image.data.get());
+			RenderStats::Add(NN_COUNTER_TEXTURE_BYTES, (NNULong)image.width * image.height * (image.bpp / 8));
 		}
 		//
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)filepaths.size() - 1);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, -2);
+		SetImageTextureParameters((GLint)images.size() - 1);
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, 0);
 	//
 	Texture2D* ret = new Texture2D();
 	ret->mTextureID = texID;
 	ret->m_width = width;
 	ret->m_height = height;
-	ret->m_format = NNPixelFormat::R8G8B8A8_UNORM;
+	ret->m_format = format;
 	return shared_ptr<Texture2D>(ret);
 }
 
+AsyncHandle<Texture2D> Texture2D::LoadAsync(const NNChar* filepath)
+{
+	return LoadAsync(vector<const NNChar*>({ filepath }));
+}
+
+AsyncHandle<Texture2D> Texture2D::LoadAsync(vector<const NNChar*> filepaths)
+{
+	// 先返回占位纹理
+	shared_ptr<Texture2D> result = CreateFromMemory(1, 1, NNPixelFormat::R8G8B8A8_UNORM, PLACEHOLDER_PIXEL);
+	if (result == nullptr)
+	{
+		return AsyncHandle<Texture2D>();
+	}
+	vector<vector<string>> sources;
+	for (const NNChar* filepath : filepaths)
+	{
+		sources.push_back({ filepath });
+	}
+	// 工作线程先查找缓存, 未命中时在同一个任务中用 ParallelFor 解码, 工作线程不会阻塞等待池中的其它任务
+	shared_ptr<vector<Image>> images = make_shared<vector<Image>>(filepaths.size());
+	shared_ptr<bool> cached = make_shared<bool>(false);
+	vector<shared_future<void>> decoding;
+	decoding.push_back(ThreadPool::Instance().Submit([images, cached, sources]() {
+		shared_ptr<TextureCache> cache = TextureCache::Open(sources);
+		if (cache != nullptr)
+		{
+			vector<vector<Image>> levels = cache->GetImages();
+			for (NNUInt idx = 0; idx < levels.size(); ++idx)
+			{
+				(*images)[idx] = levels[idx].front();
+			}
+			*cached = true;
+			return;
+		}
+		ThreadPool::Instance().ParallelFor((NNUInt)sources.size(), [&](const NNUInt idx) {
+			const string& filepath = sources[idx].front();
+			(*images)[idx] = LoadImage(filepath.c_str());
+			if ((*images)[idx].data == nullptr)
+			{
+				dLog("[Error] Broken image data! Could not load texture(%s)\n", filepath.c_str());
+			}
+		});
+	}).share());
+	// 主线程每步上传一级 mipmap 到新纹理, 全部完成后替换占位纹理
+	shared_ptr<ResourceLoader::Job> job = ResourceLoader::Instance().Enqueue(move(decoding), [result, images, cached, sources, texID = GLuint(0), level = NNUInt(0)]() mutable {
+		//
+		ResourceLoader& loader = ResourceLoader::Instance();
+		if (texID == 0)
+		{
+			// 在工作线程写入缓存, 拷贝的 Image 共享像素数据
+			if (!*cached)
+			{
+				vector<vector<Image>> levels;
+				for (const Image& image : *images)
+				{
+					levels.push_back({ image });
+				}
+				ThreadPool::Instance().Submit([sources, levels]() { TextureCache::Write(sources, levels); });
+			}
+			glGenTextures(1, &texID);
+		}
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, texID);
+		{
+			Image& image = (*images)[level];
+			if (image.data != nullptr && image.width != 0 && image.height != 0)
+			{
+				const void* pixels = loader.Stage(image.data.get(), image.width * image.height * (image.bpp / 8));
+				glTexImage2D(GL_TEXTURE_2D, level, GetGLInternalFormat(image.format), image.width, image.height, 0, GetGLFormat(image.format), GetGLType(image.format), pixels);
+				loader.Unstage();
+				if (level == 0)
+				{
+					result->m_width = image.width;
+					result->m_height = image.height;
+					result->m_format = image.format;
+				}
+			}
+			image.data = nullptr;
+			if (++level == images->size())
+			{
+				SetImageTextureParameters((GLint)images->size() - 1);
+			}
+		}
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, 0);
+		if (level < images->size())
+		{
+			return false;
+		}
+		//
+		RenderContext::instance().forgetTexture(result->mTextureID);
+		glDeleteTextures(1, &result->mTextureID);
+		result->mTextureID = texID;
+		return true;
+	});
+	return AsyncHandle<Texture2D>(result, job);
+}
+
 void Texture2D::Use(const NNUInt& slot) 
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	RenderContext::instance().bindTexture(slot, GL_TEXTURE_2D, mTextureID);
 }
 
 void Texture2D::SetSampler(std::shared_ptr<Sampler> sampler)
 {
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, mTextureID);
 	{
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler->m_mag_filter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler->m_min_filter);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler->m_wrap_u);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler->m_wrap_v);
+		// 参数按值录制, 不需要等待渲染线程
+		RenderThread::Record([](const GLint mag_filter, const GLint min_filter, const GLint wrap_u, const GLint wrap_v)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_u);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_v);
+		}, (GLint)sampler->m_mag_filter, (GLint)sampler->m_min_filter, (GLint)sampler->m_wrap_u, (GLint)sampler->m_wrap_v);
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, 0);
 }
 
 shared_ptr<NNByte[]> Texture2D::GetPixelData()
 {
 	//
+	NN_RENDER_THREAD_FORWARD(GetPixelData());
 	if (mTextureID == 0)
 	{
 		return nullptr;
@@ -162,11 +310,11 @@ shared_ptr<NNByte[]> Texture2D::GetPixelData()
 	}
 	NNByte* buffer = new NNByte[m_width * m_height * pixel_width * sizeof(NNByte)];
 	//
-	glBindTexture(GL_TEXTURE_2D, mTextureID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, mTextureID);
 	{
 		glGetTexImage(GL_TEXTURE_2D, 0, GetGLFormat(m_format), GetGLType(m_format), buffer);
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_2D, 0);
 	//
 	return shared_ptr<NNByte[]>(buffer);
 }
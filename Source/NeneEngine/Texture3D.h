@@ -4,6 +4,7 @@
 
 #include <vector>
 #include "Texture.h"
+#include "ResourceLoader.h"
 
 class Texture3DImpl;
 
@@ -19,6 +20,8 @@ public:
 	//
 	static std::shared_ptr<Texture3D> Create(const std::vector<std::string>& filepaths);
 	static std::shared_ptr<Texture3D> Create(const std::vector<std::vector<std::string>>& mipmapfilepaths);
+	// 工作线程解码, 主线程逐层上传, 完成前绑定占位纹理
+	static AsyncHandle<Texture3D> LoadAsync(const std::vector<std::vector<std::string>>& mipmapfilepaths);
 	//
 	virtual void Use(const NNUInt& slot = 0);
 private:
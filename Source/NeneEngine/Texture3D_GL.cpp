@@ -2,6 +2,11 @@
 #ifdef NENE_GL
 #include "Debug.h"
 #include "Texture3D.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+#include "TextureCache.h"
 
 using namespace std;
 
@@ -17,7 +22,7 @@ public:
 	GLuint m_texture_id;
 };
 
-Texture3DImpl::Texture3DImpl()
+Texture3DImpl::Texture3DImpl() : m_texture_id(0)
 {
 
 }
@@ -26,14 +31,16 @@ Texture3DImpl::~Texture3DImpl()
 {
 	if (m_texture_id != 0)
 	{
-		glDeleteTextures(1, &m_texture_id);
+		RenderContext::instance().forgetTexture(m_texture_id);
+		// 在已经录制的绘制之后删除
+		const GLuint texture = m_texture_id;
+		RenderThread::Defer([texture]() { glDeleteTextures(1, &texture); });
 	}
 }
 
 void Texture3DImpl::Use(const NNUInt& slot)
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_3D, m_texture_id);
+	RenderContext::instance().bindTexture(slot, GL_TEXTURE_3D, m_texture_id);
 }
 
 /** GL Implementation <<< */
@@ -53,6 +60,49 @@ shared_ptr<Texture3D> Texture3D::Create(const vector<string>& filepaths)
 
 shared_ptr<Texture3D> Texture3D::Create(const std::vector<std::vector<string>>& mipmapfilepaths)
 {
+	NN_RENDER_THREAD_FORWARD(Create(mipmapfilepaths));
+	// 每级切片连续存放 (缓存的映射内存或者解码的整块内存), 每级只上传一次
+	vector<TextureCache::Level> levels;
+	NNPixelFormat format = NNPixelFormat::INVALID;
+	shared_ptr<TextureCache> cache = TextureCache::Open(mipmapfilepaths);
+	vector<shared_ptr<ImageBatch>> batches;
+	if (cache != nullptr)
+	{
+		levels = cache->GetLevels();
+		format = cache->GetFormat();
+	}
+	else
+	{
+		// 先检查所有切片的尺寸和格式, 再并行解码
+		for (NNUInt mip = 0; mip < mipmapfilepaths.size(); ++mip)
+		{
+			shared_ptr<ImageBatch> batch = CreateImageBatch(mipmapfilepaths[mip]);
+			if (batch == nullptr || (mip > 0 && batch->format != batches[0]->format))
+			{
+				dLog("[Error] Unaligned image for texture 3d!");
+				return nullptr;
+			}
+			batches.push_back(batch);
+		}
+		if (!DecodeImageBatches(batches))
+		{
+			dLog("[Error] Broken image data for texture 3d!");
+			return nullptr;
+		}
+		//
+		vector<vector<Image>> mipimages(batches.size());
+		for (NNUInt mip = 0; mip < batches.size(); ++mip)
+		{
+			const ImageBatch& batch = *batches[mip];
+			levels.push_back({ batch.width, batch.height, (NNUInt)batch.filepaths.size(), batch.image_size, batch.data.get() });
+			for (NNUInt idx = 0; idx < batch.filepaths.size(); ++idx)
+			{
+				mipimages[mip].push_back(batch.GetImage(idx));
+			}
+		}
+		format = batches.empty() ? format : batches[0]->format;
+		TextureCache::Write(mipmapfilepaths, mipimages);
+	}
 	//
 	NNUInt tex_id = 0;
 	glGenTextures(1, &tex_id);
@@ -61,44 +111,14 @@ shared_ptr<Texture3D> Texture3D::Create(const std::vector<std::vector<string>>&
 		dLog("[Error] Cannot generate texture 3d!\n");
 		return nullptr;
 	}
-	glBindTexture(GL_TEXTURE_3D, tex_id);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, tex_id);
 	{
 		// Each mip map
-		for (NNUInt mip = 0; mip < mipmapfilepaths.size(); ++mip)
+		for (NNUInt mip = 0; mip < levels.size(); ++mip)
 		{
-			// Read image data for a mip
-			NNInt bpp = -1, width = -1, height = -1;
-			NNPixelFormat format = NNPixelFormat::INVALID;
-			vector<shared_ptr<NNByte[]>> images;
-			for (NNUInt idx = 0; idx < mipmapfilepaths[mip].size(); ++idx)
-			{
-				const string& filepath = mipmapfilepaths[mip][idx];
-				NNUInt currwidth, currheight, currbpp;
-				NNPixelFormat currformat;
-				shared_ptr<NNByte[]> currimage = LoadImage(filepath.c_str(), currwidth, currheight, currbpp, currformat);
-				bpp = (bpp == -1 ? currbpp : bpp);
-				width = (width == -1 ? currwidth : width);
-				height = (height == -1 ? currheight : height);
-				format = (format == NNPixelFormat::INVALID ? currformat : format);
-				if (currimage == nullptr || bpp != currbpp ||  width != currwidth || height != currheight || format != currformat)
-				{
-					dLog("[Error] Unaligned image for texture 3d!");
-					return nullptr;
-				}
-				images.push_back(currimage);
-			}
-			// Copy all image data
-			NNUInt depth = (NNUInt)images.size();
-			//
-			shared_ptr<NNByte[]> imagedata = nullptr;
-			NNUInt datasize = width * height * (bpp / 8);
-			imagedata = shared_ptr<NNByte[]>(new NNByte[datasize * depth]);
-			for (NNUInt idx = 0; idx < depth; ++idx)
-			{
-				memcpy(imagedata.get() + datasize * idx, images[idx].get(), datasize);
-			}
-			//
-			glTexImage3D(GL_TEXTURE_3D, mip, GetGLInternalFormat(format), width, height, depth, 0, GetGLFormat(format), GetGLType(format), imagedata.get());
+			const TextureCache::Level& level = levels[mip];
+			glTexImage3D(GL_TEXTURE_3D, mip, GetGLInternalFormat(format), level.width, level.height, level.layer_num, 0, GetGLFormat(format), GetGLType(format), level.data);
+			RenderStats::Add(NN_COUNTER_TEXTURE_BYTES, (NNULong)level.layer_size * level.layer_num);
 		}
 		//
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -110,7 +130,7 @@ shared_ptr<Texture3D> Texture3D::Create(const std::vector<std::vector<string>>&
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, (GLint)mipmapfilepaths.size() - 1);
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_LOD_BIAS, -2);
 	}
-	glBindTexture(GL_TEXTURE_3D, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, 0);
 	//
 	Texture3D* result = new Texture3D();
 	result->m_impl = new Texture3DImpl();
@@ -118,6 +138,122 @@ shared_ptr<Texture3D> Texture3D::Create(const std::vector<std::vector<string>>&
 	return shared_ptr<Texture3D>(result);
 }
 
+AsyncHandle<Texture3D> Texture3D::LoadAsync(const vector<vector<string>>& mipmapfilepaths)
+{
+	NN_RENDER_THREAD_FORWARD(LoadAsync(mipmapfilepaths));
+	// 占位纹理
+	static const NNByte placeholder[4] = { 128, 128, 128, 255 };
+	GLuint placeholder_id = 0;
+	glGenTextures(1, &placeholder_id);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, placeholder_id);
+	{
+		glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	}
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, 0);
+	shared_ptr<Texture3D> result(new Texture3D());
+	result->m_impl = new Texture3DImpl();
+	result->m_impl->m_texture_id = placeholder_id;
+	shared_ptr<vector<vector<Image>>> images = make_shared<vector<vector<Image>>>();
+	for (NNUInt mip = 0; mip < mipmapfilepaths.size(); ++mip)
+	{
+		images->emplace_back(mipmapfilepaths[mip].size());
+	}
+	// 先查找缓存, 命中时切片直接指向映射内存, 否则读取文件头分配每级的整块内存
+	// 未命中时在同一个任务中用 ParallelFor 解码所有切片, 工作线程不会阻塞等待池中的其它任务
+	shared_ptr<bool> cached = make_shared<bool>(false);
+	vector<shared_future<void>> decoding;
+	decoding.push_back(ThreadPool::Instance().Submit([images, cached, mipmapfilepaths]() {
+		shared_ptr<TextureCache> cache = TextureCache::Open(mipmapfilepaths);
+		if (cache != nullptr)
+		{
+			*images = cache->GetImages();
+			*cached = true;
+			return;
+		}
+		vector<shared_ptr<ImageBatch>> batches;
+		vector<pair<NNUInt, NNUInt>> slices;
+		for (NNUInt mip = 0; mip < mipmapfilepaths.size(); ++mip)
+		{
+			batches.push_back(CreateImageBatch(mipmapfilepaths[mip]));
+			for (NNUInt idx = 0; batches.back() != nullptr && idx < mipmapfilepaths[mip].size(); ++idx)
+			{
+				slices.emplace_back(mip, idx);
+			}
+		}
+		// 每张切片直接解码到整块内存中的对应位置
+		ThreadPool::Instance().ParallelFor((NNUInt)slices.size(), [&](const NNUInt i) {
+			const NNUInt mip = slices[i].first, idx = slices[i].second;
+			DecodeImage(*batches[mip], idx);
+			(*images)[mip][idx] = batches[mip]->GetImage(idx);
+		});
+	}).share());
+	// 主线程每步上传一级 mipmap (切片连续存放, 一次上传) 到新纹理, 全部完成后替换占位纹理
+	shared_ptr<ResourceLoader::Job> job = ResourceLoader::Instance().Enqueue(move(decoding), [result, images, cached, mipmapfilepaths, texID = GLuint(0), mip = NNUInt(0)]() mutable {
+		//
+		ResourceLoader& loader = ResourceLoader::Instance();
+		if (texID == 0)
+		{
+			// 所有切片的尺寸和格式必须一致
+			bool aligned = !images->empty();
+			for (const vector<Image>& level : *images)
+			{
+				aligned = aligned && !level.empty();
+				for (const Image& image : level)
+				{
+					const Image& first = level.front();
+					aligned = aligned && image.data != nullptr && image.width == first.width && image.height == first.height && image.bpp == first.bpp && image.format == (*images)[0][0].format;
+				}
+			}
+			if (!aligned)
+			{
+				dLog("[Error] Unaligned image for texture 3d!");
+				images->clear();
+				return true;
+			}
+			if (!*cached)
+			{
+				vector<vector<Image>> levels = *images;
+				ThreadPool::Instance().Submit([mipmapfilepaths, levels]() { TextureCache::Write(mipmapfilepaths, levels); });
+			}
+			glGenTextures(1, &texID);
+		}
+		//
+		vector<Image>& level = (*images)[mip];
+		const Image& image = level.front();
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, texID);
+		{
+			const void* pixels = loader.Stage(image.data.get(), image.width * image.height * (image.bpp / 8) * level.size());
+			glTexImage3D(GL_TEXTURE_3D, mip, GetGLInternalFormat(image.format), image.width, image.height, (GLsizei)level.size(), 0, GetGLFormat(image.format), GetGLType(image.format), pixels);
+			loader.Unstage();
+			level.clear();
+		}
+		// 下一级
+		if (++mip < images->size())
+		{
+			RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, 0);
+			return false;
+		}
+		//
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, (GLint)images->size() - 1);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_LOD_BIAS, -2);
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_3D, 0);
+		//
+		RenderContext::instance().forgetTexture(result->m_impl->m_texture_id);
+		glDeleteTextures(1, &result->m_impl->m_texture_id);
+		result->m_impl->m_texture_id = texID;
+		return true;
+	});
+	return AsyncHandle<Texture3D>(result, job);
+}
+
 void Texture3D::Use(const NNUInt& slot)
 {
 	m_impl->Use(slot);
@@ -0,0 +1,42 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <vector>
+#include "Texture.h"
+#include "Texture2D.h"
+
+//
+//    TextureArray: Same-sized 2D textures copied into the layers of one GL_TEXTURE_2D_ARRAY
+//
+
+class TextureArray : public Texture
+{
+public:
+	//
+	~TextureArray();
+	// 第 i 张纹理拷贝到第 i 层; 尺寸, 格式和 mipmap 层数必须一致, 否则返回空
+	static std::shared_ptr<TextureArray> Create(const std::vector<std::shared_ptr<Texture2D>>& textures);
+	// 单个纹理数组最多的层数
+	static NNUInt GetMaxLayerNum();
+	//
+	virtual void Use(const NNUInt& slot = 0);
+	//
+	inline NNUInt GetWidth() const { return m_width; }
+	inline NNUInt GetHeight() const { return m_height; }
+	inline NNUInt GetLayerNum() const { return m_layer_num; }
+
+protected:
+	NNUInt m_width, m_height;
+	NNUInt m_layer_num;
+#if defined NENE_GL
+	GLuint m_texture;
+#endif
+
+protected:
+	TextureArray();
+	TextureArray(const TextureArray& rhs) = delete;
+	TextureArray& operator=(const TextureArray& rhs) = delete;
+};
+
+#endif // TEXTURE_ARRAY_H
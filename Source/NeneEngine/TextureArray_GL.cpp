@@ -0,0 +1,137 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include <algorithm>
+#include "Debug.h"
+#include "TextureArray.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+
+using namespace std;
+
+TextureArray::TextureArray() : Texture(), m_width(0), m_height(0), m_layer_num(0), m_texture(0) {}
+
+TextureArray::~TextureArray()
+{
+	if (m_texture != 0)
+	{
+		RenderContext::instance().forgetTexture(m_texture);
+		// 在已经录制的绘制之后删除
+		const GLuint texture = m_texture;
+		RenderThread::Defer([texture]() { glDeleteTextures(1, &texture); });
+	}
+}
+
+NNUInt TextureArray::GetMaxLayerNum()
+{
+	NN_RENDER_THREAD_FORWARD(GetMaxLayerNum());
+	GLint layers = 0;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layers);
+	return (NNUInt)max(layers, 1);
+}
+
+shared_ptr<TextureArray> TextureArray::Create(const vector<shared_ptr<Texture2D>>& textures)
+{
+	//
+	NN_RENDER_THREAD_FORWARD(Create(textures));
+	if (!GLEW_ARB_copy_image)
+	{
+		dLog("[Error] Texture arrays need GL_ARB_copy_image to copy existing textures.\n");
+		return nullptr;
+	}
+	if (textures.empty() || textures.size() > GetMaxLayerNum())
+	{
+		dLog("[Error] Invalid layer number (%zd) for a texture array.\n", textures.size());
+		return nullptr;
+	}
+	// 检查所有纹理的尺寸, 内部格式和 mipmap 层数
+	RenderContext& ctx = RenderContext::instance();
+	const NNUInt width = textures[0]->m_width, height = textures[0]->m_height;
+	GLint chain = 1;
+	while ((width >> chain) > 0 || (height >> chain) > 0) ++chain;
+	// 所有纹理都有的 mipmap 层数: CreateFromMemory 的纹理只有第 0 层
+	GLint internal_format = 0, max_level = 0, defined_levels = chain;
+	for (NNUInt i = 0; i < textures.size(); ++i)
+	{
+		const shared_ptr<Texture2D>& texture = textures[i];
+		GLint format = 0, level = 0;
+		ctx.bindTexture(0, GL_TEXTURE_2D, texture->mTextureID);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &level);
+		if (i == 0)
+		{
+			internal_format = format;
+			max_level = level;
+		}
+		if (texture->m_width != width || texture->m_height != height || format != internal_format || level != max_level || width == 0 || height == 0)
+		{
+			ctx.bindTexture(0, GL_TEXTURE_2D, 0);
+			dLog("[Error] Textures of different size or format cannot be packed into one array.\n");
+			return nullptr;
+		}
+		GLint defined = 1;
+		for (GLint level_width = 0; defined < defined_levels; ++defined)
+		{
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, defined, GL_TEXTURE_WIDTH, &level_width);
+			if (level_width == 0)
+			{
+				break;
+			}
+		}
+		defined_levels = defined;
+	}
+	ctx.bindTexture(0, GL_TEXTURE_2D, 0);
+	// 没有生成 mipmap 的纹理 MAX_LEVEL 为默认的 1000
+	const GLint levels = min(chain, max_level + 1);
+	const GLint copied_levels = min(defined_levels, levels);
+	//
+	GLuint texID;
+	glGenTextures(1, &texID);
+	ctx.bindTexture(0, GL_TEXTURE_2D_ARRAY, texID);
+	{
+		const NNPixelFormat format = textures[0]->m_format;
+		for (GLint level = 0; level < levels; ++level)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internal_format, max(width >> level, 1u), max(height >> level, 1u), (GLsizei)textures.size(), 0,
+				GetGLFormat(format), GetGLType(format), nullptr);
+		}
+		// 与文件载入的 Texture2D 相同的默认参数
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+	ctx.bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+	// 显存内拷贝, 不经过 CPU
+	for (NNUInt layer = 0; layer < textures.size(); ++layer)
+	{
+		for (GLint level = 0; level < copied_levels; ++level)
+		{
+			glCopyImageSubData(textures[layer]->mTextureID, GL_TEXTURE_2D, level, 0, 0, 0, texID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+				max(width >> level, 1u), max(height >> level, 1u), 1);
+		}
+	}
+	// 源纹理缺少的层由拷贝的层生成
+	if (copied_levels < levels)
+	{
+		ctx.bindTexture(0, GL_TEXTURE_2D_ARRAY, texID);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		ctx.bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+	}
+	//
+	TextureArray* result = new TextureArray();
+	result->m_texture = texID;
+	result->m_width = width;
+	result->m_height = height;
+	result->m_layer_num = (NNUInt)textures.size();
+	return shared_ptr<TextureArray>(result);
+}
+
+void TextureArray::Use(const NNUInt& slot)
+{
+	RenderContext::instance().bindTexture(slot, GL_TEXTURE_2D_ARRAY, m_texture);
+}
+
+#endif // NENE_GL
@@ -0,0 +1,368 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include "Debug.h"
+#include "TextureCache.h"
+
+using namespace std;
+
+/** File Layout >>> */
+
+//
+//  [FileHeader][MipRecord * mip_num][padding to 16] then each mip:
+//  [layer 0][layer 1]...[layer n-1]
+//
+
+static const uint32_t TEXTURE_CACHE_MAGIC = 0x58544e4e; // "NNTX"
+// 3: 记录源文件的修改时间
+static const uint32_t TEXTURE_CACHE_VERSION = 3;
+static const uint32_t TEXTURE_CACHE_ALIGNMENT = 16;
+
+struct FileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t source_hash;
+	uint64_t source_size;
+	// 所有源文件中最新的修改时间
+	uint64_t source_mtime;
+	uint32_t source_num;
+	uint32_t format;
+	uint32_t bpp;
+	uint32_t width;
+	uint32_t height;
+	uint32_t layer_num;
+	uint32_t mip_num;
+	uint32_t _padding;
+};
+
+struct MipRecord
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t layer_num;
+	uint32_t _padding;
+	uint64_t offset;
+	uint64_t layer_size;
+};
+
+// 所有源文件内容的散列
+static bool HashSources(const vector<vector<string>>& sources, NNULong& hash)
+{
+	hash = 0xcbf29ce484222325ULL;
+	for (const vector<string>& level : sources)
+	{
+		for (const string& source : level)
+		{
+			shared_ptr<MappedFile> file = MappedFile::Open(source.c_str());
+			if (file == nullptr)
+			{
+				return false;
+			}
+			hash = IO::Hash(file->Data(), file->Size(), hash);
+		}
+	}
+	return true;
+}
+
+// 源文件的总大小和最新的修改时间, 只读取文件信息
+static bool StampSources(const vector<vector<string>>& sources, NNULong& size, NNULong& mtime)
+{
+	size = 0;
+	mtime = 0;
+	for (const vector<string>& level : sources)
+	{
+		for (const string& source : level)
+		{
+			NNULong file_size, file_mtime;
+			if (!IO::GetFileStamp(source.c_str(), file_size, file_mtime))
+			{
+				return false;
+			}
+			size += file_size;
+			mtime = max(mtime, file_mtime);
+		}
+	}
+	return true;
+}
+
+// 内容没有变化时只更新缓存中记录的修改时间, 失败时下次打开再计算散列
+static void RestampCache(const string& cachepath, const NNULong mtime)
+{
+	FILE* file = fopen(cachepath.c_str(), "r+b");
+	if (file == nullptr)
+	{
+		return;
+	}
+	const uint64_t value = mtime;
+	if (fseek(file, (long)offsetof(FileHeader, source_mtime), SEEK_SET) == 0)
+	{
+		fwrite(&value, sizeof(value), 1, file);
+	}
+	fclose(file);
+}
+
+static NNUInt CountSources(const vector<vector<string>>& sources)
+{
+	NNUInt count = 0;
+	for (const vector<string>& level : sources)
+	{
+		count += (NNUInt)level.size();
+	}
+	return count;
+}
+
+/** File Layout <<< */
+
+string TextureCache::GetCachePath(const vector<vector<string>>& sources)
+{
+	if (CountSources(sources) == 0)
+	{
+		return string();
+	}
+	if (sources.size() == 1 && sources[0].size() == 1)
+	{
+		return sources[0][0] + ".nntex";
+	}
+	// 同一个文件可能同时作为单张纹理和体纹理的切片, 用路径列表和层级结构区分
+	NNULong hash = 0xcbf29ce484222325ULL;
+	for (const vector<string>& level : sources)
+	{
+		const NNUInt layer_num = (NNUInt)level.size();
+		hash = IO::Hash(&layer_num, sizeof(layer_num), hash);
+		for (const string& source : level)
+		{
+			hash = IO::Hash(source.data(), source.size() + 1, hash);
+		}
+	}
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%016llx.nntex", (unsigned long long)hash);
+	for (const vector<string>& level : sources)
+	{
+		if (!level.empty())
+		{
+			return level[0] + suffix;
+		}
+	}
+	return string();
+}
+
+shared_ptr<TextureCache> TextureCache::Open(const vector<vector<string>>& sources)
+{
+	//
+	string cachepath = GetCachePath(sources);
+	if (cachepath.empty())
+	{
+		return nullptr;
+	}
+	shared_ptr<MappedFile> file = MappedFile::Open(cachepath.c_str());
+	if (file == nullptr || file->Size() < sizeof(FileHeader))
+	{
+		return nullptr;
+	}
+	// 校验文件头
+	const NNByte* base = file->Data();
+	const size_t size = file->Size();
+	const FileHeader* header = (const FileHeader*)base;
+	if (header->magic != TEXTURE_CACHE_MAGIC || header->version != TEXTURE_CACHE_VERSION || header->source_num != CountSources(sources) || header->mip_num != sources.size())
+	{
+		dLog("[Info] Texture cache is outdated. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	// 校验源文件: 大小和修改时间相同时认为没有变化, 否则再比较内容
+	NNULong source_size, source_mtime;
+	if (!StampSources(sources, source_size, source_mtime) || source_size != header->source_size)
+	{
+		dLog("[Info] Texture cache does not match source files. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	if (source_mtime != header->source_mtime)
+	{
+		NNULong source_hash;
+		if (!HashSources(sources, source_hash) || source_hash != header->source_hash)
+		{
+			dLog("[Info] Texture cache does not match source files. (%s)", cachepath.c_str());
+			return nullptr;
+		}
+		// 先解除映射再写入, 然后重新映射
+		file = nullptr;
+		RestampCache(cachepath, source_mtime);
+		file = MappedFile::Open(cachepath.c_str());
+		if (file == nullptr || file->Size() != size)
+		{
+			return nullptr;
+		}
+		base = file->Data();
+		header = (const FileHeader*)base;
+	}
+	//
+	if (sizeof(FileHeader) + header->mip_num * sizeof(MipRecord) > size)
+	{
+		dLog("[Error] Broken texture cache. (%s)", cachepath.c_str());
+		return nullptr;
+	}
+	const MipRecord* records = (const MipRecord*)(base + sizeof(FileHeader));
+	//
+	shared_ptr<TextureCache> result(new TextureCache());
+	result->m_file = file;
+	result->m_format = (NNPixelFormat)header->format;
+	result->m_bpp = header->bpp;
+	result->m_levels.resize(header->mip_num);
+	for (NNUInt mip = 0; mip < header->mip_num; ++mip)
+	{
+		const MipRecord& record = records[mip];
+		if (record.layer_num != sources[mip].size() || record.offset + record.layer_size * record.layer_num > size)
+		{
+			dLog("[Error] Broken texture cache. (%s)", cachepath.c_str());
+			return nullptr;
+		}
+		Level& level = result->m_levels[mip];
+		level.width = record.width;
+		level.height = record.height;
+		level.layer_num = record.layer_num;
+		level.layer_size = (size_t)record.layer_size;
+		level.data = base + record.offset;
+	}
+	return result;
+}
+
+bool TextureCache::Write(const vector<vector<string>>& sources, const vector<vector<Texture::Image>>& images)
+{
+	//
+	if (images.empty() || images[0].empty() || images.size() != sources.size())
+	{
+		return false;
+	}
+	const Texture::Image& first = images[0][0];
+	// 检查格式
+	for (size_t mip = 0; mip < images.size(); ++mip)
+	{
+		const vector<Texture::Image>& level = images[mip];
+		if (level.empty() || level.size() != sources[mip].size())
+		{
+			return false;
+		}
+		for (const Texture::Image& image : level)
+		{
+			if (image.data == nullptr || image.format != first.format || image.bpp != first.bpp ||
+				image.width != level[0].width || image.height != level[0].height)
+			{
+				return false;
+			}
+		}
+	}
+	// 计算布局
+	vector<MipRecord> records(images.size());
+	size_t offset = sizeof(FileHeader) + images.size() * sizeof(MipRecord);
+	offset = (offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~size_t(TEXTURE_CACHE_ALIGNMENT - 1);
+	for (size_t mip = 0; mip < images.size(); ++mip)
+	{
+		MipRecord& record = records[mip];
+		memset(&record, 0, sizeof(MipRecord));
+		record.width = images[mip][0].width;
+		record.height = images[mip][0].height;
+		record.layer_num = (uint32_t)images[mip].size();
+		record.layer_size = (uint64_t)record.width * record.height * (first.bpp / 8);
+		record.offset = offset;
+		offset += (size_t)(record.layer_size * record.layer_num);
+		offset = (offset + TEXTURE_CACHE_ALIGNMENT - 1) & ~size_t(TEXTURE_CACHE_ALIGNMENT - 1);
+	}
+	// 写入数据
+	vector<NNByte> blob(offset, 0);
+	FileHeader* header = (FileHeader*)blob.data();
+	header->magic = TEXTURE_CACHE_MAGIC;
+	header->version = TEXTURE_CACHE_VERSION;
+	NNULong source_hash, source_size, source_mtime;
+	if (!HashSources(sources, source_hash) || !StampSources(sources, source_size, source_mtime))
+	{
+		return false;
+	}
+	header->source_hash = source_hash;
+	header->source_size = source_size;
+	header->source_mtime = source_mtime;
+	header->source_num = CountSources(sources);
+	header->format = (uint32_t)first.format;
+	header->bpp = first.bpp;
+	header->width = first.width;
+	header->height = first.height;
+	header->layer_num = (uint32_t)images[0].size();
+	header->mip_num = (uint32_t)images.size();
+	memcpy(blob.data() + sizeof(FileHeader), records.data(), records.size() * sizeof(MipRecord));
+	for (size_t mip = 0; mip < images.size(); ++mip)
+	{
+		for (size_t layer = 0; layer < images[mip].size(); ++layer)
+		{
+			memcpy(blob.data() + records[mip].offset + records[mip].layer_size * layer, images[mip][layer].data.get(), (size_t)records[mip].layer_size);
+		}
+	}
+	//
+	string cachepath = GetCachePath(sources);
+	if (!IO::SaveBinaryFile(cachepath.c_str(), blob.data(), blob.size()))
+	{
+		dLog("[Error] Failed to write texture cache. (%s)", cachepath.c_str());
+		return false;
+	}
+	dLog("[Info] Texture cache written. (%s)", cachepath.c_str());
+	return true;
+}
+
+vector<vector<Texture::Image>> TextureCache::GetImages()
+{
+	shared_ptr<TextureCache> self = shared_from_this();
+	vector<vector<Texture::Image>> result(m_levels.size());
+	for (size_t mip = 0; mip < m_levels.size(); ++mip)
+	{
+		const Level& level = m_levels[mip];
+		for (NNUInt layer = 0; layer < level.layer_num; ++layer)
+		{
+			Texture::Image image;
+			// 共享所有权: 图片数据存活期间映射不会被释放
+			image.data = shared_ptr<NNByte[]>(self, const_cast<NNByte*>(level.data + level.layer_size * layer));
+			image.width = level.width;
+			image.height = level.height;
+			image.bpp = m_bpp;
+			image.format = m_format;
+			result[mip].push_back(image);
+		}
+	}
+	return result;
+}
+
+vector<vector<Texture::Image>> TextureCache::Load(const vector<vector<string>>& sources)
+{
+	//
+	shared_ptr<TextureCache> cache = Open(sources);
+	if (cache != nullptr)
+	{
+		return cache->GetImages();
+	}
+	// 每级一个批次, 所有文件并行解码
+	vector<shared_ptr<Texture::ImageBatch>> batches;
+	for (const vector<string>& level : sources)
+	{
+		batches.push_back(Texture::CreateImageBatch(level));
+	}
+	bool decoded = Texture::DecodeImageBatches(batches);
+	//
+	vector<vector<Texture::Image>> images(sources.size());
+	for (size_t mip = 0; mip < sources.size(); ++mip)
+	{
+		for (NNUInt idx = 0; idx < sources[mip].size(); ++idx)
+		{
+			images[mip].push_back(batches[mip] != nullptr ? batches[mip]->GetImage(idx) : Texture::Image());
+			if (images[mip].back().data == nullptr)
+			{
+				dLog("[Error] Broken image data! Could not load texture(%s)\n", sources[mip][idx].c_str());
+			}
+		}
+	}
+	if (decoded)
+	{
+		Write(sources, images);
+	}
+	return images;
+}
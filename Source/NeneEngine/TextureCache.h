@@ -0,0 +1,59 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "IO.h"
+#include "Texture.h"
+
+//
+//    TextureCache: Cooked texture container (.nntex) holding the decoded, GPU-native mip chain
+//
+
+class TextureCache : public std::enable_shared_from_this<TextureCache>
+{
+public:
+	// 一级 mipmap, 所有层在映射内存中连续存放
+	struct Level
+	{
+		NNUInt width, height;
+		NNUInt layer_num;
+		size_t layer_size;
+		const NNByte* data;
+	};
+
+public:
+	// 源文件按 sources[mip][layer] 组织
+	// 缓存文件路径: 单个源文件时为 <源文件>.nntex, 多个时附加路径散列
+	static std::string GetCachePath(const std::vector<std::vector<std::string>>& sources);
+	// 打开缓存, 版本, 层级结构或源文件不匹配时返回空指针; 源文件的大小和修改时间没变时不读取内容
+	static std::shared_ptr<TextureCache> Open(const std::vector<std::vector<std::string>>& sources);
+	// 写入缓存, images 与 sources 结构一致, 格式一致, 同一级尺寸一致
+	static bool Write(const std::vector<std::vector<std::string>>& sources, const std::vector<std::vector<Texture::Image>>& images);
+	// 优先读取缓存, 未命中时解码源文件并写入缓存, 失败的图片数据为空
+	static std::vector<std::vector<Texture::Image>> Load(const std::vector<std::vector<std::string>>& sources);
+
+public:
+	//
+	inline NNPixelFormat GetFormat() const { return m_format; }
+	inline NNUInt GetBitsPerPixel() const { return m_bpp; }
+	inline const std::vector<Level>& GetLevels() const { return m_levels; }
+	// 转为 Image, 数据直接指向映射内存 (并持有缓存)
+	std::vector<std::vector<Texture::Image>> GetImages();
+
+private:
+	std::shared_ptr<MappedFile> m_file;
+	NNPixelFormat m_format;
+	NNUInt m_bpp;
+	std::vector<Level> m_levels;
+
+private:
+	TextureCache() = default;
+	TextureCache(const TextureCache& rhs) = delete;
+	TextureCache& operator=(const TextureCache& rhs) = delete;
+};
+
+#endif // TEXTURE_CACHE_H
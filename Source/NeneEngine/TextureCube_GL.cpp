@@ -3,6 +3,10 @@
 
 #include "TextureCube.h"
 #include "Texture2D.h"
+#include "Debug.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
 
 enum CubeMapBias {
 	BIAS_RIGHT = 0,
@@ -27,39 +31,37 @@ shared_ptr<TextureCube> TextureCube::Create(
 	const NNChar* filepathFront, const NNChar* filepathBack
 ) 
 {
-	//
-
-	NNPixelFormat format;
-	GLuint bpp, width, height;
-	std::shared_ptr<NNByte[]> imageData[CubeMapBiasNum];
-	//
-	imageData[BIAS_RIGHT] = LoadImage(filepathRight, width, height, bpp, format);
-	imageData[BIAS_LEFT] = LoadImage(filepathLeft, width, height, bpp, format);
-	imageData[BIAS_TOP] = LoadImage(filepathTop, width, height, bpp, format);
-	imageData[BIAS_BOTTOM] = LoadImage(filepathBottom, width, height, bpp, format);
-	imageData[BIAS_BACK] = LoadImage(filepathBack, width, height, bpp, format);
-	imageData[BIAS_FRONT] = LoadImage(filepathFront, width, height, bpp, format);
+	NN_RENDER_THREAD_FORWARD(Create(filepathTop, filepathBottom, filepathLeft, filepathRight, filepathFront, filepathBack));
+	// 六个面一起检查尺寸和格式, 并行解码到同一块内存
+	vector<string> filepaths(CubeMapBiasNum);
+	filepaths[BIAS_RIGHT] = filepathRight;
+	filepaths[BIAS_LEFT] = filepathLeft;
+	filepaths[BIAS_TOP] = filepathTop;
+	filepaths[BIAS_BOTTOM] = filepathBottom;
+	filepaths[BIAS_BACK] = filepathBack;
+	filepaths[BIAS_FRONT] = filepathFront;
+	shared_ptr<ImageBatch> batch = CreateImageBatch(filepaths);
+	if (batch == nullptr || !DecodeImageBatches({ batch }))
+	{
+		dLog("[Error] TextureCube requires all textures has same height, width and format!\n");
+		return nullptr;
+	}
+	const NNPixelFormat format = batch->format;
 	//
 	GLuint texID;
 	glGenTextures(1, &texID);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, texID);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_CUBE_MAP, texID);
 	for (unsigned int i = 0; i < CubeMapBiasNum; ++i) 
 	{
-		if (imageData[i] != nullptr) 
-		{
-			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GetGLInternalFormat(format), width, height, 0, GetGLFormat(format), GetGLType(format), imageData[i].get());
-		}
-		else {
-			glDeleteTextures(1, &texID);
-			return nullptr;
-		}
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GetGLInternalFormat(format), batch->width, batch->height, 0, GetGLFormat(format), GetGLType(format), batch->data.get() + batch->image_size * i);
+		RenderStats::Add(NN_COUNTER_TEXTURE_BYTES, batch->image_size);
 	}
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	RenderContext::instance().bindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
 	//
 	TextureCube* ret = new TextureCube();
 	ret->mTextureID = texID;
@@ -68,8 +70,7 @@ shared_ptr<TextureCube> TextureCube::Create(
 
 void TextureCube::Use(const NNUInt& slot) 
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, mTextureID);
+	RenderContext::instance().bindTexture(slot, GL_TEXTURE_CUBE_MAP, mTextureID);
 }
 
 #endif // NENE_GL
\ No newline at end of file
@@ -0,0 +1,171 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <atomic>
+#include <algorithm>
+#include "ThreadPool.h"
+
+using namespace std;
+
+// ParallelFor 的共享状态, 晚到的工作线程取不到下标会直接返回
+struct ParallelForState
+{
+	function<void(NNUInt)> task;
+	NNUInt count;
+	atomic<NNUInt> next;
+	NNUInt done;
+	mutex done_mutex;
+	condition_variable done_condition;
+};
+
+static void RunParallelFor(ParallelForState& state)
+{
+	NNUInt finished = 0;
+	for (NNUInt idx = state.next++; idx < state.count; idx = state.next++)
+	{
+		state.task(idx);
+		++finished;
+	}
+	if (finished > 0)
+	{
+		lock_guard<mutex> lock(state.done_mutex);
+		state.done += finished;
+		if (state.done == state.count)
+		{
+			state.done_condition.notify_all();
+		}
+	}
+}
+
+// 工作线程的编号
+static thread_local NNInt tWorkerIndex = -1;
+
+ThreadPool::ThreadPool() : m_next_queue(0), m_pending(0), m_stopping(false)
+{
+	// 留一个核给主线程
+	NNUInt num = thread::hardware_concurrency();
+	num = num > 1 ? num - 1 : 1;
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		m_queues.emplace_back(new WorkQueue());
+	}
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+	for (thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::Instance()
+{
+	static ThreadPool instance;
+	return instance;
+}
+
+NNInt ThreadPool::GetWorkerIndex()
+{
+	return tWorkerIndex;
+}
+
+void ThreadPool::Push(function<void()>&& task)
+{
+	const NNInt worker = tWorkerIndex;
+	const NNUInt index = worker >= 0 ? (NNUInt)worker : m_next_queue++ % (NNUInt)m_queues.size();
+	{
+		lock_guard<mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(move(task));
+	}
+	// 计数在 m_mutex 下修改, 保证等待中的线程不会错过唤醒
+	{
+		lock_guard<mutex> lock(m_mutex);
+		++m_pending;
+	}
+	m_condition.notify_one();
+}
+
+bool ThreadPool::Pop(const NNUInt index, function<void()>& task)
+{
+	const NNUInt num = (NNUInt)m_queues.size();
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		WorkQueue& queue = *m_queues[(index + i) % num];
+		lock_guard<mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+		{
+			continue;
+		}
+		// 自己的队列取最新的任务, 数据还在缓存中; 窃取时取最早的任务, 通常是较大的一块
+		if (i == 0)
+		{
+			task = move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::WorkerLoop(const NNUInt index)
+{
+	tWorkerIndex = (NNInt)index;
+	while (true)
+	{
+		function<void()> task;
+		if (Pop(index, task))
+		{
+			{
+				lock_guard<mutex> lock(m_mutex);
+				--m_pending;
+			}
+			task();
+			continue;
+		}
+		unique_lock<mutex> lock(m_mutex);
+		m_condition.wait(lock, [this]() { return m_stopping || m_pending > 0; });
+		if (m_stopping && m_pending == 0)
+		{
+			return;
+		}
+	}
+}
+
+void ThreadPool::ParallelFor(const NNUInt count, const function<void(NNUInt)>& task)
+{
+	//
+	if (count == 0)
+	{
+		return;
+	}
+	shared_ptr<ParallelForState> state = make_shared<ParallelForState>();
+	state->task = task;
+	state->count = count;
+	state->next = 0;
+	state->done = 0;
+	// 只提交需要的辅助任务, 调用线程自己也是一个执行者
+	// 在工作线程中调用时辅助任务进入自己的队列, 由空闲的线程窃取
+	NNUInt helpers = min(count - 1, (NNUInt)m_workers.size());
+	for (NNUInt i = 0; i < helpers; ++i)
+	{
+		Push([state]() { RunParallelFor(*state); });
+	}
+	RunParallelFor(*state);
+	// 只等待已经领取下标的执行者
+	unique_lock<mutex> lock(state->done_mutex);
+	state->done_condition.wait(lock, [&]() { return state->done == state->count; });
+}
@@ -0,0 +1,80 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <future>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "Types.h"
+
+//
+//    ThreadPool: A singleton work-stealing pool of worker threads for CPU side jobs (must not touch the graphics context)
+//
+
+class ThreadPool
+{
+public:
+	// 获取单例
+	static ThreadPool& Instance();
+	// 提交任务, 返回结果的 future
+	template<typename F>
+	auto Submit(F&& task) -> std::future<decltype(task())>;
+	// 并行执行 task(0) ... task(count - 1), 调用线程也参与执行, 在工作线程中调用也不会死锁
+	void ParallelFor(const NNUInt count, const std::function<void(NNUInt)>& task);
+	// 工作线程数
+	inline NNUInt GetWorkerNum() const { return (NNUInt)m_workers.size(); }
+	// 当前线程在池中的编号, 不是工作线程时返回 -1
+	static NNInt GetWorkerIndex();
+
+public:
+	~ThreadPool();
+
+private:
+	// 每个工作线程一个队列: 自己从尾部取 (后进先出), 空闲时从其它队列头部窃取
+	struct WorkQueue
+	{
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+
+private:
+	void WorkerLoop(const NNUInt index);
+	// 工作线程放进自己的队列, 其它线程轮流分给各个队列
+	void Push(std::function<void()>&& task);
+	bool Pop(const NNUInt index, std::function<void()>& task);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::atomic<NNUInt> m_next_queue;
+	// 所有队列中的任务数, 用于休眠和唤醒
+	NNUInt m_pending;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stopping;
+
+private:
+	ThreadPool();
+	ThreadPool(const ThreadPool& rhs) = delete;
+	ThreadPool& operator=(const ThreadPool& rhs) = delete;
+};
+
+template<typename F>
+auto ThreadPool::Submit(F&& task) -> std::future<decltype(task())>
+{
+	using R = decltype(task());
+	// std::function 需要可拷贝, 用 shared_ptr 包一层
+	auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+	std::future<R> result = packaged->get_future();
+	Push([packaged]() { (*packaged)(); });
+	return result;
+}
+
+#endif // THREAD_POOL_H
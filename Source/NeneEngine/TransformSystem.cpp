@@ -0,0 +1,411 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include "Debug.h"
+#include "ThreadPool.h"
+#include "TransformSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define NN_TRANSFORM_SSE
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// 每个并行任务处理的节点数
+static const NNUInt PARALLEL_CHUNK = 1024;
+
+// 列主序矩阵相乘, 结果的每一列是 a 的四列的线性组合
+static inline void Multiply(const NNMat4& a, const NNMat4& b, NNMat4& out)
+{
+#if defined NN_TRANSFORM_SSE
+	const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+	const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+	const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+	const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+	for (NNUInt col = 0; col < 4; ++col)
+	{
+		const NNFloat* b_col = &b[col][0];
+		__m128 result = _mm_mul_ps(a0, _mm_set1_ps(b_col[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b_col[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b_col[2])));
+		result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b_col[3])));
+		_mm_storeu_ps(&out[col][0], result);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+// T * R * S, 直接由四元数写出旋转部分
+static inline void Compose(const NNVec3& position, const NNQuat& rotation, const NNVec3& scale, NNMat4& out)
+{
+	const NNFloat x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+	const NNFloat xx = x * x, yy = y * y, zz = z * z;
+	const NNFloat xy = x * y, xz = x * z, yz = y * z;
+	const NNFloat wx = w * x, wy = w * y, wz = w * z;
+	out[0] = NNVec4((1.0f - 2.0f * (yy + zz)) * scale.x, 2.0f * (xy + wz) * scale.x, 2.0f * (xz - wy) * scale.x, 0.0f);
+	out[1] = NNVec4(2.0f * (xy - wz) * scale.y, (1.0f - 2.0f * (xx + zz)) * scale.y, 2.0f * (yz + wx) * scale.y, 0.0f);
+	out[2] = NNVec4(2.0f * (xz + wy) * scale.z, 2.0f * (yz - wx) * scale.z, (1.0f - 2.0f * (xx + yy)) * scale.z, 0.0f);
+	out[3] = NNVec4(position, 1.0f);
+}
+
+TransformSystem::TransformSystem() : m_dead_num(0), m_updated_num(0), m_order_dirty(false)
+{
+	// 0 号句柄保留为无效句柄
+	m_slots.push_back(0);
+	m_levels.push_back(0);
+}
+
+TransformSystem::~TransformSystem()
+{}
+
+TransformSystem& TransformSystem::Instance()
+{
+	static TransformSystem instance;
+	return instance;
+}
+
+TransformSystem::Handle TransformSystem::Create(const Handle parent)
+{
+	//
+	Handle handle;
+	if (!m_free_handles.empty())
+	{
+		handle = m_free_handles.back();
+		m_free_handles.pop_back();
+	}
+	else
+	{
+		handle = (Handle)m_slots.size();
+		m_slots.push_back(0);
+	}
+	// 追加在末尾, 父节点一定在前面; 深度比末尾小时需要重新排列
+	const NNUInt index = (NNUInt)m_handles.size();
+	const NNInt parent_index = parent != INVALID_HANDLE ? (NNInt)m_slots[parent] : -1;
+	const NNUInt depth = parent_index >= 0 ? m_depths[parent_index] + 1 : 0;
+	if (!m_depths.empty() && depth < m_depths.back())
+	{
+		m_order_dirty = true;
+	}
+	m_positions.emplace_back(0.0f, 0.0f, 0.0f);
+	m_rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+	m_scales.emplace_back(1.0f, 1.0f, 1.0f);
+	m_locals.push_back(NNMat4Identity);
+	m_worlds.push_back(NNMat4Identity);
+	m_parents.push_back(parent_index);
+	m_depths.push_back(depth);
+	m_versions.push_back(0);
+	m_parent_versions.push_back(0);
+	m_flags.push_back(FLAG_DIRTY);
+	m_handles.push_back(handle);
+	m_slots[handle] = index;
+	return handle;
+}
+
+void TransformSystem::Destroy(const Handle handle)
+{
+	if (handle == INVALID_HANDLE)
+	{
+		return;
+	}
+	// 下一次 Update 时才移除 (Utils::Update 每帧调用), 句柄可以立即复用
+	m_flags[m_slots[handle]] |= FLAG_DEAD;
+	m_slots[handle] = 0;
+	m_free_handles.push_back(handle);
+	++m_dead_num;
+}
+
+void TransformSystem::SetParent(const Handle handle, const Handle parent)
+{
+	const NNUInt index = m_slots[handle];
+	NNInt parent_index = -1;
+	if (parent != INVALID_HANDLE)
+	{
+		parent_index = (NNInt)m_slots[parent];
+		for (NNInt ancestor = parent_index; ancestor >= 0; ancestor = m_parents[ancestor])
+		{
+			if (ancestor == (NNInt)index)
+			{
+				dLog("[Error] A transform cannot be parented to its own descendant.\n");
+				return;
+			}
+		}
+	}
+	m_parents[index] = parent_index;
+	m_flags[index] |= FLAG_DIRTY;
+	// 深度和顺序在 Update 时重新计算
+	m_order_dirty = true;
+}
+
+TransformSystem::Handle TransformSystem::GetParent(const Handle handle) const
+{
+	const NNInt parent = m_parents[m_slots[handle]];
+	return parent >= 0 && !(m_flags[parent] & FLAG_DEAD) ? m_handles[parent] : INVALID_HANDLE;
+}
+
+void TransformSystem::SetPosition(const Handle handle, const NNVec3& position)
+{
+	const NNUInt index = m_slots[handle];
+	m_positions[index] = position;
+	m_flags[index] = (m_flags[index] | FLAG_DIRTY) & ~FLAG_EXPLICIT;
+}
+
+void TransformSystem::SetRotation(const Handle handle, const NNQuat& rotation)
+{
+	const NNUInt index = m_slots[handle];
+	m_rotations[index] = rotation;
+	m_flags[index] = (m_flags[index] | FLAG_DIRTY) & ~FLAG_EXPLICIT;
+}
+
+void TransformSystem::SetScale(const Handle handle, const NNVec3& scale)
+{
+	const NNUInt index = m_slots[handle];
+	m_scales[index] = scale;
+	m_flags[index] = (m_flags[index] | FLAG_DIRTY) & ~FLAG_EXPLICIT;
+}
+
+void TransformSystem::SetLocalMatrix(const Handle handle, const NNMat4& local)
+{
+	const NNUInt index = m_slots[handle];
+	m_locals[index] = local;
+	m_flags[index] |= FLAG_DIRTY | FLAG_EXPLICIT;
+}
+
+const NNMat4& TransformSystem::GetLocalMatrix(const Handle handle)
+{
+	const NNUInt index = m_slots[handle];
+	if (m_flags[index] & FLAG_DIRTY)
+	{
+		Ensure(index);
+	}
+	return m_locals[index];
+}
+
+const NNMat4& TransformSystem::GetWorldMatrix(const Handle handle)
+{
+	const NNUInt index = m_slots[handle];
+	Ensure(index);
+	return m_worlds[index];
+}
+
+NNUInt TransformSystem::GetVersion(const Handle handle)
+{
+	const NNUInt index = m_slots[handle];
+	Ensure(index);
+	return m_versions[index];
+}
+
+void TransformSystem::Compute(const NNUInt index)
+{
+	const NNByte flags = m_flags[index];
+	if ((flags & FLAG_DIRTY) && !(flags & FLAG_EXPLICIT))
+	{
+		Compose(m_positions[index], m_rotations[index], m_scales[index], m_locals[index]);
+	}
+	const NNInt parent = m_parents[index];
+	if (parent >= 0)
+	{
+		Multiply(m_worlds[parent], m_locals[index], m_worlds[index]);
+		m_parent_versions[index] = m_versions[parent];
+	}
+	else
+	{
+		m_worlds[index] = m_locals[index];
+	}
+	++m_versions[index];
+	m_flags[index] = flags & ~FLAG_DIRTY;
+}
+
+void TransformSystem::Ensure(const NNUInt index)
+{
+	// 常见的根节点直接判断
+	if (m_parents[index] < 0)
+	{
+		if (m_flags[index] & FLAG_DIRTY)
+		{
+			Compute(index);
+		}
+		return;
+	}
+	// 从最上层的祖先开始向下更新
+	NNUInt chain[64];
+	NNUInt length = 0;
+	for (NNInt i = (NNInt)index; i >= 0; i = m_parents[i])
+	{
+		// 父节点已销毁时立即变为根节点
+		const NNInt parent = m_parents[i];
+		if (parent >= 0 && (m_flags[parent] & FLAG_DEAD))
+		{
+			m_parents[i] = -1;
+			m_flags[i] |= FLAG_DIRTY;
+		}
+		if (length == 64)
+		{
+			// 过深的层级先更新上半部分
+			Ensure((NNUInt)i);
+			break;
+		}
+		chain[length++] = (NNUInt)i;
+	}
+	while (length > 0)
+	{
+		const NNUInt i = chain[--length];
+		if (IsStale(i))
+		{
+			Compute(i);
+		}
+	}
+}
+
+void TransformSystem::Update()
+{
+	//
+	if (m_order_dirty || m_dead_num > 0)
+	{
+		Rebuild();
+	}
+	else if (m_levels.back() != m_handles.size())
+	{
+		// 只有按深度追加的新节点, 重新划分层即可
+		m_levels.assign(1, 0);
+		for (NNUInt i = 1; i <= m_depths.size(); ++i)
+		{
+			if (i == m_depths.size() || m_depths[i] != m_depths[i - 1])
+			{
+				m_levels.push_back(i);
+			}
+		}
+	}
+	// 父节点所在的层已经更新完
+	atomic<NNUInt> updated(0);
+	for (NNUInt level = 0; level + 1 < m_levels.size(); ++level)
+	{
+		const NNUInt begin = m_levels[level], end = m_levels[level + 1];
+		auto update_range = [this, &updated](const NNUInt first, const NNUInt last) {
+			NNUInt count = 0;
+			for (NNUInt i = first; i < last; ++i)
+			{
+				if (IsStale(i))
+				{
+					Compute(i);
+					++count;
+				}
+			}
+			updated += count;
+		};
+		if (end - begin < PARALLEL_THRESHOLD)
+		{
+			update_range(begin, end);
+			continue;
+		}
+		const NNUInt chunks = (end - begin + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+		ThreadPool::Instance().ParallelFor(chunks, [&](NNUInt chunk) {
+			const NNUInt first = begin + chunk * PARALLEL_CHUNK;
+			update_range(first, min(first + PARALLEL_CHUNK, end));
+		});
+	}
+	m_updated_num = updated;
+}
+
+void TransformSystem::Rebuild()
+{
+	const NNUInt num = (NNUInt)m_handles.size();
+	// 父节点销毁的节点变为根节点
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		const NNInt parent = m_parents[i];
+		if (parent >= 0 && (m_flags[parent] & FLAG_DEAD))
+		{
+			m_parents[i] = -1;
+			m_flags[i] |= FLAG_DIRTY;
+		}
+	}
+	// 计算深度
+	vector<NNInt> depths(num, -1);
+	vector<NNUInt> stack;
+	NNUInt max_depth = 0;
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		NNUInt node = i;
+		while (depths[node] < 0 && m_parents[node] >= 0 && depths[m_parents[node]] < 0)
+		{
+			stack.push_back(node);
+			node = (NNUInt)m_parents[node];
+		}
+		if (depths[node] < 0)
+		{
+			depths[node] = m_parents[node] >= 0 ? depths[m_parents[node]] + 1 : 0;
+		}
+		while (!stack.empty())
+		{
+			const NNUInt child = stack.back();
+			stack.pop_back();
+			depths[child] = depths[m_parents[child]] + 1;
+		}
+		max_depth = max(max_depth, (NNUInt)depths[i]);
+	}
+	// 按深度计数排序, 同一层保持原来的顺序
+	vector<NNUInt> offsets(max_depth + 2, 0);
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		if (!(m_flags[i] & FLAG_DEAD))
+		{
+			++offsets[depths[i] + 1];
+		}
+	}
+	for (NNUInt level = 1; level < offsets.size(); ++level)
+	{
+		offsets[level] += offsets[level - 1];
+	}
+	m_levels = offsets;
+	while (m_levels.size() > 1 && m_levels[m_levels.size() - 2] == m_levels.back())
+	{
+		m_levels.pop_back();
+	}
+	const NNUInt alive = offsets.back();
+	vector<NNInt> remap(num, -1);
+	vector<NNUInt> order(alive);
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		if (!(m_flags[i] & FLAG_DEAD))
+		{
+			const NNUInt target = offsets[depths[i]]++;
+			remap[i] = (NNInt)target;
+			order[target] = i;
+		}
+	}
+	// 按新顺序搬运所有数组
+	auto permute = [&order, alive](auto& values) {
+		typename std::remove_reference<decltype(values)>::type result(alive);
+		for (NNUInt i = 0; i < alive; ++i)
+		{
+			result[i] = values[order[i]];
+		}
+		values.swap(result);
+	};
+	permute(m_positions);
+	permute(m_rotations);
+	permute(m_scales);
+	permute(m_locals);
+	permute(m_worlds);
+	permute(m_parents);
+	permute(m_versions);
+	permute(m_parent_versions);
+	permute(m_flags);
+	permute(m_handles);
+	m_depths.resize(alive);
+	for (NNUInt i = 0; i < alive; ++i)
+	{
+		if (m_parents[i] >= 0)
+		{
+			m_parents[i] = remap[m_parents[i]];
+		}
+		m_depths[i] = (NNUInt)depths[order[i]];
+		m_slots[m_handles[i]] = i;
+	}
+	m_dead_num = 0;
+	m_order_dirty = false;
+}
@@ -0,0 +1,107 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <vector>
+
+#include "Types.h"
+
+//
+//    TransformSystem: Quaternion TRS transforms stored as structure-of-arrays, parents before children, updated in batches
+//
+
+class TransformSystem
+{
+public:
+	// 句柄在变换销毁前保持不变, 0 为无效句柄
+	typedef NNUInt Handle;
+	static const Handle INVALID_HANDLE = 0;
+	// 单层节点数超过该值时分发到线程池
+	static const NNUInt PARALLEL_THRESHOLD = 4096;
+
+public:
+	// 获取单例, 只在主线程使用
+	static TransformSystem& Instance();
+	// 新建单位变换
+	Handle Create(const Handle parent = INVALID_HANDLE);
+	// 子节点变为根节点
+	void Destroy(const Handle handle);
+	// 不允许成环, parent 为无效句柄时成为根节点
+	void SetParent(const Handle handle, const Handle parent);
+	Handle GetParent(const Handle handle) const;
+	// 局部变换
+	void SetPosition(const Handle handle, const NNVec3& position);
+	void SetRotation(const Handle handle, const NNQuat& rotation);
+	void SetScale(const Handle handle, const NNVec3& scale);
+	inline NNVec3 GetPosition(const Handle handle) const { return m_positions[m_slots[handle]]; }
+	inline NNQuat GetRotation(const Handle handle) const { return m_rotations[m_slots[handle]]; }
+	inline NNVec3 GetScale(const Handle handle) const { return m_scales[m_slots[handle]]; }
+	// 直接指定局部矩阵, 之后再设置 TRS 时以 TRS 为准
+	void SetLocalMatrix(const Handle handle, const NNMat4& local);
+	// 返回的引用在下一次 Create 或 Update 之前有效
+	const NNMat4& GetLocalMatrix(const Handle handle);
+	// 只更新该变换及其祖先, 返回的引用在下一次 Create 或 Update 之前有效
+	const NNMat4& GetWorldMatrix(const Handle handle);
+	// 世界矩阵每次重新计算时递增
+	NNUInt GetVersion(const Handle handle);
+	// 移除销毁的变换并按层更新所有过期的世界矩阵, 同一层内可以并行; Utils::Update 每帧调用一次
+	void Update();
+	//
+	inline NNUInt GetTransformNum() const { return (NNUInt)m_handles.size() - m_dead_num; }
+	// 上一次 Update 重新计算的变换数
+	inline NNUInt GetUpdatedNum() const { return m_updated_num; }
+
+public:
+	~TransformSystem();
+
+private:
+	enum Flag : NNByte
+	{
+		FLAG_DIRTY = 1 << 0,
+		FLAG_EXPLICIT = 1 << 1,
+		FLAG_DEAD = 1 << 2,
+	};
+
+private:
+	// 局部变换被修改或父节点的世界矩阵更新过
+	inline bool IsStale(const NNUInt index) const
+	{
+		const NNInt parent = m_parents[index];
+		return (m_flags[index] & FLAG_DIRTY) || (parent >= 0 && m_parent_versions[index] != m_versions[parent]);
+	}
+	// 父节点已经是最新时计算一个节点
+	void Compute(const NNUInt index);
+	// 递归更新祖先后计算
+	void Ensure(const NNUInt index);
+	// 去掉销毁的节点并按深度重新排列
+	void Rebuild();
+
+private:
+	// 按深度排列的稠密数组
+	std::vector<NNVec3> m_positions;
+	std::vector<NNQuat> m_rotations;
+	std::vector<NNVec3> m_scales;
+	std::vector<NNMat4> m_locals;
+	std::vector<NNMat4> m_worlds;
+	std::vector<NNInt> m_parents;
+	std::vector<NNUInt> m_depths;
+	std::vector<NNUInt> m_versions;
+	std::vector<NNUInt> m_parent_versions;
+	std::vector<NNByte> m_flags;
+	std::vector<Handle> m_handles;
+	// 每层在稠密数组中的起点, 最后一个为总数
+	std::vector<NNUInt> m_levels;
+	// 句柄 -> 稠密下标
+	std::vector<NNUInt> m_slots;
+	std::vector<Handle> m_free_handles;
+	NNUInt m_dead_num;
+	NNUInt m_updated_num;
+	bool m_order_dirty;
+
+private:
+	TransformSystem();
+	TransformSystem(const TransformSystem& rhs) = delete;
+	TransformSystem& operator=(const TransformSystem& rhs) = delete;
+};
+
+#endif // TRANSFORM_SYSTEM_H
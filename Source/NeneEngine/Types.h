@@ -25,6 +25,20 @@ enum NNVertexFormat {
 	NNVertexFormatNum = 5
 };
 
+// 顶点属性语义
+enum NNVertexSemantic {
+	NN_SEMANTIC_POSITION = 0, NN_SEMANTIC_NORMAL, NN_SEMANTIC_TEXCOORD, NN_SEMANTIC_TANGENT, NN_SEMANTIC_COLOR,
+	NNVertexSemanticNum
+};
+
+// 顶点属性的分量类型
+enum NNAttributeType {
+	NN_ATTRIBUTE_FLOAT = 0, NN_ATTRIBUTE_HALF, NN_ATTRIBUTE_SHORT, NN_ATTRIBUTE_UNSIGNED_SHORT, NN_ATTRIBUTE_UNSIGNED_BYTE,
+	// x, y, z 各 10 位, w 2 位的有符号打包格式
+	NN_ATTRIBUTE_INT_2_10_10_10,
+	NNAttributeTypeNum
+};
+
 // 纹理种类
 enum NNTextureType {
 	//
@@ -78,6 +92,33 @@ enum NNVertexOrder {
 	NNVertexOrderNum
 };
 
+// 模型导入选项
+enum NNMeshImportFlag {
+	NN_IMPORT_DEFAULT = 0,
+	// 不读取烘焙缓存, 强制重新导入 (导入后仍会重写缓存)
+	NN_IMPORT_IGNORE_CACHE = 1 << 0,
+	// 在工作线程中并行转换网格和解码纹理, 只在主线程创建图形资源
+	NN_IMPORT_PARALLEL = 1 << 1,
+	// .obj 文件使用引擎内置的解析器代替 Assimp
+	NN_IMPORT_NATIVE_OBJ = 1 << 2,
+	// 使用 16 字节的紧凑顶点格式 (CompactVertexLayout) 上传
+	NN_IMPORT_COMPACT_VERTICES = 1 << 3,
+	// 导入后按后变换缓存重排三角形, 再按首次使用重排顶点
+	NN_IMPORT_OPTIMIZE_VERTEX_CACHE = 1 << 4,
+	// 在缓存优化的基础上按簇排序以减少过度绘制
+	NN_IMPORT_OPTIMIZE_OVERDRAW = 1 << 5,
+};
+
+// 网格数据在内存中的驻留方式
+enum NNMeshResidency {
+	// 上传后释放 CPU 数据, 需要时从缓存或显存换入
+	NN_RESIDENCY_GPU_ONLY = 0,
+	// 保留完整的顶点和索引
+	NN_RESIDENCY_CPU_GPU,
+	// 只保留位置和 16/32 位索引, 用于拾取和包围盒等查询
+	NN_RESIDENCY_CPU_COMPACT,
+};
+
 // 连接字符串
 #define CONNECTION2(text1, text2) text1##text2
 #define CONNECT2(text1, text2) CONNECTION2(text1, text2)
@@ -93,6 +134,7 @@ enum NNVertexOrder {
 	#include "GLM/gtc/matrix_transform.hpp"
 	#include "GLM/gtc/type_ptr.hpp"
 	#include "GLM/gtc/epsilon.hpp"
+	#include "GLM/gtc/quaternion.hpp"
 	#include "GLM/gtx/rotate_vector.hpp"
 	#include "GLM/gtx/vector_angle.hpp"
 	#include "GLM/gtx/intersect.hpp"
@@ -110,6 +152,7 @@ enum NNVertexOrder {
 	typedef glm::vec4 NNVec4;
 	typedef glm::mat4 NNMat4;
 	typedef glm::mat3 NNMat3;
+	typedef glm::quat NNQuat;
 
 	// Math Functions
 	#define NNMat4Identity glm::mat4(1.0f)
@@ -119,6 +162,7 @@ enum NNVertexOrder {
 	#define NNCreateRotationY(mat, angle) glm::rotate(mat, angle, NNVec3(0.0f, 1.0f, 0.0f))
 	#define NNCreateRotationZ(mat, angle) glm::rotate(mat, angle, NNVec3(0.0f, 0.0f, 1.0f))
 	#define NNCreateScale(scaleVec) glm::scale(NNMat4Identity, scaleVec)
+	#define NNQuatAngleAxis(angle, axis) glm::angleAxis(angle, axis)
 	#define NNCreateLookAt(position, target, up) glm::lookAt(position, target, up)
 	#define NNCreatePerspective(fov, ratio, near, far) glm::perspective(fov, ratio, near, far)
 	#define NNCreateOrtho(left, right, bottom, top, near, far) glm::ortho(left, right, bottom, top, near, far)
@@ -167,6 +211,17 @@ enum NNVertexOrder {
 		INCREASE_WRAP = GL_INCR_WRAP,
 		DECREASE_WRAP = GL_DECR_WRAP
 	};
+	// 混合因子
+	enum NNBlendFactor {
+		BLEND_ZERO = GL_ZERO,
+		BLEND_ONE = GL_ONE,
+		BLEND_SRC_COLOR = GL_SRC_COLOR,
+		BLEND_ONE_MINUS_SRC_COLOR = GL_ONE_MINUS_SRC_COLOR,
+		BLEND_SRC_ALPHA = GL_SRC_ALPHA,
+		BLEND_ONE_MINUS_SRC_ALPHA = GL_ONE_MINUS_SRC_ALPHA,
+		BLEND_DST_ALPHA = GL_DST_ALPHA,
+		BLEND_ONE_MINUS_DST_ALPHA = GL_ONE_MINUS_DST_ALPHA,
+	};
 	//
 	#define NNWindow GLFWwindow*
 	//
@@ -194,6 +249,7 @@ enum NNVertexOrder {
 	typedef DirectX::SimpleMath::Vector3 NNVec3;
 	typedef DirectX::SimpleMath::Vector4 NNVec4;
 	typedef DirectX::SimpleMath::Matrix NNMat4;
+	typedef DirectX::SimpleMath::Quaternion NNQuat;
 
 	// Math Functions
 	#define NNMat4Identity DirectX::SimpleMath::Matrix::Identity()
@@ -203,6 +259,7 @@ enum NNVertexOrder {
 	#define NNCreateRotationY(mat, angle) mat * DirectX::SimpleMath::Matrix::CreateRotationY(angle)
 	#define NNCreateRotationZ(mat, angle) mat * DirectX::SimpleMath::Matrix::CreateRotationZ(angle)
 	#define NNCreateScale(scale) DirectX::SimpleMath::Matrix::CreateScale(scale)
+	#define NNQuatAngleAxis(angle, axis) DirectX::SimpleMath::Quaternion::CreateFromAxisAngle(axis, angle)
 	#define NNCreateLookAt(position, target, up) DirectX::SimpleMath::Matrix::CreateLookAt(position, target, up)
 	#define NNCreatePerspective(fov, ratio, nearplane, farplane) DirectX::SimpleMath::Matrix::CreatePerspectiveFieldOfView(fov, ratio, nearplane, farplane)
 	#define NNCreateOrtho(left, right, bottom, top, nearplane, farplane) DirectX::SimpleMath::Matrix::CreateOrthographicOffCenter(left, right, bottom, top, nearplane, farplane)
@@ -244,6 +301,17 @@ enum NNVertexOrder {
 		INCREASE_WRAP = D3D11_STENCIL_OP_INCR,
 		DECREASE_WRAP = D3D11_STENCIL_OP_DECR
 	};
+	// 混合因子
+	enum NNBlendFactor {
+		BLEND_ZERO = D3D11_BLEND_ZERO,
+		BLEND_ONE = D3D11_BLEND_ONE,
+		BLEND_SRC_COLOR = D3D11_BLEND_SRC_COLOR,
+		BLEND_ONE_MINUS_SRC_COLOR = D3D11_BLEND_INV_SRC_COLOR,
+		BLEND_SRC_ALPHA = D3D11_BLEND_SRC_ALPHA,
+		BLEND_ONE_MINUS_SRC_ALPHA = D3D11_BLEND_INV_SRC_ALPHA,
+		BLEND_DST_ALPHA = D3D11_BLEND_DEST_ALPHA,
+		BLEND_ONE_MINUS_DST_ALPHA = D3D11_BLEND_INV_DEST_ALPHA,
+	};
 	// 窗口类型
 	#define NNWindow HWND
 	// 键盘映射
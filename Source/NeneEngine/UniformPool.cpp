@@ -0,0 +1,118 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cstring>
+#include <algorithm>
+#include "Debug.h"
+#include "UniformPool.h"
+
+using namespace std;
+
+static inline NNUInt AlignBlock(const NNUInt size)
+{
+	return (size + UniformPool::BLOCK_ALIGNMENT - 1) / UniformPool::BLOCK_ALIGNMENT * UniformPool::BLOCK_ALIGNMENT;
+}
+
+UniformPool::UniformPool() : m_allocated_bytes(0), m_uploaded_bytes(0)
+{}
+
+UniformPool::~UniformPool()
+{
+	// 单例析构时上下文已经销毁, 图形资源由 Release 释放
+}
+
+UniformPool& UniformPool::Instance()
+{
+	static UniformPool instance;
+	return instance;
+}
+
+UniformPool::Block UniformPool::Allocate(const NNUInt size)
+{
+	//
+	Block block = { 0, 0, 0 };
+	if (size == 0)
+	{
+		dLog("[Error] Allocating an empty uniform block.\n");
+		return block;
+	}
+	const NNUInt aligned = AlignBlock(size);
+	m_allocated_bytes += aligned;
+	// 优先复用同样大小的空闲块
+	auto it = m_free_blocks.find(aligned);
+	if (it != m_free_blocks.end() && !it->second.empty())
+	{
+		block = it->second.back();
+		it->second.pop_back();
+		block.size = size;
+		return block;
+	}
+	// 从已有的 Arena 中切分
+	for (NNUInt i = 0; i < (NNUInt)m_arenas.size(); ++i)
+	{
+		Arena& arena = m_arenas[i];
+		if (arena.used + aligned <= arena.capacity)
+		{
+			block = { i, arena.used, size };
+			arena.used += aligned;
+			return block;
+		}
+	}
+	// 新建 Arena, 之前分配的块地址不变
+	Arena arena;
+	arena.capacity = aligned > ARENA_SIZE ? aligned : ARENA_SIZE;
+	arena.data.reset(new NNByte[arena.capacity]);
+	memset(arena.data.get(), 0, arena.capacity);
+	arena.used = aligned;
+	arena.dirty_begin = arena.capacity;
+	arena.dirty_end = 0;
+	arena.buffer = 0;
+	m_arenas.push_back(move(arena));
+	block = { (NNUInt)m_arenas.size() - 1, 0, size };
+	return block;
+}
+
+void UniformPool::Free(Block& block)
+{
+	if (block.IsValid() && block.arena < m_arenas.size())
+	{
+		const NNUInt aligned = AlignBlock(block.size);
+		m_free_blocks[aligned].push_back(block);
+		m_allocated_bytes -= aligned;
+	}
+	block = { 0, 0, 0 };
+}
+
+void UniformPool::Write(const Block& block, const void* data, const NNUInt offset, const NNUInt size)
+{
+	//
+	if (!block.IsValid() || block.arena >= m_arenas.size() || offset + size > block.size)
+	{
+		dLog("[Error] Invalid uniform block write: offset %u, size %u.\n", offset, size);
+		return;
+	}
+	Arena& arena = m_arenas[block.arena];
+	const NNUInt begin = block.offset + offset;
+	if (data != nullptr)
+	{
+		memcpy(arena.data.get() + begin, data, size);
+	}
+	arena.dirty_begin = min(arena.dirty_begin, begin);
+	arena.dirty_end = max(arena.dirty_end, begin + size);
+}
+
+NNByte* UniformPool::Data(const Block& block)
+{
+	if (!block.IsValid() || block.arena >= m_arenas.size())
+	{
+		return nullptr;
+	}
+	return m_arenas[block.arena].data.get() + block.offset;
+}
+
+void UniformPool::Flush()
+{
+	for (Arena& arena : m_arenas)
+	{
+		Upload(arena);
+	}
+}
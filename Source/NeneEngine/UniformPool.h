@@ -0,0 +1,85 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef UNIFORM_POOL_H
+#define UNIFORM_POOL_H
+
+#include <map>
+#include <vector>
+#include <memory>
+
+#include "Types.h"
+
+//
+//    UniformPool: A singleton sub-allocating aligned uniform blocks from shared arenas, uploading only dirty ranges
+//
+
+class UniformPool
+{
+public:
+	// 池中的一块常量, size 为 0 时无效
+	struct Block
+	{
+		NNUInt arena;
+		NNUInt offset;
+		NNUInt size;
+		inline bool IsValid() const { return size > 0; }
+	};
+	// 每块的起始对齐, 不小于常见实现的 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	static const NNUInt BLOCK_ALIGNMENT = 256;
+	// 每个 Arena 的大小, 超过的块单独使用一个 Arena
+	static const NNUInt ARENA_SIZE = 64 * 1024;
+
+public:
+	// 获取单例
+	static UniformPool& Instance();
+	// 分配一块常量, 只在内存中分配, 不需要图形上下文
+	Block Allocate(const NNUInt size);
+	// 归还到空闲链表, 同样大小的块会被复用
+	void Free(Block& block);
+	// 写入并记录脏区间, 在 Bind 或 Flush 时上传
+	void Write(const Block& block, const void* data, const NNUInt offset, const NNUInt size);
+	template<typename T>
+	inline void Write(const Block& block, const T& data) { Write(block, &data, 0, sizeof(T)); }
+	// 块在内存中的地址, 直接修改后需要调用 Write(block, nullptr, ...) 标记脏区间
+	NNByte* Data(const Block& block);
+	// 上传所在 Arena 的脏区间并绑定到 slot; size 为 0 时绑定整个块
+	void Bind(const Block& block, const NNUInt slot, const NNUInt size = 0);
+	// 上传所有 Arena 的脏区间, 由 Utils::Update 每帧调用
+	void Flush();
+	// 释放图形资源, 由 Utils::Terminate 调用; 已分配的块仍然有效
+	void Release();
+	//
+	inline NNUInt GetArenaNum() const { return (NNUInt)m_arenas.size(); }
+	inline size_t GetAllocatedBytes() const { return m_allocated_bytes; }
+	inline size_t GetUploadedBytes() const { return m_uploaded_bytes; }
+
+public:
+	~UniformPool();
+
+private:
+	struct Arena
+	{
+		std::unique_ptr<NNByte[]> data;
+		NNUInt capacity;
+		NNUInt used;
+		// 脏区间 [dirty_begin, dirty_end)
+		NNUInt dirty_begin;
+		NNUInt dirty_end;
+		NNUInt buffer;
+	};
+	// 上传一个 Arena 的脏区间, 第一次上传时创建缓冲
+	void Upload(Arena& arena);
+
+private:
+	std::vector<Arena> m_arenas;
+	// 按对齐后的大小索引的空闲块
+	std::map<NNUInt, std::vector<Block>> m_free_blocks;
+	size_t m_allocated_bytes;
+	size_t m_uploaded_bytes;
+
+private:
+	UniformPool();
+	UniformPool(const UniformPool& rhs) = delete;
+	UniformPool& operator=(const UniformPool& rhs) = delete;
+};
+
+#endif // UNIFORM_POOL_H
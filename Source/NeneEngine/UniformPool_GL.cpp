@@ -0,0 +1,79 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include "Debug.h"
+#include "UniformPool.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
+#include "RenderStats.h"
+
+using namespace std;
+
+// 渲染线程运行时数据先拷贝到命令流, 执行时再上传
+static void UploadUniforms(const GLuint buffer, const bool allocate, const size_t offset, const void* data, const size_t size)
+{
+	RenderStats::Add(NN_COUNTER_UNIFORM_BYTES, size);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	if (allocate)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformPool::Upload(Arena& arena)
+{
+	//
+	if (arena.buffer == 0)
+	{
+		// 第一次使用时整体上传
+		arena.buffer = RenderThread::Invoke([]() {
+			GLuint buffer = 0;
+			glGenBuffers(1, &buffer);
+			return buffer;
+		});
+		RenderThread::RecordData(&UploadUniforms, arena.data.get(), arena.capacity, arena.buffer, true, (size_t)0);
+		m_uploaded_bytes += arena.capacity;
+	}
+	else if (arena.dirty_begin < arena.dirty_end)
+	{
+		RenderThread::RecordData(&UploadUniforms, arena.data.get() + arena.dirty_begin, arena.dirty_end - arena.dirty_begin, arena.buffer, false, arena.dirty_begin);
+		m_uploaded_bytes += arena.dirty_end - arena.dirty_begin;
+	}
+	arena.dirty_begin = arena.capacity;
+	arena.dirty_end = 0;
+}
+
+void UniformPool::Bind(const Block& block, const NNUInt slot, const NNUInt size)
+{
+	//
+	if (!block.IsValid() || block.arena >= m_arenas.size())
+	{
+		dLog("[Error] Binding an invalid uniform block to slot %u.\n", slot);
+		return;
+	}
+	Arena& arena = m_arenas[block.arena];
+	Upload(arena);
+	RenderContext::instance().bindUniformBuffer(slot, arena.buffer, block.offset, size > 0 ? size : block.size);
+}
+
+void UniformPool::Release()
+{
+	// 只释放缓冲, 内存中的块继续有效, 重新初始化后第一次使用时整体上传
+	NN_RENDER_THREAD_FORWARD(Release());
+	for (Arena& arena : m_arenas)
+	{
+		if (arena.buffer != 0)
+		{
+			RenderContext::instance().forgetBuffer(arena.buffer);
+			glDeleteBuffers(1, &arena.buffer);
+		}
+		arena.buffer = 0;
+	}
+}
+
+#endif // NENE_GL
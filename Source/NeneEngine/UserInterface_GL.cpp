@@ -1,8 +1,15 @@
 ﻿/*Copyright reserved by KenLee@2018 hellokenlee@163.com*/
 #ifdef NENE_GL
 
+#include <deque>
+#include <cstring>
 #include "Utils.h"
+#include "Profiler.h"
+#include "DebugLayer.h"
 #include "UserInterface.h"
+#include "RenderStats.h"
+#include "RenderThread.h"
+#include "RenderContext.h"
 
 #include "ImGui/imgui.h"
 #include "ImGui/imconfig.h"
@@ -25,16 +32,83 @@ function<void()> UserInterface::s_default_draw_function = []() {
 		ImGui::Text("%.2f ms/frame (%.0f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 	}
 	ImGui::End();
+	//
+	Profiler::Instance().DrawPanel();
+	RenderStats::Instance().DrawPanel();
 };
 
 /** Static Memeber Initialization <<< */
 
+// 渲染线程运行时录制的绘制数据: 在主线程拷贝和释放 (ImGui 的内存分配不是线程安全的), 渲染线程只读取
+struct RecordedDrawData
+{
+	NNUInt frame;
+	ImVec2 display_size;
+	ImVec2 framebuffer_scale;
+	vector<unique_ptr<ImDrawList>> lists;
+	vector<ImDrawList*> pointers;
+	ImDrawData draw_data;
+};
+
+static deque<unique_ptr<RecordedDrawData>> s_recorded_draw_data;
+
+template<typename T>
+static void CopyImVector(ImVector<T>& dst, const ImVector<T>& src)
+{
+	dst.resize(src.Size);
+	if (src.Size > 0)
+	{
+		memcpy(dst.Data, src.Data, src.Size * sizeof(T));
+	}
+}
+
+static void RecordDrawLists(ImDrawData* draw_data)
+{
+	//
+	RenderThread& render_thread = RenderThread::Instance();
+	const NNUInt completed = render_thread.GetCompletedFrameNum();
+	while (!s_recorded_draw_data.empty() && s_recorded_draw_data.front()->frame < completed)
+	{
+		s_recorded_draw_data.pop_front();
+	}
+	//
+	ImGuiIO& io = ImGui::GetIO();
+	unique_ptr<RecordedDrawData> recorded(new RecordedDrawData());
+	recorded->frame = render_thread.GetSubmittedFrameNum();
+	recorded->display_size = io.DisplaySize;
+	recorded->framebuffer_scale = io.DisplayFramebufferScale;
+	for (int n = 0; n < draw_data->CmdListsCount; ++n)
+	{
+		const ImDrawList* source = draw_data->CmdLists[n];
+		ImDrawList* list = new ImDrawList(nullptr);
+		CopyImVector(list->CmdBuffer, source->CmdBuffer);
+		CopyImVector(list->IdxBuffer, source->IdxBuffer);
+		CopyImVector(list->VtxBuffer, source->VtxBuffer);
+		recorded->lists.emplace_back(list);
+		recorded->pointers.push_back(list);
+	}
+	recorded->draw_data.Valid = true;
+	recorded->draw_data.CmdLists = recorded->pointers.data();
+	recorded->draw_data.CmdListsCount = draw_data->CmdListsCount;
+	recorded->draw_data.TotalVtxCount = draw_data->TotalVtxCount;
+	recorded->draw_data.TotalIdxCount = draw_data->TotalIdxCount;
+	//
+	RecordedDrawData* data = recorded.get();
+	RenderThread::Defer([data]() {
+		ImGui_ImplGlfwGL3_RenderDrawData(&data->draw_data, data->display_size, data->framebuffer_scale);
+	});
+	s_recorded_draw_data.push_back(move(recorded));
+}
+
 UserInterface::~UserInterface()
 {
 	--s_instance_num;
 	if (s_instance_num == 0)
 	{
-		ImGui_ImplGlfwGL3_Shutdown();
+		// 同步调用会先执行完录制的绘制, 之后才能释放绘制数据
+		RenderThread::Invoke([]() { ImGui_ImplGlfwGL3_InvalidateDeviceShapes(); });
+		s_recorded_draw_data.clear();
+		ImGui::Shutdown();
 	}
 }
 
@@ -60,18 +134,34 @@ shared_ptr<UserInterface> UserInterface::Create(function<void()> newfunc)
 }
 
 void UserInterface::Draw() {
+	NN_DEBUG_GROUP("UserInterface");
+	NN_PROFILE_ZONE("UserInterface");
+	// 多边形模式从状态缓存中读取, 不查询驱动
+	RenderContext& ctx = RenderContext::instance();
+	const GLenum oldPolygonMode = ctx.getPolygonMode();
 	//
-	static GLint oldPolygonMode;
-	glGetIntegerv(GL_POLYGON_MODE, &oldPolygonMode);
-	//
-	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	ctx.polygonMode(GL_FILL);
+	// 渲染线程运行时在渲染线程上创建字体纹理, 绘制数据拷贝后录制
+	ImGuiIO& io = ImGui::GetIO();
+	if (RenderThread::IsRecording())
+	{
+		if (io.Fonts->TexID == nullptr)
+		{
+			RenderThread::Invoke([]() { ImGui_ImplGlfwGL3_CreateDeviceShapes(); });
+		}
+		io.RenderDrawListsFn = RecordDrawLists;
+	}
+	else
+	{
+		io.RenderDrawListsFn = ImGui_ImplGlfwGL3_RenderDrawLists;
+	}
 	//!TODO: Set render state for just gui
 	ImGui_ImplGlfwGL3_NewFrame();
 	m_draw_function();
 	//
 	ImGui::Render();
 	//!TODO: Reset render state for just gui
-	glPolygonMode(GL_FRONT_AND_BACK, oldPolygonMode);
+	ctx.polygonMode(oldPolygonMode);
 }
 
 #endif
\ No newline at end of file
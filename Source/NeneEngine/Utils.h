@@ -10,8 +10,8 @@
 
 class Utils {
 public:
-	// 初始化一个窗口
-	static void Init(const NNChar* name, NNUInt width, NNUInt height);
+	// 初始化一个窗口, render_thread 为真时图形调用录制后在渲染线程上执行 (仅 OpenGL)
+	static void Init(const NNChar* name, NNUInt width, NNUInt height, const bool render_thread = false);
 	// 终止和清理
 	static void Terminate();
 	// 轮询IO
@@ -6,6 +6,8 @@
 #include "Mouse.h"
 #include "NeneCB.h"
 #include "Keyboard.h"
+#include "RenderStats.h"
+#include "TransformSystem.h"
 
 #include <string>
 #include <ctime>
@@ -213,7 +215,7 @@ BOOL Utils::D3dInit() {
 	return res;
 }
 
-void Utils::Init(const NNChar* name, NNUInt width, NNUInt height) {
+void Utils::Init(const NNChar* name, NNUInt width, NNUInt height, const bool render_thread) {
 	//
 	terminate();
 	// 提示输出
@@ -258,6 +260,8 @@ void Utils::Terminate() {
 	mpContext = nullptr;
 	mpDSBuffer = nullptr;
 	mpSwapChain = nullptr;
+	// 输出剩余的日志
+	Logger::Instance().Flush();
 }
 
 void Utils::PollEvents() {
@@ -288,6 +292,8 @@ void Utils::Update() {
 	CB.PerFrame().data.currTime = currTime;
 	CB.PerFrame().data.sinTime = sinTime;
 	CB.PerFrame().data.cosTime = cosTime;
+	// 回收上一帧销毁的变换, 没有使用 FrameBuilder 时数组也不会一直增长
+	TransformSystem::Instance().Update();
 }
 
 void Utils::SetWindowShouldClose(bool flag) {
@@ -321,6 +327,7 @@ void Utils::Clear() {
 
 void Utils::SwapBuffers() {
 	mpSwapChain->Present(1, 0);
+	RenderStats::Instance().EndFrame();
 }
 
 NNUInt Utils::GetWindowWidth() {
@@ -4,6 +4,16 @@
 #include "Debug.h"
 #include "Utils.h"
 #include "NeneCB.h"
+#include "Profiler.h"
+#include "DebugLayer.h"
+#include "ResourceLoader.h"
+#include "ConstantRing.h"
+#include "UniformPool.h"
+#include "GeometryArena.h"
+#include "RenderThread.h"
+#include "RenderStats.h"
+#include "RenderContext.h"
+#include "TransformSystem.h"
 
 // 静态成员初始化
 GLFWwindow* Utils::mpWindow = nullptr;
@@ -22,7 +32,7 @@ void showEnviroment() {
 	printf("    GLFW %s\n\n", glfwGetVersionString());
 }
 
-void Utils::Init(const NNChar* name, NNUInt width, NNUInt height) {
+void Utils::Init(const NNChar* name, NNUInt width, NNUInt height, const bool render_thread) {
 	//
 	Utils::Terminate();
 	// 提示输出
@@ -36,6 +46,8 @@ void Utils::Init(const NNChar* name, NNUInt width, NNUInt height) {
 	// glfwWindowHint(GLFW_SAMPLES, 4);
 	// 不允许Resize
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+	// 调试上下文才会报告全部的验证消息
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, NN_GL_VALIDATION > 0 ? GL_TRUE : GL_FALSE);
 	// 创建窗口
 	mpWindow = glfwCreateWindow(width, height, name, nullptr, nullptr);
 	// 检查是否成功
@@ -63,32 +75,45 @@ void Utils::Init(const NNChar* name, NNUInt width, NNUInt height) {
 		printf("[Error]: Fail to init GLEW\n");
 		exit(-1);
 	}
-	//
-	glEnable(GL_DEPTH_TEST);
-	glDepthFunc(GL_LEQUAL);
+	// 新的上下文, 状态缓存全部未知
+	RenderContext& ctx = RenderContext::instance();
+	ctx.invalidate();
+	ctx.enable(GL_DEPTH_TEST, true);
+	ctx.depthFunc(GL_LEQUAL);
 	glEnable(GL_TEXTURE_3D);
 	glEnable(GL_TEXTURE_2D);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	ctx.enable(GL_BLEND, true);
+	ctx.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
 	// 忽略由glew引起的INVALID_ENUM错误
 	glGetError();
-	//
-#if NNDEBUG > 0
-	glEnable(GL_DEBUG_OUTPUT);
-	glDebugMessageCallback(_dMessageCallback, nullptr);
-#endif
+	// 验证层, 运行时可以用 DebugLayer::SetMode 切换
+	DebugLayer::Init();
 	// 设置视点
-	glViewport(0, 0, width, height);
+	ctx.viewport(0, 0, width, height);
 	// 输出信息
 	dCall(showEnviroment());
+	// 上下文交给渲染线程, 之后的图形调用都录制到命令流
+	if (render_thread) {
+		RenderThread::Instance().Start(mpWindow);
+	}
 }
 
 void Utils::Terminate() {
 	if (mpWindow != nullptr) {
+		// 执行完所有命令, 上下文交回主线程后再释放资源
+		RenderThread::Instance().Stop();
+		ResourceLoader::Instance().Release();
+		ConstantRing::Instance().Release();
+		UniformPool::Instance().Release();
+		GeometryArena::Instance().Release();
+		Profiler::Instance().Release();
 		glfwDestroyWindow(mpWindow);
 		glfwTerminate();
+		RenderContext::instance().invalidate();
 		mpWindow = nullptr;
+		// 输出剩余的日志
+		Logger::Instance().Flush();
 	}
 	mWinHeight = 0;
 	mWinWidth = 0;
@@ -110,6 +135,15 @@ void Utils::Update() {
 	CB.PerFrame().Data().curr_time = currTime;
 	CB.PerFrame().Data().sin_time = sinTime;
 	CB.PerFrame().Data().cos_time = cosTime;
+	// 在预算内处理异步资源的上传
+	{
+		NN_PROFILE_ZONE("ResourceLoader");
+		ResourceLoader::Instance().Update();
+	}
+	// 每帧一次上传常量池的脏区间
+	UniformPool::Instance().Flush();
+	// 回收上一帧销毁的变换, 没有使用 FrameBuilder 时数组也不会一直增长
+	TransformSystem::Instance().Update();
 }
 
 bool Utils::WindowShouldClose() {
@@ -125,23 +159,32 @@ void Utils::ClearColor(NNFloat r, NNFloat g, NNFloat b) {
 	mBGColor[1] = g;
 	mBGColor[2] = b;
 	mBGColor[3] = 1.0f;
-	glClearColor(r, g, b, 1.0f);
+	RenderThread::Record([](GLfloat red, GLfloat green, GLfloat blue) { glClearColor(red, green, blue, 1.0f); }, r, g, b);
 }
 
 void Utils::Clear() 
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	RenderThread::Record([]() { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); });
 }
 
 void Utils::Clear(const NNFloat& r, const NNFloat& g, const  NNFloat& b, const NNFloat& a)
 {
-	glClearColor(r, g, b, a);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glClearColor(mBGColor[0], mBGColor[1], mBGColor[2], mBGColor[3]);
+	RenderThread::Record([](GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha, GLfloat red0, GLfloat green0, GLfloat blue0, GLfloat alpha0) {
+		glClearColor(red, green, blue, alpha);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClearColor(red0, green0, blue0, alpha0);
+	}, r, g, b, a, mBGColor[0], mBGColor[1], mBGColor[2], mBGColor[3]);
 }
 
 void Utils::SwapBuffers() {
-	glfwSwapBuffers(mpWindow);
+	// 帧结束的时间戳在交换之前
+	Profiler::Instance().EndFrame();
+	RenderThread::Record(glfwSwapBuffers, mpWindow);
+	ConstantRing::Instance().EndFrame();
+	RenderContext::instance().endFrame();
+	RenderStats::Instance().EndFrame();
+	// 提交本帧的命令, 渲染线程上最多有一帧未执行完
+	RenderThread::Instance().EndFrame();
 }
 
 NNUInt Utils::GetWindowWidth() {
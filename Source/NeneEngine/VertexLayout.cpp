@@ -0,0 +1,220 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+
+#include <cmath>
+#include "VertexLayout.h"
+
+using namespace std;
+
+/** Encoding >>> */
+
+uint16_t VertexEncoding::FloatToHalf(const NNFloat value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const uint32_t magnitude = bits & 0x7fffffff;
+	// Inf / NaN
+	if (magnitude >= 0x7f800000)
+	{
+		return (uint16_t)(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+	}
+	// 溢出
+	if (magnitude >= 0x47800000)
+	{
+		return (uint16_t)(sign | 0x7c00);
+	}
+	// 非规格化数
+	if (magnitude < 0x38800000)
+	{
+		const uint32_t exponent = magnitude >> 23;
+		if (exponent < 102)
+		{
+			return (uint16_t)sign;
+		}
+		const uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+		const uint32_t shift = 126 - exponent;
+		uint32_t result = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (result & 1)))
+		{
+			++result;
+		}
+		return (uint16_t)(sign | result);
+	}
+	// 重新偏置指数, 就近舍入到偶数 (进位可能溢出到 Inf)
+	uint32_t result = (magnitude - 0x38000000) >> 13;
+	const uint32_t remainder = magnitude & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+	{
+		++result;
+	}
+	return (uint16_t)(sign | result);
+}
+
+NNFloat VertexEncoding::HalfToFloat(const uint16_t value)
+{
+	const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1f;
+	const uint32_t mantissa = value & 0x3ff;
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		const NNFloat result = ldexpf((NNFloat)mantissa, -24);
+		return sign ? -result : result;
+	}
+	else if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	NNFloat result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+int16_t VertexEncoding::FloatToSNorm16(const NNFloat value)
+{
+	const NNFloat clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	return (int16_t)lroundf(clamped * 32767.0f);
+}
+
+NNFloat VertexEncoding::SNorm16ToFloat(const int16_t value)
+{
+	const NNFloat result = value / 32767.0f;
+	return result < -1.0f ? -1.0f : result;
+}
+
+uint16_t VertexEncoding::FloatToUNorm16(const NNFloat value)
+{
+	const NNFloat clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (uint16_t)lroundf(clamped * 65535.0f);
+}
+
+NNFloat VertexEncoding::UNorm16ToFloat(const uint16_t value)
+{
+	return value / 65535.0f;
+}
+
+uint8_t VertexEncoding::FloatToUNorm8(const NNFloat value)
+{
+	const NNFloat clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (uint8_t)lroundf(clamped * 255.0f);
+}
+
+NNFloat VertexEncoding::UNorm8ToFloat(const uint8_t value)
+{
+	return value / 255.0f;
+}
+
+uint32_t VertexEncoding::PackSNorm1010102(const NNVec4& value)
+{
+	auto pack = [](const NNFloat v, const NNFloat scale, const uint32_t mask) {
+		const NNFloat clamped = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+		return (uint32_t)(int32_t)lroundf(clamped * scale) & mask;
+	};
+	return pack(value.x, 511.0f, 0x3ff) | (pack(value.y, 511.0f, 0x3ff) << 10) |
+		(pack(value.z, 511.0f, 0x3ff) << 20) | (pack(value.w, 1.0f, 0x3) << 30);
+}
+
+NNVec4 VertexEncoding::UnpackSNorm1010102(const uint32_t value)
+{
+	// 符号扩展后按 GL 的规则归一化
+	auto unpack = [](const uint32_t bits, const NNUInt width) {
+		const int32_t shift = 32 - (int32_t)width;
+		const int32_t v = (int32_t)(bits << shift) >> shift;
+		const NNFloat result = (NNFloat)v / (NNFloat)((1 << (width - 1)) - 1);
+		return result < -1.0f ? -1.0f : result;
+	};
+	return NNVec4(unpack(value & 0x3ff, 10), unpack((value >> 10) & 0x3ff, 10), unpack((value >> 20) & 0x3ff, 10), unpack(value >> 30, 2));
+}
+
+NNVec2 VertexEncoding::EncodeOctahedral(const NNVec3& normal)
+{
+	const NNFloat l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (l1 == 0.0f)
+	{
+		return NNVec2(0.0f, 0.0f);
+	}
+	const NNFloat x = normal.x / l1;
+	const NNFloat y = normal.y / l1;
+	if (normal.z >= 0.0f)
+	{
+		return NNVec2(x, y);
+	}
+	// 下半球折叠到外侧的四个三角形
+	return NNVec2((1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f), (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f));
+}
+
+NNVec3 VertexEncoding::DecodeOctahedral(const NNVec2& value)
+{
+	NNFloat x = value.x;
+	NNFloat y = value.y;
+	const NNFloat z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		x = (1.0f - fabsf(value.y)) * (value.x >= 0.0f ? 1.0f : -1.0f);
+		y = (1.0f - fabsf(value.x)) * (value.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	const NNFloat length = sqrtf(x * x + y * y + z * z);
+	return NNVec3(x / length, y / length, z / length);
+}
+
+/** Encoding <<< */
+
+/** Layouts >>> */
+
+const VertexLayoutDesc* VertexLayoutDesc::FromFormat(const NNVertexFormat vf)
+{
+	typedef VertexLayout<VertexAttribute<0, NN_SEMANTIC_POSITION, VertexFloat3>> PositionLayout;
+	typedef VertexLayout<VertexAttribute<0, NN_SEMANTIC_POSITION, VertexFloat3>, VertexAttribute<1, NN_SEMANTIC_TEXCOORD, VertexFloat2>> PositionTextureLayout;
+	typedef VertexLayout<VertexAttribute<0, NN_SEMANTIC_POSITION, VertexFloat3>, VertexAttribute<1, NN_SEMANTIC_NORMAL, VertexFloat3>> PositionNormalLayout;
+	//
+	switch (vf)
+	{
+		case POSITION: return &PositionLayout::Desc();
+		case POSITION_TEXTURE: return &PositionTextureLayout::Desc();
+		case POSITION_NORMAL: return &PositionNormalLayout::Desc();
+		case POSITION_NORMAL_TEXTURE: return &StandardVertexLayout::Desc();
+		default: return nullptr;
+	}
+}
+
+NNUInt IndexPacking::GetIndexSize(const NNUInt vertex_num)
+{
+	return vertex_num < 0x10000 ? sizeof(uint16_t) : sizeof(NNUInt);
+}
+
+void IndexPacking::Pack(const NNUInt* src, const NNUInt num, const NNUInt index_size, NNByte* dst)
+{
+	if (index_size == sizeof(NNUInt))
+	{
+		memcpy(dst, src, (size_t)num * sizeof(NNUInt));
+		return;
+	}
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		const uint16_t index = (uint16_t)src[i];
+		memcpy(dst + (size_t)i * sizeof(uint16_t), &index, sizeof(uint16_t));
+	}
+}
+
+void IndexPacking::Unpack(const NNByte* src, const NNUInt num, const NNUInt index_size, NNUInt* dst)
+{
+	if (index_size == sizeof(NNUInt))
+	{
+		memcpy(dst, src, (size_t)num * sizeof(NNUInt));
+		return;
+	}
+	for (NNUInt i = 0; i < num; ++i)
+	{
+		uint16_t index;
+		memcpy(&index, src + (size_t)i * sizeof(uint16_t), sizeof(uint16_t));
+		dst[i] = index;
+	}
+}
+
+/** Layouts <<< */
@@ -0,0 +1,426 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <array>
+#include <tuple>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "Types.h"
+
+//
+//    Vertex: Full precision vertex, the source every layout is encoded from
+//
+struct Vertex
+{
+	NNVec3 m_position;
+	NNVec3 m_normal;
+	NNVec2 m_texcoord;
+};
+
+// Vertex is uploaded and cached byte by byte
+static_assert(sizeof(Vertex) == 8 * sizeof(NNFloat), "Vertex must be tightly packed.");
+
+//
+//    VertexEncoding: Scalar quantization helpers shared by the attribute formats
+//
+
+class VertexEncoding
+{
+public:
+	// IEEE 754 半精度, 就近舍入
+	static uint16_t FloatToHalf(const NNFloat value);
+	static NNFloat HalfToFloat(const uint16_t value);
+	//
+	static int16_t FloatToSNorm16(const NNFloat value);
+	static NNFloat SNorm16ToFloat(const int16_t value);
+	static uint16_t FloatToUNorm16(const NNFloat value);
+	static NNFloat UNorm16ToFloat(const uint16_t value);
+	static uint8_t FloatToUNorm8(const NNFloat value);
+	static NNFloat UNorm8ToFloat(const uint8_t value);
+	// 10:10:10:2 有符号归一化
+	static uint32_t PackSNorm1010102(const NNVec4& value);
+	static NNVec4 UnpackSNorm1010102(const uint32_t value);
+	// 八面体映射: 单位向量 <-> [-1, 1]^2
+	static NNVec2 EncodeOctahedral(const NNVec3& normal);
+	static NNVec3 DecodeOctahedral(const NNVec2& value);
+};
+
+/** Attribute Formats >>> */
+
+// 每种格式描述 GPU 端的分量类型, 并负责 NNVec4 与字节之间的转换
+
+// 32 位浮点, 无损
+template<NNUInt N>
+struct VertexFloat
+{
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_FLOAT;
+	static constexpr NNUInt COMPONENTS = N;
+	static constexpr NNUInt SIZE = N * sizeof(NNFloat);
+	static constexpr bool NORMALIZED = false;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const NNFloat v[4] = { value.x, value.y, value.z, value.w };
+		memcpy(dst, v, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		NNFloat v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		memcpy(v, src, SIZE);
+		return NNVec4(v[0], v[1], v[2], v[3]);
+	}
+};
+
+// 16 位浮点, 只提供偶数个分量以保持 4 字节对齐 (位置的 w 填 1)
+template<NNUInt N>
+struct VertexHalf
+{
+	static_assert(N == 2 || N == 4, "Half attributes must have 2 or 4 components.");
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_HALF;
+	static constexpr NNUInt COMPONENTS = N;
+	static constexpr NNUInt SIZE = N * sizeof(uint16_t);
+	static constexpr bool NORMALIZED = false;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const NNFloat v[4] = { value.x, value.y, value.z, value.w };
+		uint16_t h[N];
+		for (NNUInt i = 0; i < N; ++i) h[i] = VertexEncoding::FloatToHalf(v[i]);
+		memcpy(dst, h, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		uint16_t h[N];
+		memcpy(h, src, SIZE);
+		NNFloat v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		for (NNUInt i = 0; i < N; ++i) v[i] = VertexEncoding::HalfToFloat(h[i]);
+		return NNVec4(v[0], v[1], v[2], v[3]);
+	}
+};
+
+// 16 位有符号归一化, 适合切线 (w 为副切线方向)
+template<NNUInt N>
+struct VertexSNorm16
+{
+	static_assert(N == 2 || N == 4, "SNorm16 attributes must have 2 or 4 components.");
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_SHORT;
+	static constexpr NNUInt COMPONENTS = N;
+	static constexpr NNUInt SIZE = N * sizeof(int16_t);
+	static constexpr bool NORMALIZED = true;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const NNFloat v[4] = { value.x, value.y, value.z, value.w };
+		int16_t s[N];
+		for (NNUInt i = 0; i < N; ++i) s[i] = VertexEncoding::FloatToSNorm16(v[i]);
+		memcpy(dst, s, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		int16_t s[N];
+		memcpy(s, src, SIZE);
+		NNFloat v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		for (NNUInt i = 0; i < N; ++i) v[i] = VertexEncoding::SNorm16ToFloat(s[i]);
+		return NNVec4(v[0], v[1], v[2], v[3]);
+	}
+};
+
+// 16 位无符号归一化, 纹理坐标超出 [0, 1] 时会被截断
+template<NNUInt N>
+struct VertexUNorm16
+{
+	static_assert(N == 2 || N == 4, "UNorm16 attributes must have 2 or 4 components.");
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_UNSIGNED_SHORT;
+	static constexpr NNUInt COMPONENTS = N;
+	static constexpr NNUInt SIZE = N * sizeof(uint16_t);
+	static constexpr bool NORMALIZED = true;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const NNFloat v[4] = { value.x, value.y, value.z, value.w };
+		uint16_t u[N];
+		for (NNUInt i = 0; i < N; ++i) u[i] = VertexEncoding::FloatToUNorm16(v[i]);
+		memcpy(dst, u, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		uint16_t u[N];
+		memcpy(u, src, SIZE);
+		NNFloat v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		for (NNUInt i = 0; i < N; ++i) v[i] = VertexEncoding::UNorm16ToFloat(u[i]);
+		return NNVec4(v[0], v[1], v[2], v[3]);
+	}
+};
+
+// 8 位无符号归一化 RGBA, 用于顶点颜色
+struct VertexUNorm8x4
+{
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_UNSIGNED_BYTE;
+	static constexpr NNUInt COMPONENTS = 4;
+	static constexpr NNUInt SIZE = 4;
+	static constexpr bool NORMALIZED = true;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		dst[0] = VertexEncoding::FloatToUNorm8(value.x);
+		dst[1] = VertexEncoding::FloatToUNorm8(value.y);
+		dst[2] = VertexEncoding::FloatToUNorm8(value.z);
+		dst[3] = VertexEncoding::FloatToUNorm8(value.w);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		return NNVec4(VertexEncoding::UNorm8ToFloat(src[0]), VertexEncoding::UNorm8ToFloat(src[1]),
+			VertexEncoding::UNorm8ToFloat(src[2]), VertexEncoding::UNorm8ToFloat(src[3]));
+	}
+};
+
+// 10:10:10:2 打包的法线, 由硬件解码, 着色器不需要修改
+struct VertexSNorm10
+{
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_INT_2_10_10_10;
+	static constexpr NNUInt COMPONENTS = 4;
+	static constexpr NNUInt SIZE = sizeof(uint32_t);
+	static constexpr bool NORMALIZED = true;
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const uint32_t packed = VertexEncoding::PackSNorm1010102(value);
+		memcpy(dst, &packed, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		uint32_t packed;
+		memcpy(&packed, src, SIZE);
+		return VertexEncoding::UnpackSNorm1010102(packed);
+	}
+};
+
+// 八面体映射的法线, 2 x SNORM16, 着色器需要用 GLSL_DECODE 还原
+struct VertexOctahedral
+{
+	static constexpr NNAttributeType TYPE = NN_ATTRIBUTE_SHORT;
+	static constexpr NNUInt COMPONENTS = 2;
+	static constexpr NNUInt SIZE = 2 * sizeof(int16_t);
+	static constexpr bool NORMALIZED = true;
+	static constexpr const NNChar* GLSL_DECODE =
+		"vec3 DecodeOctahedral(vec2 e) {\n"
+		"    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));\n"
+		"    if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);\n"
+		"    return normalize(n);\n"
+		"}\n";
+	//
+	static void Encode(const NNVec4& value, NNByte* dst)
+	{
+		const NNVec2 e = VertexEncoding::EncodeOctahedral(NNVec3(value.x, value.y, value.z));
+		const int16_t s[2] = { VertexEncoding::FloatToSNorm16(e.x), VertexEncoding::FloatToSNorm16(e.y) };
+		memcpy(dst, s, SIZE);
+	}
+	static NNVec4 Decode(const NNByte* src)
+	{
+		int16_t s[2];
+		memcpy(s, src, SIZE);
+		const NNVec3 n = VertexEncoding::DecodeOctahedral(NNVec2(VertexEncoding::SNorm16ToFloat(s[0]), VertexEncoding::SNorm16ToFloat(s[1])));
+		return NNVec4(n.x, n.y, n.z, 0.0f);
+	}
+};
+
+typedef VertexFloat<2> VertexFloat2;
+typedef VertexFloat<3> VertexFloat3;
+typedef VertexFloat<4> VertexFloat4;
+typedef VertexHalf<2> VertexHalf2;
+typedef VertexHalf<4> VertexHalf4;
+typedef VertexSNorm16<4> VertexSNorm16x4;
+typedef VertexUNorm16<2> VertexUNorm16x2;
+
+/** Attribute Formats <<< */
+
+//
+//    VertexAttribute: Binds a semantic and a storage format to a shader location
+//
+
+template<NNUInt Location, NNVertexSemantic Semantic, typename Format>
+struct VertexAttribute
+{
+	static constexpr NNUInt LOCATION = Location;
+	static constexpr NNVertexSemantic SEMANTIC = Semantic;
+	typedef Format FORMAT;
+};
+
+// 运行时描述, 由 VertexLayout 在编译期生成
+struct VertexAttributeDesc
+{
+	NNUInt location;
+	NNVertexSemantic semantic;
+	NNAttributeType type;
+	NNUInt components;
+	bool normalized;
+	NNUInt offset;
+};
+
+//
+//    VertexLayoutDesc: Type-erased view of a VertexLayout, stored by meshes and shapes
+//
+
+struct VertexLayoutDesc
+{
+	const VertexAttributeDesc* attributes;
+	NNUInt attribute_num;
+	NNUInt stride;
+	// 编码 / 解码 num 个顶点, 不在布局中的语义使用默认值
+	void (*encode)(const Vertex* src, const NNUInt num, NNByte* dst);
+	void (*decode)(const NNByte* src, const NNUInt num, Vertex* dst);
+	// 按布局设置当前绑定的 VAO, 顶点数据来自当前绑定的 GL_ARRAY_BUFFER
+	void Apply() const;
+	// 旧的浮点顶点格式对应的布局
+	static const VertexLayoutDesc* FromFormat(const NNVertexFormat vf);
+};
+
+// 从 Vertex 中取出语义对应的值; 切线和颜色不在 Vertex 中, 使用默认值
+inline NNVec4 GetVertexSemantic(const Vertex& vertex, const NNVertexSemantic semantic)
+{
+	switch (semantic)
+	{
+		case NN_SEMANTIC_POSITION: return NNVec4(vertex.m_position.x, vertex.m_position.y, vertex.m_position.z, 1.0f);
+		case NN_SEMANTIC_NORMAL: return NNVec4(vertex.m_normal.x, vertex.m_normal.y, vertex.m_normal.z, 0.0f);
+		case NN_SEMANTIC_TEXCOORD: return NNVec4(vertex.m_texcoord.x, vertex.m_texcoord.y, 0.0f, 0.0f);
+		case NN_SEMANTIC_TANGENT: return NNVec4(1.0f, 0.0f, 0.0f, 1.0f);
+		default: return NNVec4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+}
+
+inline void SetVertexSemantic(Vertex& vertex, const NNVertexSemantic semantic, const NNVec4& value)
+{
+	switch (semantic)
+	{
+		case NN_SEMANTIC_POSITION: vertex.m_position = NNVec3(value.x, value.y, value.z); break;
+		case NN_SEMANTIC_NORMAL: vertex.m_normal = NNVec3(value.x, value.y, value.z); break;
+		case NN_SEMANTIC_TEXCOORD: vertex.m_texcoord = NNVec2(value.x, value.y); break;
+		default: break;
+	}
+}
+
+//
+//    VertexLayout: Compile-time vertex layout, offsets and stride are constant expressions
+//
+
+template<typename... Attributes>
+class VertexLayout
+{
+	static_assert(sizeof...(Attributes) > 0, "Vertex layout must have at least one attribute.");
+
+public:
+	static constexpr NNUInt ATTRIBUTE_NUM = sizeof...(Attributes);
+	static constexpr NNUInt STRIDE = (0 + ... + Attributes::FORMAT::SIZE);
+	static constexpr std::array<VertexAttributeDesc, ATTRIBUTE_NUM> ATTRIBUTES = []() {
+		std::array<VertexAttributeDesc, ATTRIBUTE_NUM> result = { { { Attributes::LOCATION, Attributes::SEMANTIC, Attributes::FORMAT::TYPE, Attributes::FORMAT::COMPONENTS, Attributes::FORMAT::NORMALIZED, 0 }... } };
+		const NNUInt sizes[] = { Attributes::FORMAT::SIZE... };
+		NNUInt offset = 0;
+		for (NNUInt i = 0; i < ATTRIBUTE_NUM; ++i)
+		{
+			result[i].offset = offset;
+			offset += sizes[i];
+		}
+		return result;
+	}();
+
+	// 一个编码后的顶点, 用于直接构造带切线或颜色的数据
+	struct Packed
+	{
+		NNByte data[STRIDE];
+		//
+		template<NNVertexSemantic Semantic>
+		void Set(const NNVec4& value)
+		{
+			constexpr NNUInt index = IndexOf(Semantic);
+			static_assert(index < ATTRIBUTE_NUM, "Semantic is not in this vertex layout.");
+			std::tuple_element_t<index, std::tuple<Attributes...>>::FORMAT::Encode(value, data + ATTRIBUTES[index].offset);
+		}
+		template<NNVertexSemantic Semantic>
+		NNVec4 Get() const
+		{
+			constexpr NNUInt index = IndexOf(Semantic);
+			static_assert(index < ATTRIBUTE_NUM, "Semantic is not in this vertex layout.");
+			return std::tuple_element_t<index, std::tuple<Attributes...>>::FORMAT::Decode(data + ATTRIBUTES[index].offset);
+		}
+	};
+	static_assert(sizeof(Packed) == STRIDE, "Packed vertex must be tightly packed.");
+
+public:
+	static void Encode(const Vertex* src, const NNUInt num, NNByte* dst)
+	{
+		for (NNUInt i = 0; i < num; ++i)
+		{
+			EncodeVertex(src[i], dst + (size_t)i * STRIDE, std::index_sequence_for<Attributes...>());
+		}
+	}
+	static void Decode(const NNByte* src, const NNUInt num, Vertex* dst)
+	{
+		for (NNUInt i = 0; i < num; ++i)
+		{
+			dst[i] = Vertex();
+			DecodeVertex(src + (size_t)i * STRIDE, dst[i], std::index_sequence_for<Attributes...>());
+		}
+	}
+	// 每种布局唯一, 可以用地址比较
+	static const VertexLayoutDesc& Desc()
+	{
+		static const VertexLayoutDesc desc = { ATTRIBUTES.data(), ATTRIBUTE_NUM, STRIDE, &Encode, &Decode };
+		return desc;
+	}
+
+private:
+	static constexpr NNUInt IndexOf(const NNVertexSemantic semantic)
+	{
+		const NNVertexSemantic semantics[] = { Attributes::SEMANTIC... };
+		for (NNUInt i = 0; i < ATTRIBUTE_NUM; ++i)
+		{
+			if (semantics[i] == semantic) return i;
+		}
+		return ATTRIBUTE_NUM;
+	}
+	template<size_t... I>
+	static void EncodeVertex(const Vertex& vertex, NNByte* dst, std::index_sequence<I...>)
+	{
+		(Attributes::FORMAT::Encode(GetVertexSemantic(vertex, Attributes::SEMANTIC), dst + ATTRIBUTES[I].offset), ...);
+	}
+	template<size_t... I>
+	static void DecodeVertex(const NNByte* src, Vertex& vertex, std::index_sequence<I...>)
+	{
+		(SetVertexSemantic(vertex, Attributes::SEMANTIC, Attributes::FORMAT::Decode(src + ATTRIBUTES[I].offset)), ...);
+	}
+};
+
+// 与 Vertex 相同的 32 字节布局
+typedef VertexLayout<
+	VertexAttribute<0, NN_SEMANTIC_POSITION, VertexFloat3>,
+	VertexAttribute<1, NN_SEMANTIC_NORMAL, VertexFloat3>,
+	VertexAttribute<2, NN_SEMANTIC_TEXCOORD, VertexFloat2>
+> StandardVertexLayout;
+
+// 16 字节: 半精度位置 + 10:10:10:2 法线 + 半精度纹理坐标, 着色器输入不变
+typedef VertexLayout<
+	VertexAttribute<0, NN_SEMANTIC_POSITION, VertexHalf4>,
+	VertexAttribute<1, NN_SEMANTIC_NORMAL, VertexSNorm10>,
+	VertexAttribute<2, NN_SEMANTIC_TEXCOORD, VertexHalf2>
+> CompactVertexLayout;
+
+static_assert(StandardVertexLayout::STRIDE == sizeof(Vertex), "Standard layout must match Vertex.");
+static_assert(CompactVertexLayout::STRIDE == 16, "Compact layout must be 16 bytes.");
+
+//
+//    IndexPacking: 16-bit indices when every index fits, 32-bit otherwise
+//
+
+class IndexPacking
+{
+public:
+	// 顶点数小于 65536 时返回 2, 否则返回 4
+	static NNUInt GetIndexSize(const NNUInt vertex_num);
+	static void Pack(const NNUInt* src, const NNUInt num, const NNUInt index_size, NNByte* dst);
+	static void Unpack(const NNByte* src, const NNUInt num, const NNUInt index_size, NNUInt* dst);
+};
+
+#endif // VERTEX_LAYOUT_H
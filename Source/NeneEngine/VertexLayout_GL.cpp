@@ -0,0 +1,31 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifdef NENE_GL
+
+#include "VertexLayout.h"
+
+static GLenum GetGLAttributeType(const NNAttributeType type)
+{
+	switch (type)
+	{
+		case NN_ATTRIBUTE_FLOAT: return GL_FLOAT;
+		case NN_ATTRIBUTE_HALF: return GL_HALF_FLOAT;
+		case NN_ATTRIBUTE_SHORT: return GL_SHORT;
+		case NN_ATTRIBUTE_UNSIGNED_SHORT: return GL_UNSIGNED_SHORT;
+		case NN_ATTRIBUTE_UNSIGNED_BYTE: return GL_UNSIGNED_BYTE;
+		case NN_ATTRIBUTE_INT_2_10_10_10: return GL_INT_2_10_10_10_REV;
+		default: return GL_FLOAT;
+	}
+}
+
+void VertexLayoutDesc::Apply() const
+{
+	for (NNUInt i = 0; i < attribute_num; ++i)
+	{
+		const VertexAttributeDesc& attribute = attributes[i];
+		glVertexAttribPointer(attribute.location, attribute.components, GetGLAttributeType(attribute.type),
+			attribute.normalized ? GL_TRUE : GL_FALSE, stride, (GLvoid*)(size_t)attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+}
+
+#endif // NENE_GL
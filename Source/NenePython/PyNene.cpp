@@ -17,6 +17,7 @@
 #include "PyObserver.h"
 #include "PyMouse.h"
 #include "PyKeyboard.h"
+#include "PyRenderStats.h"
 
 namespace py = pybind11;
 
@@ -39,6 +40,7 @@ PYBIND11_EMBEDDED_MODULE(nene, mod)
 	BindObserver(mod);
 	BindMouse(mod);
 	BindKeyboard(mod);
+	BindRenderStats(mod);
 }
 
 
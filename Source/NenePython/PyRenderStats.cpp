@@ -0,0 +1,47 @@
+#include "PyRenderStats.h"
+#include "../NeneEngine/RenderStats.h"
+
+namespace py = pybind11;
+
+void BindRenderStats(py::module& mod)
+{
+	py::enum_<NNRenderCounter>(mod, "RenderCounter")
+		.value("DRAW_CALLS", NN_COUNTER_DRAW_CALLS)
+		.value("PRIMITIVES", NN_COUNTER_PRIMITIVES)
+		.value("PROGRAM_BINDS", NN_COUNTER_PROGRAM_BINDS)
+		.value("TEXTURE_BINDS", NN_COUNTER_TEXTURE_BINDS)
+		.value("VERTEX_ARRAY_BINDS", NN_COUNTER_VERTEX_ARRAY_BINDS)
+		.value("FRAMEBUFFER_BINDS", NN_COUNTER_FRAMEBUFFER_BINDS)
+		.value("UNIFORM_BYTES", NN_COUNTER_UNIFORM_BYTES)
+		.value("TEXTURE_BYTES", NN_COUNTER_TEXTURE_BYTES)
+		.value("BUFFER_BYTES", NN_COUNTER_BUFFER_BYTES)
+		;
+
+	py::class_<RenderStats::Summary>(mod, "RenderStatsSummary")
+		.def_readonly("last", &RenderStats::Summary::last)
+		.def_readonly("min", &RenderStats::Summary::min)
+		.def_readonly("max", &RenderStats::Summary::max)
+		.def_readonly("avg", &RenderStats::Summary::avg)
+		;
+
+	py::class_<RenderStats>(mod, "RenderStats")
+		.def_static("instance", &RenderStats::Instance, py::return_value_policy::reference)
+		.def_static("counter_name", &RenderStats::GetCounterName)
+		.def("summary", &RenderStats::GetSummary, py::return_value_policy::copy)
+		.def("last", &RenderStats::GetLast)
+		.def("set_window", &RenderStats::SetWindow)
+		.def("window", &RenderStats::GetWindow)
+		.def("frame_num", &RenderStats::GetFrameNum)
+		.def("reset", &RenderStats::Reset)
+		// 计数器名 -> 统计, 方便脚本记录和比较
+		.def("summaries", [](const RenderStats& stats) {
+			py::dict result;
+			for (int i = 0; i < NNRenderCounterNum; ++i)
+			{
+				const NNRenderCounter counter = (NNRenderCounter)i;
+				result[RenderStats::GetCounterName(counter)] = stats.GetSummary(counter);
+			}
+			return result;
+		})
+		;
+}
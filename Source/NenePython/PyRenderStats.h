@@ -0,0 +1,9 @@
+/*Copyright reserved by KenLee@2020 hellokenlee@163.com*/
+#ifndef PY_RENDER_STATS_H
+#define PY_RENDER_STATS_H
+
+#include <pybind11.h>
+
+void BindRenderStats(pybind11::module& mod);
+
+#endif // PY_RENDER_STATS_H
@@ -2,6 +2,7 @@
 #include "../NeneEngine/Shape.h"
 #include "../NeneEngine/Model.h"
 #include "../NeneEngine/Drawable.h"
+#include "../NeneEngine/Instance.h"
 
 namespace py = pybind11;
 
@@ -20,11 +21,33 @@ void BindShape(py::module& mod)
 	
 	auto shape = py::class_<Shape, std::shared_ptr<Shape>>(mod, "Shape", drawable)
 		.def("draw", &Shape::Draw, py::arg("pShader") = std::shared_ptr<Shader>(nullptr), py::arg("pCamera") = std::shared_ptr<Camera>(nullptr))
-		.def("draw_instanced", &Shape::DrawInstanced)
 		.def("set_draw_mode", &Shape::SetDrawMode)
 		;
 
 	auto model = py::class_<Model, std::shared_ptr <Model>>(mod, "Model", shape)
 		.def(py::init(&Model::Create))
 		;
+
+	// 实例化绘制通过 Instance 进行, 每个实例只有模型矩阵
+	auto instance = py::class_<Instance<>, std::shared_ptr<Instance<>>>(mod, "Instance")
+		.def(py::init(&Instance<>::Create), py::arg("drawable"), py::arg("instance_num") = 0)
+		.def("get_model", [](Instance<>& self, const NNUInt index) {
+			if (index >= self.GetInstanceNum())
+			{
+				throw py::index_error();
+			}
+			return self.Model(index);
+		})
+		.def("set_model", [](Instance<>& self, const NNUInt index, const NNMat4& model) {
+			if (index >= self.GetInstanceNum())
+			{
+				throw py::index_error();
+			}
+			self.Model(index) = model;
+		})
+		.def("resize", &Instance<>::Resize)
+		.def("get_instance_num", &Instance<>::GetInstanceNum)
+		.def("update", &Instance<>::Update)
+		.def("draw", &Instance<>::Draw, py::arg("pShader") = std::shared_ptr<Shader>(nullptr), py::arg("pCamera") = std::shared_ptr<Camera>(nullptr))
+		;
 }
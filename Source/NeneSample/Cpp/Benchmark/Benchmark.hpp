@@ -0,0 +1,145 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_BENCHMARK_HPP
+#define BENCHMARK_BENCHMARK_HPP
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+#include <vector>
+#include <functional>
+#include <initializer_list>
+#include "NeneEngine/Debug.h"
+#include "NeneEngine/Nene.h"
+
+namespace benchmark
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// TimeFrames 默认的帧数, 另外预热一帧
+	static const int DEFAULT_FRAMES = 30;
+
+	// 从 begin 到现在的毫秒数
+	double ElapsedMilliseconds(const Clock::time_point& begin)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+	}
+
+	// 运行 rounds 次的平均耗时 (毫秒), warmup 时先运行一次, 排除首次运行和磁盘缓存的影响
+	double TimeRounds(const std::function<void()>& run, const int rounds = 1, const bool warmup = false)
+	{
+		if (warmup)
+		{
+			run();
+		}
+		Clock::time_point begin = Clock::now();
+		for (int round = 0; round < rounds; ++round)
+		{
+			run();
+		}
+		return ElapsedMilliseconds(begin) / rounds;
+	}
+
+	// 预热一次后运行 rounds 次的平均耗时 (毫秒), glFinish 保证计入 GPU 时间
+	double TimeGPURounds(const std::function<void()>& run, const int rounds)
+	{
+		run();
+		glFinish();
+		Clock::time_point begin = Clock::now();
+		for (int round = 0; round < rounds; ++round)
+		{
+			run();
+		}
+		glFinish();
+		return ElapsedMilliseconds(begin) / rounds;
+	}
+
+	// 平均每帧耗时 (毫秒), 每帧清屏后绘制并交换缓冲
+	double TimeFrames(const std::function<void()>& draw, const int frames = DEFAULT_FRAMES)
+	{
+		return TimeGPURounds([&]() {
+			Utils::Clear();
+			draw();
+			Utils::SwapBuffers();
+		}, frames);
+	}
+
+	// 吞吐量 (MB/s)
+	double Throughput(const size_t bytes, const double milliseconds)
+	{
+		return milliseconds > 0.0 ? bytes / (1024.0 * 1024.0) * 1000.0 / milliseconds : 0.0;
+	}
+
+	// 加速比, 分母为 0 时返回 0
+	double Speedup(const double baseline, const double optimized)
+	{
+		return optimized > 0.0 ? baseline / optimized : 0.0;
+	}
+
+	// 网格排列的实例矩阵
+	NNMat4 GridTransform(const NNUInt i, const NNUInt count, const NNFloat scale)
+	{
+		const NNUInt side = (NNUInt)ceil(sqrt((double)count));
+		NNMat4 model(scale);
+		model[3] = NNVec4(((NNFloat)(i % side) / side - 0.5f) * 2.0f, ((NNFloat)(i / side) / side - 0.5f) * 2.0f, 0.0f, 1.0f);
+		return model;
+	}
+
+	// 格式化一个表格单元
+	std::string Format(const char* format, ...)
+	{
+		char buffer[256];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		return buffer;
+	}
+
+	//
+	//    Table: Fixed-width result table printed to stdout, the first column is left aligned and the others right aligned
+	//
+	class Table
+	{
+	public:
+		struct Column
+		{
+			const char* title;
+			int width;
+		};
+
+	public:
+		Table(std::initializer_list<Column> columns) : m_columns(columns) {}
+		// note 接在表头之后, 例如单位
+		void PrintHeader(const char* note = "") const
+		{
+			for (size_t i = 0; i < m_columns.size(); ++i)
+			{
+				PrintCell(i, m_columns[i].title);
+			}
+			printf("%s\n", note);
+		}
+		void PrintRow(std::initializer_list<std::string> cells) const
+		{
+			size_t i = 0;
+			for (const std::string& cell : cells)
+			{
+				PrintCell(i++, cell.c_str());
+			}
+			printf("\n");
+		}
+
+	private:
+		void PrintCell(const size_t i, const char* text) const
+		{
+			const int width = i < m_columns.size() ? m_columns[i].width : 0;
+			printf(i == 0 ? "%-*s" : " %*s", width, text);
+		}
+
+	private:
+		std::vector<Column> m_columns;
+	};
+}
+
+#endif // BENCHMARK_BENCHMARK_HPP
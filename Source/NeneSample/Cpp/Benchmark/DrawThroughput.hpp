@@ -0,0 +1,72 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_DRAW_THROUGHPUT_HPP
+#define BENCHMARK_DRAW_THROUGHPUT_HPP
+
+#include "Benchmark.hpp"
+#include "NeneEngine/ConstantRing.h"
+
+namespace benchmark
+{
+	// 每次绘制 map / unmap 同一个 UBO vs 从持久映射的常量环中分配
+	void DrawThroughput()
+	{
+		//
+		Utils::Init("Benchmark: Draw Throughput", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Shape> cube = Geometry::CreateCube();
+		shader->Use();
+		NeneCB& CB = NeneCB::Instance();
+		auto transform = [&CB](const NNUInt i) {
+			CB.PerObject().Data().model = NNMat4(1.0f);
+			CB.PerObject().Data().model[3] = NNVec4((NNFloat)(i % 100) * 0.02f - 1.0f, (NNFloat)(i / 100 % 100) * 0.02f - 1.0f, 0.0f, 1.0f);
+		};
+		// 空 VAO 画一个点, 只测量常量提交的开销
+		GLuint vao = 0;
+		glGenVertexArrays(1, &vao);
+		//
+		Table table({ { "Draws", 10 }, { "Map (draws/s)", 16 }, { "Ring (draws/s)", 16 }, { "Cube (draws/s)", 16 }, { "Speedup", 10 } });
+		table.PrintHeader();
+		const NNUInt counts[] = { 1000, 5000, 10000, 50000 };
+		for (const NNUInt draws : counts)
+		{
+			// 每帧 draws 次绘制, 返回每秒绘制次数
+			auto draws_per_second = [draws](const std::function<void(NNUInt)>& submit) {
+				const double ms = TimeFrames([&]() {
+					for (NNUInt i = 0; i < draws; ++i)
+					{
+						submit(i);
+					}
+				}, 60);
+				return ms > 0.0 ? draws * 1000.0 / ms : 0.0;
+			};
+			RenderContext::instance().bindVertexArray(vao);
+			double mapped = draws_per_second([&](const NNUInt i) {
+				transform(i);
+				CB.PerObject().Update(PER_OBJECT_SLOT);
+				glDrawArrays(GL_POINTS, 0, 1);
+			});
+			double ring = draws_per_second([&](const NNUInt i) {
+				transform(i);
+				CB.UpdatePerObject();
+				glDrawArrays(GL_POINTS, 0, 1);
+			});
+			RenderContext::instance().bindVertexArray(0);
+			// 完整的绘制路径: 每个物体一个变换, 经过状态缓存绘制立方体
+			double shapes = draws_per_second([&](const NNUInt i) {
+				transform(i);
+				CB.UpdatePerObject();
+				cube->Draw();
+			});
+			table.PrintRow({ Format("%u", draws), Format("%.0f", mapped), Format("%.0f", ring), Format("%.0f", shapes), Format("%.2fx", Speedup(ring, mapped)) });
+		}
+		printf("Persistent mapping: %s\n", ConstantRing::Instance().IsPersistent() ? "yes" : "no (glBufferSubData)");
+		RenderContext::instance().forgetVertexArray(vao);
+		glDeleteVertexArrays(1, &vao);
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_DRAW_THROUGHPUT_HPP
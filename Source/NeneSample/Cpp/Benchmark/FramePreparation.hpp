@@ -0,0 +1,85 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_FRAME_PREPARATION_HPP
+#define BENCHMARK_FRAME_PREPARATION_HPP
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 大量运动物体: 主线程逐个剔除和记录 vs 在线程池上准备绘制列表
+	void FramePreparation()
+	{
+		//
+		Utils::Init("Benchmark: Frame Preparation", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+		camera->SetPerspective(NNRadians(60.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+		std::shared_ptr<RenderQueue> queue = RenderQueue::Create();
+		//
+		printf("Workers: %u\n", ThreadPool::Instance().GetWorkerNum() + 1);
+		Table table({ { "Objects", 10 }, { "Serial prep", 14 }, { "Serial frame", 14 }, { "Jobs prep", 14 }, { "Jobs frame", 14 }, { "Visible", 10 } });
+		table.PrintHeader();
+		const NNUInt counts[] = { 5000, 20000, 50000 };
+		for (const NNUInt count : counts)
+		{
+			// 摄像机周围随机放置, 每帧所有物体绕 y 轴转动
+			std::mt19937 rng(count);
+			std::uniform_real_distribution<NNFloat> position(-100.0f, 100.0f);
+			std::vector<std::shared_ptr<Drawable>> objects(count);
+			std::shared_ptr<FrameBuilder> builder = FrameBuilder::Create();
+			for (NNUInt i = 0; i < count; ++i)
+			{
+				objects[i] = Geometry::CreateCube();
+				objects[i]->MoveTo(NNVec3(position(rng), position(rng) * 0.1f, position(rng)));
+				builder->Add(objects[i], shader);
+			}
+			NNFloat angle = 0.0f;
+			auto animate = [&]() {
+				angle += 0.01f;
+				for (const std::shared_ptr<Drawable>& object : objects)
+				{
+					object->RotateY(angle);
+				}
+			};
+			double serial_prep = 0.0;
+			double serial = TimeFrames([&]() {
+				animate();
+				Clock::time_point begin = Clock::now();
+				Frustum frustum = camera->GetFrustum();
+				TransformSystem::Instance().Update();
+				for (const std::shared_ptr<Drawable>& object : objects)
+				{
+					if (frustum.Test(object->GetWorldBounds()) != Frustum::OUTSIDE)
+					{
+						object->Submit(*queue, shader);
+					}
+				}
+				queue->Sort(camera->GetPosition());
+				serial_prep += ElapsedMilliseconds(begin);
+				queue->Execute(camera);
+				queue->Clear();
+			});
+			double jobs_prep = 0.0;
+			double jobs = TimeFrames([&]() {
+				animate();
+				Clock::time_point begin = Clock::now();
+				std::shared_ptr<const DrawList> list = builder->Build(camera);
+				jobs_prep += ElapsedMilliseconds(begin);
+				list->Execute(camera);
+			});
+			// TimeFrames 额外预热一帧
+			const double frames = DEFAULT_FRAMES + 1.0;
+			table.PrintRow({ Format("%u", count), Format("%.3f", serial_prep / frames), Format("%.3f", serial), Format("%.3f", jobs_prep / frames), Format("%.3f", jobs),
+				Format("%u", builder->GetStats().visible) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_FRAME_PREPARATION_HPP
@@ -0,0 +1,76 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_FRUSTUM_CULLING_HPP
+#define BENCHMARK_FRUSTUM_CULLING_HPP
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 散布在大场景中的物体: 全部提交 vs 层次包围盒剔除后提交
+	void FrustumCulling()
+	{
+		//
+		Utils::Init("Benchmark: Frustum Culling", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+		camera->SetPerspective(NNRadians(60.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+		std::shared_ptr<RenderQueue> queue = RenderQueue::Create();
+		//
+		Table table({ { "Objects", 10 }, { "All (ms)", 12 }, { "Culled (ms)", 12 }, { "Visible", 10 }, { "Culled", 10 }, { "Node tests", 12 }, { "Height", 10 } });
+		table.PrintHeader();
+		const NNUInt counts[] = { 1000, 5000, 20000 };
+		for (const NNUInt count : counts)
+		{
+			// 摄像机周围 500 x 500 的平面上随机放置, 每帧移动十分之一的物体
+			std::mt19937 rng(count);
+			std::uniform_real_distribution<NNFloat> position(-250.0f, 250.0f);
+			std::vector<std::shared_ptr<Drawable>> objects(count);
+			std::shared_ptr<CullingTree> tree = CullingTree::Create(0.5f);
+			for (NNUInt i = 0; i < count; ++i)
+			{
+				objects[i] = Geometry::CreateCube();
+				objects[i]->MoveTo(NNVec3(position(rng), 0.0f, position(rng)));
+				tree->Add(objects[i]);
+			}
+			NNUInt frame = 0;
+			auto animate = [&]() {
+				for (NNUInt i = frame % 10; i < count; i += 10)
+				{
+					objects[i]->MoveTo(objects[i]->GetWorldBounds().GetCenter() + NNVec3(0.01f, 0.0f, 0.0f));
+				}
+				++frame;
+			};
+			double all = TimeFrames([&]() {
+				animate();
+				for (const std::shared_ptr<Drawable>& object : objects)
+				{
+					object->Submit(*queue, shader);
+				}
+				queue->Flush(camera);
+			});
+			std::vector<Drawable*> visible;
+			double culled = TimeFrames([&]() {
+				animate();
+				tree->Refit();
+				tree->Cull(camera, visible);
+				for (Drawable* object : visible)
+				{
+					object->Submit(*queue, shader);
+				}
+				queue->Flush(camera);
+			});
+			const CullingTree::Stats& stats = tree->GetStats();
+			table.PrintRow({ Format("%u", count), Format("%.3f", all), Format("%.3f", culled), Format("%u", stats.visible), Format("%u", stats.culled),
+				Format("%u", stats.node_tests), Format("%u", tree->GetHeight()) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_FRUSTUM_CULLING_HPP
@@ -0,0 +1,73 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_INDIRECT_DRAW_HPP
+#define BENCHMARK_INDIRECT_DRAW_HPP
+
+#include <cstdio>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 静态场景: 逐个 Draw vs 构建一次的 MultiDrawIndirect 批次
+	void IndirectDraw()
+	{
+		//
+		Utils::Init("Benchmark: Indirect Draw", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Shader> indirect = Shader::Create("Resource/Shader/GLSL/CommonIndirect.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<StaticMesh> nanosuit = StaticMesh::Create("Resource/Mesh/nanosuit/nanosuit.obj");
+		std::shared_ptr<StaticMesh> bunny = StaticMesh::Create("Resource/Mesh/bunny/bunny.obj");
+		if (IndirectBatch::Create() == nullptr)
+		{
+			Utils::Terminate();
+			return;
+		}
+		//
+		struct Case { const char* name; std::shared_ptr<StaticMesh> mesh; NNUInt count; NNFloat scale; };
+		const Case cases[] = {
+			{ "nanosuit", nanosuit, 1, 0.1f },
+			{ "nanosuit", nanosuit, 100, 0.01f },
+			{ "nanosuit", nanosuit, 1000, 0.003f },
+			{ "bunny", bunny, 10000, 0.05f },
+		};
+		Table table({ { "Mesh", 10 }, { "Count", 8 }, { "Draws", 12 }, { "Draw() (ms)", 12 }, { "MultiDraws", 14 }, { "MDI (ms)", 12 }, { "Speedup", 10 } });
+		table.PrintHeader();
+		for (const Case& c : cases)
+		{
+			if (c.mesh == nullptr)
+			{
+				continue;
+			}
+			const NNUInt draws = c.count * (NNUInt)c.mesh->GetMeshes().size();
+			double single = TimeFrames([&]() {
+				shader->Use();
+				for (NNUInt i = 0; i < c.count; ++i)
+				{
+					c.mesh->SetModelMat(GridTransform(i, c.count, c.scale));
+					c.mesh->Draw();
+				}
+			});
+			// 场景不变, 只构建一次
+			std::shared_ptr<IndirectBatch> batch = IndirectBatch::Create();
+			for (NNUInt i = 0; i < c.count; ++i)
+			{
+				c.mesh->SetModelMat(GridTransform(i, c.count, c.scale));
+				c.mesh->Submit(*batch);
+			}
+			batch->Build();
+			double batched = TimeFrames([&]() {
+				batch->Draw(indirect);
+			});
+			table.PrintRow({ c.name, Format("%u", c.count), Format("%u", draws), Format("%.3f", single), Format("%u", batch->GetStats().multi_draws), Format("%.3f", batched),
+				Format("%.2fx", Speedup(single, batched)) });
+			c.mesh->SetModelMat(NNMat4(1.0f));
+		}
+		printf("Geometry arena: %u pools, %zd / %zd bytes used\n", GeometryArena::Instance().GetPoolNum(),
+			GeometryArena::Instance().GetAllocatedBytes(), GeometryArena::Instance().GetCapacityBytes());
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_INDIRECT_DRAW_HPP
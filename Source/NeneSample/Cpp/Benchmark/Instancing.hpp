@@ -0,0 +1,61 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_INSTANCING_HPP
+#define BENCHMARK_INSTANCING_HPP
+
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 逐个 Draw vs 一次实例化绘制; 实例化时每帧重新上传矩阵, 包含流式缓冲的开销
+	void Instancing()
+	{
+		//
+		Utils::Init("Benchmark: Instancing", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Shader> instanced = Shader::Create("Resource/Shader/GLSL/CommonInstanced.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Drawable> cube = Geometry::CreateCube();
+		std::shared_ptr<Drawable> bunny = StaticMesh::Create("Resource/Mesh/bunny/bunny.obj");
+		//
+		struct Case { const char* name; std::shared_ptr<Drawable> drawable; NNUInt count; NNFloat scale; };
+		const Case cases[] = {
+			{ "cube", cube, 10000, 0.005f },
+			{ "cube", cube, 50000, 0.003f },
+			{ "cube", cube, 100000, 0.002f },
+			{ "bunny", bunny, 10000, 0.05f },
+		};
+		Table table({ { "Mesh", 8 }, { "Count", 10 }, { "Draw() (ms)", 16 }, { "Instanced (ms)", 16 }, { "Speedup", 10 } });
+		table.PrintHeader();
+		for (const Case& c : cases)
+		{
+			if (c.drawable == nullptr)
+			{
+				continue;
+			}
+			double single = TimeFrames([&]() {
+				shader->Use();
+				for (NNUInt i = 0; i < c.count; ++i)
+				{
+					c.drawable->SetModelMat(GridTransform(i, c.count, c.scale));
+					c.drawable->Draw();
+				}
+			});
+			c.drawable->SetModelMat(NNMat4(1.0f));
+			auto instances = Instance<>::Create(c.drawable, c.count);
+			double batched = TimeFrames([&]() {
+				for (NNUInt i = 0; i < c.count; ++i)
+				{
+					instances->Model(i) = GridTransform(i, c.count, c.scale);
+				}
+				instances->Update();
+				instances->Draw(instanced);
+			});
+			table.PrintRow({ c.name, Format("%u", c.count), Format("%.3f", single), Format("%.3f", batched), Format("%.2fx", Speedup(single, batched)) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_INSTANCING_HPP
@@ -0,0 +1,65 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_MATERIAL_BATCHING_HPP
+#define BENCHMARK_MATERIAL_BATCHING_HPP
+
+#include <cstdio>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 材质打包前后: 渲染队列的纹理绑定次数和 MultiDrawIndirect 的分组数
+	void MaterialBatching()
+	{
+		//
+		Utils::Init("Benchmark: Material Batching", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		std::shared_ptr<Shader> arrayed = Shader::Create("Resource/Shader/GLSL/MaterialArray.vert", "Resource/Shader/GLSL/MaterialArray.frag");
+		std::shared_ptr<StaticMesh> nanosuit = StaticMesh::Create("Resource/Mesh/nanosuit/nanosuit.obj");
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+		std::shared_ptr<RenderQueue> queue = RenderQueue::Create();
+		if (nanosuit == nullptr)
+		{
+			Utils::Terminate();
+			return;
+		}
+		//
+		const NNUInt count = 1000;
+		Table table({ { "Materials", 10 }, { "Count", 10 }, { "Queue (ms)", 12 }, { "Texture binds", 17 }, { "MDI groups", 14 } });
+		auto run = [&](const char* name, std::shared_ptr<Shader> pShader) {
+			double queued = TimeFrames([&]() {
+				for (NNUInt i = 0; i < count; ++i)
+				{
+					nanosuit->SetModelMat(GridTransform(i, count, 0.003f));
+					nanosuit->Submit(*queue, pShader);
+				}
+				queue->Flush(camera);
+			});
+			const RenderQueue::Stats& stats = queue->GetStats();
+			NNUInt groups = 0;
+			std::shared_ptr<IndirectBatch> batch = IndirectBatch::Create();
+			if (batch != nullptr)
+			{
+				for (NNUInt i = 0; i < count; ++i)
+				{
+					nanosuit->SetModelMat(GridTransform(i, count, 0.003f));
+					nanosuit->Submit(*batch);
+				}
+				batch->Build();
+				groups = batch->GetGroupNum();
+			}
+			table.PrintRow({ name, Format("%zd", nanosuit->GetMaterials().size()), Format("%.3f", queued), Format("%u / %u", stats.texture_binds, stats.draws), Format("%u", groups) });
+		};
+		table.PrintHeader();
+		run("separate", shader);
+		const NNUInt bindings = nanosuit->PackMaterials();
+		run("packed", arrayed);
+		printf("%u texture bindings after packing\n", bindings);
+		nanosuit->SetModelMat(NNMat4(1.0f));
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_MATERIAL_BATCHING_HPP
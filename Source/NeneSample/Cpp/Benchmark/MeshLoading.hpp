@@ -0,0 +1,52 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_MESH_LOADING_HPP
+#define BENCHMARK_MESH_LOADING_HPP
+
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// Assimp 冷导入 (串行/并行) vs 内置 OBJ 解析 vs .nnmesh 缓存载入
+	void MeshLoading()
+	{
+		//
+		Utils::Init("Benchmark: Mesh Loading", 800, 600);
+		//
+		static const int ROUNDS = 5;
+		const char* filepaths[] = {
+			"Resource/Mesh/bunny/bunny.obj",
+			"Resource/Mesh/armadillo/armadillo.obj",
+			"Resource/Mesh/nanosuit/nanosuit.obj",
+		};
+		//
+		Table table({ { "Model", 40 }, { "Assimp (ms)", 14 }, { "Parallel (ms)", 14 }, { "Native (ms)", 14 }, { "Cached (ms)", 14 }, { "Parallel", 10 }, { "Native", 10 }, { "Cached", 10 } });
+		table.PrintHeader();
+		for (const char* filepath : filepaths)
+		{
+			// 计时一次模型载入 (毫秒)
+			auto load = [filepath](const NNUInt flags) {
+				return TimeRounds([&]() { StaticMesh::Create(filepath, 1.0f, flags); });
+			};
+			double cold = 0.0, parallel = 0.0, native = 0.0, cached = 0.0;
+			for (int round = 0; round < ROUNDS; ++round)
+			{
+				// 强制走 Assimp, 同时重写缓存
+				cold += load(NN_IMPORT_IGNORE_CACHE);
+				parallel += load(NN_IMPORT_IGNORE_CACHE | NN_IMPORT_PARALLEL);
+				native += load(NN_IMPORT_IGNORE_CACHE | NN_IMPORT_PARALLEL | NN_IMPORT_NATIVE_OBJ);
+				// 读取刚写入的缓存
+				cached += load(NN_IMPORT_DEFAULT);
+			}
+			cold /= ROUNDS;
+			parallel /= ROUNDS;
+			native /= ROUNDS;
+			cached /= ROUNDS;
+			table.PrintRow({ filepath, Format("%.2f", cold), Format("%.2f", parallel), Format("%.2f", native), Format("%.2f", cached),
+				Format("%.1fx", Speedup(cold, parallel)), Format("%.1fx", Speedup(cold, native)), Format("%.1fx", Speedup(cold, cached)) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_MESH_LOADING_HPP
@@ -0,0 +1,111 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_OBJ_PARSING_HPP
+#define BENCHMARK_OBJ_PARSING_HPP
+
+#include <vector>
+#include <functional>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 原来 LappedTextureMesh 中逐个 token 读取的方式
+	size_t ParseOBJWithFscanf(const char* filepath)
+	{
+		FILE *file = fopen(filepath, "r");
+		if (file == nullptr)
+		{
+			return 0;
+		}
+		char linebuff[512];
+		std::vector<NNVec3> normals;
+		std::vector<NNVec3> positions;
+		std::vector<NNVec2> texcoords;
+		std::vector<NNUInt> indices;
+		while (fscanf(file, "%s", linebuff) != EOF)
+		{
+			if (linebuff[0] == 'v' and linebuff[1] == 'n')
+			{
+				NNVec3 temp;
+				fscanf(file, "%f %f %f", &temp.x, &temp.y, &temp.z);
+				normals.emplace_back(temp);
+			}
+			else if (linebuff[0] == 'v' and linebuff[1] == 't')
+			{
+				NNVec2 temp;
+				fscanf(file, "%f %f", &temp.x, &temp.y);
+				texcoords.emplace_back(temp);
+			}
+			else if (linebuff[0] == 'v')
+			{
+				NNVec3 temp;
+				fscanf(file, "%f %f %f", &temp.x, &temp.y, &temp.z);
+				positions.emplace_back(temp);
+			}
+			else if (linebuff[0] == 'f')
+			{
+				// 只取位置索引, 跳过 /t/n
+				for (int i = 0; i < 3; ++i)
+				{
+					NNUInt index;
+					fscanf(file, "%u%*s", &index);
+					indices.push_back(index - 1);
+				}
+			}
+			else
+			{
+				fgets(linebuff, 512, file);
+			}
+		}
+		fclose(file);
+		return indices.size();
+	}
+
+	size_t ParseOBJWithAssimp(const char* filepath)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(filepath, aiProcess_JoinIdenticalVertices | aiProcess_Triangulate | aiProcess_GenSmoothNormals);
+		return scene == nullptr ? 0 : scene->mNumMeshes;
+	}
+
+	size_t ParseOBJWithIO(const char* filepath, bool parallel)
+	{
+		OBJData data;
+		IO::ReadOBJ(filepath, data, parallel);
+		return data.indices.size();
+	}
+
+	// Assimp vs fscanf vs IO::ReadOBJ 解析吞吐量
+	void ObjParsing()
+	{
+		const char* filepaths[] = {
+			"Resource/Mesh/bunny/bunny_with_uv.obj",
+			"Resource/Mesh/armadillo/armadillo.obj",
+			"Resource/Mesh/nanosuit/nanosuit.obj",
+		};
+		//
+		static const int ROUNDS = 5;
+		Table table({ { "Model", 40 }, { "Assimp", 12 }, { "fscanf", 12 }, { "IO", 12 }, { "IO Parallel", 12 } });
+		table.PrintHeader("  (MB/s)");
+		for (const char* filepath : filepaths)
+		{
+			size_t bytes = 0;
+			{
+				std::shared_ptr<MappedFile> file = MappedFile::Open(filepath);
+				if (file == nullptr)
+				{
+					continue;
+				}
+				bytes = file->Size();
+			}
+			// 预热一次, 排除磁盘缓存的影响
+			double assimp_ms = TimeRounds([=]() { ParseOBJWithAssimp(filepath); }, ROUNDS, true);
+			double fscanf_ms = TimeRounds([=]() { ParseOBJWithFscanf(filepath); }, ROUNDS, true);
+			double serial_ms = TimeRounds([=]() { ParseOBJWithIO(filepath, false); }, ROUNDS, true);
+			double parallel_ms = TimeRounds([=]() { ParseOBJWithIO(filepath, true); }, ROUNDS, true);
+			table.PrintRow({ filepath, Format("%.1f", Throughput(bytes, assimp_ms)), Format("%.1f", Throughput(bytes, fscanf_ms)),
+				Format("%.1f", Throughput(bytes, serial_ms)), Format("%.1f", Throughput(bytes, parallel_ms)) });
+		}
+	}
+}
+
+#endif // BENCHMARK_OBJ_PARSING_HPP
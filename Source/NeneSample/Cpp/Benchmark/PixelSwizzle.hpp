@@ -0,0 +1,47 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_PIXEL_SWIZZLE_HPP
+#define BENCHMARK_PIXEL_SWIZZLE_HPP
+
+#include <vector>
+#include <functional>
+#include "Benchmark.hpp"
+#include "NeneEngine/Swizzle.h"
+
+namespace benchmark
+{
+	// 逐像素标量循环 vs Swizzle 内核, 2048x2048 图片
+	void PixelSwizzle()
+	{
+		const size_t pixel_num = 2048 * 2048;
+		std::vector<NNByte> bgr(pixel_num * 3, 128), bgra(pixel_num * 4, 128), rgba(pixel_num * 4);
+		// 吞吐量按源数据计
+		auto throughput = [](const size_t bytes, const std::function<void()>& swizzle) {
+			return Throughput(bytes, TimeRounds(swizzle, 20, true));
+		};
+		double scalar_expand = throughput(bgr.size(), [&]() {
+			for (size_t i = 0; i < pixel_num; ++i)
+			{
+				rgba[i * 4 + 0] = bgr[i * 3 + 2];
+				rgba[i * 4 + 1] = bgr[i * 3 + 1];
+				rgba[i * 4 + 2] = bgr[i * 3 + 0];
+				rgba[i * 4 + 3] = 255;
+			}
+		});
+		double simd_expand = throughput(bgr.size(), [&]() { Swizzle::BGRToRGBA(bgr.data(), rgba.data(), pixel_num); });
+		double scalar_swap = throughput(bgra.size(), [&]() {
+			for (size_t i = 0; i < pixel_num; ++i)
+			{
+				std::swap(bgra[i * 4 + 0], bgra[i * 4 + 2]);
+			}
+		});
+		double simd_swap = throughput(bgra.size(), [&]() { Swizzle::SwapRB(bgra.data(), bgra.data(), pixel_num); });
+		//
+		printf("Instruction set: %s\n", Swizzle::GetInstructionSet());
+		Table table({ { "Kernel", 16 }, { "Scalar", 14 }, { "Swizzle", 14 }, { "Speedup", 10 } });
+		table.PrintHeader("  (MB/s)");
+		table.PrintRow({ "BGR -> RGBA", Format("%.1f", scalar_expand), Format("%.1f", simd_expand), Format("%.1fx", Speedup(simd_expand, scalar_expand)) });
+		table.PrintRow({ "Swap R/B", Format("%.1f", scalar_swap), Format("%.1f", simd_swap), Format("%.1fx", Speedup(simd_swap, scalar_swap)) });
+	}
+}
+
+#endif // BENCHMARK_PIXEL_SWIZZLE_HPP
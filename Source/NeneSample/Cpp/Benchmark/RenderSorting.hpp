@@ -0,0 +1,70 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_RENDER_SORTING_HPP
+#define BENCHMARK_RENDER_SORTING_HPP
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 随机顺序提交的物体: 立即绘制 vs 渲染队列排序后绘制
+	void RenderSorting()
+	{
+		//
+		Utils::Init("Benchmark: Render Sorting", 800, 600);
+		glfwSwapInterval(0);
+		//
+		std::vector<std::shared_ptr<Shader>> shaders = {
+			Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag"),
+			Shader::Create("Resource/Shader/GLSL/Flat.vert", "Resource/Shader/GLSL/Flat.frag"),
+		};
+		std::vector<std::shared_ptr<Drawable>> drawables = {
+			Geometry::CreateCube(),
+			Geometry::CreateSphereUV(16, 16),
+			Geometry::CreateTorus(),
+			StaticMesh::Create("Resource/Mesh/nanosuit/nanosuit.obj"),
+		};
+		std::shared_ptr<Camera> camera = std::make_shared<Camera>();
+		std::shared_ptr<RenderQueue> queue = RenderQueue::Create();
+		//
+		Table table({ { "Objects", 10 }, { "Immediate (ms)", 14 }, { "Queue (ms)", 14 }, { "Shader binds", 16 }, { "Texture binds", 16 }, { "VAO binds", 16 } });
+		table.PrintHeader();
+		const NNUInt counts[] = { 1000, 5000, 20000 };
+		for (const NNUInt count : counts)
+		{
+			// 随机的物体, 着色器和位置
+			struct Object { NNUInt drawable, shader; NNMat4 model; };
+			std::vector<Object> objects(count);
+			std::mt19937 rng(count);
+			for (NNUInt i = 0; i < count; ++i)
+			{
+				objects[i] = { (NNUInt)(rng() % drawables.size()), (NNUInt)(rng() % shaders.size()), GridTransform(i, count, 0.01f) };
+			}
+			double immediate = TimeFrames([&]() {
+				camera->Use();
+				for (const Object& object : objects)
+				{
+					drawables[object.drawable]->SetModelMat(object.model);
+					drawables[object.drawable]->Draw(shaders[object.shader]);
+				}
+			});
+			double queued = TimeFrames([&]() {
+				for (const Object& object : objects)
+				{
+					drawables[object.drawable]->SetModelMat(object.model);
+					drawables[object.drawable]->Submit(*queue, shaders[object.shader]);
+				}
+				queue->Flush(camera);
+			});
+			const RenderQueue::Stats& stats = queue->GetStats();
+			table.PrintRow({ Format("%u", count), Format("%.3f", immediate), Format("%.3f", queued), Format("%u / %u", stats.shader_binds, stats.draws),
+				Format("%u / %u", stats.texture_binds, stats.draws), Format("%u / %u", stats.vertex_array_binds, stats.draws) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_RENDER_SORTING_HPP
@@ -0,0 +1,60 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_TEXTURE_LOADING_HPP
+#define BENCHMARK_TEXTURE_LOADING_HPP
+
+#include "Benchmark.hpp"
+#include "NeneEngine/TextureCache.h"
+
+namespace benchmark
+{
+	// FreeImage 解码 (并写入缓存) vs .nntex 缓存载入
+	void TextureLoading()
+	{
+		//
+		Utils::Init("Benchmark: Texture Loading", 800, 600);
+		//
+		static const int ROUNDS = 5;
+		// VTAM 体纹理, 与 Hatching 示例一致
+		std::vector<std::vector<std::string>> vtam(4);
+		for (NNUInt mip = 0; mip < vtam.size(); ++mip)
+		{
+			for (NNUInt tone = 0; tone < (64u >> mip); ++tone)
+			{
+				NNChar filepath[256];
+				snprintf(filepath, sizeof(filepath), "Resource/Texture/VTAM/MipMapLv%d/Tone%03d.bmp", mip, tone);
+				vtam[mip].push_back(filepath);
+			}
+		}
+		// BTAM 多文件 mipmap
+		std::vector<std::vector<std::string>> btam = {
+			{ "Resource/Texture/BTAM/Default_Mip0_Tone012.png" },
+			{ "Resource/Texture/BTAM/Default_Mip1_Tone012.png" },
+			{ "Resource/Texture/BTAM/Default_Mip2_Tone012.png" },
+			{ "Resource/Texture/BTAM/Default_Mip3_Tone012.png" },
+		};
+		std::vector<const NNChar*> btam_filepaths;
+		for (const std::vector<std::string>& level : btam)
+		{
+			btam_filepaths.push_back(level[0].c_str());
+		}
+		// 解码前删除缓存, 然后计时读取刚写入的缓存
+		Table table({ { "Texture", 20 }, { "Decode (ms)", 14 }, { "Cached (ms)", 14 }, { "Speedup", 10 } });
+		table.PrintHeader();
+		auto run = [&table](const char* name, const std::vector<std::vector<std::string>>& sources, const std::function<void()>& load) {
+			double cold = 0.0, cached = 0.0;
+			for (int round = 0; round < ROUNDS; ++round)
+			{
+				std::remove(TextureCache::GetCachePath(sources).c_str());
+				cold += TimeRounds(load);
+				cached += TimeRounds(load);
+			}
+			table.PrintRow({ name, Format("%.2f", cold / ROUNDS), Format("%.2f", cached / ROUNDS), Format("%.1fx", Speedup(cold, cached)) });
+		};
+		run("VTAM (Texture3D)", vtam, [&]() { Texture3D::Create(vtam); });
+		run("BTAM (Texture2D)", btam, [&]() { Texture2D::Create(btam_filepaths); });
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_TEXTURE_LOADING_HPP
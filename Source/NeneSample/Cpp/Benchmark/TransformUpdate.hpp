@@ -0,0 +1,87 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_TRANSFORM_UPDATE_HPP
+#define BENCHMARK_TRANSFORM_UPDATE_HPP
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 分散在堆上的节点, 每次取世界矩阵都沿父节点重新计算
+	struct PointerTransform
+	{
+		PointerTransform* parent;
+		NNVec3 position;
+		NNQuat rotation;
+		NNVec3 scale;
+		NNMat4 World() const
+		{
+			NNMat4 local = NNCreateTranslation(position) * glm::mat4_cast(rotation) * NNCreateScale(scale);
+			return parent != nullptr ? parent->World() * local : local;
+		}
+	};
+
+	// 每帧旋转所有根节点: 指针层级逐个重算 vs 按层批量更新
+	void TransformUpdate()
+	{
+		//
+		Table table({ { "Nodes", 10 }, { "Depth", 8 }, { "Pointer (ms)", 16 }, { "Batched (ms)", 16 }, { "Speedup", 9 } });
+		table.PrintHeader();
+		const NNUInt counts[] = { 1000, 10000, 100000 };
+		const NNUInt FANOUT = 4;
+		const int FRAMES = 30;
+		for (const NNUInt count : counts)
+		{
+			// 每个节点挂在前 count / FANOUT 个节点之一下面, 形成多棵四叉树
+			TransformSystem& transforms = TransformSystem::Instance();
+			std::vector<std::unique_ptr<PointerTransform>> nodes(count);
+			std::vector<TransformSystem::Handle> handles(count);
+			NNUInt depth = 0;
+			std::vector<NNUInt> depths(count, 0);
+			for (NNUInt i = 0; i < count; ++i)
+			{
+				const bool root = i < FANOUT;
+				const NNUInt parent = root ? 0 : i / FANOUT - 1;
+				nodes[i].reset(new PointerTransform{ root ? nullptr : nodes[parent].get(), NNVec3(1.0f, 0.0f, 0.0f), NNQuat(), NNVec3(1.0f) });
+				handles[i] = transforms.Create(root ? TransformSystem::INVALID_HANDLE : handles[parent]);
+				transforms.SetPosition(handles[i], NNVec3(1.0f, 0.0f, 0.0f));
+				depths[i] = root ? 0 : depths[parent] + 1;
+				depth = depths[i] > depth ? depths[i] : depth;
+			}
+			std::vector<NNMat4> worlds(count);
+			NNFloat angle = 0.0f;
+			double pointer = TimeRounds([&]() {
+				angle += 0.01f;
+				for (NNUInt i = 0; i < FANOUT; ++i)
+				{
+					nodes[i]->rotation = NNQuatAngleAxis(angle, NNVec3(0.0f, 1.0f, 0.0f));
+				}
+				for (NNUInt i = 0; i < count; ++i)
+				{
+					worlds[i] = nodes[i]->World();
+				}
+			}, FRAMES);
+			double batched = TimeRounds([&]() {
+				angle += 0.01f;
+				for (NNUInt i = 0; i < FANOUT; ++i)
+				{
+					transforms.SetRotation(handles[i], NNQuatAngleAxis(angle, NNVec3(0.0f, 1.0f, 0.0f)));
+				}
+				transforms.Update();
+				for (NNUInt i = 0; i < count; ++i)
+				{
+					worlds[i] = transforms.GetWorldMatrix(handles[i]);
+				}
+			}, FRAMES);
+			table.PrintRow({ Format("%u", count), Format("%u", depth + 1), Format("%.3f", pointer), Format("%.3f", batched), Format("%.2fx", Speedup(pointer, batched)) });
+			for (const TransformSystem::Handle handle : handles)
+			{
+				transforms.Destroy(handle);
+			}
+		}
+	}
+}
+
+#endif // BENCHMARK_TRANSFORM_UPDATE_HPP
@@ -0,0 +1,90 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_VERTEX_CACHE_HPP
+#define BENCHMARK_VERTEX_CACHE_HPP
+
+#include <cstdio>
+#include <functional>
+#include "Benchmark.hpp"
+#include "NeneEngine/MeshOptimizer.h"
+#include "VertexFormats.hpp"
+
+namespace benchmark
+{
+	// 所有组按三角形数 (ACMR) 和顶点数 (ATVR) 加权; optimize 为空时统计原始顺序
+	MeshOptimizer::CacheStats AnalyzeOBJ(const OBJData& data, const std::function<void(NNUInt*, NNUInt, const NNByte*, NNUInt)>& optimize, double& milliseconds)
+	{
+		double misses = 0.0, triangles = 0.0, vertices = 0.0;
+		milliseconds = 0.0;
+		for (const OBJGroup& group : data.groups)
+		{
+			std::vector<NNUInt> indices(data.indices.begin() + group.index_offset, data.indices.begin() + group.index_offset + group.index_num);
+			if (optimize)
+			{
+				Clock::time_point begin = Clock::now();
+				optimize(indices.data(), group.index_num, (const NNByte*)&data.positions[group.vertex_offset], group.vertex_num);
+				milliseconds += ElapsedMilliseconds(begin);
+			}
+			MeshOptimizer::CacheStats stats = MeshOptimizer::AnalyzeVertexCache(indices.data(), group.index_num, group.vertex_num);
+			misses += stats.acmr * (group.index_num / 3);
+			triangles += group.index_num / 3;
+			vertices += stats.acmr > 0.0f ? stats.acmr * (group.index_num / 3) / stats.atvr : 0.0;
+		}
+		MeshOptimizer::CacheStats result = { 0.0f, 0.0f };
+		if (triangles > 0.0 && vertices > 0.0)
+		{
+			result.acmr = (NNFloat)(misses / triangles);
+			result.atvr = (NNFloat)(misses / vertices);
+		}
+		return result;
+	}
+
+	// 原始顺序 vs Tipsify vs Tipsify + 过度绘制排序: ACMR/ATVR, 优化耗时和绘制耗时
+	void VertexCache()
+	{
+		//
+		Utils::Init("Benchmark: Vertex Cache", 800, 600);
+		//
+		const char* filepaths[] = {
+			"Resource/Mesh/bunny/bunny.obj",
+			"Resource/Mesh/armadillo/armadillo.obj",
+		};
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		//
+		Table table({ { "Model", 40 }, { "Source ACMR/ATVR", 18 }, { "Tipsify ACMR/ATVR", 18 }, { "Overdraw ACMR/ATVR", 18 },
+			{ "Tipsify (ms)", 12 }, { "Overdraw (ms)", 12 }, { "Draw (ms)", 12 }, { "Opt Draw (ms)", 12 } });
+		table.PrintHeader();
+		for (const char* filepath : filepaths)
+		{
+			OBJData data;
+			if (!IO::ReadOBJ(filepath, data, true))
+			{
+				continue;
+			}
+			double source_ms = 0.0, tipsify_ms = 0.0, overdraw_ms = 0.0;
+			MeshOptimizer::CacheStats source = AnalyzeOBJ(data, nullptr, source_ms);
+			// 只按顶点缓存重排, 不需要位置
+			MeshOptimizer::CacheStats tipsify = AnalyzeOBJ(data, [](NNUInt* indices, NNUInt index_num, const NNByte*, NNUInt vertex_num) {
+				MeshOptimizer::OptimizeVertexCache(indices, index_num, vertex_num);
+			}, tipsify_ms);
+			MeshOptimizer::CacheStats overdraw = AnalyzeOBJ(data, [](NNUInt* indices, NNUInt index_num, const NNByte* positions, NNUInt vertex_num) {
+				MeshOptimizer::OptimizeOverdraw(indices, index_num, positions, vertex_num, sizeof(NNVec3));
+			}, overdraw_ms);
+			// 绘制时间, 优化结果写入各自的缓存
+			double draw_ms = 0.0, optimized_draw_ms = 0.0;
+			{
+				auto mesh = StaticMesh::Create(filepath, 1.0f, NN_IMPORT_NATIVE_OBJ);
+				draw_ms = TimeMeshDrawing(mesh, shader);
+			}
+			{
+				auto mesh = StaticMesh::Create(filepath, 1.0f, NN_IMPORT_NATIVE_OBJ | NN_IMPORT_OPTIMIZE_OVERDRAW);
+				optimized_draw_ms = TimeMeshDrawing(mesh, shader);
+			}
+			table.PrintRow({ filepath, Format("%.3f / %.3f", source.acmr, source.atvr), Format("%.3f / %.3f", tipsify.acmr, tipsify.atvr), Format("%.3f / %.3f", overdraw.acmr, overdraw.atvr),
+				Format("%.2f", tipsify_ms), Format("%.2f", overdraw_ms), Format("%.3f", draw_ms), Format("%.3f", optimized_draw_ms) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_VERTEX_CACHE_HPP
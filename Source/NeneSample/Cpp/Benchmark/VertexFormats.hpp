@@ -0,0 +1,54 @@
+/*Copyright reserved by KenLee@2020 ken4000kl@gmail.com*/
+#ifndef BENCHMARK_VERTEX_FORMATS_HPP
+#define BENCHMARK_VERTEX_FORMATS_HPP
+
+#include <cstdio>
+#include "Benchmark.hpp"
+
+namespace benchmark
+{
+	// 绘制 100 次的平均耗时 (毫秒)
+	double TimeMeshDrawing(const std::shared_ptr<StaticMesh>& mesh, const std::shared_ptr<Shader>& shader)
+	{
+		shader->Use();
+		return TimeGPURounds([&]() { mesh->Draw(); }, 100);
+	}
+
+	// 32 字节标准顶点 + 32 位索引 vs 16 字节紧凑顶点 + 16 位索引
+	void VertexFormats()
+	{
+		//
+		Utils::Init("Benchmark: Vertex Formats", 800, 600);
+		//
+		const char* filepaths[] = {
+			"Resource/Mesh/bunny/bunny.obj",
+			"Resource/Mesh/armadillo/armadillo.obj",
+			"Resource/Mesh/nanosuit/nanosuit.obj",
+		};
+		std::shared_ptr<Shader> shader = Shader::Create("Resource/Shader/GLSL/Common.vert", "Resource/Shader/GLSL/Common.frag");
+		//
+		Table table({ { "Model", 40 }, { "Standard (KB)", 14 }, { "Compact (KB)", 14 }, { "Standard (ms)", 14 }, { "Compact (ms)", 14 }, { "Memory", 10 } });
+		table.PrintHeader();
+		for (const char* filepath : filepaths)
+		{
+			size_t standard_bytes = 0, compact_bytes = 0;
+			double standard_ms = 0.0, compact_ms = 0.0;
+			{
+				auto mesh = StaticMesh::Create(filepath, 1.0f, NN_IMPORT_NATIVE_OBJ);
+				standard_bytes = Mesh::GetMemoryStats().gpu_bytes;
+				standard_ms = TimeMeshDrawing(mesh, shader);
+			}
+			{
+				auto mesh = StaticMesh::Create(filepath, 1.0f, NN_IMPORT_NATIVE_OBJ | NN_IMPORT_COMPACT_VERTICES);
+				compact_bytes = Mesh::GetMemoryStats().gpu_bytes;
+				compact_ms = TimeMeshDrawing(mesh, shader);
+			}
+			table.PrintRow({ filepath, Format("%.1f", standard_bytes / 1024.0), Format("%.1f", compact_bytes / 1024.0), Format("%.3f", standard_ms), Format("%.3f", compact_ms),
+				Format("%.1f%%", standard_bytes > 0 ? 100.0 * compact_bytes / standard_bytes : 0.0) });
+		}
+		//
+		Utils::Terminate();
+	}
+}
+
+#endif // BENCHMARK_VERTEX_FORMATS_HPP
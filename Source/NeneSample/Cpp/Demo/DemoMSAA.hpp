@@ -19,33 +19,34 @@ public:
 		mpCube = Geometry::createCube(CLOCK_WISE);
 		mpShaderCommon = Shader::create("Resource/Shader/GLSL/Texture.vert", "Resource/Shader/GLSL/Texture.frag", POSITION_NORMAL_TEXTURE);
 		mpTextureDiiffse = Texture2D::create("Resource/Texture/Pure.png");
+		// 绑定都经过 RenderContext, 保持状态缓存和实际状态一致
 		//* 
 		glGenTextures(1, &mColorTex);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, mColorTex);
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, mColorTex);
 		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, mSamples, GL_RGBA8, Utils::getWindowWidth(), Utils::getWindowHeight(), false);
 		
 		glGenTextures(1, &mDepthTex);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, mDepthTex);
+		RenderContext::instance().bindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, mDepthTex);
 		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, mSamples, GL_DEPTH24_STENCIL8, Utils::getWindowWidth(), Utils::getWindowHeight(), false);
 		//
 		glGenFramebuffers(1, &mFBO);
-		glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+		RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, mFBO);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, mColorTex, 0);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D_MULTISAMPLE, mDepthTex, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, 0);
 		//*/
 		// Above is equivalent to :
 		// mpRT = RenderTarget::createMultisample(Utils::getWindowWidth(), Utils::getWindowHeight(), 4, 1);
 	}
 	virtual void onLoop(shared_ptr<Camera> camera) {
 		//
-		glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+		RenderContext::instance().bindFramebuffer(GL_FRAMEBUFFER, mFBO);
 		Utils::clear();
 		mpTextureDiiffse->use(0);
 		mpCube->draw(mpShaderCommon);
 		//
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
+		RenderContext::instance().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		RenderContext::instance().bindFramebuffer(GL_READ_FRAMEBUFFER, mFBO);
 		glDrawBuffer(GL_BACK);
 		glBlitFramebuffer(0, 0, Utils::getWindowWidth(), Utils::getWindowHeight(), 0, 0, Utils::getWindowWidth(), Utils::getWindowHeight(), GL_COLOR_BUFFER_BIT, mFilter);
 	}
@@ -36,7 +36,7 @@ namespace hatching
 		{
 			//
 			ImGui::SetWindowPos(ImVec2(10, 10));
-			ImGui::SetWindowSize(ImVec2(320, 240));
+			ImGui::SetWindowSize(ImVec2(320, 280));
 			//
 			ImGui::Text("Camera: ");
 			ImGui::Text("(%.1f, %.1f, %.1f) | (%.1f, %.1f) ", g_camera_position[0], g_camera_position[1], g_camera_position[2], g_camera_rotation[0], g_camera_rotation[1]);
@@ -52,6 +52,10 @@ namespace hatching
 			//
 			ImGui::Text("ModelRotation: ");
 			ImGui::SliderFloat("     ", &g_model_rotation_speed, 0.0f, M_PI_TIMES_2);
+			//
+			ImGui::Text("Loading: %zd resources pending", ResourceLoader::Instance().GetPendingNum());
+			Mesh::MemoryStats mesh_stats = Mesh::GetMemoryStats();
+			ImGui::Text("Mesh: %.1f MB GPU, %.1f MB CPU (%.1f MB saved)", mesh_stats.gpu_bytes / 1048576.0, mesh_stats.cpu_bytes / 1048576.0, mesh_stats.cpu_bytes_saved / 1048576.0);
 
 		}
 		ImGui::End();
@@ -74,16 +78,16 @@ namespace hatching
 		auto cube = Geometry::CreateCube();
 		auto ball = Geometry::CreateSphereUV(30, 30);
 		//
-		auto bunny = StaticMesh::Create("Resource/Mesh/bunny/bunny_with_uv.obj");
+		auto bunny = StaticMesh::LoadAsync("Resource/Mesh/bunny/bunny_with_uv.obj");
 		auto tex_bunny_lapped_coord = Texture2D::Create("Resource/Texture/Hatching/LappedCoordPadded.png");
-		auto tex_lapped_patch = Texture2D::Create("Resource/Texture/splotch_checkboard.png");
-		auto shader_lapped = Shader::Create("Resource/Shader/GLSL/LappedTexture.vert", "Resource/Shader/GLSL/LappedTexture.frag");
+		auto tex_lapped_patch = Texture2D::LoadAsync("Resource/Texture/splotch_checkboard.png");
+		auto shader_lapped = Shader::LoadAsync("Resource/Shader/GLSL/LappedTexture.vert", "Resource/Shader/GLSL/LappedTexture.frag");
 		// <Real-Time Hatching> Praun et al.
-		auto shader_praun = Shader::Create("Resource/Shader/GLSL/PraunHatchOrigin.vert", "Resource/Shader/GLSL/PraunHatchOrigin.frag");
+		auto shader_praun = Shader::LoadAsync("Resource/Shader/GLSL/PraunHatchOrigin.vert", "Resource/Shader/GLSL/PraunHatchOrigin.frag");
 		// <Real-Time Stroke Textures> Freud. et al. 
-		auto shader_fraud = Shader::Create("Resource/Shader/GLSL/FreudHatch.vert", "Resource/Shader/GLSL/FreudHatch.frag");
+		auto shader_fraud = Shader::LoadAsync("Resource/Shader/GLSL/FreudHatch.vert", "Resource/Shader/GLSL/FreudHatch.frag");
 		// <Fine Tone Control in Harward Hatching> Praun et al. Scheme1
-		auto shader_praun_scheme1 = Shader::Create("Resource/Shader/GLSL/PraunHatchScheme1.vert", "Resource/Shader/GLSL/PraunHatchScheme1.frag");
+		auto shader_praun_scheme1 = Shader::LoadAsync("Resource/Shader/GLSL/PraunHatchScheme1.vert", "Resource/Shader/GLSL/PraunHatchScheme1.frag");
 		//
 		static const size_t MIPMAP_LEVELS = 4;
 		static const NNUInt MAX_TONE_LEVELS = 64;
@@ -104,17 +108,17 @@ namespace hatching
 			}
 		}
 		//
-		auto tex_vol = Texture3D::Create(images);
-		auto tex_hatch = Texture2D::Create({
+		auto tex_vol = Texture3D::LoadAsync(images);
+		auto tex_hatch = Texture2D::LoadAsync({
 			"Resource/Texture/TAM/default23.bmp"
 		});
-		auto tex_hatch_tone012 = Texture2D::Create({
+		auto tex_hatch_tone012 = Texture2D::LoadAsync({
 			"Resource/Texture/BTAM/Default_Mip0_Tone012.png",
 			"Resource/Texture/BTAM/Default_Mip1_Tone012.png", 
 			"Resource/Texture/BTAM/Default_Mip2_Tone012.png", 
 			"Resource/Texture/BTAM/Default_Mip3_Tone012.png"
 		});
-		auto tex_hatch_tone345 = Texture2D::Create({
+		auto tex_hatch_tone345 = Texture2D::LoadAsync({
 			"Resource/Texture/BTAM/Default_Mip0_Tone345.png",
 			"Resource/Texture/BTAM/Default_Mip1_Tone345.png",
 			"Resource/Texture/BTAM/Default_Mip2_Tone345.png",
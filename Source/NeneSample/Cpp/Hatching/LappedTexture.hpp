@@ -171,11 +171,11 @@ namespace lappedtexture
 				ca->Draw();
 				//
 				{
-					glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+					RenderContext::instance().polygonMode(GL_LINE);
 					CustomConstantBuffer.Data().color = NNVec4(0.0, 1.0, 1.0, 1.0);
 					CustomConstantBuffer.Update(NNConstantBufferSlot::CUSTOM_DATA_SLOT);
 					bunny->Draw(shader_3d_color);
-					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					RenderContext::instance().polygonMode(GL_FILL);
 				}
 				//
 				
@@ -195,12 +195,12 @@ namespace lappedtexture
 				// Highlight Selected Patch
 				if (NNUInt(g_viewing_patch_index) < g_lapped_mesh->PatchCount())
 				{
-					glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+					RenderContext::instance().polygonMode(GL_LINE);
 					CustomConstantBuffer.Data().color = NNVec4(1.0, 0.0, 0.0, 1.0);
 					CustomConstantBuffer.Update(NNConstantBufferSlot::CUSTOM_DATA_SLOT);
 					shader_3d_color->Use();
 					g_lapped_mesh->GetPatch(g_viewing_patch_index).Draw();
-					glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+					RenderContext::instance().polygonMode(GL_FILL);
 				}
 
 				if (g_need_snap_texcoord)
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <bitset>
+#include "NeneEngine/IO.h"
 #include "NeneEngine/Debug.h"
 #include "LappedTextureMesh.h"
 
@@ -46,6 +47,7 @@ LappedTextureMesh::LappedTextureMesh(std::shared_ptr<Mesh> static_mesh):
 {
 	//
 	CreateShaderAndTextures();
+	m_source_mesh->SetResidency(NN_RESIDENCY_CPU_GPU);
 	//
 	const std::vector<NNUInt>& indices = m_source_mesh->GetIndexData();
 	//
@@ -86,70 +88,24 @@ void LappedTextureMesh::CreateShaderAndTextures()
 
 void LappedTextureMesh::ReadOBJFileAndBuildSourceFaceAdjacencies(const char* filepath)
 {
-	FILE *file = fopen(filepath, "r");
-	if (file == nullptr)
+	OBJData data;
+	if (not IO::ReadOBJ(filepath, data))
 	{
 		return;
 	}
-	//
-	char linebuff[512];
-	vector<NNVec3> normals;
-	vector<NNVec3> positions;
-	vector<NNVec2> texcoords;
-	vector<NNUInt> positions_indices;
-	vector<NNUInt> texcoords_indices;
-	while (fscanf(file, "%s", linebuff) != EOF)
+	// 焊接后的索引转为全局索引
+	const vector<NNUInt>& positions_indices = data.position_indices;
+	vector<NNUInt> indices(data.indices.size());
+	for (const OBJGroup& group : data.groups)
 	{
-		if (linebuff[0] == 'm' and linebuff[0] == 't')
+		for (NNUInt i = group.index_offset; i < group.index_offset + group.index_num; ++i)
 		{
-			fgets(linebuff, 512, file);
-		}
-		else if (linebuff[0] == 'v' and linebuff[1] == 'n')
-		{
-			NNVec3 temp;
-			fscanf(file, "%f %f %f", &temp.x, &temp.y, &temp.z);
-			normals.emplace_back(temp);
-		}
-		else if (linebuff[0] == 'v' and linebuff[1] == 't')
-		{
-			NNVec2 temp;
-			fscanf(file, "%f %f", &temp.x, &temp.y);
-			texcoords.emplace_back(temp);
-		}
-		else if (linebuff[0] == 'v')
-		{
-			NNVec3 temp;
-			fscanf(file, "%f %f %f", &temp.x, &temp.y, &temp.z);
-			positions.emplace_back(temp);
-		}
-		else if (linebuff[0] == 'f')
-		{
-			NNUInt iav, iat, ibv, ibt, icv, ict;
-			fscanf(file, "%d/%d %d/%d %d/%d", &iav, &iat, &ibv, &ibt, &icv, &ict);
-			positions_indices.push_back(iav - 1);
-			positions_indices.push_back(ibv - 1);
-			positions_indices.push_back(icv - 1);
-			texcoords_indices.push_back(iat - 1);
-			texcoords_indices.push_back(ibt - 1);
-			texcoords_indices.push_back(ict - 1);
-		}
-		else if (linebuff[0] == '#')
-		{
-			fgets(linebuff, 512, file);
-		}
-		else if (linebuff[0] == 'o')
-		{
-			fgets(linebuff, 512, file);
-		}
-		else
-		{
-			fgets(linebuff, 512, file);
+			indices[i] = data.indices[i] + group.vertex_offset;
 		}
 	}
-	//
-	vector<NNUInt> indices;
-	vector<Vertex> vertices;
-	unordered_map<NNUInt, NNUInt> vertex_map;
+	// 顶点法线取首个引用它的面的法线
+	vector<Vertex> vertices(data.positions.size());
+	vector<bool> vertex_visited(data.positions.size(), false);
 	//
 	unordered_map<NNUInt, FaceEdge> edge_map;
 	m_source_face_count = NNUInt(positions_indices.size() / 3);
@@ -157,22 +113,18 @@ void LappedTextureMesh::ReadOBJFileAndBuildSourceFaceAdjacencies(const char* fil
 	//
 	for (NNUInt f = 0; f < m_source_face_count; ++f)
 	{
-		NNVec3 ab = positions[positions_indices[f * 3 + 1]] - positions[positions_indices[f * 3 + 0]];
-		NNVec3 bc = positions[positions_indices[f * 3 + 2]] - positions[positions_indices[f * 3 + 1]];
+		NNVec3 ab = data.positions[indices[f * 3 + 1]] - data.positions[indices[f * 3 + 0]];
+		NNVec3 bc = data.positions[indices[f * 3 + 2]] - data.positions[indices[f * 3 + 1]];
 		NNVec3 normal = glm::normalize(glm::cross(ab, bc));
 		for (int v = 0; v < 3; ++v)
 		{
 			//
-			NNUInt ip = positions_indices[f * 3 + v];
-			NNUInt it = texcoords_indices[f * 3 + v];
-			NNUInt vmkey = (ip << 16) | it;
-			if (vertex_map.find(vmkey) == vertex_map.end())
+			NNUInt idx = indices[f * 3 + v];
+			if (not vertex_visited[idx])
 			{
-				NNUInt idx = NNUInt(vertices.size());
-				vertices.push_back(Vertex{ positions[ip], normal, texcoords[it] });
-				vertex_map[vmkey] = idx;
+				vertices[idx] = Vertex{ data.positions[idx], normal, data.texcoords[idx] };
+				vertex_visited[idx] = true;
 			}
-			indices.push_back(vertex_map[vmkey]);
 			//
 			NNUInt s_i = positions_indices[f * 3 + ((v + 0) % 3)];
 			NNUInt e_i = positions_indices[f * 3 + ((v + 1) % 3)];
@@ -198,6 +150,8 @@ void LappedTextureMesh::ReadOBJFileAndBuildSourceFaceAdjacencies(const char* fil
 	}
 	//
 	m_source_mesh = Mesh::Create(vertices, indices, {});
+	// 铺贴过程需要频繁访问顶点和索引
+	m_source_mesh->SetResidency(NN_RESIDENCY_CPU_GPU);
 }
 
 bool LappedTextureMesh::IsFilled()
@@ -245,9 +199,9 @@ void LappedTextureMesh::DrawDebug(const NNUInt& i)
 	m_patch_debug_shader->Use();
 	if(i < m_patches.size())
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		RenderContext::instance().polygonMode(GL_LINE);
 		m_patches[i].Draw();
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		RenderContext::instance().polygonMode(GL_FILL);
 	}
 }
 
@@ -343,7 +297,7 @@ void LappedTextureMesh::DrawAndCalcFaceCoverage()
 	//
 	// m_coverage_rtt->GetColorTex(0)->SavePixelData("coverage.png");
 	//
-	dLog("[Coverage] Re-add candidate %zd faces; Remain uncovered face num: %zd", faces_to_readd.size(), m_candidate_faces.size());
+	nnLog(NN_LOG_DEBUG, NN_LOG_SAMPLE, "[Coverage] Re-add candidate %zd faces; Remain uncovered face num: %zd", faces_to_readd.size(), m_candidate_faces.size());
 	////
 	//vector<NNUInt> indices;
 	//for (const auto& face : faces_to_readd)
@@ -417,7 +371,7 @@ void LappedTextureMesh::BuildSourceFaceAdjacencies()
 	//
 	for (NNUInt src_face = 0; src_face < face_num; ++src_face)
 	{
-		dLog("[Coverage] Building %d adjacent face relation...", src_face);
+		nnLog(NN_LOG_TRACE, NN_LOG_SAMPLE, "[Coverage] Building %d adjacent face relation...", src_face);
 		for (NNUInt dst_face = src_face + 1; dst_face < face_num; ++dst_face)
 		{
 			optional<FaceAdjacency> adj = CalcAdjacentEdge(indices, vertices, src_face, dst_face);
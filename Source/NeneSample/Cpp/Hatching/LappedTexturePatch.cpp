@@ -89,7 +89,7 @@ LappedTexturePatch::LappedTexturePatch(const std::vector<NNUInt>& indices, const
 	//
 	m_patch_rendering_mesh = Mesh::Create(m_patch_vertices, m_patch_indices, {});
 	//
-	dLog("[Patch] Init add face: %d; Remain: %zd faces; (%d, %d, %d)", sface, m_candidate_faces.size(), m_source_indices[IA(sface)], m_source_indices[IB(sface)], m_source_indices[IC(sface)]);
+	nnLog(NN_LOG_TRACE, NN_LOG_SAMPLE, "[Patch] Init add face: %d; Remain: %zd faces; (%d, %d, %d)", sface, m_candidate_faces.size(), m_source_indices[IA(sface)], m_source_indices[IB(sface)], m_source_indices[IC(sface)]);
 }
 
 void LappedTexturePatch::Draw() const
@@ -135,14 +135,14 @@ void LappedTexturePatch::GenerateCoverageMesh()
 		++index;
 	}
 	m_patch_coverage_mesh = Shape::Create(vertices, NNVertexFormat::POSITION_TEXTURE);
-	dLog("[Patch] Regenerate coverage mesh for patch.\n");
+	nnLog(NN_LOG_DEBUG, NN_LOG_SAMPLE, "[Patch] Regenerate coverage mesh for patch.\n");
 }
 
 void LappedTexturePatch::Grow()
 {
 	if (m_is_grown)
 	{
-		dLog("[Patch] The patch is grown.\n");
+		nnLog(NN_LOG_DEBUG, NN_LOG_SAMPLE, "[Patch] The patch is grown.\n");
 		return;
 	}
 	optional<NNUInt> pface = AddNearestAdjacentFaceToPatch();
@@ -152,7 +152,7 @@ void LappedTexturePatch::Grow()
 		//
 		m_is_grown = true;
 		m_patch_rendering_mesh = Mesh::Create(m_patch_vertices, m_patch_indices, {});
-		dLog("[Patch] No adjacency found for this patch. Patch face num: %zd; Remain face num: %zd\n", m_source_coverage_faces.size(), m_candidate_faces.size());
+		nnLog(NN_LOG_DEBUG, NN_LOG_SAMPLE, "[Patch] No adjacency found for this patch. Patch face num: %zd; Remain face num: %zd\n", m_source_coverage_faces.size(), m_candidate_faces.size());
 		//
 		GenerateCoverageMesh();
 	}
@@ -212,7 +212,7 @@ optional<NNUInt> LappedTexturePatch::AddNearestAdjacentFaceToPatch()
 				const FaceAdjacency& other_adj = kv.second;
 				CopyPatchAdjacencyVertexTexcoord(other_adj, true);
 				need_to_calc_texcoord = false;
-				dLog("[Patch] Grow with face that all vertices is in patch! (%d: %d, %d)", min_dis_adj->dst_face, min_dis_adj->src_face, other_face);
+				nnLog(NN_LOG_TRACE, NN_LOG_SAMPLE, "[Patch] Grow with face that all vertices is in patch! (%d: %d, %d)", min_dis_adj->dst_face, min_dis_adj->src_face, other_face);
 				break;
 			}
 		}
@@ -239,7 +239,7 @@ optional<NNUInt> LappedTexturePatch::AddNearestAdjacentFaceToPatch()
 			NNVec2 t2 = SimilarTriangle3DTo2D(p0, p1, p2, nf, t0, t1);
 			m_patch_vertices[dst_diago_pi2].m_texcoord = t2;
 		}
-		dLog("[Patch] Grow add %zdth face: %d;", m_source_coverage_faces.size(), min_dis_adj->dst_face);
+		nnLog(NN_LOG_TRACE, NN_LOG_SAMPLE, "[Patch] Grow add %zdth face: %d;", m_source_coverage_faces.size(), min_dis_adj->dst_face);
 		return pface;
 	}
 
@@ -2,11 +2,39 @@
 #include "Simple/Main.hpp"
 #include "Hatching/Hatching.hpp"
 #include "Hatching/LappedTexture.hpp"
+#include "Benchmark/MeshLoading.hpp"
+#include "Benchmark/ObjParsing.hpp"
+#include "Benchmark/TextureLoading.hpp"
+#include "Benchmark/PixelSwizzle.hpp"
+#include "Benchmark/VertexFormats.hpp"
+#include "Benchmark/VertexCache.hpp"
+#include "Benchmark/DrawThroughput.hpp"
+#include "Benchmark/Instancing.hpp"
+#include "Benchmark/RenderSorting.hpp"
+#include "Benchmark/IndirectDraw.hpp"
+#include "Benchmark/MaterialBatching.hpp"
+#include "Benchmark/FrustumCulling.hpp"
+#include "Benchmark/TransformUpdate.hpp"
+#include "Benchmark/FramePreparation.hpp"
 
 
 int main()
 {
 	hatching::Main();
 	//lappedtexture::Main();
+	//benchmark::MeshLoading();
+	//benchmark::ObjParsing();
+	//benchmark::TextureLoading();
+	//benchmark::PixelSwizzle();
+	//benchmark::VertexFormats();
+	//benchmark::VertexCache();
+	//benchmark::DrawThroughput();
+	//benchmark::Instancing();
+	//benchmark::RenderSorting();
+	//benchmark::IndirectDraw();
+	//benchmark::MaterialBatching();
+	//benchmark::FrustumCulling();
+	//benchmark::TransformUpdate();
+	//benchmark::FramePreparation();
 	return 0;
 }